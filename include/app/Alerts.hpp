@@ -1,6 +1,7 @@
 #pragma once
 #include "model/Snapshot.hpp"
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <chrono>
 
@@ -16,6 +17,8 @@ struct AlertRules {
   double mem_high_pct       = 90.0;   // warn/crit
   double top_proc_cpu_pct   = 80.0;   // warn
   std::chrono::seconds sustain = std::chrono::seconds(3);
+  double psi_some_avg10_pct = 20.0;   // warn: system-wide some pressure
+  double psi_full_avg10_pct = 10.0;   // crit: system-wide full pressure
 };
 
 class AlertEngine {
@@ -27,6 +30,14 @@ private:
   AlertRules rules_;
   std::chrono::steady_clock::time_point cpu_high_since_{};
   std::chrono::steady_clock::time_point mem_high_since_{};
+  // Per "scope:resource": trigger fires already seen, and when the last new
+  // one arrived. A fire is reported for `sustain` after it, not just on the
+  // one frame it landed in.
+  struct PsiSeen {
+    uint64_t fires{};
+    std::chrono::steady_clock::time_point last{};
+  };
+  std::unordered_map<std::string, PsiSeen> psi_seen_;
 };
 
 } // namespace montauk::app
@@ -14,7 +14,7 @@ namespace montauk::app {
 // fault delta is derived from prev_faults, the caller-owned per-pid cumulative
 // fault count from the previous cycle (the Producer holds it across frames and
 // this call refreshes it). Runs on the Producer thread before publish; writes
-// back onto procs.processes. A near-empty population (< 8 processes) is unscored.
+// back onto procs' anomaly columns. A near-empty population (< 8 processes) is unscored.
 void enrich_anomalies(montauk::model::ProcessSnapshot& procs,
                       std::unordered_map<int32_t, uint64_t>& prev_faults,
                       std::unordered_map<int32_t, uint64_t>& prev_ctxsw);
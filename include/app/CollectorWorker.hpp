@@ -0,0 +1,113 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace montauk::app {
+
+// One slow collector on its own cadence thread, writing into its own slot.
+//
+// The Producer loop used to call every collector inline, so one statvfs on a
+// hung NFS mount or one provider socket sitting out its timeout held back the
+// publish for CPU, memory and everything else. A worker runs `fn` every
+// `interval` into a private T it owns (collector state that accumulates across
+// samples keeps working), then copies the finished result into the slot. The
+// Producer calls merge_into() at publish time and takes whatever is newest;
+// the slot lock is only ever held for that copy, never across a sample, so a
+// stalled collector just means its values stop advancing.
+//
+// ready_fd() becomes readable whenever a sample lands, so the Producer's
+// DeadlineScheduler can wake for it instead of polling; merge_into() drains it.
+template <typename T>
+class CollectorWorker {
+public:
+  using SampleFn = std::function<void(T&)>;
+
+  // first_gap: the wait after the very first sample, for collectors that
+  // only report a rate once a second sample exists (RAPL power, GPU util) --
+  // the hot-start warm-up wants both inside its budget.
+  CollectorWorker(std::chrono::milliseconds interval, SampleFn fn,
+                  std::chrono::milliseconds first_gap = std::chrono::milliseconds{-1})
+      : interval_(interval), first_gap_(first_gap.count() < 0 ? interval : first_gap),
+        fn_(std::move(fn)), ready_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+  CollectorWorker(const CollectorWorker&) = delete;
+  CollectorWorker& operator=(const CollectorWorker&) = delete;
+  ~CollectorWorker() {
+    stop();
+    if (ready_fd_ >= 0) ::close(ready_fd_);
+  }
+
+  // -1 if eventfd() failed; merge_into() still works, nothing wakes for it.
+  [[nodiscard]] int ready_fd() const { return ready_fd_; }
+
+  void start() {
+    if (thread_.joinable()) return;
+    thread_ = std::jthread([this](std::stop_token st) { run(st); });
+  }
+
+  void stop() {
+    if (!thread_.joinable()) return;
+    thread_.request_stop();
+    thread_.join();
+  }
+
+  // Copy the latest finished sample into out if one landed since the last
+  // merge. Never waits on a sample in progress.
+  bool merge_into(T& out) {
+    if (ready_fd_ >= 0) {
+      uint64_t n = 0;
+      ssize_t r = ::read(ready_fd_, &n, sizeof(n));  // EAGAIN when nothing landed
+      (void)r;
+    }
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (gen_ == merged_) return false;
+    out = slot_;
+    merged_ = gen_;
+    return true;
+  }
+
+  // Wait until n samples have landed or the deadline passes (warm-up only).
+  bool wait_samples(uint64_t n, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lk(mtx_);
+    return cv_.wait_until(lk, deadline, [&] { return gen_ >= n; });
+  }
+
+private:
+  void run(std::stop_token st) {
+    T work{};
+    while (!st.stop_requested()) {
+      const auto t0 = std::chrono::steady_clock::now();
+      fn_(work);
+      std::unique_lock<std::mutex> lk(mtx_);
+      slot_ = work;
+      const auto gap = ++gen_ == 1 ? first_gap_ : interval_;
+      cv_.notify_all();
+      if (ready_fd_ >= 0) {
+        const uint64_t one = 1;
+        ssize_t r = ::write(ready_fd_, &one, sizeof(one));
+        (void)r;
+      }
+      cv_.wait_until(lk, st, t0 + gap, [] { return false; });
+    }
+  }
+
+  const std::chrono::milliseconds interval_;
+  const std::chrono::milliseconds first_gap_;
+  SampleFn fn_;
+  std::mutex mtx_;
+  std::condition_variable_any cv_;
+  T slot_{};
+  uint64_t gen_{0};
+  uint64_t merged_{0};
+  int ready_fd_{-1};
+  std::jthread thread_{};
+};
+
+} // namespace montauk::app
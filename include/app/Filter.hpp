@@ -16,7 +16,7 @@ struct ProcessFilterSpec {
 class ProcessFilter {
 public:
   explicit ProcessFilter(ProcessFilterSpec spec);
-  // Returns filtered indices into ps.processes
+  // Returns the indices of the matching rows of ps
   [[nodiscard]] std::vector<size_t> apply(const montauk::model::ProcessSnapshot& ps) const;
 private:
   ProcessFilterSpec spec_;
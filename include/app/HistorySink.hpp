@@ -0,0 +1,53 @@
+#pragma once
+
+#include "app/MetricsSink.hpp"
+#include "model/HistoryLog.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace montauk::app {
+
+// Concrete MetricsSink feeding a HistoryWriter: every sample PrometheusSink
+// would format as a line is handed to the writer as (name, labels, value)
+// instead. Labels are escaped exactly as PrometheusSink escapes them, so a
+// series read back from a binary log keys the same as the line a .prom log
+// holds for it. The caller brackets the walk with begin_scrape/end_scrape.
+class HistorySink : public MetricsSink {
+public:
+  explicit HistorySink(montauk::model::HistoryWriter& writer) : w_(writer) {}
+
+  void section_begin(const char*) override {}
+  void section_end() override {}
+
+  void collection_begin(const char*, Shape) override {}
+  void collection_end() override {}
+  void entry_begin() override {}
+  void entry_end() override {}
+
+  void f64(const MetricDesc& d, double v) override;
+  void u64(const MetricDesc& d, uint64_t v) override;
+  void i64(const MetricDesc& d, int64_t v) override;
+  void boolean(const MetricDesc& d, bool v) override;
+  void str(const MetricDesc&, std::string_view) override {}
+
+  void labeled_f64(const MetricDesc& d, std::span<const Label> labels, double v) override;
+  void labeled_u64(const MetricDesc& d, std::span<const Label> labels, uint64_t v) override;
+  void labeled_i64(const MetricDesc& d, std::span<const Label> labels, int64_t v) override;
+
+  void info_line(const char* prom_name, const char* help, std::span<const Label> labels) override;
+  void provider(const montauk::model::Provider& p) override;
+
+  // Nothing to return: the samples went to the writer.
+  [[nodiscard]] std::string finish() override { return {}; }
+
+private:
+  void labeled(const MetricDesc& d, std::span<const Label> labels, double v);
+
+  montauk::model::HistoryWriter& w_;
+  std::string labels_;
+  std::unordered_map<std::string, montauk::model::SeriesKind, montauk::model::HistoryKeyHash, std::equal_to<>> provider_types_;
+};
+
+}  // namespace montauk::app
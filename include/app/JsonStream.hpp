@@ -0,0 +1,43 @@
+#pragma once
+
+#include "app/MetricsSelection.hpp"
+#include "model/Snapshot.hpp"
+
+#include <array>
+#include <string>
+
+namespace montauk::app {
+
+// `montauk --json-stream`: NDJSON, one line per published generation, every
+// value rendered by JsonSink through the same walk as the one-shot --json.
+//
+// The first line is the --json object with the generation's "seq" added.
+// Each later line holds "schema_version", "seq" and only what changed since
+// the line before:
+//   - a section ("cpu", "memory", ...) with just its members whose value
+//     changed; a member or section that went away is null;
+//   - arrays and nested objects are replaced whole, except the process
+//     section's "top" and "anomaly_features", which are keyed by pid:
+//       {"added":[row,...],"removed":[pid,...],
+//        "changed":[{"pid":P,<changed members>},...],"order":[pid,...]}
+//     with "order" present only when the rows' order moved (a list that
+//     was absent comes back whole).
+// Merging each line onto the object so far gives that generation's object.
+//
+// A section whose collected data is byte-for-byte the one the previous line
+// was rendered from (encode_section) is not rendered again.
+class JsonStream {
+public:
+  // Append the line for generation `s`, newline included.
+  void next(const montauk::model::Snapshot& s, std::string& out);
+
+private:
+  static constexpr size_t kSections = static_cast<size_t>(MetricsSection::Trace);
+
+  bool started_{false};
+  std::array<std::string, kSections> source_;  // what each section was last rendered from
+  std::array<std::string, kSections> members_;  // and its rendered members, "k":v,...
+  std::string scratch_;
+};
+
+} // namespace montauk::app
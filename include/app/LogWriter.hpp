@@ -10,11 +10,20 @@
 
 namespace montauk::app {
 
+// Text: hourly .prom chunks of Prometheus exposition, one block per interval.
+// Delta: the same .prom chunks, but a block holds only the series that changed
+// since the one before, with a full keyframe every minute
+// (model::PromDeltaEncoder).
+// Binary: hourly .mhist chunks in the columnar format of
+// model/HistoryBinary.hpp.
+// The --analyze paths read all three alike.
+enum class LogFormat { Text, Delta, Binary };
+
 class LogWriter {
 public:
   LogWriter(const SnapshotBuffers& buffers, std::filesystem::path log_dir,
             std::chrono::milliseconds interval = std::chrono::milliseconds(1000),
-            const TraceBuffers* trace = nullptr);
+            const TraceBuffers* trace = nullptr, LogFormat format = LogFormat::Text);
   ~LogWriter();
   LogWriter(const LogWriter&) = delete;
   LogWriter& operator=(const LogWriter&) = delete;
@@ -30,6 +39,7 @@ private:
   const TraceBuffers* trace_{nullptr};
   std::filesystem::path log_dir_;
   std::chrono::milliseconds interval_;
+  LogFormat format_;
   std::jthread thread_;
 };
 
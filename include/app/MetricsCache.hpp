@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "app/MetricsSelection.hpp"
+#include "app/SnapshotBuffers.hpp"
+#include "app/TraceBuffers.hpp"
+
+namespace montauk::app {
+
+// One rendered /metrics body. Immutable once built and handed out by
+// shared_ptr, so a request still sending it is unaffected when a newer
+// generation replaces it in the cache.
+class MetricsExposition {
+public:
+  MetricsExposition(uint64_t seq, uint64_t trace_seq, std::string text)
+      : seq_(seq), trace_seq_(trace_seq), text_(std::move(text)) {}
+
+  [[nodiscard]] uint64_t seq() const { return seq_; }
+  [[nodiscard]] uint64_t trace_seq() const { return trace_seq_; }
+  [[nodiscard]] const std::string& text() const { return text_; }
+  // The gzip copy of text(), compressed by the first request that asks for
+  // it; empty when montauk was built or runs without zlib.
+  [[nodiscard]] const std::string& gzip() const;
+
+private:
+  uint64_t seq_, trace_seq_;
+  std::string text_;
+  mutable std::once_flag gzip_once_;
+  mutable std::string gzip_;
+};
+
+// The /metrics exposition, rendered at most once per published generation.
+// Every scrape used to project and serialize the snapshot itself, so N
+// Prometheus replicas and a few curls paid for N renders of identical bytes.
+// get() compares SnapshotBuffers::seq() (and the trace buffer's) against the
+// cached render and only re-renders when one moved; concurrent requests for a
+// stale generation wait on the one render rather than each starting their own.
+// Each distinct MetricsSelection (by its key) is its own cached variant of
+// the generation, up to kMaxVariants of them; a new generation drops them all.
+class MetricsCache {
+public:
+  explicit MetricsCache(const SnapshotBuffers& buffers, const TraceBuffers* trace = nullptr)
+      : buffers_(buffers), trace_(trace) {}
+
+  static constexpr size_t kMaxVariants = 16;
+
+  [[nodiscard]] std::shared_ptr<const MetricsExposition> get(const MetricsSelection& sel = {});
+  // Renders done so far: one per generation and selection scraped, however
+  // many scrapes.
+  [[nodiscard]] uint64_t renders() const { return renders_.load(std::memory_order_relaxed); }
+
+private:
+  const SnapshotBuffers& buffers_;
+  const TraceBuffers* trace_;
+  std::mutex mu_;
+  uint64_t seq_{0}, trace_seq_{0};
+  // Oldest first; evicted from the front once kMaxVariants are cached.
+  std::vector<std::pair<std::string, std::shared_ptr<const MetricsExposition>>> variants_;
+  std::atomic<uint64_t> renders_{0};
+};
+
+} // namespace montauk::app
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "app/MetricsCache.hpp"
+
+namespace montauk::app {
+
+// The HTTP/1.1 subset the /metrics endpoint speaks, kept apart from the
+// io_uring loop in MetricsServer.cpp so it builds and is tested without
+// liburing. Requests carry no body (GET only); anything after a request's
+// blank line is the next pipelined request.
+struct HttpRequest {
+  size_t length{};                // bytes of buf the request occupies
+  std::string_view request_line;  // points into the caller's buffer
+  bool keep_alive{};              // HTTP/1.1 unless "Connection: close"; 1.0 only if asked
+  bool gzip{};                    // Accept-Encoding admits gzip
+};
+
+// True when an HTTP request's Accept-Encoding header admits gzip (and does
+// not refuse it with q=0).
+[[nodiscard]] bool accepts_gzip(std::string_view request);
+
+// The first complete request head at the front of buf, or nullopt if the
+// blank line ending it has not arrived yet.
+[[nodiscard]] std::optional<HttpRequest> parse_http_request(std::string_view buf);
+
+// One response: a head and a body the server sends with one sendmsg. body
+// points into exp (the cached exposition, kept alive until the send
+// completes) or at a static string.
+struct HttpResponse {
+  std::string head;
+  std::shared_ptr<const MetricsExposition> exp;
+  std::string_view body;
+  bool keep_alive{};
+};
+
+// Route req and fill out (reusing its head's capacity across requests on a
+// connection). /metrics and its narrower endpoints (see MetricsSelection)
+// come from the cache, gzip'd when the client allows; a malformed metrics
+// query is a 400.
+void build_http_response(const HttpRequest& req, MetricsCache& cache, HttpResponse& out);
+
+// The response to a request head that outgrew the server's buffer, after
+// which the connection is closed.
+void build_http_too_large(HttpResponse& out);
+
+} // namespace montauk::app
@@ -2,12 +2,15 @@
 
 #include "app/MetricsSink.hpp"
 #include "app/MetricsServer.hpp"
+#include "app/MetricsSelection.hpp"
 
 namespace montauk::app {
 
 // The single walk over MetricsSnapshot both snapshot_to_json and
 // snapshot_to_prometheus drive through their own MetricsSink. Every field is
 // read and visited exactly once here, regardless of which sink is attached.
-void render_snapshot(MetricsSink& sink, const MetricsSnapshot& s);
+// Sections `sel` does not want are skipped, not rendered and discarded, and
+// at most sel.top per-process rows are visited.
+void render_snapshot(MetricsSink& sink, const MetricsSnapshot& s, const MetricsSelection& sel = {});
 
 }  // namespace montauk::app
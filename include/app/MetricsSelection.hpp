@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace montauk::app {
+
+// The sections of the /metrics walk, in render order: one per render_*
+// function in MetricsRender.cpp, plus the trace snapshot.
+enum class MetricsSection : uint8_t {
+  System, Cpu, Pmu, Memory, Gpu, Thermal, Network, Disk, Filesystems,
+  Cgroups, Pressure, Providers, Processes, Trace, Count
+};
+
+// What one scrape asked for. The default selects everything, which renders
+// byte-for-byte what an unfiltered /metrics always has.
+//
+//   /metrics/system     every section but processes and trace
+//   /metrics/procs      the process section
+//   /metrics/trace      the trace snapshot
+//   ?family=A,B         only these families; a trailing * matches a prefix
+//                       (family=montauk_cpu_*); repeatable
+//   ?top=N              at most N per-process rows
+//
+// Sections none of whose families can match are skipped by the walk rather
+// than rendered and filtered; the families of the sections that do render
+// are filtered as PrometheusSink emits them.
+struct MetricsSelection {
+  static constexpr uint32_t kAllSections = (1u << static_cast<unsigned>(MetricsSection::Count)) - 1;
+
+  uint32_t sections{kAllSections};
+  std::vector<std::string> families;  // empty: every family
+  size_t top{std::numeric_limits<size_t>::max()};
+  // Canonical form of the request (path plus normalized query), empty for
+  // the default: the key MetricsCache stores the rendered variant under.
+  std::string key;
+
+  [[nodiscard]] bool wants(MetricsSection s) const;
+  // Any section of the MetricsSnapshot walk, i.e. anything but the trace.
+  [[nodiscard]] bool wants_snapshot() const;
+  [[nodiscard]] bool wants_family(std::string_view name) const;
+  [[nodiscard]] bool filters_families() const { return !families.empty(); }
+};
+
+// The family-name prefixes a section's metrics start with. Kept next to the
+// walk they describe; test_metrics_selection checks every family each
+// section emits against it.
+[[nodiscard]] std::span<const std::string_view> section_family_prefixes(MetricsSection s);
+
+enum class MetricsTarget { NotFound, BadRequest, Ok };
+
+// Parse a request target ("/metrics/procs?top=5"). NotFound for a path that
+// is not a metrics endpoint, BadRequest for an unknown or malformed query
+// parameter -- a typo'd filter must not silently return everything.
+[[nodiscard]] MetricsTarget parse_metrics_target(std::string_view target, MetricsSelection& out);
+
+} // namespace montauk::app
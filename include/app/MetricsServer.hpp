@@ -5,6 +5,8 @@
 #include <string>
 #include <algorithm>
 #include <thread>
+#include "app/MetricsCache.hpp"
+#include "app/MetricsSelection.hpp"
 #include "app/SnapshotBuffers.hpp"
 #include "app/TraceBuffers.hpp"
 #include "model/Snapshot.hpp"
@@ -41,8 +43,9 @@ struct AnomalyFeatureRow {
   std::array<char, 16> comm{};
 };
 
-// Bounded snapshot for metrics serialization.
-// Fixed-size top_procs array: no heap allocation during seqlock copy.
+// Bounded snapshot for metrics serialization. top_procs is the first
+// MAX_TOP_PROCS rows of the process table, copied as flat columns; its strings
+// stay in the collector's pool.
 struct MetricsSnapshot {
   montauk::model::CpuSnapshot cpu;
   montauk::model::PmuSnapshot pmu;
@@ -51,13 +54,18 @@ struct MetricsSnapshot {
   montauk::model::NetSnapshot net;
   montauk::model::DiskSnapshot disk;
   montauk::model::FsSnapshot fs;
+  montauk::model::CgroupSnapshot cgroups;
+  montauk::model::PsiSnapshot psi;
   std::vector<montauk::model::Provider> providers;
   montauk::model::Thermal thermal;
   size_t total_processes{}, running_processes{};
   size_t state_sleeping{}, state_zombie{}, total_threads{};
+  uint64_t proc_sample_us{};
+  size_t proc_scan_shards{1};
+  // Short-lived processes that exited in the last 30-60 s, by comm.
+  std::vector<montauk::model::ExitedComm> exited;
   static constexpr int MAX_TOP_PROCS = 64;
-  std::array<montauk::model::ProcSample, MAX_TOP_PROCS> top_procs{};
-  int top_procs_count{};
+  montauk::model::ProcessSnapshot top_procs;
   // The full population the anomaly fusion ran over (up to max_procs), so the
   // emitted score is reproducible against the same set it was judged against.
   std::vector<AnomalyFeatureRow> anomaly_features;
@@ -65,15 +73,16 @@ struct MetricsSnapshot {
   uint32_t anomaly_axis_mask{};
 };
 
-// Serialize a MetricsSnapshot into Prometheus text exposition format (version 0.0.4).
-[[nodiscard]] std::string snapshot_to_prometheus(const MetricsSnapshot& snap);
+// Serialize a MetricsSnapshot into Prometheus text exposition format (version 0.0.4),
+// or the part of it `sel` asks for.
+[[nodiscard]] std::string snapshot_to_prometheus(const MetricsSnapshot& snap, const MetricsSelection& sel = {});
 
 // Serialize a MetricsSnapshot into one structured JSON object (see JsonSerializer.cpp).
 // The `montauk --json` one-shot surface: an agent reads live system state as JSON.
 [[nodiscard]] std::string snapshot_to_json(const MetricsSnapshot& snap);
 
 // Serialize a TraceSnapshot into Prometheus text exposition format.
-[[nodiscard]] std::string trace_to_prometheus(const montauk::model::TraceSnapshot& snap);
+[[nodiscard]] std::string trace_to_prometheus(const montauk::model::TraceSnapshot& snap, const MetricsSelection& sel = {});
 
 // Serialize a TraceSnapshot into one structured JSON object (see TraceRender.cpp).
 [[nodiscard]] std::string trace_to_json(const montauk::model::TraceSnapshot& snap);
@@ -83,57 +92,71 @@ struct MetricsSnapshot {
   return buffers.read([](const montauk::model::TraceSnapshot& s) { return s; });
 }
 
-// Read a bounded MetricsSnapshot from SnapshotBuffers under the reuse guard.
-[[nodiscard]] inline MetricsSnapshot read_metrics_snapshot(const SnapshotBuffers& buffers) {
-  return buffers.read([](const montauk::model::Snapshot& s) {
-    MetricsSnapshot ms{};
-    ms.cpu = s.cpu;
-    ms.pmu = s.pmu;
-    ms.mem = s.mem;
-    ms.vram = s.vram;
-    ms.net = s.net;
-    ms.disk = s.disk;
-    ms.fs = s.fs;
-    ms.providers = s.providers;
-    ms.thermal = s.thermal;
-    ms.total_processes = s.procs.total_processes;
-    ms.running_processes = s.procs.running_processes;
-    ms.state_sleeping = s.procs.state_sleeping;
-    ms.state_zombie = s.procs.state_zombie;
-    ms.total_threads = s.procs.total_threads;
-    int n = std::min(static_cast<int>(s.procs.processes.size()), MetricsSnapshot::MAX_TOP_PROCS);
-    std::copy_n(s.procs.processes.begin(), n, ms.top_procs.begin());
-    ms.top_procs_count = n;
-    // Carry the FULL fused population's features (not just the displayed top_procs)
-    // so the anomaly score is reproducible against the same set it was judged on.
-    ms.anomaly_axis_mask = s.procs.anomaly_axis_mask;
-    ms.anomaly_features.reserve(s.procs.processes.size());
-    for (const auto& p : s.procs.processes) {
-      AnomalyFeatureRow row{p.pid, p.cpu_pct, static_cast<double>(p.rss_kb),
-                            p.has_gpu_util ? p.gpu_util_pct : 0.0,
-                            p.fault_delta, static_cast<double>(p.thread_count),
-                            p.ctxsw_delta, p.anomaly_score, p.anomaly_axis, {}};
-      // The PROGRAM, not the first 15 bytes of a command line. p.cmd is the
-      // full cmdline for enriched rows, so a raw truncation yields things like
-      // "python3 -c \nimp" -- a cut mid-argument, newline included. Take the
-      // first token, and its basename when that token is an absolute path
-      // (/usr/lib/firefox/firefox -> firefox). Kernel threads like
-      // "kworker/4:0H" carry slashes but no leading one, so they pass through.
-      std::string_view name{p.cmd};
-      name = name.substr(0, name.find_first_of(" \t\n"));
-      if (name.starts_with('/')) {
-        const size_t slash = name.find_last_of('/');
-        if (slash != std::string_view::npos && slash + 1 < name.size())
-          name = name.substr(slash + 1);
-      }
-      const size_t n_cmd = std::min(name.size(), row.comm.size() - 1);
-      std::copy_n(name.begin(), n_cmd, row.comm.begin());
-      ms.anomaly_features.push_back(row);
+// Project one Snapshot generation into a bounded MetricsSnapshot.
+[[nodiscard]] inline MetricsSnapshot project_metrics_snapshot(const montauk::model::Snapshot& s) {
+  MetricsSnapshot ms{};
+  ms.cpu = s.cpu;
+  ms.pmu = s.pmu;
+  ms.mem = s.mem;
+  ms.vram = s.vram;
+  ms.net = s.net;
+  ms.disk = s.disk;
+  ms.fs = s.fs;
+  ms.cgroups = s.cgroups;
+  ms.psi = s.psi;
+  ms.providers = s.providers;
+  ms.thermal = s.thermal;
+  ms.total_processes = s.procs.total_processes;
+  ms.running_processes = s.procs.running_processes;
+  ms.state_sleeping = s.procs.state_sleeping;
+  ms.state_zombie = s.procs.state_zombie;
+  ms.total_threads = s.procs.total_threads;
+  ms.proc_sample_us = s.procs.sample_us;
+  ms.proc_scan_shards = s.procs.scan_shards;
+  ms.exited = s.procs.exited;
+  const auto& ps = s.procs;
+  ms.top_procs.assign_prefix(ps, MetricsSnapshot::MAX_TOP_PROCS);
+  // Carry the FULL fused population's features (not just the displayed top_procs)
+  // so the anomaly score is reproducible against the same set it was judged on.
+  ms.anomaly_axis_mask = ps.anomaly_axis_mask;
+  ms.anomaly_features.reserve(ps.size());
+  for (size_t i = 0; i < ps.size(); ++i) {
+    AnomalyFeatureRow row{ps.pid[i], ps.cpu_pct[i], static_cast<double>(ps.rss_kb[i]),
+                          ps.has_gpu_util[i] ? ps.gpu_util_pct[i] : 0.0,
+                          ps.fault_delta[i], static_cast<double>(ps.thread_count[i]),
+                          ps.ctxsw_delta[i], ps.anomaly_score[i], ps.anomaly_axis[i], {}};
+    // The PROGRAM, not the first 15 bytes of a command line. p.cmd is the
+    // full cmdline for enriched rows, so a raw truncation yields things like
+    // "python3 -c \nimp" -- a cut mid-argument, newline included. Take the
+    // first token, and its basename when that token is an absolute path
+    // (/usr/lib/firefox/firefox -> firefox). Kernel threads like
+    // "kworker/4:0H" carry slashes but no leading one, so they pass through.
+    std::string_view name{ps.cmd_of(i)};
+    name = name.substr(0, name.find_first_of(" \t\n"));
+    if (name.starts_with('/')) {
+      const size_t slash = name.find_last_of('/');
+      if (slash != std::string_view::npos && slash + 1 < name.size())
+        name = name.substr(slash + 1);
     }
-    return ms;
-  });
+    const size_t n_cmd = std::min(name.size(), row.comm.size() - 1);
+    std::copy_n(name.begin(), n_cmd, row.comm.begin());
+    ms.anomaly_features.push_back(row);
+  }
+  return ms;
 }
 
+// Project the current Snapshot generation. The generation is immutable and
+// held by refcount, so the projection runs without any lock the Producer could
+// wait on.
+[[nodiscard]] inline MetricsSnapshot read_metrics_snapshot(const SnapshotBuffers& buffers) {
+  return buffers.read(project_metrics_snapshot);
+}
+
+// The Prometheus endpoint: one io_uring event loop serving every scraper.
+// Multishot accept feeds a bounded connection table; each connection has one
+// recv or send in flight at a time, speaks HTTP/1.1 keep-alive and carries
+// its own deadline, so a slow or idle client costs a slot, never the other
+// scrapers' latency. Bodies come from the per-generation MetricsCache.
 class MetricsServer {
 public:
   MetricsServer(const SnapshotBuffers& buffers, uint16_t port,
@@ -145,12 +168,17 @@ public:
   void start();
   void stop();
 
+  static constexpr size_t kMaxConns = 512;    // connections beyond this are closed on accept
+  static constexpr size_t kRequestMax = 8192;  // request head bytes; larger gets a 431
+  static constexpr int kIoTimeoutSec = 5;      // to finish a request or a response
+  static constexpr int kIdleTimeoutSec = 120;  // between keep-alive requests
+
 private:
   void run(std::stop_token st);
-  void handle_client(int client_fd);
 
   const SnapshotBuffers& buffers_;
   const TraceBuffers* trace_{nullptr};
+  MetricsCache cache_;  // the exposition, rendered once per generation
   uint16_t port_;
   int listen_fd_{-1};
   int stop_eventfd_{-1};
@@ -0,0 +1,31 @@
+#pragma once
+#include <chrono>
+#include "model/Snapshot.hpp"
+
+namespace montauk::app {
+
+// The --json / --anomalies / --similar fast path. The Producer is built for a
+// long-running monitor: it starts the GPU, filesystem, provider and thermal
+// workers (NVML init included), warms up, and a one-shot then had to sit out a
+// whole kProcessInterval before its per-process cpu_pct meant anything -- over
+// a second per invocation, paid on every host a fleet tool shells out to.
+//
+// sample_one_shot() fills `out` from two passes of the collectors the JSON
+// rate fields need, `window` apart, with per-process CPU from schedstat run
+// time (nanoseconds, so a 50 ms window is as sound as a 1 s tick window). The
+// non-rate collectors run inside the window instead of the caller sleeping
+// through it. Nothing GPU, NVML, provider, PMU or BPF is touched: those
+// sections of the snapshot stay empty. Without schedstat the window widens to
+// Producer::kProcessInterval, the tick-accounting floor.
+struct OneShotStats {
+  std::chrono::microseconds window{};  // measured between the two process passes
+  std::chrono::microseconds total{};   // the whole call
+  bool schedstat{false};               // false: fell back to clock ticks
+};
+
+inline constexpr std::chrono::milliseconds kOneShotWindow{50};
+
+OneShotStats sample_one_shot(montauk::model::Snapshot& out,
+                             std::chrono::milliseconds window = kOneShotWindow);
+
+} // namespace montauk::app
@@ -7,6 +7,7 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include "app/CollectorWorker.hpp"
 #include "app/SnapshotBuffers.hpp"
 #include "collectors/MemoryCollector.hpp"
 #include "collectors/GpuCollector.hpp"
@@ -15,8 +16,11 @@
 #include "collectors/NetCollector.hpp"
 #include "collectors/DiskCollector.hpp"
 #include "collectors/FsCollector.hpp"
+#include "collectors/CgroupCollector.hpp"
+#include "collectors/PsiCollector.hpp"
 #include "collectors/ProviderCollector.hpp"
 #include "collectors/IProcessCollector.hpp"
+#include "collectors/ProcIoPssSampler.hpp"
 #include "app/Alerts.hpp"
 #include "collectors/ThermalCollector.hpp"
 
@@ -31,7 +35,16 @@ public:
   // the hot-start warm-up pre-samples a few ticks apart, and at that width the
   // whole-jiffy quantization dominates (one jiffy of error is most of the
   // window), which is what makes a one-shot read far above 100% per core.
+  // That holds for clock-tick accounting; with [process] cpu_accounting =
+  // "schedstat" the window can shrink to kSchedstatInterval (see
+  // process_interval()).
   static constexpr std::chrono::milliseconds kProcessInterval{1000};
+  static constexpr std::chrono::milliseconds kSchedstatInterval{250};
+  static constexpr std::chrono::milliseconds kMinProcessInterval{100};
+
+  // The per-process cadence in effect: [process] interval_ms, or the default
+  // for the configured accounting.
+  std::chrono::milliseconds process_interval() const noexcept { return proc_interval_; }
 
   explicit Producer(SnapshotBuffers& buffers);
   void start();
@@ -65,11 +78,18 @@ public:
   // unlucky one catches a whole jiffy and reads far above 100% per core). A
   // consumer that needs a trustworthy per-process cpu_pct -- the --json
   // one-shot -- waits for this to advance past its post-warm-up value, which
-  // only a steady-loop sample a full kProcessInterval later can do.
+  // only a steady-loop sample a full process_interval() later can do.
   uint64_t process_samples() const noexcept {
     return process_samples_.load(std::memory_order_acquire);
   }
 
+  // Times the collection loop has woken since start(); --self-test reports
+  // the rate.
+  uint64_t wakeups() const noexcept { return wakeups_.load(std::memory_order_relaxed); }
+
+  // Times a PSI stall trigger woke the loop out of cadence.
+  uint64_t psi_wakes() const noexcept { return psi_wakes_.load(std::memory_order_relaxed); }
+
 #ifdef MONTAUK_TESTING
   // Test-only helper: apply a set of per-process GPU samples (pid->util%)
   // to the given ProcessSnapshot while updating the rolling cache. A TTL
@@ -95,14 +115,28 @@ private:
   // snapshot, and the collector keeps existing attachments untouched.
   void refresh_pmu_targets(const montauk::model::ProcessSnapshot& procs);
   std::atomic<uint64_t> process_samples_{0};  // see process_samples()
+  std::atomic<uint64_t> wakeups_{0};          // see wakeups()
+  std::atomic<uint64_t> psi_wakes_{0};        // see psi_wakes()
+  std::chrono::milliseconds proc_interval_{kProcessInterval};  // see process_interval()
+  // proc_->sample() plus the bookkeeping every call site wants: stamps the
+  // pass's wall time on the snapshot and bumps process_samples_.
+  void sample_procs(montauk::model::ProcessSnapshot& procs);
+  std::chrono::steady_clock::time_point last_proc_sample_{};  // set by sample_procs()
   montauk::collectors::MemoryCollector mem_{};
   montauk::collectors::GpuCollector gpu_{};
   montauk::collectors::NetCollector net_{};
   montauk::collectors::DiskCollector disk_{};
   montauk::collectors::FsCollector fs_{};
+  montauk::collectors::CgroupCollector cgroups_{};
+  // Read inline: a handful of pread()s on fds it keeps open. Its stall
+  // triggers wake run() directly (see there).
+  montauk::collectors::PsiCollector psi_;
   montauk::collectors::ProviderCollector providers_{};
   // Process collector (event-driven if available, else traditional)
   std::unique_ptr<montauk::collectors::IProcessCollector> proc_;
+  // Per-process I/O rate and PSS over the published rows, under [process]
+  // io_budget_us per pass; null when that is 0.
+  std::unique_ptr<montauk::collectors::ProcIoPssSampler> io_pss_;
   montauk::app::AlertEngine alerts_{};
   montauk::collectors::ThermalCollector thermal_{};
   // Rolling cache of per-process GPU util with a short TTL to avoid flicker between NVML sample windows (test helper)
@@ -114,6 +148,25 @@ private:
   std::unordered_map<int32_t, uint64_t> anomaly_prev_ctxsw_;
   // Unified GPU attributor (NVML + fdinfo)
   std::unique_ptr<montauk::app::GpuAttributor> gpu_attr_;
+  // The collectors that can block -- NVML, statvfs on network mounts,
+  // provider sockets, hwmon/powercap sysfs -- each sample on their own thread;
+  // run() merges their latest result at publish time. Declared after the
+  // collectors they call so they are joined before those are destroyed.
+  CollectorWorker<montauk::model::GpuVram> gpu_worker_{
+      std::chrono::milliseconds{1000}, [this](montauk::model::GpuVram& v) { (void)gpu_.sample(v); },
+      std::chrono::milliseconds{150}};
+  CollectorWorker<montauk::model::FsSnapshot> fs_worker_{
+      std::chrono::milliseconds{5000}, [this](montauk::model::FsSnapshot& f) { (void)fs_.sample(f); }};
+  // Rates, so the first gap is short enough for the warm-up to see two.
+  CollectorWorker<montauk::model::CgroupSnapshot> cgroup_worker_{
+      std::chrono::milliseconds{1000}, [this](montauk::model::CgroupSnapshot& c) { (void)cgroups_.sample(c); },
+      std::chrono::milliseconds{150}};
+  CollectorWorker<std::vector<montauk::model::Provider>> prov_worker_{
+      std::chrono::milliseconds{1000},
+      [this](std::vector<montauk::model::Provider>& p) { (void)providers_.sample(p); }};
+  CollectorWorker<montauk::model::Thermal> therm_worker_{
+      std::chrono::milliseconds{2000}, [this](montauk::model::Thermal& t) { (void)thermal_.sample(t); },
+      std::chrono::milliseconds{150}};
 };
 
 #ifdef MONTAUK_TESTING
@@ -124,14 +177,14 @@ inline void Producer::test_apply_gpu_samples(const std::unordered_map<int,int>&
     last_proc_gpu_[kv.first] = std::make_pair(kv.second, now_tp);
   }
   const auto ttl = std::chrono::milliseconds(2000);
-  for (auto& p : procs.processes) {
-    auto it = pid_to_gpu.find(p.pid);
+  for (size_t i = 0; i < procs.size(); ++i) {
+    auto it = pid_to_gpu.find(procs.pid[i]);
     if (it != pid_to_gpu.end()) {
-      p.has_gpu_util = true; p.gpu_util_pct = (double)it->second; continue;
+      procs.has_gpu_util[i] = true; procs.gpu_util_pct[i] = (double)it->second; continue;
     }
-    auto it2 = last_proc_gpu_.find(p.pid);
+    auto it2 = last_proc_gpu_.find(procs.pid[i]);
     if (it2 != last_proc_gpu_.end() && (now_tp - it2->second.second) <= ttl) {
-      p.has_gpu_util = true; p.gpu_util_pct = (double)it2->second.first; continue;
+      procs.has_gpu_util[i] = true; procs.gpu_util_pct[i] = (double)it2->second.first; continue;
     }
   }
   for (auto it = last_proc_gpu_.begin(); it != last_proc_gpu_.end(); ) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "app/MetricsSelection.hpp"
 #include "app/MetricsSink.hpp"
 
 #include <string>
@@ -12,8 +13,14 @@ namespace montauk::app {
 // formatting helpers (PrometheusSink.cpp's anonymous-namespace functions)
 // moved here verbatim from the old PrometheusSerializer.cpp, so the bytes
 // this produces are unchanged; only who calls them changed.
+//
+// With a filter, families MetricsSelection::wants_family() rejects are
+// dropped before they are formatted, and provider passthrough is filtered
+// line by line by the family each line belongs to.
 class PrometheusSink : public MetricsSink {
 public:
+  explicit PrometheusSink(const MetricsSelection* filter = nullptr) : filter_(filter) {}
+
   void section_begin(const char* json_key) override;
   void section_end() override;
 
@@ -46,11 +53,17 @@ private:
   };
 
   Family& family_for(const MetricDesc& d);
+  bool drops(const char* prom_name);
   void flush_families();
 
   std::string out_;
   std::vector<Family> pending_;
   int collection_depth_{0};
+  const MetricsSelection* filter_;
+  // Per-process families repeat one MetricDesc per row; remember the verdict
+  // for the last name rather than re-matching it every line.
+  const char* last_name_{nullptr};
+  bool last_drop_{false};
 };
 
 }  // namespace montauk::app
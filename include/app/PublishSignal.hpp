@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace montauk::app {
+
+// Publish notification for consumers that would otherwise poll seq(). Each
+// waiter owns its own eventfd, so one consumer draining it never eats another
+// consumer's wakeup, and the fd drops straight into a poll set next to
+// sockets. notify() is one 8-byte write per attached waiter; the mutex only
+// ever contends with a waiter attaching or detaching, never with a read.
+class PublishSignal {
+public:
+  void notify() {
+    std::lock_guard lk(mu_);
+    const uint64_t one = 1;
+    for (int fd : fds_) {
+      // Non-blocking and a 64-bit counter: the write cannot stall the writer.
+      [[maybe_unused]] ssize_t r = ::write(fd, &one, sizeof(one));
+    }
+  }
+
+private:
+  friend class PublishWaiter;
+  void attach(int fd) {
+    std::lock_guard lk(mu_);
+    fds_.push_back(fd);
+  }
+  void detach(int fd) {
+    std::lock_guard lk(mu_);
+    fds_.erase(std::remove(fds_.begin(), fds_.end(), fd), fds_.end());
+  }
+
+  std::mutex mu_;
+  std::vector<int> fds_;
+};
+
+// One consumer's subscription: readable after every publish() since the last
+// drain(), and after wake() (the stop path). fd() is -1 if eventfd failed;
+// wait() then degrades to a timed sleep, 5 ms when asked to wait forever.
+class PublishWaiter {
+public:
+  explicit PublishWaiter(PublishSignal& sig)
+      : sig_(sig), fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (fd_ >= 0) sig_.attach(fd_);
+  }
+  ~PublishWaiter() {
+    if (fd_ < 0) return;
+    sig_.detach(fd_);
+    ::close(fd_);
+  }
+  PublishWaiter(const PublishWaiter&) = delete;
+  PublishWaiter& operator=(const PublishWaiter&) = delete;
+
+  [[nodiscard]] int fd() const { return fd_; }
+
+  // Wake the waiting thread without a publish; safe from any thread.
+  void wake() {
+    const uint64_t one = 1;
+    if (fd_ < 0) return;
+    [[maybe_unused]] ssize_t r = ::write(fd_, &one, sizeof(one));
+  }
+
+  void drain() {
+    uint64_t v;
+    if (fd_ < 0) return;
+    [[maybe_unused]] ssize_t r = ::read(fd_, &v, sizeof(v));
+  }
+
+  // Block until notified or timeout_ms passes (-1: no timeout). Drains, so
+  // the next wait() blocks again; callers re-check seq() and their stop flag.
+  void wait(int timeout_ms) {
+    if (fd_ < 0 && timeout_ms < 0) timeout_ms = 5;
+    pollfd p{fd_, POLLIN, 0};
+    if (::poll(&p, 1, timeout_ms) > 0) drain();
+  }
+
+private:
+  PublishSignal& sig_;
+  int fd_;
+};
+
+} // namespace montauk::app
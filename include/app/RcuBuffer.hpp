@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "app/PublishSignal.hpp"
+
+namespace montauk::app {
+
+// Read-copy-update publication, generic over any copyable T carrying a
+// `uint64_t seq` member. Same writer-side shape as DoubleBuffer (fill back(),
+// then publish()) but readers never copy and the writer never waits.
+//
+// The writer keeps one private working T that collectors accumulate into
+// across loop iterations. publish() copies it into a fresh immutable
+// generation -- one copy per publish, paid on the Producer thread -- and swaps
+// that in as the current one. acquire() hands out a shared_ptr to the current
+// generation: O(1), a refcount bump, no lock held while the reader uses it.
+// A generation is freed when the last reader holding it lets go, so a slow
+// /metrics scrape pins only its own generation and never the writer.
+//
+// The swap itself is std::atomic<std::shared_ptr>; libstdc++ guards it with a
+// spin bit held for a refcount update, not for anything a reader does with
+// the snapshot afterwards.
+template <typename T>
+class RcuBuffer {
+public:
+  using Ptr = std::shared_ptr<const T>;
+
+  RcuBuffer() : front_(std::make_shared<const T>()) {}
+  RcuBuffer(const RcuBuffer&) = delete;
+  RcuBuffer& operator=(const RcuBuffer&) = delete;
+
+  // The writer's working copy. Only the publishing thread touches it.
+  [[nodiscard]] T& back() { return work_; }
+  // Kept for DoubleBuffer's writer shape; there is nothing to lock.
+  [[nodiscard]] T& begin_write() { return work_; }
+
+  void publish() {
+    const uint64_t next = seq_.load(std::memory_order_relaxed) + 1;
+    work_.seq = next;
+    front_.store(std::make_shared<const T>(work_), std::memory_order_release);
+    seq_.store(next, std::memory_order_release);
+    signal_.notify();
+  }
+
+  // The current generation; stays valid (and unchanged) for as long as the
+  // caller holds it, however many publishes land meanwhile.
+  [[nodiscard]] Ptr acquire() const { return front_.load(std::memory_order_acquire); }
+
+  // DoubleBuffer-compatible read: fn runs on the acquired generation, no lock.
+  template <typename Fn>
+  [[nodiscard]] auto read(Fn&& fn) const {
+    const Ptr p = acquire();
+    return fn(*p);
+  }
+
+  [[nodiscard]] uint64_t seq() const { return seq_.load(std::memory_order_acquire); }
+
+  // Fires after every publish(); consumers block on a PublishWaiter over it
+  // instead of polling seq(). Subscribing does not write the buffer, hence
+  // reachable through a const reference.
+  [[nodiscard]] PublishSignal& signal() const { return signal_; }
+
+private:
+  alignas(64) T work_{};
+  alignas(64) std::atomic<Ptr> front_;
+  std::atomic<uint64_t> seq_{0};
+  mutable PublishSignal signal_;
+};
+
+} // namespace montauk::app
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include "app/SnapshotBuffers.hpp"
+#include "util/shm_snapshot.h"
+
+namespace montauk::app {
+
+// Publishes every Snapshot generation into a shared-memory segment in the
+// fixed layout of util/shm_snapshot.h, under its seqlock, for local readers
+// that want the latest CPU/memory/process table without a socket or a parse.
+//
+// The segment is a named file (normally under /dev/shm) rather than an
+// anonymous memfd, so an unrelated sidecar can open it by path. It is created
+// or reused in place, sized to one montauk_shm_segment; the magic goes in
+// last so a reader never validates a half-initialized header. On stop the
+// LIVE flag is cleared and the file is left for readers still mapping it.
+class ShmExporter {
+public:
+  ShmExporter(const SnapshotBuffers& buffers, std::filesystem::path path);
+  ~ShmExporter();
+  ShmExporter(const ShmExporter&) = delete;
+  ShmExporter& operator=(const ShmExporter&) = delete;
+
+  // Create and map the segment; false (logged) if it cannot be.
+  [[nodiscard]] bool open();
+  void start();
+  void stop();
+
+  // Write one generation into the segment under the seqlock. The run loop's
+  // step; public for tests.
+  void publish(const montauk::model::Snapshot& s);
+
+  // Project a Snapshot onto the fixed layout: CPU, memory, process counts and
+  // the first MONTAUK_SHM_MAX_PROCS rows (already cpu_pct descending).
+  static void fill(const montauk::model::Snapshot& s, montauk_shm_data& out);
+
+private:
+  void run(std::stop_token st);
+  void close();
+
+  const SnapshotBuffers& buffers_;
+  std::filesystem::path path_;
+  int lock_fd_{-1};  // holds the flock that makes this the only writer
+  montauk_shm_segment* seg_{nullptr};
+  // Built off to the side so the seqlock window is one memcpy, not the
+  // projection. Heap-held: it is some 66 KiB.
+  std::unique_ptr<montauk_shm_data> staging_;
+  std::jthread thread_;
+};
+
+} // namespace montauk::app
@@ -1,11 +1,12 @@
 #pragma once
-#include "app/DoubleBuffer.hpp"
+#include "app/RcuBuffer.hpp"
 #include "model/Snapshot.hpp"
 
 namespace montauk::app {
 
-// Lock-free double buffer for Snapshot
-using SnapshotBuffers = DoubleBuffer<montauk::model::Snapshot>;
+// Immutable, refcounted Snapshot generations (see RcuBuffer.hpp). Readers
+// acquire() the current one; the Producer never waits on them.
+using SnapshotBuffers = RcuBuffer<montauk::model::Snapshot>;
 
 static_assert(alignof(SnapshotBuffers) >= 64,
               "SnapshotBuffers must be cache-line aligned for lock-free publishing");
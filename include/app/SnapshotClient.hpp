@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <stop_token>
+#include <thread>
+#include "app/SnapshotBuffers.hpp"
+#include "app/SnapshotCodec.hpp"
+
+namespace montauk::app {
+
+// `--attach SOCKET`: the viewer half of SnapshotServer. Reads frames off the
+// socket, applies them to the SnapshotBuffers working copy and publishes, so
+// everything downstream -- the TUI, --log, --metrics -- runs exactly as it
+// does over a local Producer, which an attached montauk never starts.
+class SnapshotClient {
+public:
+  SnapshotClient(SnapshotBuffers& buffers, std::filesystem::path path);
+  ~SnapshotClient();
+  SnapshotClient(const SnapshotClient&) = delete;
+  SnapshotClient& operator=(const SnapshotClient&) = delete;
+
+  // Connect; false (logged) if no server is listening there.
+  [[nodiscard]] bool connect();
+  void start();
+  void stop();
+
+  // False once the server hung up or sent a frame that did not decode.
+  [[nodiscard]] bool connected() const { return connected_.load(std::memory_order_acquire); }
+  [[nodiscard]] uint64_t frames() const { return frames_.load(std::memory_order_relaxed); }
+
+private:
+  void run(std::stop_token st);
+
+  SnapshotBuffers& buffers_;
+  std::filesystem::path path_;
+  int fd_{-1};
+  SnapshotDecoder decoder_;
+  std::atomic<bool> connected_{false};
+  std::atomic<uint64_t> frames_{0};
+  std::jthread thread_;
+};
+
+} // namespace montauk::app
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "model/Snapshot.hpp"
+
+namespace montauk::app {
+
+// Binary wire form of a Snapshot for `--serve` / `--attach`: one montauk
+// collects, any number of viewers decode and render.
+//
+// A Snapshot is encoded once per generation into sections (cpu, memory, net,
+// ... one per top-level member) plus one byte string per process row. A frame
+// carries a generation relative to a base the receiver already holds: only
+// the sections whose bytes changed, and for each row either the row or a
+// reference to an identical row of the base. A keyframe is a frame against no
+// base. Idle processes -- most of the table -- cost four bytes a tick.
+//
+// Native byte order and field widths: the format is for a local socket, both
+// ends the same build. The version in every frame header guards that.
+//
+// Frame: u32 payload length, then the payload --
+//   u32 magic, u16 version, u8 kind (0 key, 1 delta), u8 0,
+//   u64 seq, u64 base_seq, u32 section mask,
+//   per set bit: u32 length + section bytes,
+//   u32 rows, per row: u32 tag -- kRowRef | base index, or the length of
+//   the row bytes that follow.
+inline constexpr uint32_t kFrameMagic = 0x534b544d;  // "MTKS"
+inline constexpr uint16_t kFrameVersion = 1;
+inline constexpr uint32_t kFrameMax = 64u << 20;     // a receiver rejects more
+inline constexpr uint32_t kRowRef = 0x80000000u;
+
+enum class SnapshotSection : uint8_t {
+  Cpu, Pmu, Mem, Vram, Net, Disk, Fs, Cgroups, Psi, Providers, Alerts,
+  Thermal, Nvml, Misc, ProcHead, Count
+};
+inline constexpr size_t kSnapshotSections = static_cast<size_t>(SnapshotSection::Count);
+
+// One generation, encoded; what the server keeps per generation and diffs
+// every client's frame against.
+struct EncodedSnapshot {
+  uint64_t seq{};
+  std::array<std::string, kSnapshotSections> sections;
+  std::vector<int32_t> row_pid;
+  std::vector<std::string> rows;
+};
+
+[[nodiscard]] EncodedSnapshot encode_snapshot(const montauk::model::Snapshot& s);
+
+// One section's bytes, replacing out. Equal bytes mean an equal section, so a
+// consumer can tell an untouched section without rendering it.
+void encode_section(const montauk::model::Snapshot& s, SnapshotSection id, std::string& out);
+
+// Append the frame taking a receiver from base to cur; base null = keyframe.
+void encode_frame(const EncodedSnapshot& cur, const EncodedSnapshot* base, std::string& out);
+
+// Receiver side. Applies payloads (the bytes after the length prefix) in
+// order to a Snapshot it owns; sections a delta leaves out keep their values.
+class SnapshotDecoder {
+public:
+  // false on a malformed payload or a delta against a base this decoder does
+  // not hold; out may then be partly updated and the stream is unusable.
+  [[nodiscard]] bool apply(std::string_view payload, montauk::model::Snapshot& out);
+  // seq of the last generation applied; 0 before the first keyframe.
+  [[nodiscard]] uint64_t seq() const { return seq_; }
+
+private:
+  uint64_t seq_{0};
+  std::vector<montauk::model::ProcSample> rows_;
+};
+
+} // namespace montauk::app
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+#include "app/SnapshotBuffers.hpp"
+#include "app/SnapshotCodec.hpp"
+
+namespace montauk::app {
+
+// `--serve SOCKET`: streams this montauk's snapshots to any number of
+// `--attach SOCKET` viewers over a unix socket, so a box with five people
+// watching it pays for collection once (see SnapshotCodec for the frames).
+//
+// Each generation is encoded once. A client gets a frame only once its
+// previous one has fully left the socket, and that frame goes from the last
+// generation it was sent straight to the newest: a slow viewer skips
+// generations rather than queueing them, and never holds more than one frame
+// of the server's memory. Frames against the same base are built once per
+// generation and shared. A client whose base has aged out of the short
+// history gets a keyframe. One poll() thread serves the listener and every
+// client; nothing here blocks the Producer.
+class SnapshotServer {
+public:
+  SnapshotServer(const SnapshotBuffers& buffers, std::filesystem::path path);
+  ~SnapshotServer();
+  SnapshotServer(const SnapshotServer&) = delete;
+  SnapshotServer& operator=(const SnapshotServer&) = delete;
+
+  // Bind the socket and spawn the serve thread; false (logged) on failure,
+  // including when the path is a live server's socket or not a socket. A
+  // stale socket left by a previous run is replaced.
+  [[nodiscard]] bool start();
+  void stop();
+
+  [[nodiscard]] size_t clients() const { return nclients_.load(std::memory_order_relaxed); }
+  // Frames sent and generations skipped, over every client so far.
+  [[nodiscard]] uint64_t frames_sent() const { return frames_.load(std::memory_order_relaxed); }
+  [[nodiscard]] uint64_t generations_skipped() const { return skipped_.load(std::memory_order_relaxed); }
+
+  static constexpr size_t kMaxClients = 64;
+  static constexpr size_t kHistory = 8;  // generations kept as delta bases
+
+private:
+  struct Client {
+    int fd{-1};
+    uint64_t sent_seq{0};  // generation the client has (or will have once out drains)
+    std::shared_ptr<const std::string> out;
+    size_t off{0};
+  };
+
+  void serve(std::stop_token st);
+  void accept_clients();
+  void refresh();
+  void feed(Client& c);
+  // Send what the socket takes; false once the client is gone.
+  bool flush(Client& c);
+  [[nodiscard]] const EncodedSnapshot* history(uint64_t seq) const;
+
+  const SnapshotBuffers& buffers_;
+  std::filesystem::path path_;
+  int listen_fd_{-1};
+  std::vector<Client> clients_;
+  std::deque<EncodedSnapshot> history_;  // oldest first; back() is current
+  // Frames of the current generation, by base seq (0 = keyframe).
+  std::vector<std::pair<uint64_t, std::shared_ptr<const std::string>>> frames_cache_;
+  std::atomic<size_t> nclients_{0};
+  std::atomic<uint64_t> frames_{0};
+  std::atomic<uint64_t> skipped_{0};
+  std::jthread thread_;
+};
+
+} // namespace montauk::app
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "collectors/IProcessCollector.hpp"
+#include "collectors/ProcessTree.hpp"
+#include "collectors/TaskIterRecords.hpp"
+#include "util/ProcIdentityCache.hpp"
+#include "util/Procfs.hpp"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct montauk_procs_bpf;
+struct bpf_link;
+
+namespace montauk::collectors {
+
+// Process collector over a BPF task iterator (src/bpf/montauk_procs.bpf.c).
+// Each sample drives one pass of the iterator, which writes a packed record
+// per task -- ids, state, ns CPU time, RSS, thread count, context switches,
+// faults, start time, comm -- and reads it back off a single fd in large
+// chunks: no per-pid /proc files for the scan at all. cpu_pct comes from
+// sum_exec_runtime over wall time, so it has CpuClock::Schedstat's resolution
+// whatever the configured clock. Only the kept top-K rows touch /proc, once
+// per process image, for the cmdline and exe path the iterator does not carry.
+//
+// init() fails -- and Producer falls back to netlink, then procfs -- when the
+// build has no BPF, libbpf cannot be loaded, or the program is refused
+// (no CAP_BPF/CAP_PERFMON, no BTF, kernel before 5.8).
+class BpfIterProcessCollector : public IProcessCollector {
+public:
+  explicit BpfIterProcessCollector(size_t max_procs = 256, size_t enrich_top_n = 256);
+  ~BpfIterProcessCollector() override;
+
+  bool init() override;
+  void shutdown() override;
+  bool sample(montauk::model::ProcessSnapshot& out) override;
+  const char* name() const override { return "BPF Task Iterator"; }
+
+private:
+  // Fill procs_ from one pass of the iterator. False when it could not be read.
+  bool read_iterator();
+
+  struct montauk_procs_bpf* skel_{nullptr};
+  struct bpf_link* link_{nullptr};
+
+  std::vector<uint8_t> buf_;
+  TaskIterFold fold_;
+  std::vector<TaskIterProc> procs_;
+  std::vector<montauk::model::ProcSample> rows_;
+  ProcessTree tree_;  // from the iterator's real_parent tgid
+
+  // Previous pass's run time per pid, keyed with its start time so a
+  // recycled pid does not diff against its predecessor.
+  struct Baseline {
+    uint64_t start_ns{};
+    uint64_t run_ns{};
+  };
+  std::unordered_map<int32_t, Baseline> last_;
+  std::unordered_map<int32_t, Baseline> next_;
+  uint64_t last_wall_ns_{0};
+
+  montauk::util::ProcReader rd_;
+  montauk::util::ProcIdentityCache ids_;
+  size_t max_procs_;
+  size_t enrich_top_n_;
+  uint64_t page_kb_{4};
+  uint64_t ticks_per_sec_{100};
+};
+
+} // namespace montauk::collectors
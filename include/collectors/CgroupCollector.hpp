@@ -0,0 +1,90 @@
+#pragma once
+#include "model/Cgroup.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace montauk::collectors {
+
+// cpu.stat: usage_usec and throttled_usec (0 when absent).
+void parse_cgroup_cpu_stat(std::string_view text, uint64_t& usage_usec, uint64_t& throttled_usec);
+// memory.stat: anon and file bytes.
+void parse_cgroup_memory_stat(std::string_view text, uint64_t& anon, uint64_t& file);
+// io.stat: rbytes and wbytes summed over every device line.
+void parse_cgroup_io_stat(std::string_view text, uint64_t& rbytes, uint64_t& wbytes);
+
+// The mapped path of the cgroup v2 mount (/sys/fs/cgroup, or its unified/
+// mount on a hybrid host); empty when there is none.
+[[nodiscard]] std::string cgroup_v2_root();
+
+// Per-cgroup resource use from the cgroup v2 hierarchy (/sys/fs/cgroup, or
+// its unified/ mount on a hybrid host; MONTAUK_SYS_ROOT-mapped).
+//
+// The tree is walked once; after that an inotify watch on every directory
+// reports mkdir/rmdir, and only the created subtree is walked (or the removed
+// one dropped). Without inotify, or after an event queue overflow, the whole
+// tree is re-walked instead. Each sample then reads five small files per
+// group -- cpu.stat, memory.current, memory.stat, io.stat, pids.current --
+// through fds opened once and kept (up to fd_budget of them; files past it
+// are opened per read). The kernel's counters are already subtree totals, so
+// there is no rollup to compute: a few hundred reads here stand in for
+// attributing every pid to its group and summing.
+//
+// Groups are capped at kMaxGroups (deeper and later directories are skipped);
+// publish keeps the kPublish busiest. Single-threaded: owned by one worker.
+class CgroupCollector {
+public:
+  static constexpr size_t kMaxGroups = 4096;
+  static constexpr size_t kPublish = 64;
+  static constexpr size_t kDefaultFdBudget = 512;
+
+  explicit CgroupCollector(size_t fd_budget = kDefaultFdBudget);
+  ~CgroupCollector();
+  CgroupCollector(const CgroupCollector&) = delete;
+  CgroupCollector& operator=(const CgroupCollector&) = delete;
+
+  // False when there is no cgroup v2 hierarchy to read.
+  [[nodiscard]] bool sample(montauk::model::CgroupSnapshot& out);
+
+  // Directories walked since construction: the first walk counts every
+  // group, an incremental one only the new subtree.
+  [[nodiscard]] uint64_t dirs_walked() const { return dirs_walked_; }
+
+private:
+  static constexpr int kFiles = 5;  // cpu.stat memory.current memory.stat io.stat pids.current
+
+  struct Node {
+    int depth{};
+    int wd{-1};
+    int fds[kFiles]{-1, -1, -1, -1, -1};
+    uint64_t gen{};  // last full walk that saw it
+    bool have_prev{false};
+    uint64_t usage_usec{}, throttled_usec{}, rbytes{}, wbytes{};
+    double ts{};
+  };
+
+  bool locate_root();
+  void walk(const std::string& rel, int depth);
+  void close_node(Node& n);
+  void drop(const std::string& rel);
+  void drop_all();
+  void drain_events();
+  bool read_file(Node& n, const std::string& rel, int which, std::string& buf);
+
+  std::string root_;                 // mapped path of the v2 mount; empty until found
+  int inotify_fd_{-1};
+  bool rewalk_{true};
+  uint64_t gen_{0};
+  uint64_t samples_{0};
+  std::unordered_map<std::string, Node> nodes_;
+  std::unordered_map<int, std::string> wd_rel_;
+  size_t fd_budget_;
+  size_t fds_open_{0};
+  uint64_t dirs_walked_{0};
+  std::string buf_;
+};
+
+} // namespace montauk::collectors
@@ -1,5 +1,6 @@
 #pragma once
 #include "model/Snapshot.hpp"
+#include "util/Procfs.hpp"
 #include <chrono>
 
 namespace montauk::collectors {
@@ -12,7 +13,9 @@ private:
   montauk::model::CpuTimes last_total_{};
   std::vector<montauk::model::CpuTimes> last_per_{};
   std::vector<montauk::model::CpuTimes> per_scratch_{};  // reused parse buffer
+  montauk::util::ProcReader rd_{};
   std::vector<std::string> freq_paths_{};  // per-core cpufreq paths, built once
+  std::string freq_buf_{};                 // reused cpufreq read buffer
   bool has_last_{false};
   std::string cpu_model_{};
   int physical_cores_{0};   // summed per-socket "cpu cores" from /proc/cpuinfo
@@ -1,7 +1,10 @@
 #pragma once
+#include "util/Procfs.hpp"
+#include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
 #include <chrono>
+#include <vector>
 
 namespace montauk::collectors {
 
@@ -29,6 +32,9 @@ public:
 private:
   struct LastSample { IntelCycles intel{}; AmdEngines amd{}; Clock::time_point tp{}; };
   std::unordered_map<int, LastSample> last_;
+  montauk::util::ProcReader rd_;
+  std::vector<int32_t> pids_;  // copy of rd_.pids(): the walk reuses rd_
+  std::vector<int32_t> fds_;   // per-pid fdinfo listing, reused
 };
 
 } // namespace montauk::collectors
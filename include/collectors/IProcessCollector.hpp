@@ -1,8 +1,17 @@
 #pragma once
 #include "model/Snapshot.hpp"
 
+#include <cstdint>
+
 namespace montauk::collectors {
 
+// Source of per-process cpu_pct in the /proc-scanning collectors.
+//   Ticks:     utime+stime from /proc/PID/stat over the /proc/stat total. Clock-
+//              tick resolution, so a window much under a second is quantized.
+//   Schedstat: nanosecond run time from /proc/PID/schedstat (summed over
+//              threads) over monotonic wall time; accurate at 100-250 ms.
+enum class CpuClock : uint8_t { Ticks, Schedstat };
+
 // Minimal interface for process collectors so we can swap
 // between traditional /proc scanning and event-driven netlink.
 class IProcessCollector {
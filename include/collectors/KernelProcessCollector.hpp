@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <string>
 #include <cstdint>
+#include <vector>
 
 namespace montauk::collectors {
 
@@ -36,6 +37,9 @@ private:
   // Cmdline cache (one-shot per PID, populated from /proc in userspace)
   std::unordered_map<int32_t, std::string> cmdline_cache_;
 
+  // This snapshot's rows before they are published into the columns.
+  std::vector<montauk::model::ProcSample> rows_;
+
   // Helpers
   bool resolve_family();
   bool send_get_snapshot();
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "collectors/IProcessCollector.hpp"
+#include "collectors/ProcessTree.hpp"
+#include "collectors/ShardedScan.hpp"
+#include "collectors/TaskstatsListener.hpp"
+#include "util/ExitRollup.hpp"
+#include "util/PidFdCache.hpp"
+#include "util/ProcIdentityCache.hpp"
+#include "util/Procfs.hpp"
+#include <algorithm>
 #include <thread>
 #include <atomic>
 #include <mutex>
@@ -14,7 +22,12 @@ namespace montauk::collectors {
 // Falls back gracefully if unavailable.
 class NetlinkProcessCollector : public IProcessCollector {
 public:
-  explicit NetlinkProcessCollector(size_t max_procs = 256, size_t enrich_top_n = 256);
+  // scan_threads caps the sharded per-pid parse (0 = auto, 1 = serial).
+  // fd_cache caps the fds kept open for hot pids (see util::PidFdCache; 0 = off).
+  // clock picks the cpu_pct source (see CpuClock).
+  explicit NetlinkProcessCollector(size_t max_procs = 256, size_t enrich_top_n = 256,
+                                   size_t scan_threads = 0, size_t fd_cache = 0,
+                                   CpuClock clock = CpuClock::Ticks);
   ~NetlinkProcessCollector() override;
 
   bool init() override;        // returns false if socket cannot be created/bound
@@ -22,6 +35,11 @@ public:
   bool sample(montauk::model::ProcessSnapshot& out) override;
   const char* name() const override { return "Event-Driven Netlink"; }
 
+  // Apply one connector message (a cn_msg carrying a proc_event). The event
+  // thread's step; public for tests, as is the per-tick budget.
+  void handle_cn_msg(void* cn_msg_ptr, ssize_t len);
+  void set_sample_budget(size_t n) { sample_budget_ = std::max<size_t>(n, 1); }
+
 private:
   // Netlink socket (Linux only). Atomic: shutdown() clears it from the main
   // thread while event_loop() reads it in recv() on the event thread.
@@ -35,12 +53,49 @@ private:
   std::mutex active_mu_;
   std::unordered_set<int32_t> active_pids_;
   std::unordered_map<int32_t, std::string> pid_to_comm_;
+  std::vector<int32_t> exited_;  // EXIT events not yet applied to fds_/ids_
+  std::vector<int32_t> execed_;  // EXEC events not yet applied to ids_
+  // Process-level FORK/EXIT events not yet applied to tree_, in arrival order.
+  struct TreeEvent {
+    bool fork;
+    int32_t parent;  // fork only
+    int32_t pid;
+  };
+  std::vector<TreeEvent> tree_events_;
+  // Exits read from /proc on the EXIT event, when exits_ is not running.
+  std::vector<TaskExit> exit_records_;
+
+  // /proc readers: one per thread that reads, since a reader's views alias
+  // its own buffer. rd_ is sample()'s, ev_rd_ the event thread's.
+  montauk::util::ProcReader rd_;
+  montauk::util::ProcReader ev_rd_;
+  ShardedScan scan_;
+  // This cycle's rows before they are published into the snapshot's columns.
+  std::vector<montauk::model::ProcSample> rows_;
+  // Hot-pid fds and per-image identities; sample()-thread only. EXIT/EXEC
+  // events reach them through exited_/execed_.
+  montauk::util::PidFdCache fds_;
+  montauk::util::ProcIdentityCache ids_;
+  // Parent/child edges over the active set; sample()-thread only, fed by
+  // tree_events_ between scans and by each scanned row's ppid.
+  ProcessTree tree_;
+
+  // Exit accounting for processes that live and die between two samples:
+  // taskstats records (or exit_records_), rolled up per comm in sample().
+  TaskstatsListener exits_;
+  std::vector<TaskExit> exit_batch_;
+  montauk::util::ExitRollup exit_rollup_;
+  // The active set as of the last sample (the initial /proc scan before the
+  // first): an exit outside it forked since then and is short-lived.
+  std::unordered_set<int32_t> population_;
 
   // CPU deltas for percentage computation
   std::unordered_map<int32_t, uint64_t> last_per_proc_{}; // pid -> total_time
   uint64_t last_cpu_total_{};
   bool have_last_{false};
   unsigned ncpu_{0};
+  CpuClock clock_;  // sample()-thread only
+  bool clock_probed_{false};
 
   // Limits
   size_t max_procs_{};
@@ -52,7 +107,6 @@ private:
 
   // Event processing helpers (Linux only)
   void event_loop();
-  void handle_cn_msg(void* cn_msg_ptr, ssize_t len);
   void send_control_message(int op);
 };
 
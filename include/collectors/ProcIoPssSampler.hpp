@@ -0,0 +1,92 @@
+#pragma once
+#include "model/Process.hpp"
+#include "util/Procfs.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace montauk::collectors {
+
+// /proc/PID/io: read_bytes and write_bytes (storage, not rchar/wchar).
+struct ProcIoCounters {
+  uint64_t read_bytes{};
+  uint64_t write_bytes{};
+};
+[[nodiscard]] std::optional<ProcIoCounters> parse_proc_io(std::string_view text);
+// /proc/PID/smaps_rollup: the Pss line, in kB.
+[[nodiscard]] std::optional<uint64_t> parse_smaps_rollup_pss_kb(std::string_view text);
+
+// Per-process storage I/O rate and PSS for a published process table, read
+// under a per-tick time budget so they can never stretch the cadence.
+//
+// The first top_k rows (the table is cpu-sorted) are visited every tick;
+// whatever budget is left walks the remaining rows round-robin, the way
+// NetlinkProcessCollector fills its candidate set. The rotation runs in pid
+// order and resumes after the last pid it visited, not at a row index: the
+// table is re-ranked every tick, so an index would skip or repeat rows as
+// they move, while pid order reaches every row within ceil(rows / visits per
+// tick) ticks however the ranking churns. A visit reads
+// /proc/PID/io, and /proc/PID/smaps_rollup only when the cached PSS is older
+// than kPssRefresh: the rollup walks every VMA under mmap_lock and is the
+// expensive half. The budget is checked before each read, so one tick
+// overruns it by at most one read.
+//
+// Results are cached per pid and start time; every row gets the last values
+// its process produced and their age, so a row the rotation has not reached
+// lately says so instead of pretending to be fresh. An I/O rate spans the
+// two most recent visits, however many ticks apart.
+//
+// Reads need ptrace access to the target (same uid, or root); unreadable
+// rows just stay at kAgeNever. Owned by one thread.
+class ProcIoPssSampler {
+public:
+  static constexpr size_t kDefaultTopK = 16;
+  static constexpr std::chrono::microseconds kDefaultBudget{2000};
+  static constexpr std::chrono::milliseconds kPssRefresh{2000};
+
+  // rotate_max caps the rotation's visits per tick on top of the budget.
+  explicit ProcIoPssSampler(size_t top_k = kDefaultTopK,
+                            std::chrono::microseconds budget = kDefaultBudget,
+                            size_t rotate_max = SIZE_MAX)
+      : top_k_(top_k), budget_ns_(static_cast<uint64_t>(budget.count()) * 1000),
+        rotate_max_(rotate_max) {}
+
+  // Read what the budget allows, then fill io_*/pss_* on every row.
+  void sample(montauk::model::ProcessSnapshot& procs);
+
+  // Files read on the last tick, and whether it stopped on the budget.
+  [[nodiscard]] size_t last_reads() const { return last_reads_; }
+  [[nodiscard]] bool last_budget_hit() const { return last_budget_hit_; }
+
+private:
+  struct Entry {
+    uint64_t start_time{};
+    uint64_t gen{};
+    uint64_t read_bytes{}, write_bytes{};
+    uint64_t io_ns{};    // steady_ns of the last /proc/PID/io read; 0 = none
+    double read_bps{}, write_bps{};
+    uint64_t rate_ns{};  // read that produced the current rates; 0 = no rate yet
+    uint64_t pss_kb{};
+    uint64_t pss_ns{};   // 0 = never read
+  };
+  void visit(Entry& e, int32_t pid, uint64_t deadline);
+
+  montauk::util::ProcReader rd_;
+  std::unordered_map<int32_t, Entry> cache_;
+  size_t top_k_;
+  uint64_t budget_ns_;
+  size_t rotate_max_;
+  int32_t rr_last_pid_{0};  // last pid the rotation visited; 0 = none yet
+  std::vector<std::pair<int32_t, size_t>> rr_order_;  // (pid, row) past top_k, by pid
+  uint64_t gen_{0};
+  size_t last_reads_{0};
+  bool last_budget_hit_{false};
+};
+
+} // namespace montauk::collectors
@@ -1,21 +1,82 @@
 #pragma once
 #include "model/Snapshot.hpp"
 #include "collectors/IProcessCollector.hpp"
-#include <unordered_map>
+#include "collectors/ProcessTree.hpp"
+#include "collectors/ShardedScan.hpp"
+#include "util/PidFdCache.hpp"
+#include "util/ProcIdentityCache.hpp"
+#include "util/Procfs.hpp"
 #include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace montauk::collectors {
 
 class ProcessCollector : public IProcessCollector {
 public:
-  // min_interval_ms governs how often we compute; extra calls within the interval no-op
-  explicit ProcessCollector(unsigned min_interval_ms = 500, size_t max_procs = 256, size_t enrich_top_n = 256);
+  // min_interval_ms governs how often we compute; extra calls within the interval no-op.
+  // scan_threads caps the sharded per-pid parse (0 = auto, 1 = serial).
+  // fd_cache caps the fds kept open for hot pids (see util::PidFdCache; 0 = off).
+  // clock picks the cpu_pct source (see CpuClock).
+  explicit ProcessCollector(unsigned min_interval_ms = 500, size_t max_procs = 256, size_t enrich_top_n = 256,
+                            size_t scan_threads = 0, size_t fd_cache = 0, CpuClock clock = CpuClock::Ticks);
   bool init() override { return true; }
   void shutdown() override {}
   const char* name() const override { return "Traditional /proc Scanner"; }
   bool sample(montauk::model::ProcessSnapshot& out) override;
+  // The clock in effect: Ticks after a failed schedstat probe (first sample()).
+  CpuClock cpu_clock() const noexcept { return clock_; }
+
+protected:
+  // Per-cycle inputs of the per-pid parse; read-only while a scan runs.
+  // Under CpuClock::Schedstat, cpu_total is monotonic nanoseconds and ncpu 1,
+  // so the same delta formula yields per-core percent from run-time ns.
+  struct ScanCtx {
+    bool have_last;
+    uint64_t cpu_total, last_cpu_total, page_kb;
+    unsigned ncpu;
+    bool schedstat;
+  };
+  // The parse phase: append a row per pid to rows, in pid order, and count
+  // states into out. Returns the shards used. Default: ShardedScan over
+  // synchronous reads; UringProcessCollector batches the reads instead.
+  virtual size_t scan(std::span<const int32_t> pids, const ScanCtx& c,
+                      std::vector<montauk::model::ProcSample>& rows, montauk::model::ProcessSnapshot& out);
+  // Push pid's row built from its /proc/<pid>/stat contents onto sh.rows. False
+  // when stat was unreadable or malformed: the row is then a churn placeholder
+  // and the caller skips the status fields. Under CpuClock::Schedstat, sched is
+  // the pid's schedstat if the caller already read it (a single-threaded
+  // process needs nothing else); otherwise it is read here.
+  bool parse_stat_row(ShardedScan::Shard& sh, const ScanCtx& c, int32_t pid,
+                      std::optional<std::string_view> stat,
+                      std::optional<std::string_view> sched = std::nullopt) const;
+  montauk::util::ProcReader rd_{};
+  montauk::util::PidFdCache fds_;
+  montauk::util::ProcIdentityCache ids_;
+
 private:
-  std::unordered_map<int32_t, uint64_t> last_per_proc_{}; // pid -> total_time
+  ShardedScan scan_;
+  std::vector<int32_t> pids_{};  // this cycle's /proc listing
+  // This cycle's rows, ranked and enriched here, then published into the
+  // snapshot's columns. Kept across cycles for its capacity.
+  std::vector<montauk::model::ProcSample> rows_{};
+  ProcessTree tree_;  // every scanned pid, rolled up before the top-K cut
+  // pid -> (total_time, start_time) from the previous scan, sorted by pid. Two
+  // flat vectors swapped each cycle instead of a rebuilt hash map: the map
+  // allocated a node per pid per cycle, these reach their high-water mark once
+  // and stay there.
+  struct Baseline {
+    int32_t pid;
+    uint64_t total_time;
+    uint64_t start_time;
+    auto operator<=>(const Baseline&) const = default;
+  };
+  std::vector<Baseline> last_per_proc_{};
+  std::vector<Baseline> next_per_proc_{};
   uint64_t last_cpu_total_{};
   bool have_last_{false};
   unsigned min_interval_ms_{};
@@ -23,6 +84,8 @@ private:
   size_t enrich_top_n_{};
   std::chrono::steady_clock::time_point last_run_{};
   unsigned ncpu_{0};
+  CpuClock clock_;
+  bool clock_probed_{false};
 };
 
 } // namespace montauk::collectors
@@ -4,12 +4,14 @@
 #pragma once
 #include "util/Procfs.hpp"
 #include "util/Churn.hpp"
+#include "util/PidFdCache.hpp"
 
 #include <algorithm>
 #include <charconv>
 #include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <mutex>
 #include <optional>
@@ -29,21 +31,28 @@ inline double now_secs() {
   return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
 }
 
+// Monotonic nanoseconds: the denominator clock of CpuClock::Schedstat.
+inline uint64_t steady_ns() {
+  using namespace std::chrono;
+  return static_cast<uint64_t>(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
 // Parse the (comm)-delimited fields of a /proc/PID/stat line. comm may
 // itself contain spaces/parens, so the value between the first '(' and the
 // last ')' is taken verbatim; everything after is whitespace-delimited.
 // Parses in place over the line (this runs per process per cycle); a field
 // that fails to parse leaves its out-param untouched, like the istringstream
 // extraction it replaced.
-inline bool parse_stat_line(const std::string& content, char& state,
+inline bool parse_stat_line(std::string_view content, char& state,
                              uint64_t& utime, uint64_t& stime,
                              int64_t& rss_pages, std::string& comm,
                              uint64_t& minflt, uint64_t& majflt,
-                             int& num_threads) {
+                             int& num_threads, uint64_t* starttime = nullptr,
+                             int32_t* ppid = nullptr) {
   const auto lp = content.find('(');
   const auto rp = content.rfind(')');
-  if (lp == std::string::npos || rp == std::string::npos || rp < lp) return false;
-  comm.assign(content, lp + 1, rp - lp - 1);
+  if (lp == std::string_view::npos || rp == std::string_view::npos || rp < lp) return false;
+  comm.assign(content.substr(lp + 1, rp - lp - 1));
   const char* p = content.data() + rp + 1;
   const char* const end = content.data() + content.size();
   auto next_field = [&]() {
@@ -56,7 +65,7 @@ inline bool parse_stat_line(const std::string& content, char& state,
     auto [b, e] = next_field();  // state
     if (b < e) state = *b;
   }
-  (void)next_field();  // ppid (no caller uses it)
+  { auto [b, e] = next_field(); if (ppid) std::from_chars(b, e, *ppid); }
   // pgrp, session, tty_nr, tpgid, flags (5), then minflt, cminflt, majflt,
   // cmajflt -- the same 9 fields the old code skipped wholesale, now capturing
   // the two page-fault counters.
@@ -68,10 +77,13 @@ inline bool parse_stat_line(const std::string& content, char& state,
   { auto [b, e] = next_field(); std::from_chars(b, e, utime); }
   { auto [b, e] = next_field(); std::from_chars(b, e, stime); }
   // cutime, cstime, priority, nice (4), then num_threads, then itrealvalue,
-  // starttime, vsize (3) -- the same 8 fields, now capturing num_threads.
+  // starttime, vsize (3) -- the same 8 fields, now capturing num_threads and,
+  // for callers that key on the process incarnation, starttime.
   for (int i = 0; i < 4; ++i) (void)next_field();
   { auto [b, e] = next_field(); std::from_chars(b, e, num_threads); }
-  for (int i = 0; i < 3; ++i) (void)next_field();
+  (void)next_field();  // itrealvalue
+  { auto [b, e] = next_field(); if (starttime) std::from_chars(b, e, *starttime); }
+  (void)next_field();  // vsize
   { auto [b, e] = next_field(); std::from_chars(b, e, rss_pages); }
   return true;
 }
@@ -79,10 +91,8 @@ inline bool parse_stat_line(const std::string& content, char& state,
 // Total jiffies from the aggregate "cpu " line of /proc/stat. Only the first
 // line is examined; the per-core block below it is never touched, so this
 // stays cheap for the collectors that re-read it every cycle.
-inline uint64_t read_cpu_total() {
-  auto txt = montauk::util::read_file_string("/proc/stat");
-  if (!txt) return 0;
-  std::string_view first(*txt);
+inline uint64_t parse_cpu_total(std::string_view txt) {
+  std::string_view first(txt);
   if (auto nl = first.find('\n'); nl != std::string_view::npos) first = first.substr(0, nl);
   auto pos = first.find(' ');
   if (pos == std::string_view::npos) return 0;
@@ -100,16 +110,25 @@ inline uint64_t read_cpu_total() {
   return total;
 }
 
-// Count per-core "cpuN" lines of /proc/stat (aggregate "cpu " line skipped).
-inline unsigned read_cpu_count() {
+inline uint64_t read_cpu_total() {
   auto txt = montauk::util::read_file_string("/proc/stat");
-  if (!txt) return 1;
-  const std::string& s = *txt;
+  if (!txt) return 0;
+  return parse_cpu_total(*txt);
+}
+
+inline uint64_t read_cpu_total(montauk::util::ProcReader& rd) {
+  auto txt = rd.read("stat");
+  if (!txt) return 0;
+  return parse_cpu_total(*txt);
+}
+
+// Count per-core "cpuN" lines of /proc/stat (aggregate "cpu " line skipped).
+inline unsigned parse_cpu_count(std::string_view s) {
   unsigned count = 0; bool first = true;
   size_t start = 0;
   while (start < s.size()) {
     size_t end = s.find('\n', start);
-    if (end == std::string::npos) end = s.size();
+    if (end == std::string_view::npos) end = s.size();
     std::string_view line(s.data() + start, end - start);
     if (line.starts_with("cpu")) {
       if (first) { first = false; }
@@ -123,12 +142,31 @@ inline unsigned read_cpu_count() {
   return count;
 }
 
+inline unsigned read_cpu_count() {
+  auto txt = montauk::util::read_file_string("/proc/stat");
+  if (!txt) return 1;
+  return parse_cpu_count(*txt);
+}
+
+inline unsigned read_cpu_count(montauk::util::ProcReader& rd) {
+  auto txt = rd.read("stat");
+  if (!txt) return 1;
+  return parse_cpu_count(*txt);
+}
+
 inline std::string read_exe_path(int32_t pid) {
   auto link = montauk::util::read_symlink(std::string("/proc/") + std::to_string(pid) + "/exe");
   if (!link) return {};
   return *link;
 }
 
+// Reader form: assigns into the caller's string so a row whose exe path is
+// unchanged frame to frame reuses its existing capacity.
+inline void read_exe_path(montauk::util::ProcReader& rd, int32_t pid, std::string& out) {
+  auto link = rd.readlink_pid(pid, "exe");
+  if (link) out.assign(*link); else out.clear();
+}
+
 // uid -> user name via /etc/passwd, cached. Mutex-guarded and negative-caching
 // (an unknown uid caches its numeric string) so repeated misses stay cheap.
 inline std::string user_name_cached(uint32_t uid) {
@@ -179,7 +217,6 @@ struct StatusInfo {
   int thread_count{1};
 };
 
-// User name and thread count from /proc/PID/status.
 // THE COMMAND LINE CAP, one rule for every collector. 512 bytes is enough for
 // display and for Security's scan of it, and an unbounded cmdline is a process's
 // to choose -- so the cap belongs beside the read, not at one of two call sites.
@@ -193,18 +230,13 @@ inline void cap_cmdline(std::string& cmd) {
   if (cmd.size() > kCmdlineMax) cmd.resize(kCmdlineMax);
 }
 
-inline StatusInfo info_from_status(int32_t pid) {
+// User name and thread count from /proc/PID/status.
+inline StatusInfo parse_status_info(std::string_view s) {
   StatusInfo info;
-  auto path = std::string("/proc/") + std::to_string(pid) + "/status";
-  std::optional<std::string> txt;
-  try { txt = montauk::util::read_file_string(path); }
-  catch (...) { txt = std::nullopt; montauk::util::note_churn(montauk::util::ChurnKind::Proc); }
-  if (!txt) return info;
-  const std::string& s = *txt;
   size_t start = 0;
   while (start < s.size()) {
     size_t end = s.find('\n', start);
-    if (end == std::string::npos) end = s.size();
+    if (end == std::string_view::npos) end = s.size();
     std::string_view line(s.data() + start, end - start);
     if (line.starts_with("Uid:")) {
       uint32_t uid = 0;
@@ -222,6 +254,30 @@ inline StatusInfo info_from_status(int32_t pid) {
   return info;
 }
 
+inline StatusInfo info_from_status(int32_t pid) {
+  auto path = std::string("/proc/") + std::to_string(pid) + "/status";
+  std::optional<std::string> txt;
+  try { txt = montauk::util::read_file_string(path); }
+  catch (...) { txt = std::nullopt; montauk::util::note_churn(montauk::util::ChurnKind::Proc); }
+  if (!txt) return {};
+  return parse_status_info(*txt);
+}
+
+inline StatusInfo info_from_status(montauk::util::ProcReader& rd, int32_t pid) {
+  auto txt = rd.read_pid(pid, "status");
+  if (!txt) return {};
+  return parse_status_info(*txt);
+}
+
+// Through the hot-pid fd cache; starttime 0 (a churned row) reads uncached.
+inline StatusInfo info_from_status(montauk::util::ProcReader& rd, montauk::util::PidFdCache& fds,
+                                   int32_t pid, uint64_t starttime) {
+  if (starttime == 0) return info_from_status(rd, pid);
+  auto txt = fds.read(rd, pid, starttime, montauk::util::PidFdCache::Status);
+  if (!txt) return {};
+  return parse_status_info(*txt);
+}
+
 // Context-switch counters from /proc/PID/status, for EVERY process rather than
 // the enriched top-K. Split from info_from_status deliberately: that one also
 // resolves a uid to a user name through a cache, which is the expensive part and
@@ -234,19 +290,13 @@ inline StatusInfo info_from_status(int32_t pid) {
 // rows breaks the full-population fusion it feeds.
 struct CtxSwitches { uint64_t voluntary{0}, involuntary{0}; bool ok{false}; };
 
-inline CtxSwitches ctx_switches_from_status(int32_t pid) {
+inline CtxSwitches parse_ctx_switches(std::string_view s) {
   CtxSwitches c;
-  auto path = std::string("/proc/") + std::to_string(pid) + "/status";
-  std::optional<std::string> txt;
-  try { txt = montauk::util::read_file_string(path); }
-  catch (...) { txt = std::nullopt; montauk::util::note_churn(montauk::util::ChurnKind::Proc); }
-  if (!txt) return c;
-  const std::string& s = *txt;
   size_t start = 0;
   int found = 0;
   while (start < s.size() && found < 2) {
     size_t end = s.find('\n', start);
-    if (end == std::string::npos) end = s.size();
+    if (end == std::string_view::npos) end = s.size();
     std::string_view line(s.data() + start, end - start);
     // "nonvoluntary_" is checked first: it ENDS with the same text the
     // voluntary check looks for, so testing the shorter prefix first would
@@ -268,28 +318,73 @@ inline CtxSwitches ctx_switches_from_status(int32_t pid) {
   return c;
 }
 
+inline CtxSwitches ctx_switches_from_status(int32_t pid) {
+  auto path = std::string("/proc/") + std::to_string(pid) + "/status";
+  std::optional<std::string> txt;
+  try { txt = montauk::util::read_file_string(path); }
+  catch (...) { txt = std::nullopt; montauk::util::note_churn(montauk::util::ChurnKind::Proc); }
+  if (!txt) return {};
+  return parse_ctx_switches(*txt);
+}
+
+inline CtxSwitches ctx_switches_from_status(montauk::util::ProcReader& rd, int32_t pid) {
+  auto txt = rd.read_pid(pid, "status");
+  if (!txt) return {};
+  return parse_ctx_switches(*txt);
+}
+
+// First field of a schedstat file (/proc/PID/schedstat or its per-thread
+// twin under task/): the task's cumulative on-CPU time in nanoseconds.
+inline std::optional<uint64_t> parse_schedstat_run_ns(std::string_view s) {
+  uint64_t v = 0;
+  auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+  if (ec != std::errc{} || p == s.data()) return std::nullopt;
+  return v;
+}
+
+// Whole-process on-CPU nanoseconds, for CpuClock::Schedstat. /proc/PID/schedstat
+// describes the thread-group leader only, so a multi-threaded process (nthreads
+// from this cycle's stat) sums its live threads, one read each. Runtime of
+// threads that already exited is missing from that sum; a thread exit shows up
+// as a total below the baseline, which the callers' no-negative-delta rule
+// turns into one quiet cycle. nullopt when nothing could be read: the process
+// exited between its stat and this.
+inline std::optional<uint64_t> read_process_run_ns(montauk::util::ProcReader& rd, int32_t pid,
+                                                   int nthreads, std::vector<int32_t>& tids) {
+  if (nthreads <= 1) {
+    auto s = rd.read_pid(pid, "schedstat");
+    return s ? parse_schedstat_run_ns(*s) : std::nullopt;
+  }
+  if (!rd.list_numeric(pid, "task", tids)) return std::nullopt;
+  uint64_t sum = 0;
+  bool any = false;
+  char path[64];
+  for (int32_t tid : tids) {
+    char* p = std::to_chars(path, path + 16, pid).ptr;
+    std::memcpy(p, "/task/", 6);
+    p = std::to_chars(p + 6, p + 22, tid).ptr;
+    std::memcpy(p, "/schedstat", 11);
+    auto s = rd.read(path);
+    if (!s) continue;  // that thread exited mid-walk
+    if (auto ns = parse_schedstat_run_ns(*s)) { sum += *ns; any = true; }
+  }
+  return any ? std::optional<uint64_t>(sum) : std::nullopt;
+}
+
 // Read /proc/PID/cmdline, turning its NUL-separated argv into a single
 // space-joined string. Union of every prior copy's guards: an empty read
 // short-circuits before the join loop, and read_file_bytes is defensively
 // try/catch'd (it does not itself throw, but callers relied on the guard).
-inline std::string read_cmdline(int32_t pid) {
-  auto path = std::string("/proc/") + std::to_string(pid) + "/cmdline";
-  std::optional<std::vector<unsigned char>> bytes;
-  try {
-    bytes = montauk::util::read_file_bytes(path);
-  } catch (...) {
-    bytes = std::nullopt;
-    montauk::util::note_churn(montauk::util::ChurnKind::Proc);
-  }
-  if (!bytes || bytes->empty()) return {};
+// NUL-separated argv -> one space-joined string.
+inline std::string join_cmdline(std::string_view bytes) {
   std::string out;
-  out.reserve(bytes->size());
+  out.reserve(bytes.size());
   bool sep = true;
-  for (auto b : *bytes) {
+  for (auto b : bytes) {
     if (b == 0) {
       if (!sep) { out.push_back(' '); sep = true; }
     } else {
-      out.push_back(static_cast<char>(b));
+      out.push_back(b);
       sep = false;
     }
   }
@@ -297,6 +392,33 @@ inline std::string read_cmdline(int32_t pid) {
   return out;
 }
 
+inline std::string read_cmdline(int32_t pid) {
+  auto path = std::string("/proc/") + std::to_string(pid) + "/cmdline";
+  std::optional<std::vector<unsigned char>> bytes;
+  try {
+    bytes = montauk::util::read_file_bytes(path);
+  } catch (...) {
+    bytes = std::nullopt;
+    montauk::util::note_churn(montauk::util::ChurnKind::Proc);
+  }
+  if (!bytes || bytes->empty()) return {};
+  return join_cmdline(std::string_view(reinterpret_cast<const char*>(bytes->data()), bytes->size()));
+}
+
+inline std::string read_cmdline(montauk::util::ProcReader& rd, int32_t pid) {
+  auto bytes = rd.read_pid(pid, "cmdline");
+  if (!bytes || bytes->empty()) return {};
+  return join_cmdline(*bytes);
+}
+
+inline std::string read_cmdline(montauk::util::ProcReader& rd, montauk::util::PidFdCache& fds,
+                                int32_t pid, uint64_t starttime) {
+  if (starttime == 0) return read_cmdline(rd, pid);
+  auto bytes = fds.read(rd, pid, starttime, montauk::util::PidFdCache::Cmdline);
+  if (!bytes || bytes->empty()) return {};
+  return join_cmdline(*bytes);
+}
+
 // Truncate v to its top-k entries by cpu_pct (descending) in sorted order.
 // One stable pack index sort (sublimation_pack_sort_f64) covers both the old
 // select-then-sort steps: the index sort orders every row by key without
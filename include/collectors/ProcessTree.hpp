@@ -0,0 +1,76 @@
+#pragma once
+#include "model/Process.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace montauk::collectors {
+
+// The parent/child structure of the live process population, kept across
+// ticks so a pass only pays for what changed, with per-subtree CPU/RSS/thread
+// rollups.
+//
+// Edges come from the ppid of each row a collector scans (a reparent to init
+// or a subreaper shows up there as a changed ppid) and, when netlink is
+// active, from FORK/EXIT events between scans, so a child is attached to its
+// parent before it is ever read. Each node keeps its children list; an edge
+// change touches the two lists involved and nothing else.
+//
+// refresh() then sums every subtree in one iterative post-order walk from the
+// roots -- O(n), no recursion for a deep fork chain -- and writes the totals
+// back onto the rows. It runs on the full population BEFORE the top-K cut, so
+// a quiet parent that is kept still carries the cost of children that were
+// not. A node the latest scan did not read (netlink's budgeted candidate set)
+// contributes the values it was last read with. Owned by one thread.
+class ProcessTree {
+public:
+  // Process-level events (pid == tgid; thread forks and exits are not edges).
+  void on_fork(int32_t parent, int32_t child);
+  void on_exit(int32_t pid);
+
+  // rows is the whole population: merge them, drop every node they do not
+  // name, roll up, and fill ppid/subtree_* on each row.
+  void refresh(std::span<montauk::model::ProcSample> rows);
+  // rows is a subset of the population in live (netlink): merge them, drop
+  // nodes not in live, roll up, and fill the rows.
+  void refresh(std::span<montauk::model::ProcSample> rows, std::span<const int32_t> live);
+
+  [[nodiscard]] size_t size() const { return nodes_.size(); }
+  // Parent of pid as the tree holds it; 0 = root or unknown.
+  [[nodiscard]] int32_t parent_of(int32_t pid) const;
+
+private:
+  struct Node {
+    int32_t ppid{0};
+    uint64_t start_time{};
+    double cpu_pct{};
+    uint64_t rss_kb{};
+    uint32_t threads{};
+    uint64_t gen{};    // refresh that last saw the pid live
+    uint64_t visit{};  // rollup walk that last reached it
+    std::vector<int32_t> children;
+    double sub_cpu_pct{};
+    uint64_t sub_rss_kb{};
+    uint32_t sub_threads{};
+    uint32_t sub_procs{};
+  };
+
+  void merge(std::span<montauk::model::ProcSample> rows);
+  void sweep();
+  void rollup();
+  void annotate(std::span<montauk::model::ProcSample> rows) const;
+  void link(int32_t pid, Node& n, int32_t ppid);
+  void unlink(int32_t pid, Node& n);
+  void erase(int32_t pid);
+
+  std::unordered_map<int32_t, Node> nodes_;
+  std::vector<std::pair<Node*, size_t>> stack_;  // rollup walk scratch
+  uint64_t gen_{0};
+  uint64_t walk_{0};
+};
+
+} // namespace montauk::collectors
@@ -0,0 +1,81 @@
+#pragma once
+#include "model/Psi.hpp"
+#include "util/DeadlineScheduler.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace montauk::collectors {
+
+// A /proc/pressure/* or cgroup *.pressure file: its "some" line, and its
+// "full" line where there is one (has_full). False when neither parses.
+bool parse_psi(std::string_view text, montauk::model::PsiLine& some, montauk::model::PsiLine& full,
+               bool& has_full);
+
+// Pressure stall information for the system (/proc/pressure/{cpu,memory,io})
+// and for any cgroup v2 groups named at construction ({cpu,memory,io}.pressure
+// under the v2 root). sample() just re-reads the averages through fds kept
+// open.
+//
+// arm() additionally registers a kernel PSI trigger on each file -- "some
+// <stall> <window>": fire when tasks were stalled for `stall` within any
+// `window`. watch() hands each trigger fd to a DeadlineScheduler as EPOLLPRI,
+// so a stall is seen within the kernel's PSI polling granularity (a few ms)
+// of a window being exceeded, rather than on the next poll of the averages,
+// which only move every 2 s anyway. The triggers go straight into the
+// scheduler's epoll set, not behind a nested one: a trigger's poll consumes
+// its event as it reports it, so the outer wait's readiness check on a
+// nested set would eat the fire before an inner epoll_wait could see it.
+// Triggers are only written to real procfs/cgroup2 files; a remapped test
+// tree just reads averages. Unprivileged processes may only register windows
+// that are multiples of 2 s; a refused trigger is logged once and skipped.
+//
+// Single-threaded: owned by the Producer thread.
+class PsiCollector {
+public:
+  explicit PsiCollector(std::vector<std::string> cgroups = {});
+  ~PsiCollector();
+  PsiCollector(const PsiCollector&) = delete;
+  PsiCollector& operator=(const PsiCollector&) = delete;
+
+  // Register the stall triggers. Returns the number armed.
+  size_t arm(std::chrono::microseconds stall, std::chrono::microseconds window);
+
+  [[nodiscard]] size_t armed() const { return armed_; }
+
+  // Register every armed trigger with sched; on_fire runs after each fire is
+  // counted. A trigger whose cgroup goes away (EPOLLERR) is disarmed and
+  // unwatched. False if any trigger could not be registered.
+  bool watch(montauk::util::DeadlineScheduler& sched, std::function<void()> on_fire);
+
+  // Without a scheduler: poll the triggers once, counting each fire against
+  // its resource. Returns how many fired. Never blocks.
+  size_t drain_fires();
+
+  // False when no pressure file could be read at all.
+  [[nodiscard]] bool sample(montauk::model::PsiSnapshot& out);
+
+private:
+  struct Source {
+    std::string scope, resource, path;
+    int fd{-1};
+    bool armed{false};
+    uint64_t fires{0};
+  };
+  void open_sources();
+  // What a poll of src's trigger reported; true when it fired.
+  bool on_event(Source& src, bool fired, bool error);
+
+  std::vector<std::string> cgroups_;
+  std::vector<Source> sources_;
+  bool opened_{false};
+  size_t armed_{0};
+  std::string buf_;
+};
+
+} // namespace montauk::collectors
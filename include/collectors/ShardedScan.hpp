@@ -0,0 +1,113 @@
+// Sharded per-pid /proc parse, shared by ProcessCollector and
+// NetlinkProcessCollector. The pid list is cut into contiguous shards, each
+// shard parsed by one task on sublimation's work-stealing pool with its own
+// ProcReader and row buffer, then the shards are concatenated in index order.
+// Contiguous shards merged in order reproduce the serial scan's row order
+// exactly, so top_k_by_cpu_pct (stable on ties) and the anomaly fusion see the
+// same input whether the scan ran on one thread or sixteen.
+#pragma once
+#include "model/Process.hpp"
+#include "util/Procfs.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "sublimation.h"  // after std headers (c23_compat unreachable macro)
+
+namespace montauk::collectors {
+
+class ShardedScan {
+public:
+  // Below this many pids per shard the fan-out (the pool starts its threads
+  // per call) costs more than the parse it spreads; a desktop with a few
+  // hundred processes never leaves the serial path.
+  static constexpr size_t kMinPidsPerShard = 512;
+
+  struct Shard {
+    montauk::util::ProcReader rd;
+    std::vector<montauk::model::ProcSample> rows;
+    size_t running{0}, sleeping{0}, zombie{0};
+    std::string comm;  // parse scratch, kept warm across cycles
+    std::vector<int32_t> tids;  // thread listing scratch (CpuClock::Schedstat)
+
+    void count_state(char st) {
+      if (st == 'R') ++running;
+      else if (st == 'S' || st == 'D') ++sleeping;
+      else if (st == 'Z') ++zombie;
+    }
+  };
+
+  // max_threads: 0 = sublimation's cpuset-aware default, 1 = always serial.
+  explicit ShardedScan(size_t max_threads = 0) : max_threads_(max_threads) {}
+
+  // Run fn(Shard&, int32_t pid) once per pid; fn appends whatever rows it
+  // produces to shard.rows and counts states on the shard. Rows are appended
+  // to `rows` in pid-list order and the state counters are summed into out.
+  // Returns the number of shards the pass used.
+  template <typename Fn>
+  size_t run(std::span<const int32_t> pids, std::vector<montauk::model::ProcSample>& rows,
+             montauk::model::ProcessSnapshot& out, Fn&& fn) {
+    const size_t n = pids.size();
+    size_t workers = max_threads_ ? max_threads_ : sublimation_default_workers();
+    size_t nshards = n / kMinPidsPerShard;
+    if (nshards > workers) nshards = workers;
+    if (nshards < 1) nshards = 1;
+    while (shards_.size() < nshards) shards_.push_back(std::make_unique<Shard>());
+    for (size_t i = 0; i < nshards; ++i) {
+      auto& sh = *shards_[i];
+      sh.rows.clear();
+      sh.running = sh.sleeping = sh.zombie = 0;
+    }
+
+    using F = std::remove_reference_t<Fn>;
+    Job<F> job{this, pids, nshards, &fn};
+    // parallel_for returns 0 only when the pool could not start; the shards are
+    // independent, so the same tasks run serially give the same result.
+    if (nshards == 1 || !sublimation_parallel_for(nshards, nshards, &Job<F>::task, &job)) {
+      for (size_t i = 0; i < nshards; ++i) Job<F>::task(i, &job);
+    }
+
+    for (size_t i = 0; i < nshards; ++i) {
+      auto& sh = *shards_[i];
+      for (auto& r : sh.rows) rows.push_back(std::move(r));
+      sh.rows.clear();
+      out.state_running += sh.running;
+      out.state_sleeping += sh.sleeping;
+      out.state_zombie += sh.zombie;
+    }
+    return nshards;
+  }
+
+private:
+  template <typename Fn>
+  struct Job {
+    ShardedScan* self;
+    std::span<const int32_t> pids;
+    size_t nshards;
+    Fn* fn;
+
+    static void task(size_t i, void* user) {
+      auto* j = static_cast<Job*>(user);
+      const size_t n = j->pids.size();
+      const size_t b = n * i / j->nshards;
+      const size_t e = n * (i + 1) / j->nshards;
+      auto& sh = *j->self->shards_[i];
+      // Nothing may unwind into the C pool; a shard that throws (allocation
+      // failure) keeps the rows it had and the scan publishes the rest.
+      try {
+        for (size_t k = b; k < e; ++k) (*j->fn)(sh, j->pids[k]);
+      } catch (...) {
+      }
+    }
+  };
+
+  size_t max_threads_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace montauk::collectors
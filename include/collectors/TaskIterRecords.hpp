@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace montauk::collectors {
+
+// One process as the dump_tasks iterator reported it: the leader's record
+// with every other thread's counters summed in. Times are nanoseconds.
+struct TaskIterProc {
+  int32_t pid{};
+  int32_t ppid{};
+  uint32_t uid{};
+  uint32_t nr_threads{};
+  char state{'S'};
+  uint64_t run_ns{};     // sum_exec_runtime, live and dead threads
+  uint64_t cpu_ns{};     // utime+stime, live and dead threads
+  uint64_t nvcsw{};
+  uint64_t nivcsw{};
+  uint64_t flt{};
+  uint64_t start_ns{};   // boot-relative
+  uint64_t rss_pages{};
+  std::string comm;
+};
+
+// Folds the iterator's byte stream (src/bpf/montauk_procs.h) into processes.
+// The stream is read in chunks that need not end on a record boundary, so
+// feed() carries a partial record over to the next call. Thread records may
+// come before or after their leader's; a group whose leader never shows up
+// (it was reaped mid-walk) is dropped at finish().
+class TaskIterFold {
+public:
+  void feed(const void* data, size_t len);
+  // Move the completed processes into out (replacing its contents) and reset
+  // for the next pass. Returns false when the stream ended mid-record.
+  bool finish(std::vector<TaskIterProc>& out);
+
+private:
+  // Consume whole records from [p, p+len); returns the bytes used.
+  size_t consume(const uint8_t* p, size_t len);
+
+  std::unordered_map<int32_t, TaskIterProc> procs_;
+  std::vector<uint8_t> carry_;
+};
+
+} // namespace montauk::collectors
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace montauk::collectors {
+
+// The final accounting of one exited process, from its exit record.
+struct TaskExit {
+  int32_t tgid{};
+  std::string comm;
+  uint64_t cpu_us{};    // utime+stime over the whole process
+  uint64_t rss_kb{};    // high-water RSS; 0 when the record has none
+  uint64_t io_bytes{};  // storage read+write bytes
+};
+
+// One TASKSTATS_CMD_NEW exit message: the exiting thread's own accounting,
+// and whether it was the last thread of its group.
+struct TaskRecord {
+  int32_t pid{};
+  int32_t tgid{};
+  bool group_dead{false};  // carried an AGGR_TGID record: the group is gone
+  TaskExit stats;          // this thread's totals (tgid filled in)
+};
+
+// Parse the attributes of one generic-netlink TASKSTATS_CMD_NEW message (the
+// bytes after the genlmsghdr). False when it carries no AGGR_PID record.
+bool parse_taskstats_record(const void* attrs, size_t len, TaskRecord& out);
+
+// Turns per-thread exit records into per-process exits. The AGGR_TGID record
+// that accompanies a group's last thread is no help for this: it accumulates
+// only delay-accounting fields, which stay zero unless delayacct is enabled.
+// So each thread's own record is summed per tgid, and the sum is emitted when
+// the group dies -- flagged by that AGGR_TGID record, or, for a single-
+// threaded process, by the leader's record arriving with nothing pending. A
+// leader that exits before its other threads is emitted then and again when
+// the group dies (the exit counts twice; no time does). Kernels before
+// TASKSTATS v10 leave ac_tgid zero; each thread then counts as a process.
+// Pending groups are capped at kMaxGroups; records for new groups past that
+// are dropped and counted.
+class TaskExitAssembler {
+public:
+  static constexpr size_t kMaxGroups = 4096;
+  void add(const TaskRecord& r, std::vector<TaskExit>& out);
+  [[nodiscard]] uint64_t dropped() const { return dropped_; }
+  [[nodiscard]] size_t pending() const { return groups_.size(); }
+
+private:
+  std::unordered_map<int32_t, TaskExit> groups_;
+  uint64_t dropped_{0};
+};
+
+// Exit records from the kernel's TASKSTATS generic netlink family: the
+// listener registers for every CPU's exits, assembles each process's final
+// CPU, RSS high-water mark and I/O, and queues it for the collector to drain.
+// Registration needs CAP_NET_ADMIN -- the same privilege the cn_proc events
+// it complements need -- and CONFIG_TASKSTATS; start() returns false without
+// either. The queue is capped so a fork storm between two samples costs bounded memory:
+// exits past kMaxPending are counted in dropped() and discarded.
+class TaskstatsListener {
+public:
+  static constexpr size_t kMaxPending = 8192;
+
+  TaskstatsListener() = default;
+  TaskstatsListener(const TaskstatsListener&) = delete;
+  TaskstatsListener& operator=(const TaskstatsListener&) = delete;
+  ~TaskstatsListener() { stop(); }
+
+  bool start();
+  void stop();
+  [[nodiscard]] bool running() const { return running_.load(std::memory_order_relaxed); }
+
+  // Move every queued exit into out (appended).
+  void drain(std::vector<TaskExit>& out);
+  // Records lost: queue full, socket overrun (ENOBUFS), or assembler full.
+  [[nodiscard]] uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+  bool send_genl(uint16_t type, uint8_t cmd, uint16_t attr, const void* data, size_t len);
+  bool await_reply(uint16_t type, uint16_t* family_id);
+  void loop();
+
+  std::atomic<int> sock_{-1};
+  uint16_t family_{0};
+  std::string cpumask_;
+  std::atomic<bool> running_{false};
+  std::thread thread_;
+  TaskExitAssembler assembler_;  // loop()'s only
+  std::mutex mu_;
+  std::vector<TaskExit> pending_;
+  std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace montauk::collectors
@@ -0,0 +1,32 @@
+#pragma once
+#include "collectors/ProcessCollector.hpp"
+#include "util/UringProcBatch.hpp"
+
+namespace montauk::collectors {
+
+// The traditional scanner with its per-pid stat/status reads batched through
+// io_uring (see util::UringProcBatch): the same rows, top-K and enrichment as
+// ProcessCollector, at two io_uring_enter calls per chunk of files instead of
+// four syscalls per file. init() fails when io_uring is unusable so the
+// Producer can pick another backend; if the ring fails later (or the kernel
+// rejects the opcodes) the scan falls back to ProcessCollector's synchronous
+// reads for the rest of the run.
+class UringProcessCollector : public ProcessCollector {
+public:
+  using ProcessCollector::ProcessCollector;
+  bool init() override { return batch_.init(); }
+  const char* name() const override { return "io_uring /proc Scanner"; }
+
+  // io_uring_enter calls the last batched scan made (0 after a fallback).
+  [[nodiscard]] uint64_t last_enters() const { return batch_.last_enters(); }
+
+protected:
+  size_t scan(std::span<const int32_t> pids, const ScanCtx& c,
+              std::vector<montauk::model::ProcSample>& rows, montauk::model::ProcessSnapshot& out) override;
+
+private:
+  montauk::util::UringProcBatch batch_{};
+  ShardedScan::Shard sh_{};
+};
+
+} // namespace montauk::collectors
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace montauk::model {
+
+// One cgroup v2 directory. cgroup v2 counters are hierarchical -- a group's
+// cpu.stat, memory.current and io.stat already include every descendant --
+// so these are subtree totals as the kernel keeps them, not sums montauk made.
+struct CgroupStat {
+  std::string path;          // relative to the cgroup root; "/" is the root
+  int depth{};               // 0 for the root
+  double cpu_pct{};          // cpu.stat usage_usec rate; 100 = one core
+  double throttled_pct{};    // cpu.stat throttled_usec rate, same scale
+  uint64_t mem_bytes{};      // memory.current
+  uint64_t anon_bytes{};     // memory.stat anon
+  uint64_t file_bytes{};     // memory.stat file
+  double io_read_bps{};      // io.stat rbytes rate, all devices
+  double io_write_bps{};     // io.stat wbytes rate, all devices
+  uint64_t pids{};           // pids.current
+};
+
+struct CgroupSnapshot {
+  std::vector<CgroupStat> groups;  // busiest first (cpu, then memory), capped
+  size_t total{};                  // cgroups tracked, published or not
+};
+
+} // namespace montauk::model
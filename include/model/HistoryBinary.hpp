@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary history-log format shared between the writer (LogWriter with
+// --log-format binary, via HistoryWriter) and the reader (HistoryReader, which
+// the --analyze scrape readers consume).
+//
+// Rationale: the hourly .prom text log re-renders every series at every
+// interval -- name, labels and a formatted number, ~60 bytes for a value that
+// usually did not change -- and reading it back means tokenizing every line
+// again. Here a series' name and labels are written once per segment, and its
+// values are stored column by column in blocks of scrapes, each value XOR'd
+// against the one before it so an unchanged value costs one byte and a column
+// that never changed within a block costs nine.
+//
+// Layout:
+//   [ HistoryFileHeader ] [ frame ] [ frame ] ... [ INDX frame ]
+//   [ HistoryFileHeader ] ...          <- a writer reopening the hour appends
+//                                         a new segment with its own dictionary
+//
+// Each frame: a little-endian uint32 tag, a uint32 payload length, then the
+// payload. Integers inside a payload are LEB128 varints ("uv"); signed ones
+// are zigzag'd first ("sv").
+//
+//   BLCK  uv new_series, then per new series:
+//           u8 kind (SeriesKind), uv name_len, name, uv labels_len, labels
+//         uv scrapes, uv series   (dictionary size this block's columns cover)
+//         sv first timestamp_ms, then sv delta-of-delta per further scrape
+//         per series id 0..series-1: u8 HistoryColumn, then its data
+//   INDX  uv blocks, then per block: uv frame offset (from the segment
+//         header), sv first_ms, sv last_ms, uv scrapes
+//
+// A column's values are a XOR stream: each double's bits XOR the previous
+// value's (0 before the first), written as a control byte -- leading zero
+// bytes << 4 | trailing zero bytes -- then the bytes between, low first. 0x80
+// alone means "same as before". Labels are the raw Prometheus text between
+// the braces (k="v",...), escapes included, so a series read back keys
+// exactly like the same line of a .prom log.
+//
+// The INDX frame is written when the segment is closed (hour rotation,
+// shutdown); a segment cut short by a crash simply has none, and readers scan
+// its blocks instead.
+
+namespace montauk::model {
+
+// "MTKHIST1" -- exactly 8 bytes, no NUL terminator stored.
+inline constexpr char kHistoryMagic[8] = {'M', 'T', 'K', 'H', 'I', 'S', 'T', '1'};
+
+// Bump on any incompatible header/frame change. Readers refuse mismatched
+// versions rather than decoding garbage.
+inline constexpr uint32_t kHistoryFormatVersion = 1;
+
+struct HistoryFileHeader {
+  char     magic[8];    // kHistoryMagic (not NUL-terminated)
+  uint32_t version;     // kHistoryFormatVersion
+  uint32_t flags;       // reserved, 0
+  int64_t  created_ms;  // wall clock when the segment was opened
+};
+
+inline constexpr uint32_t kHistoryTagBlock = 0x4b434c42;  // "BLCK"
+inline constexpr uint32_t kHistoryTagIndex = 0x58444e49;  // "INDX"
+
+// Prometheus TYPE of a series' family. _bucket/_sum/_count series carry their
+// family's Histogram or Summary kind.
+enum class SeriesKind : uint8_t { Untyped, Gauge, Counter, Histogram, Summary };
+
+// How one series' values are stored in a block.
+enum class HistoryColumn : uint8_t {
+  Absent,  // in none of the block's scrapes
+  Const,   // in all of them, one value: 8 raw bytes
+  Xor,     // in all of them: a XOR stream of `scrapes` values
+  Sparse,  // in some: a presence bitmap of ceil(scrapes/8) bytes, then a
+           // XOR stream of the present values
+};
+
+} // namespace montauk::model
@@ -0,0 +1,205 @@
+#pragma once
+
+// Writer and reader for montauk history logs. HistoryWriter produces the
+// binary format in model/HistoryBinary.hpp and PromDeltaEncoder the
+// change-only .prom text; HistoryReader reads those and plain .prom text logs
+// alike, handing all three out as the same full scrapes of interned series,
+// so a consumer is written once against ids and doubles rather than once per
+// file format.
+
+#include "model/HistoryBinary.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace montauk::model {
+
+// One time series: a family name plus the raw text of its label set.
+struct HistorySeries {
+  std::string name;
+  std::string labels;  // k="v",... as written between the braces; empty if none
+  SeriesKind kind{SeriesKind::Untyped};
+
+  // name{labels}, or name alone -- the series' identity in a .prom line.
+  [[nodiscard]] std::string key() const {
+    return labels.empty() ? name : name + '{' + labels + '}';
+  }
+};
+
+// Series key -> id, looked up by string_view so a reader can probe with the
+// bytes of a line without building a std::string per sample.
+struct HistoryKeyHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+using HistoryIds = std::unordered_map<std::string, uint32_t, HistoryKeyHash, std::equal_to<>>;
+
+class HistoryWriter {
+public:
+  // A block closes after this many scrapes or once it spans this long,
+  // whichever comes first -- the most a crash can lose.
+  static constexpr size_t kBlockScrapes = 60;
+  static constexpr int64_t kBlockSpanMs = 60'000;
+
+  HistoryWriter() = default;
+  ~HistoryWriter();
+  HistoryWriter(const HistoryWriter&) = delete;
+  HistoryWriter& operator=(const HistoryWriter&) = delete;
+
+  // Open `path` for append and start a new segment there. False (errno set)
+  // if it cannot be opened or the header cannot be written.
+  [[nodiscard]] bool open(const char* path, int64_t now_ms);
+  // Write the pending block and the segment's index, then close.
+  void close();
+  [[nodiscard]] bool is_open() const { return f_ != nullptr; }
+
+  // One scrape: begin_scrape, a sample per series, end_scrape. A series
+  // sampled twice in one scrape keeps the later value.
+  void begin_scrape(int64_t ts_ms);
+  void sample(std::string_view name, std::string_view labels, SeriesKind kind, double v);
+  // Closes the block when it is full; false if writing it failed.
+  [[nodiscard]] bool end_scrape();
+
+  // Series interned in this segment so far.
+  [[nodiscard]] size_t series() const { return cols_.size(); }
+
+private:
+  struct Column {
+    std::vector<uint32_t> rows;  // scrape index within the pending block
+    std::vector<double> vals;
+  };
+  struct IndexEntry {
+    uint64_t offset;
+    int64_t first_ms, last_ms;
+    uint32_t scrapes;
+  };
+
+  bool write_block();
+  bool write_frame(uint32_t tag, const std::string& payload);
+
+  FILE* f_{nullptr};
+  uint64_t seg_pos_{0};  // bytes written since the segment header
+  HistoryIds ids_;
+  std::string key_;
+  std::vector<HistorySeries> new_series_;  // interned since the last block
+  std::vector<Column> cols_;
+  std::vector<int64_t> ts_;
+  std::vector<IndexEntry> index_;
+  std::string buf_;
+};
+
+// Change-only .prom text (LogWriter's --log-format delta). A keyframe block is
+// a plain scrape: the timestamp comment, then the whole exposition. A delta
+// block is the timestamp comment, kPromDeltaComment, then only the samples
+// whose value text changed since the previous block -- each after its
+// family's HELP/TYPE if those were not yet written since the keyframe -- and a
+// kPromRemovedComment line per series the previous block had and this one
+// lacks. Replaying the blocks in order gives back every full scrape.
+inline constexpr std::string_view kPromDeltaComment = "# montauk_scrape_delta";
+inline constexpr std::string_view kPromRemovedComment = "# montauk_scrape_removed ";
+
+class PromDeltaEncoder {
+public:
+  // A keyframe at least this often, so a reader can start decoding at one
+  // without replaying the file from the top.
+  static constexpr int64_t kKeyframeMs = 60'000;
+
+  // Append the block for one scrape of exposition `body`, taken at `ts_ms`.
+  void encode(int64_t ts_ms, std::string_view body, std::string& out);
+  // Make the next block a keyframe: a new file must not depend on the last.
+  void reset() { keyframe_ms_ = -1; }
+
+private:
+  struct Entry {
+    std::string value;  // value text as rendered, timestamp included if any
+    uint32_t gen;       // last block the series appeared in
+  };
+  std::unordered_map<std::string, Entry, HistoryKeyHash, std::equal_to<>> last_;
+  std::unordered_map<std::string, uint32_t, HistoryKeyHash, std::equal_to<>> headed_;  // family -> keyframe gen
+  int64_t keyframe_ms_{-1};
+  uint32_t gen_{0};
+  uint32_t keyframe_gen_{0};
+};
+
+enum class HistoryReadStatus {
+  Ok,          // open succeeded / clean end
+  OpenFailed,
+  BadVersion,  // a binary segment of another format version
+  Corrupt,     // a frame that does not decode; reading stops there
+};
+
+// The series present in one scrape, as parallel id/value arrays. ids index
+// HistoryReader::series().
+struct HistoryScrape {
+  int64_t ts_ms{-1};  // -1: a text log without timestamp comments
+  std::vector<uint32_t> ids;
+  std::vector<double> values;
+};
+
+class HistoryReader {
+public:
+  HistoryReader() = default;
+  ~HistoryReader();
+  HistoryReader(const HistoryReader&) = delete;
+  HistoryReader& operator=(const HistoryReader&) = delete;
+
+  // Binary or Prometheus text, told apart by the first bytes.
+  [[nodiscard]] HistoryReadStatus open(const char* path);
+  void close();
+  [[nodiscard]] bool binary() const { return binary_; }
+
+  // Every series met so far, in first-seen order. Grows as next() reads on;
+  // a series repeated across binary segments or text scrapes keeps one id.
+  [[nodiscard]] const std::vector<HistorySeries>& series() const { return series_; }
+
+  // The next scrape, in file order. False at the end or when the rest of the
+  // file does not decode (status() says which).
+  [[nodiscard]] bool next(HistoryScrape& out);
+  [[nodiscard]] HistoryReadStatus status() const { return status_; }
+
+private:
+  uint32_t intern(std::string_view name, std::string_view labels, SeriesKind kind);
+  bool next_text(HistoryScrape& out);
+  bool next_binary(HistoryScrape& out);
+  bool read_segment_header();
+  bool decode_block(const std::vector<uint8_t>& payload);
+  SeriesKind text_kind(std::string_view name) const;
+  void begin_text_delta(HistoryScrape& out);
+  void end_text_scrape(HistoryScrape& out);
+
+  FILE* f_{nullptr};
+  bool binary_{false};
+  HistoryReadStatus status_{HistoryReadStatus::Ok};
+  std::vector<HistorySeries> series_;
+  HistoryIds ids_;
+  std::string key_;
+
+  // Binary: this segment's ids -> series_ ids, and the decoded block being
+  // handed out a scrape at a time.
+  std::vector<uint32_t> local_;
+  std::vector<HistoryScrape> block_;
+  size_t block_next_{0};
+  std::vector<uint8_t> frame_;
+
+  // Text: TYPE declarations, the line buffer and the look-ahead timestamp of
+  // the scrape after the one being returned.
+  std::unordered_map<std::string, SeriesKind, HistoryKeyHash, std::equal_to<>> types_;
+  char* line_{nullptr};
+  size_t line_cap_{0};
+  bool text_started_{false};
+  int64_t text_next_ts_{-1};
+
+  // Change-only text: the previous full scrape a delta block applies to, and
+  // each id's position in the scrape being rebuilt.
+  std::vector<uint32_t> prev_ids_;
+  std::vector<double> prev_values_;
+  std::vector<uint32_t> text_pos_;
+  bool text_delta_{false};
+};
+
+} // namespace montauk::model
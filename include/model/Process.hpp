@@ -1,6 +1,12 @@
 #pragma once
+#include "model/StringPool.hpp"
+
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace montauk::model {
@@ -11,6 +17,12 @@ enum class ChurnReason {
   ReadFailed,  // Transient /proc read error (not security-relevant)
 };
 
+// Age of a per-process value that has never been read (see ProcSample io_age_ms).
+inline constexpr uint32_t kAgeNever = UINT32_MAX;
+
+// One process row as a collector builds it. Collectors parse, rank and enrich
+// rows, then publish them into ProcessSnapshot's columns with assign_rows();
+// ProcessSnapshot::row() materializes one back for code that wants the struct.
 struct ProcSample {
   int32_t pid{};
   uint64_t total_time{}; // utime+stime, jiffies
@@ -29,6 +41,9 @@ struct ProcSample {
   // the /proc/PID/stat line the collectors already parse).
   uint64_t flt_raw{0};      // cumulative minor+major faults; rate derived in enrichment
   int      thread_count{1}; // /proc/PID/stat num_threads
+  // /proc/PID/stat starttime (jiffies after boot). With the pid it names one
+  // process incarnation: a recycled pid comes back with a different value.
+  uint64_t start_time{0};
   // Cumulative context-switch counters from /proc/PID/status, read for EVERY
   // process. The rate is what the anomaly fusion wants; the raw totals live here
   // so the delta can be taken across frames the way flt_raw's is.
@@ -43,10 +58,80 @@ struct ProcSample {
   double  ctxsw_delta{0.0};
   double  anomaly_score{0.0};
   int8_t  anomaly_axis{-1};   // 0=cpu 1=rss 2=gpu 3=faults 4=threads 5=ctxsw; -1 = none
+  // Storage I/O rates (/proc/PID/io read_bytes/write_bytes) and PSS
+  // (/proc/PID/smaps_rollup), filled after the scan by ProcIoPssSampler under
+  // a time budget. Not every row is read every tick, so each value carries the
+  // age of the read it came from at publish; kAgeNever = not read yet.
+  double   io_read_bps{0.0};
+  double   io_write_bps{0.0};
+  uint32_t io_age_ms{kAgeNever};
+  uint64_t pss_kb{0};
+  uint32_t pss_age_ms{kAgeNever};
+  // Process tree (collectors::ProcessTree): the parent from the stat line and
+  // totals over the subtree rooted here, this process included, taken over
+  // the whole population before the top-K cut. subtree_procs 0 = the
+  // collector keeps no tree.
+  int32_t  ppid{0};
+  double   subtree_cpu_pct{0.0};
+  uint64_t subtree_rss_kb{0};
+  uint32_t subtree_threads{0};
+  uint32_t subtree_procs{0};
 };
 
+// Processes of one comm that exited without ever appearing in a sample --
+// the fork-heavy tail (compilers, shell pipelines, test runners) whose whole
+// life fits between two scans. Totals are over their full lifetimes, from the
+// exit record (see util::ExitRollup).
+struct ExitedComm {
+  std::string comm;
+  uint64_t exits{};
+  uint64_t cpu_us{};      // utime+stime
+  uint64_t max_rss_kb{};  // largest high-water RSS among them
+  uint64_t io_bytes{};    // storage read+write
+};
+
+// The published process table, column-major: one vector per field, all the
+// same length, row i across every column. Readers copy a few flat arrays per
+// frame; the string fields are StringPool ids resolved through str(). Rows
+// are sorted by cpu desc.
 struct ProcessSnapshot {
-  std::vector<ProcSample> processes; // sorted by cpu desc
+  using StrId = StringPool::Id;
+
+  std::vector<int32_t>     pid;
+  std::vector<uint64_t>    total_time;   // utime+stime, jiffies
+  std::vector<uint64_t>    rss_kb;
+  std::vector<double>      cpu_pct;      // 0..100 (overall machine)
+  std::vector<ChurnReason> churn_reason;
+  std::vector<uint8_t>     has_gpu_util;
+  std::vector<double>      gpu_util_pct;
+  std::vector<uint8_t>     has_gpu_mem;
+  std::vector<uint64_t>    gpu_mem_kb;
+  std::vector<StrId>       user_name;
+  std::vector<StrId>       cmd;
+  std::vector<StrId>       exe_path;
+  std::vector<uint64_t>    flt_raw;
+  std::vector<int>         thread_count;
+  std::vector<uint64_t>    start_time;
+  std::vector<uint64_t>    vctx_raw;
+  std::vector<uint64_t>    nvctx_raw;
+  std::vector<double>      fault_delta;
+  std::vector<double>      ctxsw_delta;
+  std::vector<double>      anomaly_score;
+  std::vector<int8_t>      anomaly_axis;
+  std::vector<double>      io_read_bps;
+  std::vector<double>      io_write_bps;
+  std::vector<uint32_t>    io_age_ms;
+  std::vector<uint64_t>    pss_kb;
+  std::vector<uint32_t>    pss_age_ms;
+  std::vector<int32_t>     ppid;
+  std::vector<double>      subtree_cpu_pct;
+  std::vector<uint64_t>    subtree_rss_kb;
+  std::vector<uint32_t>    subtree_threads;
+  std::vector<uint32_t>    subtree_procs;
+  // Pool the string ids index. Shared with every copy of this snapshot and
+  // with the collector's later frames; null until the first assign_rows().
+  std::shared_ptr<StringPool> strings;
+
   size_t total_processes{};
   size_t running_processes{};
   // Number of processes enriched with full cmdline+user this cycle
@@ -59,12 +144,46 @@ struct ProcessSnapshot {
   size_t state_zombie{};    // 'Z'
   // System-wide thread statistics
   size_t total_threads{};      // Total threads across all processes
+  // Collection cost of the pass that produced this snapshot: wall time of the
+  // collector's sample() (set by the Producer, so every backend reports it) and
+  // how many shards the per-pid parse was split across (1 = serial).
+  uint64_t sample_us{};
+  size_t scan_shards{1};
   // Which anomaly feature axes actually carried signal this tick, one bit per
   // column of the feature table (cpu, rss, gpu, faults, threads, ctxsw). A
   // collector that cannot supply an axis leaves it constant, and a constant
   // column is excluded from the fusion rather than diluting it -- so the basis
   // is whatever this says, never the full six by assumption.
   uint32_t anomaly_axis_mask{};
+  // Recently exited short-lived processes by comm, cpu desc. Only collectors
+  // that see exits (netlink) fill it.
+  std::vector<ExitedComm> exited;
+
+  // Once the pool holds this many strings, assign_rows() starts a fresh one
+  // holding only the live rows' strings.
+  static constexpr size_t kPoolBudget = size_t{1} << 16;
+
+  [[nodiscard]] size_t size() const { return pid.size(); }
+  [[nodiscard]] bool empty() const { return pid.empty(); }
+  [[nodiscard]] const std::string& str(StrId id) const {
+    static const std::string kNone;
+    return strings ? strings->str(id) : kNone;
+  }
+  [[nodiscard]] const std::string& cmd_of(size_t i) const { return str(cmd[i]); }
+  [[nodiscard]] const std::string& user_of(size_t i) const { return str(user_name[i]); }
+  [[nodiscard]] const std::string& exe_of(size_t i) const { return str(exe_path[i]); }
+
+  // Replace every row with rows, interning their strings. The collectors'
+  // publish step; creates the pool on first use.
+  void assign_rows(std::span<const ProcSample> rows);
+  // Append one row (tests, fixtures).
+  void push_back(const ProcSample& r);
+  // Row i as a struct, strings copied out of the pool.
+  [[nodiscard]] ProcSample row(size_t i) const;
+  // The first n rows of src (same pool), with src's counters. What a
+  // bounded reader such as read_metrics_snapshot copies.
+  void assign_prefix(const ProcessSnapshot& src, size_t n);
+  void clear_rows();
 };
 
 } // namespace montauk::model
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace montauk::model {
+
+// One line of a PSI file ("some ..." or "full ..."): the share of wall time
+// in which at least one (some) or every (full) non-idle task was stalled.
+struct PsiLine {
+  double avg10{};      // percent, 10 s running average
+  double avg60{};
+  double avg300{};
+  uint64_t total_us{};  // cumulative stall time
+};
+
+// cpu, memory or io pressure for the whole system or one cgroup.
+struct PsiResource {
+  std::string scope;     // "system", or a cgroup path ("/system.slice")
+  std::string resource;  // "cpu" | "memory" | "io"
+  PsiLine some;
+  PsiLine full;          // all zero where the kernel has no full line
+  bool has_full{};
+  bool armed{};              // a stall trigger is registered on it
+  uint64_t trigger_fires{};  // times that trigger fired since start
+};
+
+struct PsiSnapshot {
+  std::vector<PsiResource> entries;  // system scope first, then cgroups
+  uint64_t trigger_fires{};          // all entries
+};
+
+} // namespace montauk::model
@@ -9,6 +9,8 @@
 #include "model/Process.hpp"
 #include "model/Thermal.hpp"
 #include "model/Fs.hpp"
+#include "model/Cgroup.hpp"
+#include "model/Psi.hpp"
 #include "model/Provider.hpp"
 
 namespace montauk::model {
@@ -100,6 +102,8 @@ struct Snapshot {
   NetSnapshot net;
   DiskSnapshot disk;
   FsSnapshot fs;
+  CgroupSnapshot cgroups;
+  PsiSnapshot psi;
   std::vector<Provider> providers;
   ProcessSnapshot procs;
   std::vector<AlertItem> alerts; // latest generated alerts with severity
@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace montauk::model {
+
+// Append-only string intern pool behind ProcessSnapshot's string columns
+// (user, command line, executable). A snapshot stores 32-bit ids and holds the
+// pool by shared_ptr, so copying a snapshot -- each SnapshotBuffers publish,
+// read_metrics_snapshot's top rows -- copies flat id arrays and bumps one
+// refcount instead of deep-copying thousands of small strings.
+//
+// One writer (the process collector, on the Producer thread) interns; any
+// number of readers resolve ids concurrently. Strings live in fixed-size chunks
+// behind a fixed-size chunk table, so an append never moves a string or the
+// table a reader is indexing. A reader only ever holds ids interned before the
+// snapshot carrying them was published, and that publish orders the append
+// before the read. Nothing is ever removed: when the pool grows past its
+// budget the writer starts a fresh one (see ProcessSnapshot::assign_rows) and
+// the old one lives on until the last snapshot referring to it is dropped.
+class StringPool {
+public:
+  using Id = uint32_t;
+  static constexpr Id kEmpty = 0;  // "", pre-interned
+
+  StringPool();
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // Writer only. Returns the existing id for s, or appends it.
+  [[nodiscard]] Id intern(std::string_view s);
+  // Any thread, for an id taken from a published snapshot of this pool.
+  [[nodiscard]] std::string_view get(Id id) const {
+    return chunks_[id >> kChunkShift][id & (kChunkSize - 1)];
+  }
+  [[nodiscard]] const std::string& str(Id id) const {
+    return chunks_[id >> kChunkShift][id & (kChunkSize - 1)];
+  }
+  // Writer only.
+  [[nodiscard]] size_t size() const { return count_; }
+  [[nodiscard]] bool full() const { return count_ == kCapacity; }
+
+  static constexpr size_t kChunkShift = 10;
+  static constexpr size_t kChunkSize = size_t{1} << kChunkShift;
+  static constexpr size_t kMaxChunks = 1024;
+  static constexpr size_t kCapacity = kChunkSize * kMaxChunks;
+
+private:
+  std::array<std::unique_ptr<std::string[]>, kMaxChunks> chunks_;
+  size_t count_{0};
+  // Keys view the chunk-resident strings, which never move.
+  std::unordered_map<std::string_view, Id> index_;
+};
+
+}  // namespace montauk::model
@@ -49,8 +49,21 @@ struct Config {
     int max_procs = 256;
     int enrich_top_n = 256;
     std::string collector = "auto";
+    int scan_threads = 0;  // 0 = auto, 1 = serial
+    int fd_cache = -1;     // hot-pid fds kept open; -1 = auto, 0 = off
+    std::string cpu_accounting = "ticks";  // "ticks" | "schedstat"
+    int interval_ms = 0;   // process scan cadence; 0 = auto (1000 ticks, 250 schedstat)
+    int io_budget_us = 2000;  // per-tick time for /proc/PID/io + smaps_rollup reads; 0 = off
+    int io_top_k = 16;        // rows read every tick; the rest rotate
   } process;
 
+  // [psi] section
+  struct Psi {
+    int stall_ms = 150;    // trigger when tasks stall this long ...
+    int window_ms = 1000;  // ... within this window; stall_ms 0 = no triggers
+    std::string cgroups;   // comma-separated v2 groups to watch too, e.g. "system.slice"
+  } psi;
+
   // [nvidia]
   struct Nvidia {
     std::string smi_path = "auto";
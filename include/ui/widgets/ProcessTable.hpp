@@ -2,8 +2,10 @@
 
 #include "ui/widget/Component.hpp"
 #include "app/Filter.hpp"
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_set>
 
 namespace montauk::ui {
 enum class SortMode { CPU, MEM, PID, NAME, GPU, GMEM };
@@ -12,8 +14,8 @@ enum class SortMode { CPU, MEM, PID, NAME, GPU, GMEM };
 namespace montauk::ui::widgets {
 
 // PROCESS MONITOR. Owns all process-table state (sort mode, scroll offset,
-// search filter, sticky column widths, CPU/GPU scaling preference). Input
-// goes through Component::handle_input.
+// search filter, tree mode and its collapsed set, sticky column widths,
+// CPU/GPU scaling preference). Input goes through Component::handle_input.
 class ProcessTable : public widget::Component {
  public:
   enum class CPUScale { Total, Core };
@@ -44,6 +46,13 @@ class ProcessTable : public widget::Component {
   GPUScale gpu_scale_   = GPUScale::Utilization;
   bool     show_gmem_   = true;
 
+  // Tree mode: rows threaded under their parents. A collapsed row hides its
+  // children and shows its subtree's rollups in their place. Left/Right
+  // collapse/expand the row at the top of the view (top_pid_, last frame's).
+  bool tree_mode_ = false;
+  std::unordered_set<int32_t> collapsed_;
+  int32_t top_pid_ = -1;
+
   // Search overlay state.
   bool        search_mode_  = false;
   std::string filter_query_;
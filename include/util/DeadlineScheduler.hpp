@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace montauk::util {
+
+// Deadline scheduler for the Producer loop: periodic timers in a min-heap
+// behind one absolute CLOCK_MONOTONIC timerfd, plus external wake sources,
+// all in one epoll set. run_once() sleeps until exactly the earliest deadline
+// or the first readable fd -- no fixed polling tick -- then runs every timer
+// that is due, in registration order, and every fd callback that is ready.
+//
+// Timers keep phase: a timer due at t re-arms for t + period, so a late
+// wakeup does not push the cadence back; one that fell a whole period behind
+// skips to now + period rather than firing a burst. Watched fds are level-
+// triggered and their callbacks must drain them. wake() is safe from any
+// thread and makes a blocked run_once() return (stop requests use it).
+//
+// Without epoll/timerfd (ok() false) run_once() degrades to sleeping until
+// the next deadline, bounded so wake() is noticed within kFallbackSlice;
+// watched fds are then never reported.
+class DeadlineScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr std::chrono::milliseconds kFallbackSlice{100};
+
+  DeadlineScheduler();
+  ~DeadlineScheduler();
+  DeadlineScheduler(const DeadlineScheduler&) = delete;
+  DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+  [[nodiscard]] bool ok() const { return epfd_ >= 0 && tfd_ >= 0 && wakefd_ >= 0; }
+
+  // Run fn every period, first at `first`.
+  void every(std::chrono::milliseconds period, std::function<void()> fn,
+             Clock::time_point first = Clock::now());
+  // Run fn whenever fd is readable. The scheduler does not own fd.
+  bool watch(int fd, std::function<void()> fn);
+  // Run fn(revents) whenever fd reports any of `events` (an epoll mask, e.g.
+  // EPOLLPRI for a PSI trigger) or an error; revents is what epoll returned.
+  bool watch(int fd, uint32_t events, std::function<void(uint32_t)> fn);
+  // Stop reporting fd; safe from inside its own callback.
+  void unwatch(int fd);
+  // Make a blocked (or the next) run_once() return. Any thread.
+  void wake();
+
+  // Block until something is due, then dispatch it. Returns the number of
+  // timers and fd callbacks run (0 for a bare wake()).
+  size_t run_once();
+
+  // Times run_once() came back from the kernel; what the Producer's own
+  // wakeups-per-second figure is built from.
+  [[nodiscard]] uint64_t wakeups() const { return wakeups_; }
+
+private:
+  struct Timer {
+    Clock::time_point due;
+    std::chrono::milliseconds period;
+    std::function<void()> fn;
+  };
+  struct Watch {
+    int fd;  // -1 once unwatched; the slot stays so tags remain stable
+    std::function<void(uint32_t)> fn;
+  };
+  void arm();
+  size_t fire_due(Clock::time_point now);
+
+  int epfd_{-1};
+  int tfd_{-1};
+  int wakefd_{-1};
+  std::vector<Timer> timers_;
+  std::vector<size_t> heap_;  // indexes into timers_, earliest due on top
+  std::vector<Watch> watches_;
+  std::vector<size_t> due_;   // scratch for fire_due()
+  uint64_t wakeups_{0};
+};
+
+} // namespace montauk::util
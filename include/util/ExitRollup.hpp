@@ -0,0 +1,44 @@
+#pragma once
+#include "model/Process.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace montauk::util {
+
+// Per-comm rollup of exited short-lived processes over a trailing window, in
+// bounded memory. Two generations of kGeneration each: add() lands in the
+// current one, which becomes the previous one when it ages out, so publish()
+// covers the last 30-60 s. Each generation holds at most kMaxComms names;
+// later names fold into kOther rather than growing the map, which is what a
+// fork bomb of uniquely named processes would otherwise do. Single-threaded:
+// the collector's sample() both adds and publishes.
+class ExitRollup {
+public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr std::chrono::seconds kGeneration{30};
+  static constexpr size_t kMaxComms = 256;
+  static constexpr size_t kPublish = 32;
+  static constexpr std::string_view kOther = "[other]";
+
+  void add(std::string_view comm, uint64_t cpu_us, uint64_t rss_kb, uint64_t io_bytes,
+           Clock::time_point now);
+
+  // Both generations merged, cpu desc, at most n rows; the rest fold into
+  // kOther. Empty when nothing exited in the window.
+  void publish(std::vector<montauk::model::ExitedComm>& out, Clock::time_point now,
+               size_t n = kPublish);
+
+private:
+  using Gen = std::unordered_map<std::string, montauk::model::ExitedComm>;
+  void rotate(Clock::time_point now);
+  Gen cur_, prev_;
+  Clock::time_point started_{};
+};
+
+} // namespace montauk::util
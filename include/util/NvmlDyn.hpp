@@ -2,6 +2,7 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <mutex>
 #include "model/Snapshot.hpp"
 
 namespace montauk::util {
@@ -40,8 +41,10 @@ private:
   NvmlDyn(const NvmlDyn&) = delete;
   NvmlDyn& operator=(const NvmlDyn&) = delete;
 
+  bool load();  // the body of load_once(), run exactly once
+
   void* handle_{};
-  bool loaded_{false};
+  std::once_flag loaded_;
   bool suppressed_{false};
 
   // Function pointers (subset used by GpuCollector)
@@ -0,0 +1,91 @@
+#pragma once
+#include "util/Procfs.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
+namespace montauk::util {
+
+// Bounded LRU of open /proc/<pid>/{stat,status,cmdline} fds for the processes
+// that stay in the top-K frame after frame. A procfs fd re-read with pread at
+// offset 0 regenerates its contents, so a hot pid costs one pread per file per
+// cycle instead of openat + pread + pread + close.
+//
+// Entries are keyed by (pid, starttime): a pid whose starttime changed is a
+// recycled pid and its fds are dropped before use. A read that fails (ESRCH
+// once the task has exited) drops the pid too, and collectors with an exit
+// feed call invalidate() directly. The cap counts fds, not pids, so it can be
+// sized against RLIMIT_NOFILE; 0 disables the cache, and a nonzero cap holds
+// at least one pid's three fds.
+class PidFdCache {
+public:
+  enum Leaf : uint8_t { Stat, Status, Cmdline, kLeaves };
+
+  explicit PidFdCache(size_t max_fds = 0)
+    : max_fds_(max_fds == 0 ? 0 : std::max<size_t>(max_fds, kLeaves)) {}
+  ~PidFdCache() { clear(); }
+  PidFdCache(const PidFdCache&) = delete;
+  PidFdCache& operator=(const PidFdCache&) = delete;
+
+  [[nodiscard]] bool enabled() const { return max_fds_ > 0; }
+  [[nodiscard]] size_t open_fds() const { return open_fds_; }
+
+  // Advance the LRU clock; call once per collection cycle.
+  void tick() { ++clock_; }
+
+  // Make sure pid's leaf has a cached fd (opening it on a miss) without
+  // reading it. Collectors prime the stat fd of the pids they enrich so the
+  // next scan's read_cached() hits. False if it cannot be opened.
+  bool open(ProcReader& rd, int32_t pid, uint64_t starttime, Leaf leaf);
+
+  // pid's leaf through its cached fd, opened through rd and cached on a miss
+  // (evicting the least recently used pids past the cap). The contents alias
+  // rd's buffer. nullopt when the file cannot be opened or read; a failed read
+  // drops the pid.
+  [[nodiscard]] auto read(ProcReader& rd, int32_t pid, uint64_t starttime, Leaf leaf)
+      -> std::optional<std::string_view>;
+
+  // Lookup-only variant for the sharded scan: never opens, inserts or evicts,
+  // so concurrent callers are safe as long as each pid is read by one of
+  // them. nullopt on a miss or a failed read; the caller falls back to a
+  // plain read and the stale entry goes at the next sweep.
+  [[nodiscard]] auto read_cached(ProcReader& rd, int32_t pid, Leaf leaf)
+      -> std::optional<std::string_view>;
+
+  // Drop every entry for which stale(pid, starttime) is true. Collectors call
+  // it after a scan with "not seen, or seen with another starttime".
+  template <typename Pred>
+  void sweep(Pred&& stale) {
+    for (auto it = map_.begin(); it != map_.end();) {
+      if (stale(it->first, it->second.starttime)) { close_entry(it->second); it = map_.erase(it); }
+      else ++it;
+    }
+  }
+
+  void invalidate(int32_t pid);
+  void clear();
+
+private:
+  struct Entry {
+    uint64_t starttime{};
+    uint64_t last_use{};
+    std::array<int, kLeaves> fd{-1, -1, -1};
+  };
+  // pid's entry with leaf's fd open, created or reset as needed; nullptr
+  // if the fd cannot be opened.
+  Entry* entry(ProcReader& rd, int32_t pid, uint64_t starttime, Leaf leaf);
+  void close_entry(Entry& e);
+  void evict(int32_t keep);
+
+  size_t max_fds_;
+  size_t open_fds_{0};
+  uint64_t clock_{0};
+  std::unordered_map<int32_t, Entry> map_;
+};
+
+}  // namespace montauk::util
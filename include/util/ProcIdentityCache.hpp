@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace montauk::util {
+
+// What a process is -- command line, executable, owner -- changes at exec and
+// essentially never otherwise, yet the collectors re-read cmdline, readlink'd
+// exe and parsed status for every kept row every tick. This caches the three
+// per process image so a steady-state row costs its stat read and nothing
+// more. An entry is keyed on the pid, its starttime and its stat comm: a
+// starttime mismatch is a recycled pid, and since exec keeps the starttime but
+// resets comm to the new binary's name, a comm mismatch is an exec (a child
+// caught between fork and exec would otherwise keep its parent's identity).
+// prctl(PR_SET_NAME) also trips it, which costs one re-read. Netlink
+// invalidates on EXEC as well; the collectors sweep pids that are gone.
+//
+// The strings are interned: montauk's rows share a handful of users and a
+// few dozen executables, so entries hold pointers into one pool (node-based,
+// so the pointers are stable) instead of a copy each. The pool is compacted
+// once it outgrows the live entries.
+class ProcIdentityCache {
+public:
+  // A null field is "not read yet"; an empty string is "read, and empty" (a
+  // kernel thread has no cmdline or exe), which is not re-read either.
+  struct Entry {
+    uint64_t starttime{};
+    size_t comm_hash{};
+    uint64_t last_use{};
+    const std::string* exe{};
+    const std::string* cmd{};
+    const std::string* user{};
+  };
+
+  explicit ProcIdentityCache(size_t max_entries = 4096) : max_entries_(max_entries) {}
+
+  // Advance the LRU clock; call once per collection cycle.
+  void tick() { ++clock_; }
+
+  // pid's entry for this image: created empty on a miss, reset when the
+  // cached starttime or comm differs. Past max_entries the least recently
+  // used pids are dropped first.
+  [[nodiscard]] Entry& at(int32_t pid, uint64_t starttime, std::string_view comm);
+
+  [[nodiscard]] const std::string* intern(std::string_view s);
+
+  void invalidate(int32_t pid) { map_.erase(pid); }
+
+  // Drop every entry for which stale(pid, starttime) is true.
+  template <typename Pred>
+  void sweep(Pred&& stale) {
+    std::erase_if(map_, [&](const auto& kv) { return stale(kv.first, kv.second.starttime); });
+    if (pool_.size() > 3 * map_.size() + 256) compact();
+  }
+
+  [[nodiscard]] size_t size() const { return map_.size(); }
+  [[nodiscard]] size_t pool_size() const { return pool_.size(); }
+
+private:
+  struct Hash {
+    using is_transparent = void;
+    size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+  };
+  void evict();
+  void compact();
+
+  size_t max_entries_;
+  uint64_t clock_{0};
+  std::unordered_map<int32_t, Entry> map_;
+  std::unordered_set<std::string, Hash, std::equal_to<>> pool_;
+};
+
+}  // namespace montauk::util
@@ -1,6 +1,9 @@
 // C++23 utility helpers for reading /proc with optional root remap
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 
@@ -18,10 +21,68 @@ namespace montauk::util {
 // Read entire file as bytes. Returns std::nullopt on error.
 [[nodiscard]] auto read_file_bytes(const std::string& abs) -> std::optional<std::vector<unsigned char>>;
 
+// Read an already-mapped path into buf, reusing its storage. No remap is
+// applied: callers that cache a path resolve it through map_*_path once.
+[[nodiscard]] auto read_file_into(const char* path, std::string& buf) -> bool;
+
 // List directory entries (names only). Returns empty vector on error.
 [[nodiscard]] auto list_dir(const std::string& abs) -> std::vector<std::string>;
 
 // Read symlink target. Returns std::nullopt on error.
 [[nodiscard]] auto read_symlink(const std::string& abs) -> std::optional<std::string>;
 
+// Allocation-free /proc reader for the per-cycle hot paths. Holds one open
+// dirfd on /proc (MONTAUK_PROC_ROOT-mapped, re-resolved whenever the variable
+// changes) and reads with openat + pread into a buffer it owns, so after the
+// first cycle grows the buffer to the largest file seen, a read costs the
+// syscalls and nothing else. Paths are relative to /proc ("stat",
+// "1234/status"); no path string is ever built on the heap.
+//
+// Every view returned aliases the reader's buffer and is valid only until the
+// next call on the same reader. One reader per collector (or per worker
+// thread): it is deliberately not thread-safe.
+class ProcReader {
+public:
+  ProcReader() = default;
+  ~ProcReader();
+  ProcReader(const ProcReader&) = delete;
+  ProcReader& operator=(const ProcReader&) = delete;
+
+  // Whole file at /proc/<rel>.
+  [[nodiscard]] auto read(const char* rel) -> std::optional<std::string_view>;
+  // Whole file at /proc/<pid>/<leaf>.
+  [[nodiscard]] auto read_pid(int32_t pid, const char* leaf) -> std::optional<std::string_view>;
+  // Symlink target of /proc/<pid>/<leaf> (e.g. "exe").
+  [[nodiscard]] auto readlink_pid(int32_t pid, const char* leaf) -> std::optional<std::string_view>;
+
+  // Numeric entries of /proc (every live tgid), in directory order. The vector
+  // is owned by the reader and refilled in place each call.
+  [[nodiscard]] auto pids() -> const std::vector<int32_t>&;
+  // Numeric entries of /proc/<pid>/<sub> (e.g. the fd numbers under "fdinfo")
+  // appended to out after clearing it. False if the directory cannot be opened.
+  [[nodiscard]] auto list_numeric(int32_t pid, const char* sub, std::vector<int32_t>& out) -> bool;
+  // Open /proc/<pid>/<leaf> read-only and hand the fd to the caller, who owns
+  // it (PidFdCache keeps such fds across cycles). -1 on failure.
+  [[nodiscard]] int open_pid(int32_t pid, const char* leaf);
+  // Whole file behind an already-open fd, re-read from offset 0 with pread, so
+  // a long-lived procfs fd yields fresh contents each call. nullopt on a read
+  // error (ESRCH: the task exited since the fd was opened).
+  [[nodiscard]] auto read_fd(int fd) -> std::optional<std::string_view>;
+  // The reader's dirfd on the current proc root (reopened on a root change),
+  // for callers that issue their own *at() requests, e.g. a batched io_uring
+  // scan. Owned by the reader; -1 if the root cannot be opened.
+  [[nodiscard]] int root_fd() { return ensure_root() ? dirfd_ : -1; }
+
+private:
+  [[nodiscard]] bool ensure_root();
+  [[nodiscard]] auto read_at(const char* rel) -> std::optional<std::string_view>;
+  static void fill_numeric(int dfd, std::vector<int32_t>& out);
+
+  int dirfd_{-1};
+  bool root_set_{false};
+  std::string root_;          // MONTAUK_PROC_ROOT the dirfd was opened under
+  std::string buf_;           // grow-only read buffer; views alias it
+  std::vector<int32_t> pids_;
+};
+
 } // namespace montauk::util
@@ -3,7 +3,8 @@
 
 namespace montauk::util {
 
-// Runtime liburing loader (dlopen/dlsym), mirroring util/NvmlDyn.
+// Runtime liburing loader (dlopen/dlsym), mirroring util/NvmlDyn. Shared by
+// the metrics endpoint and the batched procfs collector (UringProcBatch).
 //
 // liburing was hard-linked, which put it in montauk's DT_NEEDED and made the
 // whole binary fail to LOAD on a box without it -- including for flags that
@@ -24,6 +25,10 @@ public:
 
   int queue_init(unsigned entries, struct io_uring* ring, unsigned flags);
   int submit(struct io_uring* ring);
+  // Submit and block until at least wait_nr completions are posted, in one
+  // io_uring_enter. Falls back to submit + wait_cqe on a liburing without the
+  // export (the batched procfs scan is the only caller that needs it).
+  int submit_and_wait(struct io_uring* ring, unsigned wait_nr);
   int wait_cqe(struct io_uring* ring, struct io_uring_cqe** cqe_ptr);
   void queue_exit(struct io_uring* ring);
 
@@ -38,6 +43,7 @@ private:
 
   int (*p_queue_init)(unsigned, struct io_uring*, unsigned){};
   int (*p_submit)(struct io_uring*){};
+  int (*p_submit_and_wait)(struct io_uring*, unsigned){};  // optional
   int (*p_get_cqe)(struct io_uring*, struct io_uring_cqe**, unsigned, unsigned,
                    sigset_t*){};
   void (*p_queue_exit)(struct io_uring*){};
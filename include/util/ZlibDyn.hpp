@@ -0,0 +1,39 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+
+namespace montauk::util {
+
+// Runtime zlib loader (dlopen/dlsym), mirroring util/UringDyn: zlib.h is a
+// BUILD dependency (z_stream needs a layout), libz is not a LINK one, so a box
+// without it serves /metrics uncompressed instead of failing to exec.
+class ZlibDyn {
+public:
+  static ZlibDyn& instance();
+
+  // dlopen libz once (idempotent, thread-safe). Respects MONTAUK_ZLIB_PATH.
+  [[nodiscard]] bool load_once();
+
+  // gzip-wrap `in` into `out` (replacing it); false if zlib is unavailable or
+  // deflate failed, with `out` left empty.
+  [[nodiscard]] bool gzip(std::string_view in, std::string& out);
+
+private:
+  ZlibDyn() = default;
+  ZlibDyn(const ZlibDyn&) = delete;
+  ZlibDyn& operator=(const ZlibDyn&) = delete;
+
+  bool load();  // the body of load_once(), run exactly once
+
+  void* handle_{};
+  std::once_flag loaded_;
+
+  int (*p_deflateInit2_)(z_streamp, int, int, int, int, int, const char*, int){};
+  int (*p_deflate)(z_streamp, int){};
+  int (*p_deflateEnd)(z_streamp){};
+  uLong (*p_deflateBound)(z_streamp, uLong){};
+};
+
+}  // namespace montauk::util
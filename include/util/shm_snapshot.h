@@ -0,0 +1,217 @@
+#ifndef MONTAUK_UTIL_SHM_SNAPSHOT_H
+#define MONTAUK_UTIL_SHM_SNAPSHOT_H
+
+// The shared-memory snapshot segment `montauk --shm PATH` publishes: a fixed,
+// versioned binary layout behind a seqlock, so a local sidecar maps the file
+// once and then reads the latest CPU, memory and process table with no
+// syscalls and nothing to parse. Shared by montauk (C++23, the writer) and any
+// C or C++ reader; installed as <montauk/shm_snapshot.h>.
+//
+// POD by construction, fixed-width fields only, naturally aligned with no
+// implicit padding, so the layout is the same in C and C++ on one machine. It
+// is a same-host format: native byte order throughout.
+//
+// Protocol. The writer bumps hdr.seq to odd, copies the new data in, and
+// bumps it to even. A reader loads seq (acquire), copies, fences, reloads it;
+// equal and even means the copy is consistent. Any layout change bumps
+// MONTAUK_SHM_VERSION, which open() checks.
+//
+// Header-only: every function is static inline, like util/sink.h.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MONTAUK_SHM_MAGIC   UINT64_C(0x314d48534b544e4d)  // "MNTKSHM1" in memory on little-endian
+#define MONTAUK_SHM_VERSION 1u
+
+#define MONTAUK_SHM_MAX_CPUS  512
+#define MONTAUK_SHM_MAX_PROCS 256
+#define MONTAUK_SHM_USER_LEN  32
+#define MONTAUK_SHM_CMD_LEN   96
+
+// montauk_shm_header.flags
+#define MONTAUK_SHM_F_LIVE 1u  // cleared when the writer exits cleanly
+
+// montauk_shm_proc.flags: which optional values are present.
+#define MONTAUK_SHM_PROC_GPU  1u  // gpu_util_pct / gpu_mem_kb
+#define MONTAUK_SHM_PROC_IO   2u  // io_read_bps / io_write_bps
+#define MONTAUK_SHM_PROC_PSS  4u  // pss_kb
+#define MONTAUK_SHM_PROC_TREE 8u  // ppid / subtree_*
+
+typedef struct montauk_shm_header {
+  uint64_t magic;         // written last when the segment is created
+  uint32_t version;       // MONTAUK_SHM_VERSION
+  uint32_t header_size;   // sizeof(montauk_shm_header)
+  uint64_t segment_size;  // bytes the writer mapped; >= sizeof(montauk_shm_segment)
+  uint64_t seq;           // seqlock: odd while a write is in progress
+  uint64_t generation;    // montauk's publish count for the snapshot held
+  uint64_t publish_ns;    // CLOCK_REALTIME when it was written
+  uint32_t writer_pid;
+  uint32_t flags;         // MONTAUK_SHM_F_*
+  uint64_t reserved;
+} montauk_shm_header;
+
+typedef struct montauk_shm_cpu {
+  double   usage_pct;     // 0..100, whole machine
+  double   pct_user;
+  double   pct_system;
+  double   pct_iowait;
+  double   pct_irq;
+  double   pct_steal;
+  double   freq_avg_mhz;  // 0 = unknown
+  double   ctxt_per_sec;
+  double   intr_per_sec;
+  uint32_t logical_threads;
+  uint32_t ncpus;         // entries of per_core_pct in use
+  double   per_core_pct[MONTAUK_SHM_MAX_CPUS];
+} montauk_shm_cpu;
+
+typedef struct montauk_shm_mem {
+  uint64_t total_kb;
+  uint64_t used_kb;
+  uint64_t available_kb;
+  uint64_t cached_kb;
+  uint64_t buffers_kb;
+  uint64_t swap_total_kb;
+  uint64_t swap_used_kb;
+  double   used_pct;
+} montauk_shm_mem;
+
+typedef struct montauk_shm_proc {
+  int32_t  pid;
+  int32_t  ppid;
+  uint32_t threads;
+  uint32_t flags;           // MONTAUK_SHM_PROC_*
+  double   cpu_pct;         // 0..100 of the whole machine
+  uint64_t rss_kb;
+  double   gpu_util_pct;
+  uint64_t gpu_mem_kb;
+  double   io_read_bps;
+  double   io_write_bps;
+  uint64_t pss_kb;
+  double   anomaly_score;
+  double   subtree_cpu_pct;
+  uint64_t subtree_rss_kb;
+  uint32_t subtree_threads;
+  uint32_t subtree_procs;
+  char     user[MONTAUK_SHM_USER_LEN];  // NUL-terminated, truncated
+  char     cmd[MONTAUK_SHM_CMD_LEN];    // NUL-terminated, truncated
+} montauk_shm_proc;
+
+typedef struct montauk_shm_data {
+  montauk_shm_cpu cpu;
+  montauk_shm_mem mem;
+  uint64_t total_processes;
+  uint64_t running_processes;
+  uint64_t sleeping_processes;
+  uint64_t zombie_processes;
+  uint64_t total_threads;
+  uint32_t nprocs;    // rows of procs in use, cpu_pct descending
+  uint32_t reserved;
+  montauk_shm_proc procs[MONTAUK_SHM_MAX_PROCS];
+} montauk_shm_data;
+
+typedef struct montauk_shm_segment {
+  montauk_shm_header hdr;
+  montauk_shm_data   data;
+} montauk_shm_segment;
+
+// Bytes of data that hold nprocs rows: what the writer copies and a reader
+// needs, rather than the whole table.
+static inline size_t montauk_shm_data_bytes(uint32_t nprocs) {
+  if (nprocs > MONTAUK_SHM_MAX_PROCS) nprocs = MONTAUK_SHM_MAX_PROCS;
+  return offsetof(montauk_shm_data, procs) + (size_t)nprocs * sizeof(montauk_shm_proc);
+}
+
+// ---- writer side (montauk) ----
+
+// Single writer. begin's acquire keeps the data stores after the odd seq;
+// end's release keeps them before the even one.
+static inline void montauk_shm_write_begin(montauk_shm_header* h) {
+  __atomic_fetch_add(&h->seq, 1, __ATOMIC_ACQ_REL);
+}
+
+static inline void montauk_shm_write_end(montauk_shm_header* h) {
+  __atomic_fetch_add(&h->seq, 1, __ATOMIC_RELEASE);
+}
+
+// ---- reader side ----
+
+typedef struct montauk_shm_reader {
+  const montauk_shm_segment* seg;
+  size_t len;
+} montauk_shm_reader;
+
+// Map the segment at path read-only. 0, or -errno; -EPROTO when the file is
+// not a montauk segment of this version (or montauk has not finished creating
+// it yet). The fd is closed once mapped.
+static inline int montauk_shm_open(montauk_shm_reader* r, const char* path) {
+  r->seg = NULL;
+  r->len = 0;
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return -errno;
+  struct stat st;
+  if (fstat(fd, &st) != 0) { int e = -errno; close(fd); return e; }
+  if ((size_t)st.st_size < sizeof(montauk_shm_segment)) { close(fd); return -EPROTO; }
+  void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  int e = p == MAP_FAILED ? -errno : 0;
+  close(fd);
+  if (e) return e;
+  const montauk_shm_segment* seg = (const montauk_shm_segment*)p;
+  if (__atomic_load_n(&seg->hdr.magic, __ATOMIC_ACQUIRE) != MONTAUK_SHM_MAGIC ||
+      seg->hdr.version != MONTAUK_SHM_VERSION || seg->hdr.header_size != sizeof(montauk_shm_header)) {
+    munmap(p, (size_t)st.st_size);
+    return -EPROTO;
+  }
+  r->seg = seg;
+  r->len = (size_t)st.st_size;
+  return 0;
+}
+
+static inline void montauk_shm_close(montauk_shm_reader* r) {
+  if (r->seg) munmap((void*)r->seg, r->len);
+  r->seg = NULL;
+  r->len = 0;
+}
+
+// Copy the latest consistent snapshot into out; no syscalls. Returns 0 and
+// sets *generation (if non-null), -ENODATA before the first write, or -EAGAIN
+// if the writer kept overlapping the copy (retry later; it writes a few
+// kilobytes once per publish, so this takes a stalled writer).
+static inline int montauk_shm_read(const montauk_shm_reader* r, montauk_shm_data* out, uint64_t* generation) {
+  const montauk_shm_header* h = &r->seg->hdr;
+  for (int attempt = 0; attempt < 64; ++attempt) {
+    const uint64_t s1 = __atomic_load_n(&h->seq, __ATOMIC_ACQUIRE);
+    if (s1 == 0) return -ENODATA;
+    if (s1 & 1) continue;
+    uint32_t n = __atomic_load_n(&r->seg->data.nprocs, __ATOMIC_RELAXED);
+    if (n > MONTAUK_SHM_MAX_PROCS) n = MONTAUK_SHM_MAX_PROCS;
+    memcpy(out, &r->seg->data, montauk_shm_data_bytes(n));
+    const uint64_t gen = __atomic_load_n(&h->generation, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&h->seq, __ATOMIC_RELAXED) != s1) continue;
+    out->nprocs = n;
+    if (generation) *generation = gen;
+    return 0;
+  }
+  return -EAGAIN;
+}
+
+// Whether a writer still owns the segment: MONTAUK_SHM_F_LIVE set and its pid
+// alive. This one does make a syscall (kill(pid, 0)); it is a liveness probe
+// for a reader that sees the generation stop moving, not part of the read path.
+static inline int montauk_shm_writer_alive(const montauk_shm_reader* r) {
+  const montauk_shm_header* h = &r->seg->hdr;
+  if (!(__atomic_load_n(&h->flags, __ATOMIC_ACQUIRE) & MONTAUK_SHM_F_LIVE)) return 0;
+  const pid_t pid = (pid_t)__atomic_load_n(&h->writer_pid, __ATOMIC_RELAXED);
+  return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+#endif  // MONTAUK_UTIL_SHM_SNAPSHOT_H
@@ -1,4 +1,5 @@
 #include "app/Alerts.hpp"
+#include <algorithm>
 #include <chrono>
 namespace steady = std::chrono;
 
@@ -22,8 +23,27 @@ std::vector<Alert> AlertEngine::evaluate(const montauk::model::Snapshot& s) {
   } else { mem_high_since_ = {}; }
 
   // Top process
-  if (!s.procs.processes.empty()) {
-    if (s.procs.processes[0].cpu_pct >= rules_.top_proc_cpu_pct) out.push_back({"warn", "Top process CPU high"});
+  if (!s.procs.empty()) {
+    if (s.procs.cpu_pct[0] >= rules_.top_proc_cpu_pct) out.push_back({"warn", "Top process CPU high"});
+  }
+
+  // Pressure: thresholds on the system-wide averages, plus a stall alert for
+  // any scope whose PSI trigger fired recently.
+  for (const auto& r : s.psi.entries) {
+    const std::string what = r.resource == "cpu" ? "CPU" : r.resource == "io" ? "IO" : "Memory";
+    const bool system = r.scope == "system";
+    auto& seen = psi_seen_[r.scope + ":" + r.resource];
+    if (r.trigger_fires > seen.fires) { seen.fires = r.trigger_fires; seen.last = now; }
+    if (system && r.has_full && r.full.avg10 >= rules_.psi_full_avg10_pct) {
+      out.push_back({"crit", what + " pressure: tasks fully stalled"});
+      continue;
+    }
+    if (system && r.some.avg10 >= rules_.psi_some_avg10_pct) {
+      out.push_back({"warn", what + " pressure high"});
+      continue;
+    }
+    if (seen.last.time_since_epoch().count() != 0 && now - seen.last < std::max(rules_.sustain, steady::seconds(1)))
+      out.push_back({"warn", system ? what + " pressure stall" : what + " pressure stall in " + r.scope});
   }
   return out;
 }
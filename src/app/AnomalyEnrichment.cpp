@@ -2,6 +2,7 @@
 
 #include "sublimation_learn.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -11,17 +12,19 @@ namespace montauk::app {
 void enrich_anomalies(montauk::model::ProcessSnapshot& procs,
                       std::unordered_map<int32_t, uint64_t>& prev_faults,
                       std::unordered_map<int32_t, uint64_t>& prev_ctxsw) {
-  auto& ps = procs.processes;
-  const size_t n = ps.size();
-  for (auto& p : ps) { p.anomaly_score = 0.0; p.anomaly_axis = -1;
-                       p.fault_delta = 0.0; p.ctxsw_delta = 0.0; }
+  // Straight off the columns: each feature below is one pass over one array.
+  const size_t n = procs.size();
+  std::fill(procs.anomaly_score.begin(), procs.anomaly_score.end(), 0.0);
+  std::fill(procs.anomaly_axis.begin(), procs.anomaly_axis.end(), int8_t{-1});
+  std::fill(procs.fault_delta.begin(), procs.fault_delta.end(), 0.0);
+  std::fill(procs.ctxsw_delta.begin(), procs.ctxsw_delta.end(), 0.0);
   auto refresh_faults = [&]() {
     prev_faults.clear();
-    prev_faults.reserve(ps.size());
-    for (const auto& p : ps) prev_faults[p.pid] = p.flt_raw;
+    prev_faults.reserve(n);
+    for (size_t i = 0; i < n; ++i) prev_faults[procs.pid[i]] = procs.flt_raw[i];
     prev_ctxsw.clear();
-    prev_ctxsw.reserve(ps.size());
-    for (const auto& p : ps) prev_ctxsw[p.pid] = p.nvctx_raw;
+    prev_ctxsw.reserve(n);
+    for (size_t i = 0; i < n; ++i) prev_ctxsw[procs.pid[i]] = procs.nvctx_raw[i];
   };
   if (n < 8) { refresh_faults(); return; }  // too few for a distribution
 
@@ -31,18 +34,21 @@ void enrich_anomalies(montauk::model::ProcessSnapshot& procs,
   constexpr size_t d = 6;  // cpu%, rss, gpu%, fault delta, thread count, ctxsw delta
   std::vector<double> x(n * d);
   for (size_t i = 0; i < n; ++i) {
-    x[i * d + 0] = ps[i].cpu_pct;
-    x[i * d + 1] = static_cast<double>(ps[i].rss_kb);
-    x[i * d + 2] = ps[i].has_gpu_util ? ps[i].gpu_util_pct : 0.0;
-    auto pf = prev_faults.find(ps[i].pid);
-    x[i * d + 3] = (pf != prev_faults.end() && ps[i].flt_raw > pf->second)
-                       ? static_cast<double>(ps[i].flt_raw - pf->second) : 0.0;
-    x[i * d + 4] = static_cast<double>(ps[i].thread_count);
-    auto pc = prev_ctxsw.find(ps[i].pid);
-    x[i * d + 5] = (pc != prev_ctxsw.end() && ps[i].nvctx_raw > pc->second)
-                       ? static_cast<double>(ps[i].nvctx_raw - pc->second) : 0.0;
-    ps[i].fault_delta = x[i * d + 3];   // publish the stateful features for --json / vector
-    ps[i].ctxsw_delta = x[i * d + 5];
+    x[i * d + 0] = procs.cpu_pct[i];
+    x[i * d + 1] = static_cast<double>(procs.rss_kb[i]);
+    x[i * d + 2] = procs.has_gpu_util[i] ? procs.gpu_util_pct[i] : 0.0;
+    x[i * d + 4] = static_cast<double>(procs.thread_count[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    auto pf = prev_faults.find(procs.pid[i]);
+    if (pf != prev_faults.end() && procs.flt_raw[i] > pf->second)
+      procs.fault_delta[i] = static_cast<double>(procs.flt_raw[i] - pf->second);
+    auto pc = prev_ctxsw.find(procs.pid[i]);
+    if (pc != prev_ctxsw.end() && procs.nvctx_raw[i] > pc->second)
+      procs.ctxsw_delta[i] = static_cast<double>(procs.nvctx_raw[i] - pc->second);
+    // published as-is for --json / vector
+    x[i * d + 3] = procs.fault_delta[i];
+    x[i * d + 5] = procs.ctxsw_delta[i];
   }
 
   // The fusion is the sublimation learn-lane primitive: the three spatial
@@ -89,10 +95,8 @@ void enrich_anomalies(montauk::model::ProcessSnapshot& procs,
       const int8_t a = axes[i];
       if (a >= 0 && (size_t)a < dl) axes[i] = (int8_t)live[(size_t)a];
     }
-    for (size_t i = 0; i < n; ++i) {
-      ps[i].anomaly_score = scores[i];
-      ps[i].anomaly_axis = axes[i];
-    }
+    std::copy(scores.begin(), scores.end(), procs.anomaly_score.begin());
+    std::copy(axes.begin(), axes.end(), procs.anomaly_axis.begin());
   }  // on allocation failure the reset 0.0 / -1 above stands
   refresh_faults();
 }
@@ -30,19 +30,19 @@ ProcessFilter::ProcessFilter(ProcessFilterSpec spec) : spec_(std::move(spec)) {
 
 std::vector<size_t> ProcessFilter::apply(const montauk::model::ProcessSnapshot& ps) const {
   std::vector<size_t> out;
-  out.reserve(ps.processes.size());
-  for (size_t i = 0; i < ps.processes.size(); ++i) {
-    const auto& p = ps.processes[i];
+  out.reserve(ps.size());
+  for (size_t i = 0; i < ps.size(); ++i) {
     bool ok = true;
-    if (bmh_) {
-      if (sublimation_search_find(&*bmh_, p.cmd.data(), p.cmd.size(), nullptr) == -1) ok = false;
+    if (spec_.cpu_min) { if (ps.cpu_pct[i] < *spec_.cpu_min) ok = false; }
+    if (ok && spec_.mem_min_kb) { if (ps.rss_kb[i] < *spec_.mem_min_kb) ok = false; }
+    if (ok && spec_.user_equals) { if (ps.user_of(i) != *spec_.user_equals) ok = false; }
+    const std::string_view cmd = ps.cmd_of(i);
+    if (ok && bmh_) {
+      if (sublimation_search_find(&*bmh_, cmd.data(), cmd.size(), nullptr) == -1) ok = false;
     }
     if (ok && compiled_) {
-      if (sublimation_search_find(&*compiled_, p.cmd.data(), p.cmd.size(), nullptr) < 0) ok = false;
+      if (sublimation_search_find(&*compiled_, cmd.data(), cmd.size(), nullptr) < 0) ok = false;
     }
-    if (ok && spec_.user_equals) { if (p.user_name != *spec_.user_equals) ok = false; }
-    if (ok && spec_.cpu_min) { if (p.cpu_pct < *spec_.cpu_min) ok = false; }
-    if (ok && spec_.mem_min_kb) { if (p.rss_kb < *spec_.mem_min_kb) ok = false; }
     if (ok) out.push_back(i);
   }
   return out;
@@ -88,7 +88,7 @@ class LiteralSet {
       sublimation_search_compile(&progs_[i++], l, std::strlen(l),
                                  SUBLIMATION_SEARCH_FIXED, 0);
   }
-  [[nodiscard]] bool any(const std::string& hay) const {
+  [[nodiscard]] bool any(std::string_view hay) const {
     return sublimation_search_selects(progs_.data(), static_cast<int>(progs_.size()),
                                       /*regex_face=*/0, hay.data(), hay.size(),
                                       /*xline=*/0, /*wword=*/0) != 0;
@@ -105,15 +105,14 @@ const LiteralSet kChromeFamily{"chrome", "helium"};
 // with the same six probes and the same tie-break; the block existed twice.
 struct GpuOwnerScan { int pid = -1; int matches = 0; int chrome_pid = -1; };
 
-template <typename Procs>
-GpuOwnerScan scan_gpu_owner(const Procs& processes) {
+GpuOwnerScan scan_gpu_owner(const montauk::model::ProcessSnapshot& procs) {
   GpuOwnerScan r;
-  for (const auto& p : processes) {
-    const std::string& c = p.cmd;
+  for (size_t i = 0; i < procs.size(); ++i) {
+    const std::string_view c = procs.cmd_of(i);
     if (kGpuProcess.any(c) || kXServer.any(c)) {
       r.matches++;
-      r.pid = p.pid;
-      if (kChromeFamily.any(c)) r.chrome_pid = p.pid;
+      r.pid = procs.pid[i];
+      if (kChromeFamily.any(c)) r.chrome_pid = procs.pid[i];
     }
   }
   return r;
@@ -351,16 +350,16 @@ void GpuAttributor::enrich(montauk::model::Snapshot& s) {
   if (running_pids.empty()) {
     int dev_util_hint = (int)std::max({ (double)as_int_pct(s.vram.gpu_util_pct), (double)as_int_pct(s.vram.enc_util_pct), (double)as_int_pct(s.vram.dec_util_pct) });
     if (dev_util_hint > 0) {
-      for (const auto& p : s.procs.processes) {
+      for (const int32_t pid : s.procs.pid) {
         try {
-          std::filesystem::path fddir(std::string("/proc/") + std::to_string(p.pid) + "/fd");
+          std::filesystem::path fddir(std::string("/proc/") + std::to_string(pid) + "/fd");
           if (!std::filesystem::exists(fddir)) continue;
           for (auto& de : std::filesystem::directory_iterator(fddir)) {
             std::error_code ec; auto target = std::filesystem::read_symlink(de.path(), ec);
             if (ec) continue;
             auto tstr = target.string();
             if (tstr.rfind("/dev/nvidia", 0) == 0 || tstr.find("nvidia-uvm") != std::string::npos || tstr.find("/dev/dri/renderD") == 0) {
-              running_pids.insert(p.pid); break;
+              running_pids.insert(pid); break;
             }
           }
         } catch (...) { /* ignore per-pid errors */ }
@@ -370,7 +369,7 @@ void GpuAttributor::enrich(montauk::model::Snapshot& s) {
 
   // Heuristics for per-process GMEM when vendor APIs don't expose it
   auto choose_gpu_pid = [&]() -> int {
-    const auto scan = scan_gpu_owner(s.procs.processes);
+    const auto scan = scan_gpu_owner(s.procs);
     const int gpu_proc_pid = scan.pid;
     const int matches = scan.matches;
     const int chrome_gpu_pid = scan.chrome_pid;
@@ -453,7 +452,7 @@ void GpuAttributor::enrich(montauk::model::Snapshot& s) {
   if (pid_to_gpu.empty() && !s.nvml.mig_enabled) {
     int dev_util = (int)std::max({ (double)as_int_pct(s.vram.gpu_util_pct), (double)as_int_pct(s.vram.enc_util_pct), (double)as_int_pct(s.vram.dec_util_pct) });
     if (dev_util > 0) {
-      const auto scan = scan_gpu_owner(s.procs.processes);
+      const auto scan = scan_gpu_owner(s.procs);
       const int gpu_proc_pid = scan.pid;
       const int matches = scan.matches;
       const int chrome_gpu_pid = scan.chrome_pid;
@@ -494,10 +493,11 @@ void GpuAttributor::enrich(montauk::model::Snapshot& s) {
   const auto hold = std::chrono::milliseconds(3000);
   const auto decay = std::chrono::milliseconds(3000);
   const auto exit_decay = std::chrono::milliseconds(500);
-  for (auto& p : s.procs.processes) {
-    double disp = 0.0; auto itst = gpu_smooth_.find(p.pid);
+  auto& procs = s.procs;
+  for (size_t i = 0; i < procs.size(); ++i) {
+    double disp = 0.0; auto itst = gpu_smooth_.find(procs.pid[i]);
     if (itst != gpu_smooth_.end() && itst->second.last_sample.time_since_epoch().count() > 0) {
-      auto age = now_tp - itst->second.last_sample; bool running = running_pids.count(p.pid) > 0;
+      auto age = now_tp - itst->second.last_sample; bool running = running_pids.count(procs.pid[i]) > 0;
       if (running) disp = itst->second.ema;
       else if (age <= hold) disp = itst->second.ema;
       else { auto over = age - hold; auto dwin = (itst->second.last_running.time_since_epoch().count() > 0 ? decay : exit_decay); double t = (double)std::chrono::duration_cast<std::chrono::milliseconds>(over).count() / (double)std::chrono::duration_cast<std::chrono::milliseconds>(dwin).count();
@@ -505,10 +505,10 @@ void GpuAttributor::enrich(montauk::model::Snapshot& s) {
     }
     if (disp < 0.0) disp = 0.0;
     if (disp > 100.0) disp = 100.0;
-    p.has_gpu_util = (disp > 0.0);
-    p.gpu_util_pct = disp;
+    procs.has_gpu_util[i] = (disp > 0.0);
+    procs.gpu_util_pct[i] = disp;
   }
-  for (auto& p : s.procs.processes) { auto mit = pid_to_gpu_mem_kb.find(p.pid); if (mit != pid_to_gpu_mem_kb.end()) { p.has_gpu_mem = true; p.gpu_mem_kb = mit->second; } }
+  for (size_t i = 0; i < procs.size(); ++i) { auto mit = pid_to_gpu_mem_kb.find(procs.pid[i]); if (mit != pid_to_gpu_mem_kb.end()) { procs.has_gpu_mem[i] = true; procs.gpu_mem_kb[i] = mit->second; } }
   // Prune smoothing state
   for (auto it = gpu_smooth_.begin(); it != gpu_smooth_.end(); ) { auto age = now_tp - it->second.last_sample; if (age > std::chrono::seconds(30)) it = gpu_smooth_.erase(it); else ++it; }
 }
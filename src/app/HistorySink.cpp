@@ -0,0 +1,116 @@
+#include "app/HistorySink.hpp"
+#include "model/Provider.hpp"
+
+namespace montauk::app {
+
+using montauk::model::SeriesKind;
+
+namespace {
+
+SeriesKind kind_of(const MetricDesc& d) {
+  return d.kind == MetricKind::Counter ? SeriesKind::Counter : SeriesKind::Gauge;
+}
+
+// PrometheusSink's label escaping, so both logs key a series identically.
+void append_escaped(std::string& out, std::string_view sv) {
+  for (char c : sv) {
+    if (c == '\\') out += "\\\\";
+    else if (c == '"') out += "\\\"";
+    else if (c == '\n') out += "\\n";
+    else out += c;
+  }
+}
+
+void format_labels(std::string& out, std::span<const Label> labels) {
+  out.clear();
+  for (size_t i = 0; i < labels.size(); ++i) {
+    if (i > 0) out += ',';
+    out += labels[i].key;
+    out += "=\"";
+    append_escaped(out, labels[i].value);
+    out += '"';
+  }
+}
+
+SeriesKind kind_from_type(std::string_view t) {
+  if (t.starts_with("counter")) return SeriesKind::Counter;
+  if (t.starts_with("gauge")) return SeriesKind::Gauge;
+  if (t.starts_with("histogram")) return SeriesKind::Histogram;
+  if (t.starts_with("summary")) return SeriesKind::Summary;
+  return SeriesKind::Untyped;
+}
+
+}  // namespace
+
+void HistorySink::f64(const MetricDesc& d, double v) {
+  if (d.prom_name) w_.sample(d.prom_name, {}, kind_of(d), v);
+}
+
+void HistorySink::u64(const MetricDesc& d, uint64_t v) {
+  if (d.prom_name) w_.sample(d.prom_name, {}, kind_of(d), static_cast<double>(v));
+}
+
+void HistorySink::i64(const MetricDesc& d, int64_t v) {
+  if (d.prom_name) w_.sample(d.prom_name, {}, kind_of(d), static_cast<double>(v));
+}
+
+void HistorySink::boolean(const MetricDesc& d, bool v) {
+  if (d.prom_name) w_.sample(d.prom_name, {}, kind_of(d), v ? 1.0 : 0.0);
+}
+
+void HistorySink::labeled(const MetricDesc& d, std::span<const Label> labels, double v) {
+  if (!d.prom_name) return;
+  format_labels(labels_, labels);
+  w_.sample(d.prom_name, labels_, kind_of(d), v);
+}
+
+void HistorySink::labeled_f64(const MetricDesc& d, std::span<const Label> labels, double v) {
+  labeled(d, labels, v);
+}
+
+void HistorySink::labeled_u64(const MetricDesc& d, std::span<const Label> labels, uint64_t v) {
+  labeled(d, labels, static_cast<double>(v));
+}
+
+void HistorySink::labeled_i64(const MetricDesc& d, std::span<const Label> labels, int64_t v) {
+  labeled(d, labels, static_cast<double>(v));
+}
+
+void HistorySink::info_line(const char* prom_name, const char*, std::span<const Label> labels) {
+  format_labels(labels_, labels);
+  w_.sample(prom_name, labels_, SeriesKind::Gauge, 1.0);
+}
+
+void HistorySink::provider(const montauk::model::Provider& p) {
+  // The samples are already parsed; only the TYPE lines need reading here,
+  // so a provider's histogram keeps its kind in the log.
+  provider_types_.clear();
+  std::string_view text = p.raw_text;
+  while (!text.empty()) {
+    const size_t nl = text.find('\n');
+    std::string_view line = text.substr(0, nl);
+    text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+    if (!line.starts_with("# TYPE ")) continue;
+    line.remove_prefix(7);
+    const size_t sp = line.find(' ');
+    if (sp == std::string_view::npos) continue;
+    provider_types_.insert_or_assign(std::string(line.substr(0, sp)), kind_from_type(line.substr(sp + 1)));
+  }
+  for (const auto& m : p.metrics) {
+    std::string_view name = m.name;
+    SeriesKind kind = SeriesKind::Untyped;
+    if (auto it = provider_types_.find(name); it != provider_types_.end()) {
+      kind = it->second;
+    } else {
+      for (std::string_view suffix : {"_bucket", "_sum", "_count"}) {
+        if (!name.ends_with(suffix)) continue;
+        auto fam = provider_types_.find(name.substr(0, name.size() - suffix.size()));
+        if (fam != provider_types_.end()) kind = fam->second;
+        break;
+      }
+    }
+    w_.sample(m.name, m.labels, kind, m.value);
+  }
+}
+
+}  // namespace montauk::app
@@ -0,0 +1,254 @@
+#include "app/JsonStream.hpp"
+#include "app/JsonSink.hpp"
+#include "app/MetricsRender.hpp"
+#include "app/SnapshotCodec.hpp"
+
+#include <charconv>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace montauk::app {
+
+namespace {
+
+// The codec section each rendered section reads, indexed by MetricsSection.
+// Count: no single one -- system is keyed below, processes always renders
+// (its rates move every tick).
+constexpr SnapshotSection kSource[] = {
+    SnapshotSection::Count, SnapshotSection::Cpu, SnapshotSection::Pmu, SnapshotSection::Mem,
+    SnapshotSection::Vram, SnapshotSection::Thermal, SnapshotSection::Net, SnapshotSection::Disk,
+    SnapshotSection::Fs, SnapshotSection::Cgroups, SnapshotSection::Psi, SnapshotSection::Providers,
+    SnapshotSection::Count};
+static_assert(std::size(kSource) == static_cast<size_t>(MetricsSection::Trace));
+
+// The snapshot facts render_system prints. Kernel and scheduler are read at
+// render time, so a stream picks up a changed scheduler with the next of these.
+void system_source(const montauk::model::Snapshot& s, std::string& out) {
+  out = s.cpu.model;
+  out += '\0' + std::to_string(s.cpu.physical_cores) + '\0' + std::to_string(s.cpu.logical_threads) + '\0' +
+         std::to_string(s.mem.total_kb) + '\0' + s.vram.name;
+  if (!s.vram.devices.empty()) out += '\0' + s.vram.devices.front().name;
+}
+
+// JsonSink writes compact JSON with plain keys, so a value's extent is found
+// by matching brackets outside strings; nothing here parses a value.
+size_t skip_string(std::string_view t, size_t i) {
+  for (++i; i < t.size(); ++i) {
+    if (t[i] == '\\') ++i;
+    else if (t[i] == '"') return i + 1;
+  }
+  return t.size();
+}
+
+size_t skip_value(std::string_view t, size_t i) {
+  if (i < t.size() && t[i] == '"') return skip_string(t, i);
+  int depth = 0;
+  for (; i < t.size(); ++i) {
+    const char c = t[i];
+    if (c == '"') i = skip_string(t, i) - 1;
+    else if (c == '{' || c == '[') ++depth;
+    else if (c == '}' || c == ']') {
+      if (depth == 0) return i;
+      if (--depth == 0) return i + 1;
+    } else if (c == ',' && depth == 0) return i;
+  }
+  return i;
+}
+
+struct Member {
+  std::string_view key;  // as written between the quotes
+  std::string_view value;
+};
+
+// "k":v,"k":v -- an object's text without its braces.
+std::vector<Member> split_members(std::string_view t) {
+  std::vector<Member> out;
+  size_t i = 0;
+  while (i < t.size() && t[i] == '"') {
+    const size_t k = skip_string(t, i);
+    const size_t e = skip_value(t, k + 1);
+    out.push_back({t.substr(i + 1, k - i - 2), t.substr(k + 1, e - k - 1)});
+    i = e < t.size() && t[e] == ',' ? e + 1 : e;
+  }
+  return out;
+}
+
+std::vector<std::string_view> split_elements(std::string_view arr) {
+  std::vector<std::string_view> out;
+  size_t i = 1;
+  while (i < arr.size() && arr[i] != ']') {
+    const size_t e = skip_value(arr, i);
+    out.push_back(arr.substr(i, e - i));
+    i = e < arr.size() && arr[e] == ',' ? e + 1 : e;
+  }
+  return out;
+}
+
+std::string_view inner(std::string_view obj) { return obj.substr(1, obj.size() - 2); }
+bool is_object(std::string_view v) { return v.starts_with('{'); }
+bool is_array(std::string_view v) { return v.starts_with('['); }
+
+// The member named `key`, looked for from `hint` on since both sides are
+// rendered in the same order.
+const Member* find(const std::vector<Member>& ms, std::string_view key, size_t& hint) {
+  for (size_t n = 0; n < ms.size(); ++n) {
+    const size_t i = (hint + n) % ms.size();
+    if (ms[i].key == key) {
+      hint = i + 1;
+      return &ms[i];
+    }
+  }
+  return nullptr;
+}
+
+// Appends "key":value members, placing the commas.
+struct ObjectOut {
+  std::string& out;
+  bool any{false};
+  std::string& key(std::string_view k) {
+    if (any) out += ',';
+    any = true;
+    out += '"';
+    out += k;
+    out += "\":";
+    return out;
+  }
+};
+
+int64_t row_pid(std::string_view row) {
+  int64_t pid = -1;
+  const auto ms = split_members(inner(row));
+  if (!ms.empty() && ms[0].key == "pid")
+    std::from_chars(ms[0].value.data(), ms[0].value.data() + ms[0].value.size(), pid);
+  return pid;
+}
+
+// How deep a member list sits: the line's sections, a section's members, the
+// process section's members, or a process row's.
+enum class Level { Sections, Section, Processes, Row };
+
+void diff_members(std::string_view prev, std::string_view cur, ObjectOut& o, Level level);
+
+// Rows of a pid-keyed list: those added whole, those gone by pid, those
+// changed as their pid plus the members that moved, and the pid order when
+// it is not the previous one.
+void diff_rows(std::string_view prev, std::string_view cur, ObjectOut& o, std::string_view key) {
+  const auto before = split_elements(prev), after = split_elements(cur);
+  std::unordered_map<int64_t, std::string_view> old;
+  std::vector<int64_t> old_order, order;
+  for (auto r : before) {
+    old_order.push_back(row_pid(r));
+    old.emplace(old_order.back(), r);
+  }
+  std::string added, changed;
+  for (auto r : after) {
+    const int64_t pid = row_pid(r);
+    order.push_back(pid);
+    auto it = old.find(pid);
+    if (it == old.end()) {
+      (added.empty() ? added : added += ',') += r;
+    } else {
+      if (it->second != r) {
+        std::string fields;
+        ObjectOut f{fields};
+        diff_members(inner(it->second), inner(r), f, Level::Row);
+        if (!changed.empty()) changed += ',';
+        changed += "{\"pid\":" + std::to_string(pid) + ',' + fields + '}';
+      }
+      old.erase(it);
+    }
+  }
+  std::string removed;
+  for (int64_t pid : old_order)
+    if (old.contains(pid)) (removed.empty() ? removed : removed += ',') += std::to_string(pid);
+
+  std::string& out = o.key(key);
+  out += '{';
+  ObjectOut d{out};
+  if (!added.empty()) d.key("added") += '[' + added + ']';
+  if (!removed.empty()) d.key("removed") += '[' + removed + ']';
+  if (!changed.empty()) d.key("changed") += '[' + changed + ']';
+  if (order != old_order) {
+    std::string& ord = d.key("order");
+    ord += '[';
+    for (size_t i = 0; i < order.size(); ++i) (i ? ord += ',' : ord) += std::to_string(order[i]);
+    ord += ']';
+  }
+  out += '}';
+}
+
+// Members of cur whose value differs from prev's, then prev's members cur
+// lacks as null. A section object recurses one level; in the process section
+// "top" and "anomaly_features" diff by pid; anything else is replaced whole.
+void diff_members(std::string_view prev, std::string_view cur, ObjectOut& o, Level level) {
+  const auto before = split_members(prev), after = split_members(cur);
+  size_t hint = 0;
+  for (const auto& m : after) {
+    const Member* p = find(before, m.key, hint);
+    if (p && p->value == m.value) continue;
+    if (p && level == Level::Sections && is_object(p->value) && is_object(m.value)) {
+      std::string& out = o.key(m.key);
+      out += '{';
+      ObjectOut in{out};
+      diff_members(inner(p->value), inner(m.value), in, m.key == "processes" ? Level::Processes : Level::Section);
+      out += '}';
+    } else if (p && level == Level::Processes && is_array(p->value) && is_array(m.value) &&
+               (m.key == "top" || m.key == "anomaly_features")) {
+      diff_rows(p->value, m.value, o, m.key);
+    } else {
+      o.key(m.key) += m.value;
+    }
+  }
+  hint = 0;
+  for (const auto& p : before)
+    if (!find(after, p.key, hint)) o.key(p.key) += "null";
+}
+
+}  // namespace
+
+void JsonStream::next(const montauk::model::Snapshot& s, std::string& out) {
+  const MetricsSnapshot ms = project_metrics_snapshot(s);
+  std::array<std::string, kSections> rendered;
+  std::array<bool, kSections> fresh{};
+  std::string header;
+  for (size_t i = 0; i < kSections; ++i) {
+    const auto sec = static_cast<MetricsSection>(i);
+    if (sec == MetricsSection::System) system_source(s, scratch_);
+    else if (kSource[i] != SnapshotSection::Count) encode_section(s, kSource[i], scratch_);
+    else scratch_.clear();
+    if (started_ && sec != MetricsSection::Processes && scratch_ == source_[i]) continue;
+    source_[i].swap(scratch_);
+
+    JsonSink sink;
+    MetricsSelection sel;
+    sel.sections = 1u << i;
+    render_snapshot(sink, ms, sel);
+    const std::string text = sink.finish();
+    const std::string_view obj = std::string_view(text).substr(0, text.rfind('}') + 1);
+    // Every render opens with the sink's schema_version; the line has it once.
+    ObjectOut members{rendered[i]};
+    for (const auto& m : split_members(inner(obj))) {
+      if (m.key == "schema_version") header = "{\"schema_version\":" + std::string(m.value);
+      else members.key(m.key) += m.value;
+    }
+    fresh[i] = true;
+  }
+
+  out += header;
+  out += ",\"seq\":" + std::to_string(s.seq);
+  ObjectOut line{out, true};
+  for (size_t i = 0; i < kSections; ++i) {
+    if (!fresh[i]) continue;
+    if (!started_) {
+      if (!rendered[i].empty()) out += ',' + rendered[i];
+    } else {
+      diff_members(members_[i], rendered[i], line, Level::Sections);
+    }
+    members_[i] = std::move(rendered[i]);
+  }
+  out += "}\n";
+  started_ = true;
+}
+
+}  // namespace montauk::app
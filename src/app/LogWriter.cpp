@@ -1,6 +1,10 @@
 #include "app/LogWriter.hpp"
 #include "util/Log.hpp"
 #include "app/MetricsServer.hpp"
+#include "app/HistorySink.hpp"
+#include "app/MetricsRender.hpp"
+#include "app/TraceRender.hpp"
+#include "model/HistoryLog.hpp"
 #include <cstdio>
 #include <cstring>
 #include <ctime>
@@ -11,8 +15,9 @@ namespace montauk::app {
 
 LogWriter::LogWriter(const SnapshotBuffers& buffers, std::filesystem::path log_dir,
                      std::chrono::milliseconds interval,
-                     const TraceBuffers* trace)
-    : buffers_(buffers), trace_(trace), log_dir_(std::move(log_dir)), interval_(interval) {
+                     const TraceBuffers* trace, LogFormat format)
+    : buffers_(buffers), trace_(trace), log_dir_(std::move(log_dir)), interval_(interval),
+      format_(format) {
   std::error_code ec;
   std::filesystem::create_directories(log_dir_, ec);
   if (ec) {
@@ -36,10 +41,16 @@ void LogWriter::stop() {
 
 void LogWriter::run(std::stop_token st) {
   std::ofstream file;
+  montauk::model::HistoryWriter history;
+  montauk::model::PromDeltaEncoder delta;
+  std::string block;
   std::filesystem::path current_path;
+  const bool binary = format_ == LogFormat::Binary;
 
-  montauk::util::log_info("LogWriter: writing to %s/ (interval %lldms)",
-               log_dir_.c_str(), static_cast<long long>(interval_.count()));
+  montauk::util::log_info("LogWriter: writing %s to %s/ (interval %lldms)",
+               binary ? "binary" : format_ == LogFormat::Delta ? "delta" : "text",
+               log_dir_.c_str(),
+               static_cast<long long>(interval_.count()));
 
   // Wait for first real publish to avoid writing all-zeros cold-start block
   while (buffers_.seq() == 0 && !st.stop_requested()) {
@@ -50,14 +61,26 @@ void LogWriter::run(std::stop_token st) {
     auto now = std::chrono::system_clock::now();
     auto required_path = chunk_path();
 
+    // Timestamp in milliseconds since epoch
+    auto epoch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count();
+
     // Rotate on hour boundary
     if (required_path != current_path) {
       if (file.is_open()) {
         file.flush();
         file.close();
       }
-      file.open(required_path, std::ios::app);
-      if (!file) {
+      history.close();
+      delta.reset();  // each file opens on a keyframe
+      bool opened;
+      if (binary) {
+        opened = history.open(required_path.c_str(), epoch_ms);
+      } else {
+        file.open(required_path, std::ios::app);
+        opened = static_cast<bool>(file);
+      }
+      if (!opened) {
         montauk::util::log_error("LogWriter: failed to open %s: %s",
                      required_path.c_str(), std::strerror(errno));
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -66,28 +89,44 @@ void LogWriter::run(std::stop_token st) {
       current_path = required_path;
     }
 
-    // Read snapshot via seqlock
+    // Project the current published generation
     MetricsSnapshot ms = read_metrics_snapshot(buffers_);
 
-    // Timestamp in milliseconds since epoch
-    auto epoch_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-    char ts_buf[32];
-    auto [ptr, ec] = std::to_chars(ts_buf, ts_buf + sizeof(ts_buf), epoch_ms);
-
-    // Write timestamp + snapshot block
-    file.write("# montauk_scrape_timestamp_ms ", 30);
-    file.write(ts_buf, ptr - ts_buf);
-    file.put('\n');
-
-    std::string body = snapshot_to_prometheus(ms);
-    if (trace_) {
-      auto ts = read_trace_snapshot(*trace_);
-      body += trace_to_prometheus(ts);
-    }
-    file.write(body.data(), static_cast<std::streamsize>(body.size()));
+    if (binary) {
+      // Same walk as the text log, values handed to the writer instead of
+      // formatted; the writer flushes a block once it fills.
+      history.begin_scrape(epoch_ms);
+      HistorySink sink(history);
+      render_snapshot(sink, ms);
+      if (trace_) render_trace(sink, read_trace_snapshot(*trace_));
+      if (!history.end_scrape())
+        montauk::util::log_error("LogWriter: write to %s failed: %s",
+                     current_path.c_str(), std::strerror(errno));
+    } else if (format_ == LogFormat::Delta) {
+      std::string body = snapshot_to_prometheus(ms);
+      if (trace_) body += trace_to_prometheus(read_trace_snapshot(*trace_));
+      block.clear();
+      delta.encode(epoch_ms, body, block);
+      file.write(block.data(), static_cast<std::streamsize>(block.size()));
+      file.flush();
+    } else {
+      char ts_buf[32];
+      auto [ptr, ec] = std::to_chars(ts_buf, ts_buf + sizeof(ts_buf), epoch_ms);
+
+      // Write timestamp + snapshot block
+      file.write("# montauk_scrape_timestamp_ms ", 30);
+      file.write(ts_buf, ptr - ts_buf);
+      file.put('\n');
+
+      std::string body = snapshot_to_prometheus(ms);
+      if (trace_) {
+        auto ts = read_trace_snapshot(*trace_);
+        body += trace_to_prometheus(ts);
+      }
+      file.write(body.data(), static_cast<std::streamsize>(body.size()));
 
-    file.flush();
+      file.flush();
+    }
 
     auto wake = now + interval_;
     std::this_thread::sleep_until(wake);
@@ -97,6 +136,7 @@ void LogWriter::run(std::stop_token st) {
     file.flush();
     file.close();
   }
+  history.close();
 }
 
 std::filesystem::path LogWriter::chunk_path() const {
@@ -106,8 +146,9 @@ std::filesystem::path LogWriter::chunk_path() const {
   ::localtime_r(&now_t, &tm);
 
   char buf[64];
-  std::snprintf(buf, sizeof(buf), "montauk_%04d-%02d-%02d_%02d.prom",
-                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour);
+  std::snprintf(buf, sizeof(buf), "montauk_%04d-%02d-%02d_%02d.%s",
+                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
+                format_ == LogFormat::Binary ? "mhist" : "prom");
 
   return log_dir_ / buf;
 }
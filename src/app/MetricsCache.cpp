@@ -0,0 +1,42 @@
+#include "app/MetricsCache.hpp"
+#include "app/MetricsServer.hpp"
+#ifdef MONTAUK_HAVE_ZLIB
+#include "util/ZlibDyn.hpp"
+#endif
+
+namespace montauk::app {
+
+const std::string& MetricsExposition::gzip() const {
+#ifdef MONTAUK_HAVE_ZLIB
+  std::call_once(gzip_once_, [this] { (void)montauk::util::ZlibDyn::instance().gzip(text_, gzip_); });
+#endif
+  return gzip_;
+}
+
+std::shared_ptr<const MetricsExposition> MetricsCache::get(const MetricsSelection& sel) {
+  // Sample the generation before rendering: a publish racing the render
+  // leaves an entry keyed older than its contents, which only costs the next
+  // request one redundant render -- never a stale body served as current.
+  const uint64_t seq = buffers_.seq();
+  const uint64_t trace_seq = trace_ ? trace_->seq() : 0;
+  std::lock_guard lk(mu_);
+  if (variants_.empty() || seq != seq_ || trace_seq != trace_seq_) {
+    variants_.clear();
+    seq_ = seq;
+    trace_seq_ = trace_seq;
+  }
+  for (const auto& [key, exp] : variants_)
+    if (key == sel.key) return exp;
+
+  // Neither buffer is copied out for a selection that renders none of it.
+  std::string text;
+  if (sel.wants_snapshot()) text = snapshot_to_prometheus(read_metrics_snapshot(buffers_), sel);
+  if (trace_ && sel.wants(MetricsSection::Trace)) text += trace_to_prometheus(read_trace_snapshot(*trace_), sel);
+  auto exp = std::make_shared<const MetricsExposition>(seq, trace_seq, std::move(text));
+  if (variants_.size() == kMaxVariants) variants_.erase(variants_.begin());
+  variants_.emplace_back(sel.key, exp);
+  renders_.fetch_add(1, std::memory_order_relaxed);
+  return exp;
+}
+
+} // namespace montauk::app
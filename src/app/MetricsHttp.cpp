@@ -0,0 +1,167 @@
+#include "app/MetricsHttp.hpp"
+#include "util/AsciiLower.hpp"
+
+#include <charconv>
+
+namespace montauk::app {
+
+namespace {
+
+constexpr std::string_view kIndexBody =
+    "montauk: use /metrics, /metrics/system, /metrics/procs or /metrics/trace\n"
+    "         (?family=NAME[,NAME*...] to pick families, ?top=N to cap process rows)\n";
+constexpr std::string_view kBadRequestBody = "400 Bad Request: metrics takes family= and top=N\n";
+constexpr std::string_view kNotFoundBody = "404 Not Found\n";
+constexpr std::string_view kTooLargeBody = "431 Request Header Fields Too Large\n";
+
+bool iequals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i)
+    if (montauk::util::ascii_lower(static_cast<unsigned char>(a[i])) !=
+        montauk::util::ascii_lower(static_cast<unsigned char>(b[i])))
+      return false;
+  return true;
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+  return s;
+}
+
+// Does a comma-separated header value list `token`? ("keep-alive, Upgrade")
+bool lists(std::string_view value, std::string_view token) {
+  while (!value.empty()) {
+    const size_t comma = value.find(',');
+    if (iequals(trim(value.substr(0, comma)), token)) return true;
+    if (comma == std::string_view::npos) break;
+    value.remove_prefix(comma + 1);
+  }
+  return false;
+}
+
+void append_head(HttpResponse& out, std::string_view status, std::string_view type,
+                 std::string_view extra) {
+  out.head.assign("HTTP/1.1 ");
+  out.head += status;
+  out.head += "\r\nContent-Type: ";
+  out.head += type;
+  out.head += "\r\n";
+  out.head += extra;
+  out.head += out.keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+  out.head += "Content-Length: ";
+  char len_buf[24];
+  auto [ptr, ec] = std::to_chars(len_buf, len_buf + sizeof(len_buf), out.body.size());
+  out.head.append(len_buf, ptr);
+  out.head += "\r\n\r\n";
+}
+
+}  // namespace
+
+bool accepts_gzip(std::string_view request) {
+  // Header lines only: stop at the blank line ending the head.
+  size_t pos = request.find('\n');
+  while (pos != std::string_view::npos) {
+    const size_t start = pos + 1;
+    pos = request.find('\n', start);
+    std::string_view line = trim(request.substr(start, pos == std::string_view::npos ? std::string_view::npos : pos - start));
+    if (line.empty()) break;
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos || !iequals(trim(line.substr(0, colon)), "accept-encoding")) continue;
+
+    std::string_view list = line.substr(colon + 1);
+    while (!list.empty()) {
+      const size_t comma = list.find(',');
+      std::string_view item = list.substr(0, comma);
+      list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+      std::string_view coding = item, params;
+      if (const size_t semi = item.find(';'); semi != std::string_view::npos) {
+        coding = item.substr(0, semi);
+        params = trim(item.substr(semi + 1));
+      }
+      coding = trim(coding);
+      if (!iequals(coding, "gzip") && coding != "*") continue;
+      if (params.size() > 2 && (params[0] == 'q' || params[0] == 'Q') && params[1] == '=') {
+        double q = 1.0;
+        std::string_view v = trim(params.substr(2));
+        auto [p, ec] = std::from_chars(v.data(), v.data() + v.size(), q);
+        if (ec == std::errc{} && q <= 0.0) {
+          if (coding == "*") continue;
+          return false;  // an explicit gzip;q=0 outranks any wildcard
+        }
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+std::optional<HttpRequest> parse_http_request(std::string_view buf) {
+  // Tolerate bare-LF clients (printf | nc) as well as CRLF ones.
+  size_t end = buf.find("\r\n\r\n");
+  size_t len = end == std::string_view::npos ? end : end + 4;
+  if (const size_t lf = buf.find("\n\n"); lf != std::string_view::npos && (len == std::string_view::npos || lf + 2 < len))
+    len = lf + 2;
+  if (len == std::string_view::npos) return std::nullopt;
+
+  HttpRequest req;
+  req.length = len;
+  const std::string_view head = buf.substr(0, len);
+  const size_t line_end = head.find('\n');
+  req.request_line = trim(head.substr(0, line_end));
+  req.keep_alive = req.request_line.ends_with("HTTP/1.1");
+  req.gzip = accepts_gzip(head);
+
+  size_t pos = line_end;
+  while (pos != std::string_view::npos && pos + 1 < head.size()) {
+    const size_t start = pos + 1;
+    pos = head.find('\n', start);
+    const std::string_view line = trim(head.substr(start, pos == std::string_view::npos ? std::string_view::npos : pos - start));
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos || !iequals(trim(line.substr(0, colon)), "connection")) continue;
+    const std::string_view value = line.substr(colon + 1);
+    if (lists(value, "close")) req.keep_alive = false;
+    else if (lists(value, "keep-alive")) req.keep_alive = true;
+  }
+  return req;
+}
+
+void build_http_response(const HttpRequest& req, MetricsCache& cache, HttpResponse& out) {
+  out.exp.reset();
+  out.keep_alive = req.keep_alive;
+  const std::string_view line = req.request_line;
+  std::string_view target;
+  if (line.starts_with("GET ")) {
+    target = line.substr(4);
+    target = target.substr(0, target.find(' '));
+  }
+  MetricsSelection sel;
+  const MetricsTarget routed = target.starts_with("/metrics") ? parse_metrics_target(target, sel) : MetricsTarget::NotFound;
+  if (routed == MetricsTarget::Ok) {
+    // Rendered at most once per generation and selection; every scrape of it
+    // shares the bytes.
+    out.exp = cache.get(sel);
+    const bool gz = req.gzip && !out.exp->gzip().empty();
+    out.body = gz ? std::string_view(out.exp->gzip()) : std::string_view(out.exp->text());
+    append_head(out, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                gz ? "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n" : "Vary: Accept-Encoding\r\n");
+  } else if (routed == MetricsTarget::BadRequest) {
+    out.body = kBadRequestBody;
+    append_head(out, "400 Bad Request", "text/plain", "");
+  } else if (target == "/") {
+    out.body = kIndexBody;
+    append_head(out, "200 OK", "text/plain", "");
+  } else {
+    out.body = kNotFoundBody;
+    append_head(out, "404 Not Found", "text/plain", "");
+  }
+}
+
+void build_http_too_large(HttpResponse& out) {
+  out.exp.reset();
+  out.keep_alive = false;
+  out.body = kTooLargeBody;
+  append_head(out, "431 Request Header Fields Too Large", "text/plain", "");
+}
+
+} // namespace montauk::app
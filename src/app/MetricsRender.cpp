@@ -2,7 +2,7 @@
 // snapshot_to_prometheus drive through their own MetricsSink -- every field
 // read and visited exactly once here. Section order follows the original
 // JSON layout (system, cpu, pmu, memory, gpu, thermal, network, disk,
-// filesystems, providers, processes); Prometheus's original section order
+// filesystems, cgroups, pressure, providers, processes); Prometheus's original section order
 // differed from JSON's (its own metric-family order doesn't matter to a
 // Prometheus scraper, and JSON object key order doesn't matter to a JSON
 // reader, so unifying onto one canonical order changes surface *ordering*
@@ -10,6 +10,7 @@
 #include "app/MetricsRender.hpp"
 #include "ui/Formatting.hpp"
 
+#include <algorithm>
 #include <cstdio>
 
 // Stamped by CMake (project VERSION -> montauk_core PUBLIC); the fallback keeps
@@ -459,6 +460,87 @@ void render_filesystems(MetricsSink& sink, const MetricsSnapshot& s) {
   sink.collection_end();
 }
 
+// Busiest cgroup v2 groups, as subtree totals (see CgroupCollector). Absent
+// without a v2 hierarchy.
+void render_cgroups(MetricsSink& sink, const MetricsSnapshot& s) {
+  if (s.cgroups.groups.empty()) return;
+  sink.collection_begin("cgroups", Shape::Objects);
+  MetricDesc cpu{nullptr, "montauk_cgroup_cpu_percent", "Per-cgroup CPU utilization (100 = one core)"};
+  MetricDesc thr{nullptr, "montauk_cgroup_cpu_throttled_percent", "Per-cgroup CPU time throttled by its quota"};
+  MetricDesc mem{nullptr, "montauk_cgroup_memory_bytes", "Per-cgroup memory.current"};
+  MetricDesc anon{nullptr, "montauk_cgroup_memory_anon_bytes", "Per-cgroup anonymous memory"};
+  MetricDesc file{nullptr, "montauk_cgroup_memory_file_bytes", "Per-cgroup page cache"};
+  MetricDesc rd{nullptr, "montauk_cgroup_io_read_bps", "Per-cgroup read bytes/sec"};
+  MetricDesc wr{nullptr, "montauk_cgroup_io_write_bps", "Per-cgroup write bytes/sec"};
+  MetricDesc pids{nullptr, "montauk_cgroup_pids", "Per-cgroup pids.current"};
+  for (const auto& g : s.cgroups.groups) {
+    sink.entry_begin();
+    sink.str({"path", nullptr, nullptr}, g.path);
+    sink.i64({"depth", nullptr, nullptr}, g.depth);
+    sink.f64({"cpu_pct", nullptr, nullptr}, g.cpu_pct);
+    sink.f64({"throttled_pct", nullptr, nullptr}, g.throttled_pct);
+    sink.u64({"mem_bytes", nullptr, nullptr}, g.mem_bytes);
+    sink.u64({"anon_bytes", nullptr, nullptr}, g.anon_bytes);
+    sink.u64({"file_bytes", nullptr, nullptr}, g.file_bytes);
+    sink.f64({"io_read_bps", nullptr, nullptr}, g.io_read_bps);
+    sink.f64({"io_write_bps", nullptr, nullptr}, g.io_write_bps);
+    sink.u64({"pids", nullptr, nullptr}, g.pids);
+    Label l[]{{"cgroup", g.path}};
+    sink.labeled_f64(cpu, l, g.cpu_pct);
+    sink.labeled_f64(thr, l, g.throttled_pct);
+    sink.labeled_u64(mem, l, g.mem_bytes);
+    sink.labeled_u64(anon, l, g.anon_bytes);
+    sink.labeled_u64(file, l, g.file_bytes);
+    sink.labeled_f64(rd, l, g.io_read_bps);
+    sink.labeled_f64(wr, l, g.io_write_bps);
+    sink.labeled_u64(pids, l, g.pids);
+    sink.entry_end();
+  }
+  sink.collection_end();
+}
+
+void render_pressure(MetricsSink& sink, const MetricsSnapshot& s) {
+  if (s.psi.entries.empty()) return;
+  sink.collection_begin("pressure", Shape::Objects);
+  MetricDesc some10{nullptr, "montauk_pressure_some_avg10", "Share of time some tasks stalled, 10 s average (percent)"};
+  MetricDesc some60{nullptr, "montauk_pressure_some_avg60", "Share of time some tasks stalled, 60 s average (percent)"};
+  MetricDesc full10{nullptr, "montauk_pressure_full_avg10", "Share of time all tasks stalled, 10 s average (percent)"};
+  MetricDesc full60{nullptr, "montauk_pressure_full_avg60", "Share of time all tasks stalled, 60 s average (percent)"};
+  MetricDesc some_total{nullptr, "montauk_pressure_some_stall_seconds_total",
+                        "Time some tasks were stalled (cumulative)", MetricKind::Counter};
+  MetricDesc full_total{nullptr, "montauk_pressure_full_stall_seconds_total",
+                        "Time all tasks were stalled (cumulative)", MetricKind::Counter};
+  MetricDesc fires{nullptr, "montauk_pressure_trigger_fires_total",
+                   "PSI stall trigger events since start", MetricKind::Counter};
+  for (const auto& r : s.psi.entries) {
+    sink.entry_begin();
+    sink.str({"scope", nullptr, nullptr}, r.scope);
+    sink.str({"resource", nullptr, nullptr}, r.resource);
+    sink.f64({"some_avg10", nullptr, nullptr}, r.some.avg10);
+    sink.f64({"some_avg60", nullptr, nullptr}, r.some.avg60);
+    sink.u64({"some_total_us", nullptr, nullptr}, r.some.total_us);
+    if (r.has_full) {
+      sink.f64({"full_avg10", nullptr, nullptr}, r.full.avg10);
+      sink.f64({"full_avg60", nullptr, nullptr}, r.full.avg60);
+      sink.u64({"full_total_us", nullptr, nullptr}, r.full.total_us);
+    }
+    sink.boolean({"trigger_armed", nullptr, nullptr}, r.armed);
+    sink.u64({"trigger_fires", nullptr, nullptr}, r.trigger_fires);
+    Label l[]{{"scope", r.scope}, {"resource", r.resource}};
+    sink.labeled_f64(some10, l, r.some.avg10);
+    sink.labeled_f64(some60, l, r.some.avg60);
+    sink.labeled_f64(some_total, l, static_cast<double>(r.some.total_us) / 1e6);
+    if (r.has_full) {
+      sink.labeled_f64(full10, l, r.full.avg10);
+      sink.labeled_f64(full60, l, r.full.avg60);
+      sink.labeled_f64(full_total, l, static_cast<double>(r.full.total_us) / 1e6);
+    }
+    if (r.armed) sink.labeled_u64(fires, l, r.trigger_fires);
+    sink.entry_end();
+  }
+  sink.collection_end();
+}
+
 void render_providers(MetricsSink& sink, const MetricsSnapshot& s) {
   if (s.providers.empty()) return;
   sink.collection_begin("providers", Shape::Objects);
@@ -470,44 +552,114 @@ void render_providers(MetricsSink& sink, const MetricsSnapshot& s) {
   sink.collection_end();
 }
 
-void render_processes(MetricsSink& sink, const MetricsSnapshot& s) {
+void render_processes(MetricsSink& sink, const MetricsSnapshot& s, size_t top) {
   sink.section_begin("processes");
   sink.u64({"total", "montauk_processes_total", "Total processes"}, s.total_processes);
   sink.u64({"running", "montauk_processes_running", "Running processes"}, s.running_processes);
   sink.u64({"sleeping", "montauk_processes_sleeping", "Sleeping processes"}, s.state_sleeping);
   sink.u64({"zombie", "montauk_processes_zombie", "Zombie processes"}, s.state_zombie);
   sink.u64({"threads", "montauk_threads_total", "Total threads"}, s.total_threads);
+  sink.u64({"sample_us", "montauk_process_sample_microseconds", "Wall time of the last process collection pass"}, s.proc_sample_us);
+  sink.u64({"scan_shards", "montauk_process_scan_shards", "Shards the last per-pid parse ran on"}, s.proc_scan_shards);
+
+  // Processes that lived and died between two samples, rolled up by comm:
+  // the CPU a fork-heavy build spends where no row ever shows it.
+  if (!s.exited.empty()) {
+    sink.collection_begin("exited", Shape::Objects);
+    MetricDesc n_desc{nullptr, "montauk_exited_processes", "Short-lived processes exited in the last 30-60s"};
+    MetricDesc cpu_desc{nullptr, "montauk_exited_cpu_seconds", "Lifetime CPU of short-lived processes exited in the last 30-60s"};
+    MetricDesc rss_desc{nullptr, "montauk_exited_max_rss_bytes", "Largest peak RSS among short-lived processes exited in the last 30-60s"};
+    MetricDesc io_desc{nullptr, "montauk_exited_io_bytes", "Storage I/O of short-lived processes exited in the last 30-60s"};
+    for (const auto& e : s.exited) {
+      const double cpu_s = static_cast<double>(e.cpu_us) / 1e6;
+      sink.entry_begin();
+      sink.str({"comm", nullptr, nullptr}, e.comm);
+      sink.u64({"exits", nullptr, nullptr}, e.exits);
+      sink.f64({"cpu_seconds", nullptr, nullptr}, cpu_s);
+      sink.u64({"max_rss_kb", nullptr, nullptr}, e.max_rss_kb);
+      sink.u64({"io_bytes", nullptr, nullptr}, e.io_bytes);
+      Label l[]{{"comm", e.comm}};
+      sink.labeled_u64(n_desc, l, e.exits);
+      sink.labeled_f64(cpu_desc, l, cpu_s);
+      sink.labeled_u64(rss_desc, l, e.max_rss_kb * 1024ULL);
+      sink.labeled_u64(io_desc, l, e.io_bytes);
+      sink.entry_end();
+    }
+    sink.collection_end();
+  }
 
-  if (s.top_procs_count > 0) {
+  const auto& t = s.top_procs;
+  const size_t rows = std::min(t.size(), top);
+  if (rows) {
     sink.collection_begin("top", Shape::Objects);
     MetricDesc cpu_desc{nullptr, "montauk_process_cpu_percent", "Per-process CPU utilization"};
     MetricDesc mem_desc{nullptr, "montauk_process_memory_bytes", "Per-process resident memory"};
     MetricDesc gpu_util_desc{nullptr, "montauk_process_gpu_utilization_percent", "Per-process GPU utilization"};
     MetricDesc gpu_mem_desc{nullptr, "montauk_process_gpu_memory_bytes", "Per-process GPU memory"};
     MetricDesc anom_desc{nullptr, "montauk_process_anomaly_score", "Per-process fused anomaly score"};
-    for (int i = 0; i < s.top_procs_count; ++i) {
-      const auto& p = s.top_procs[i];
+    MetricDesc io_rd_desc{nullptr, "montauk_process_io_read_bps", "Per-process storage read bytes/sec"};
+    MetricDesc io_wr_desc{nullptr, "montauk_process_io_write_bps", "Per-process storage write bytes/sec"};
+    MetricDesc pss_desc{nullptr, "montauk_process_pss_bytes", "Per-process proportional set size"};
+    MetricDesc sub_cpu_desc{nullptr, "montauk_process_subtree_cpu_percent", "CPU utilization of the process and all its descendants"};
+    MetricDesc sub_mem_desc{nullptr, "montauk_process_subtree_memory_bytes", "Resident memory of the process and all its descendants"};
+    MetricDesc sub_thr_desc{nullptr, "montauk_process_subtree_threads", "Threads in the process and all its descendants"};
+    MetricDesc sub_n_desc{nullptr, "montauk_process_subtree_processes", "Processes in the subtree rooted at the process, itself included"};
+    for (size_t i = 0; i < rows; ++i) {
+      const std::string& cmd = t.cmd_of(i);
       sink.entry_begin();
-      sink.i64({"pid", nullptr, nullptr}, p.pid);
-      sink.str({"cmd", nullptr, nullptr}, p.cmd);
-      sink.str({"user", nullptr, nullptr}, p.user_name);
-      sink.f64({"cpu_pct", nullptr, nullptr}, p.cpu_pct);
-      sink.u64({"rss_kb", nullptr, nullptr}, p.rss_kb);
-      if (p.has_gpu_util) sink.f64({"gpu_util_pct", nullptr, nullptr}, p.gpu_util_pct);
-      if (p.has_gpu_mem) sink.u64({"gpu_mem_kb", nullptr, nullptr}, p.gpu_mem_kb);
-      sink.f64({"anomaly_score", nullptr, nullptr}, p.anomaly_score);
-      sink.i64({"anomaly_axis", nullptr, nullptr}, p.anomaly_axis);
+      sink.i64({"pid", nullptr, nullptr}, t.pid[i]);
+      sink.str({"cmd", nullptr, nullptr}, cmd);
+      sink.str({"user", nullptr, nullptr}, t.user_of(i));
+      sink.f64({"cpu_pct", nullptr, nullptr}, t.cpu_pct[i]);
+      sink.u64({"rss_kb", nullptr, nullptr}, t.rss_kb[i]);
+      if (t.has_gpu_util[i]) sink.f64({"gpu_util_pct", nullptr, nullptr}, t.gpu_util_pct[i]);
+      if (t.has_gpu_mem[i]) sink.u64({"gpu_mem_kb", nullptr, nullptr}, t.gpu_mem_kb[i]);
+      sink.f64({"anomaly_score", nullptr, nullptr}, t.anomaly_score[i]);
+      sink.i64({"anomaly_axis", nullptr, nullptr}, t.anomaly_axis[i]);
+      // Read under a time budget, so only present once read, with the age of
+      // the read they came from.
+      const bool has_io = t.io_age_ms[i] != montauk::model::kAgeNever;
+      const bool has_pss = t.pss_age_ms[i] != montauk::model::kAgeNever;
+      if (has_io) {
+        sink.f64({"io_read_bps", nullptr, nullptr}, t.io_read_bps[i]);
+        sink.f64({"io_write_bps", nullptr, nullptr}, t.io_write_bps[i]);
+        sink.u64({"io_age_ms", nullptr, nullptr}, t.io_age_ms[i]);
+      }
+      if (has_pss) {
+        sink.u64({"pss_kb", nullptr, nullptr}, t.pss_kb[i]);
+        sink.u64({"pss_age_ms", nullptr, nullptr}, t.pss_age_ms[i]);
+      }
+      // Only from collectors that keep a process tree (not the kernel module).
+      const bool has_tree = t.subtree_procs[i] != 0;
+      if (has_tree) {
+        sink.i64({"ppid", nullptr, nullptr}, t.ppid[i]);
+        sink.f64({"subtree_cpu_pct", nullptr, nullptr}, t.subtree_cpu_pct[i]);
+        sink.u64({"subtree_rss_kb", nullptr, nullptr}, t.subtree_rss_kb[i]);
+        sink.u64({"subtree_threads", nullptr, nullptr}, t.subtree_threads[i]);
+        sink.u64({"subtree_procs", nullptr, nullptr}, t.subtree_procs[i]);
+      }
 
       // Prometheus per-process labels: pid + cmd, cmd truncated to 32 chars --
       // preserved verbatim from emit_labeled_2d/2u's original max_len=32 arg.
-      std::string pid_str = std::to_string(p.pid);
-      std::string cmd_trunc = p.cmd.substr(0, 32);
+      std::string pid_str = std::to_string(t.pid[i]);
+      std::string cmd_trunc = cmd.substr(0, 32);
       Label l[]{{"pid", pid_str}, {"cmd", cmd_trunc}};
-      sink.labeled_f64(cpu_desc, l, p.cpu_pct);
-      sink.labeled_u64(mem_desc, l, p.rss_kb * 1024ULL);
-      if (p.has_gpu_util) sink.labeled_f64(gpu_util_desc, l, p.gpu_util_pct);
-      if (p.has_gpu_mem) sink.labeled_u64(gpu_mem_desc, l, p.gpu_mem_kb * 1024ULL);
-      sink.labeled_f64(anom_desc, l, p.anomaly_score);
+      sink.labeled_f64(cpu_desc, l, t.cpu_pct[i]);
+      sink.labeled_u64(mem_desc, l, t.rss_kb[i] * 1024ULL);
+      if (t.has_gpu_util[i]) sink.labeled_f64(gpu_util_desc, l, t.gpu_util_pct[i]);
+      if (t.has_gpu_mem[i]) sink.labeled_u64(gpu_mem_desc, l, t.gpu_mem_kb[i] * 1024ULL);
+      sink.labeled_f64(anom_desc, l, t.anomaly_score[i]);
+      if (has_io) {
+        sink.labeled_f64(io_rd_desc, l, t.io_read_bps[i]);
+        sink.labeled_f64(io_wr_desc, l, t.io_write_bps[i]);
+      }
+      if (has_pss) sink.labeled_u64(pss_desc, l, t.pss_kb[i] * 1024ULL);
+      if (has_tree) {
+        sink.labeled_f64(sub_cpu_desc, l, t.subtree_cpu_pct[i]);
+        sink.labeled_u64(sub_mem_desc, l, t.subtree_rss_kb[i] * 1024ULL);
+        sink.labeled_u64(sub_thr_desc, l, t.subtree_threads[i]);
+        sink.labeled_u64(sub_n_desc, l, t.subtree_procs[i]);
+      }
       sink.entry_end();
     }
     sink.collection_end();
@@ -558,18 +710,21 @@ void render_processes(MetricsSink& sink, const MetricsSnapshot& s) {
 
 }  // namespace
 
-void render_snapshot(MetricsSink& sink, const MetricsSnapshot& s) {
-  render_system(sink, s);
-  render_cpu(sink, s);
-  render_pmu(sink, s);
-  render_memory(sink, s);
-  render_gpu(sink, s);
-  render_thermal(sink, s);
-  render_network(sink, s);
-  render_disk(sink, s);
-  render_filesystems(sink, s);
-  render_providers(sink, s);
-  render_processes(sink, s);
+void render_snapshot(MetricsSink& sink, const MetricsSnapshot& s, const MetricsSelection& sel) {
+  using enum MetricsSection;
+  if (sel.wants(System)) render_system(sink, s);
+  if (sel.wants(Cpu)) render_cpu(sink, s);
+  if (sel.wants(Pmu)) render_pmu(sink, s);
+  if (sel.wants(Memory)) render_memory(sink, s);
+  if (sel.wants(Gpu)) render_gpu(sink, s);
+  if (sel.wants(Thermal)) render_thermal(sink, s);
+  if (sel.wants(Network)) render_network(sink, s);
+  if (sel.wants(Disk)) render_disk(sink, s);
+  if (sel.wants(Filesystems)) render_filesystems(sink, s);
+  if (sel.wants(Cgroups)) render_cgroups(sink, s);
+  if (sel.wants(Pressure)) render_pressure(sink, s);
+  if (sel.wants(Providers)) render_providers(sink, s);
+  if (sel.wants(Processes)) render_processes(sink, s, sel.top);
 }
 
 }  // namespace montauk::app
@@ -0,0 +1,165 @@
+#include "app/MetricsSelection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+
+namespace montauk::app {
+
+namespace {
+
+constexpr uint32_t bit(MetricsSection s) { return 1u << static_cast<unsigned>(s); }
+
+// Indexed by MetricsSection. Providers pass third-party expositions through
+// under whatever names they chose, so the empty prefix: any filter may match.
+constexpr std::string_view kSystem[] = {"montauk_system_"};
+constexpr std::string_view kCpu[] = {"montauk_cpu_"};
+constexpr std::string_view kPmu[] = {"montauk_pmu_", "montauk_energy_per_instruction_"};
+constexpr std::string_view kMemory[] = {"montauk_memory_"};
+constexpr std::string_view kGpu[] = {"montauk_gpu_"};
+constexpr std::string_view kThermal[] = {"montauk_thermal_", "montauk_cstate_", "montauk_package_energy_", "montauk_power_"};
+constexpr std::string_view kNetwork[] = {"montauk_network_"};
+constexpr std::string_view kDisk[] = {"montauk_disk_"};
+constexpr std::string_view kFilesystems[] = {"montauk_filesystem_"};
+constexpr std::string_view kCgroups[] = {"montauk_cgroup_"};
+constexpr std::string_view kPressure[] = {"montauk_pressure_"};
+constexpr std::string_view kProviders[] = {""};
+constexpr std::string_view kProcesses[] = {"montauk_process_", "montauk_processes_", "montauk_exited_", "montauk_threads_"};
+constexpr std::string_view kTrace[] = {"montauk_trace_", "montauk_sched_op_"};
+
+constexpr std::array<std::span<const std::string_view>, static_cast<size_t>(MetricsSection::Count)> kPrefixes{
+    kSystem, kCpu, kPmu, kMemory, kGpu, kThermal, kNetwork, kDisk, kFilesystems,
+    kCgroups, kPressure, kProviders, kProcesses, kTrace};
+
+bool is_prefix_pattern(std::string_view f) { return f.ends_with('*'); }
+
+std::string percent_decode(std::string_view s) {
+  std::string out;
+  out.reserve(s.size());
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s[i] == '%' && i + 2 < s.size()) {
+      unsigned v = 0;
+      auto [p, ec] = std::from_chars(s.data() + i + 1, s.data() + i + 3, v, 16);
+      if (ec == std::errc{} && p == s.data() + i + 3) {
+        out += static_cast<char>(v);
+        i += 2;
+        continue;
+      }
+    }
+    out += s[i] == '+' ? ' ' : s[i];
+  }
+  return out;
+}
+
+// Prometheus metric-name characters, with * allowed only as the last one.
+bool valid_family(std::string_view f) {
+  if (f.empty()) return false;
+  for (size_t i = 0; i < f.size(); ++i) {
+    const char c = f[i];
+    const bool name_char = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                           c == '_' || c == ':';
+    if (!name_char && !(c == '*' && i + 1 == f.size())) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+std::span<const std::string_view> section_family_prefixes(MetricsSection s) {
+  return kPrefixes[static_cast<size_t>(s)];
+}
+
+bool MetricsSelection::wants(MetricsSection s) const {
+  if (!(sections & bit(s))) return false;
+  if (families.empty()) return true;
+  for (const auto& f : families) {
+    const bool prefix = is_prefix_pattern(f);
+    const std::string_view q = prefix ? std::string_view(f).substr(0, f.size() - 1) : std::string_view(f);
+    for (std::string_view p : section_family_prefixes(s))
+      if (q.starts_with(p) || (prefix && p.starts_with(q))) return true;
+  }
+  return false;
+}
+
+bool MetricsSelection::wants_snapshot() const {
+  for (unsigned i = 0; i < static_cast<unsigned>(MetricsSection::Trace); ++i)
+    if (wants(static_cast<MetricsSection>(i))) return true;
+  return false;
+}
+
+bool MetricsSelection::wants_family(std::string_view name) const {
+  if (families.empty()) return true;
+  for (const auto& f : families) {
+    if (is_prefix_pattern(f) ? name.starts_with(std::string_view(f).substr(0, f.size() - 1)) : name == f)
+      return true;
+  }
+  return false;
+}
+
+MetricsTarget parse_metrics_target(std::string_view target, MetricsSelection& out) {
+  out = MetricsSelection{};
+  const size_t q = target.find('?');
+  std::string_view path = target.substr(0, q);
+  std::string_view query = q == std::string_view::npos ? std::string_view{} : target.substr(q + 1);
+  if (path.size() > 1 && path.ends_with('/')) path.remove_suffix(1);
+
+  if (path == "/metrics") out.sections = MetricsSelection::kAllSections;
+  else if (path == "/metrics/system") out.sections = MetricsSelection::kAllSections & ~(bit(MetricsSection::Processes) | bit(MetricsSection::Trace));
+  else if (path == "/metrics/procs") out.sections = bit(MetricsSection::Processes);
+  else if (path == "/metrics/trace") out.sections = bit(MetricsSection::Trace);
+  else return MetricsTarget::NotFound;
+
+  bool has_top = false;
+  while (!query.empty()) {
+    const size_t amp = query.find('&');
+    const std::string_view param = query.substr(0, amp);
+    query = amp == std::string_view::npos ? std::string_view{} : query.substr(amp + 1);
+    if (param.empty()) continue;
+    const size_t eq = param.find('=');
+    const std::string_view key = param.substr(0, eq);
+    const std::string value = percent_decode(eq == std::string_view::npos ? std::string_view{} : param.substr(eq + 1));
+
+    if (key == "family") {
+      std::string_view list = value;
+      while (!list.empty()) {
+        const size_t comma = list.find(',');
+        const std::string_view f = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+        if (f.empty()) continue;
+        if (!valid_family(f)) return MetricsTarget::BadRequest;
+        out.families.emplace_back(f);
+      }
+    } else if (key == "top") {
+      size_t n = 0;
+      auto [p, ec] = std::from_chars(value.data(), value.data() + value.size(), n);
+      if (value.empty() || ec != std::errc{} || p != value.data() + value.size()) return MetricsTarget::BadRequest;
+      out.top = std::min(out.top, n);
+      has_top = true;
+    } else {
+      return MetricsTarget::BadRequest;
+    }
+  }
+
+  // Same selection, same key, whatever order the parameters came in.
+  std::sort(out.families.begin(), out.families.end());
+  out.families.erase(std::unique(out.families.begin(), out.families.end()), out.families.end());
+  if (path == "/metrics" && out.families.empty() && !has_top) return MetricsTarget::Ok;  // key stays empty
+  out.key = path;
+  char sep = '?';
+  if (!out.families.empty()) {
+    out.key += sep;
+    out.key += "family=";
+    for (size_t i = 0; i < out.families.size(); ++i) {
+      if (i) out.key += ',';
+      out.key += out.families[i];
+    }
+    sep = '&';
+  }
+  if (has_top) {
+    out.key += sep;
+    out.key += "top=" + std::to_string(out.top);
+  }
+  return MetricsTarget::Ok;
+}
+
+} // namespace montauk::app
@@ -1,4 +1,5 @@
 #include "app/MetricsServer.hpp"
+#include "app/MetricsHttp.hpp"
 #include "util/UringDyn.hpp"
 #include "util/Log.hpp"
 #include <liburing.h>
@@ -8,19 +9,310 @@
 #include <netinet/tcp.h>
 #include <poll.h>
 #include <unistd.h>
+#include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
-#include <algorithm>
-#include <charconv>
+#include <memory>
+#include <vector>
 
 namespace montauk::app {
 
-// Tags for distinguishing CQE sources
-enum class UringTag : uint64_t { ListenPoll = 1, StopPoll = 2 };
+namespace {
+
+// Tags for distinguishing CQE sources: the top byte of user_data. Connection
+// completions carry their table slot in the low bits.
+enum class UringTag : uint64_t { Accept = 1, StopPoll = 2, Tick = 3, Conn = 4 };
+
+constexpr uint64_t user_data(UringTag tag, uint32_t slot = 0) {
+  return (static_cast<uint64_t>(tag) << 56) | slot;
+}
+
+// SQ depth. Every connection has at most one op in flight, plus accept, the
+// stop poll and the tick, so the CQ (twice this) never overflows.
+constexpr unsigned kRingEntries = 1024;
+static_assert(MetricsServer::kMaxConns + 3 <= kRingEntries);
+
+using Clock = std::chrono::steady_clock;
+
+struct Conn {
+  int fd{-1};
+  bool sending{false};  // the op in flight is the response, not a recv
+  bool expired{false};  // past its deadline: shut down, closed on its next completion
+  // Set once per phase, never pushed back by a partial recv or short send:
+  // idle until a request's first byte, then kIoTimeoutSec to finish the
+  // request, then kIoTimeoutSec from dispatch to finish the response.
+  Clock::time_point deadline{};
+  std::unique_ptr<char[]> in;  // kRequestMax bytes, allocated on the slot's first use
+  size_t have{0};
+  HttpResponse resp;
+  iovec iov[2]{};
+  msghdr msg{};
+};
+
+// The event loop proper. Every socket op is an io_uring SQE; the thread only
+// blocks in submit_and_wait, so no client can hold it up.
+class UringHttpLoop {
+public:
+  UringHttpLoop(io_uring& ring, montauk::util::UringDyn& uring, int listen_fd, int stop_fd,
+                MetricsCache& cache)
+      : ring_(ring), uring_(uring), listen_fd_(listen_fd), stop_fd_(stop_fd), cache_(cache),
+        conns_(MetricsServer::kMaxConns) {
+    free_.reserve(conns_.size());
+    for (size_t i = conns_.size(); i-- > 0;) free_.push_back(static_cast<uint32_t>(i));
+  }
+
+  ~UringHttpLoop() {
+    for (auto& c : conns_)
+      if (c.fd >= 0) ::close(c.fd);
+  }
+
+  // Returns with no connection op left in flight (see reap_conns()).
+  void run(std::stop_token st) {
+    serve(st);
+    reap_conns();
+  }
+
+private:
+  void serve(std::stop_token st) {
+    arm_accept();
+    auto* sqe = get_sqe();
+    io_uring_prep_poll_add(sqe, stop_fd_, POLLIN);
+    io_uring_sqe_set_data64(sqe, user_data(UringTag::StopPoll));
+    arm_tick();
+
+    while (!st.stop_requested()) {
+      int ret = uring_.submit_and_wait(&ring_, 1);
+      if (ret < 0 && ret != -EINTR) {
+        montauk::util::log_error("metrics server: io_uring_submit_and_wait() failed: %s", std::strerror(-ret));
+        return;
+      }
+      // Drain everything already posted before entering the kernel again.
+      struct io_uring_cqe* cqe = nullptr;
+      while (!__io_uring_peek_cqe(&ring_, &cqe, nullptr) && cqe) {
+        const uint64_t data = io_uring_cqe_get_data64(cqe);
+        const int res = cqe->res;
+        const unsigned flags = cqe->flags;
+        io_uring_cqe_seen(&ring_, cqe);
+        switch (static_cast<UringTag>(data >> 56)) {
+          case UringTag::StopPoll: return;
+          case UringTag::Accept: on_accept(res, flags); break;
+          case UringTag::Tick: on_tick(); break;
+          case UringTag::Conn: on_conn(static_cast<uint32_t>(data), res); break;
+        }
+      }
+    }
+  }
+
+  // Every open connection has exactly one recv or send in flight, pointing
+  // into its Conn. Shut the sockets so each completes now, and wait for all
+  // of those completions: only then may the buffers be freed.
+  void reap_conns() {
+    size_t inflight = 0;
+    for (auto& c : conns_) {
+      if (c.fd < 0) continue;
+      ::shutdown(c.fd, SHUT_RDWR);
+      ++inflight;
+    }
+    while (inflight > 0) {
+      int ret = uring_.submit_and_wait(&ring_, 1);
+      if (ret < 0 && ret != -EINTR) return;  // the ring goes first in MetricsServer::run
+      struct io_uring_cqe* cqe = nullptr;
+      while (!__io_uring_peek_cqe(&ring_, &cqe, nullptr) && cqe) {
+        const uint64_t data = io_uring_cqe_get_data64(cqe);
+        io_uring_cqe_seen(&ring_, cqe);
+        if (static_cast<UringTag>(data >> 56) != UringTag::Conn) continue;
+        const auto slot = static_cast<uint32_t>(data);
+        if (conns_[slot].fd < 0) continue;
+        close_conn(slot);
+        --inflight;
+      }
+    }
+  }
+
+  // submit() empties the SQ, so the retry always succeeds: kRingEntries
+  // covers every op that can be queued between two submits.
+  struct io_uring_sqe* get_sqe() {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (!sqe) {
+      uring_.submit(&ring_);
+      sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+  }
+
+  void arm_accept() {
+    auto* sqe = get_sqe();
+    // Multishot (5.19+): one SQE keeps posting a CQE per accepted connection.
+    if (multishot_) io_uring_prep_multishot_accept(sqe, listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    else io_uring_prep_accept(sqe, listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    io_uring_sqe_set_data64(sqe, user_data(UringTag::Accept));
+  }
+
+  void on_accept(int res, unsigned flags) {
+    if (res >= 0) {
+      open_conn(res);
+    } else if (res == -EINVAL && multishot_) {
+      montauk::util::log_info("metrics server: kernel lacks multishot accept, re-arming per connection");
+      multishot_ = false;
+    } else if (res != -EINTR && res != -ECONNABORTED && res != -EAGAIN) {
+      // EMFILE and friends: re-arming now would spin, so wait for the tick.
+      montauk::util::log_warn("metrics server: accept failed: %s", std::strerror(-res));
+      accept_paused_ = true;
+      return;
+    }
+    if (!(flags & IORING_CQE_F_MORE)) arm_accept();
+  }
+
+  void open_conn(int fd) {
+    if (free_.empty()) {
+      // The table is the bound: refusing here keeps the loop's memory and
+      // per-tick sweep fixed however many clients pile on.
+      if (!warned_full_) {
+        montauk::util::log_warn("metrics server: %zu connections open, refusing more",
+                                MetricsServer::kMaxConns);
+        warned_full_ = true;
+      }
+      ::close(fd);
+      return;
+    }
+    const uint32_t slot = free_.back();
+    free_.pop_back();
+    Conn& c = conns_[slot];
+    c.fd = fd;
+    c.have = 0;
+    c.expired = false;
+    if (!c.in) c.in = std::make_unique<char[]>(MetricsServer::kRequestMax);
+    int one = 1;
+    (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    arm_recv(slot);
+  }
+
+  void close_conn(uint32_t slot) {
+    Conn& c = conns_[slot];
+    ::close(c.fd);
+    c.fd = -1;
+    c.have = 0;
+    c.resp.exp.reset();  // let go of the exposition this connection pinned
+    free_.push_back(slot);
+    warned_full_ = false;
+  }
+
+  void arm_recv(uint32_t slot) {
+    Conn& c = conns_[slot];
+    c.sending = false;
+    // An empty buffer is an idle keep-alive connection. A partial request
+    // keeps the deadline its first byte set (on_conn), so a client trickling
+    // bytes cannot stretch it.
+    if (c.have == 0) c.deadline = Clock::now() + std::chrono::seconds(MetricsServer::kIdleTimeoutSec);
+    auto* sqe = get_sqe();
+    io_uring_prep_recv(sqe, c.fd, c.in.get() + c.have, MetricsServer::kRequestMax - c.have, 0);
+    io_uring_sqe_set_data64(sqe, user_data(UringTag::Conn, slot));
+  }
+
+  void arm_send(uint32_t slot) {
+    Conn& c = conns_[slot];
+    c.sending = true;
+    auto* sqe = get_sqe();
+    // MSG_NOSIGNAL: a scraper that hung up mid-response must not SIGPIPE montauk.
+    io_uring_prep_sendmsg(sqe, c.fd, &c.msg, MSG_NOSIGNAL);
+    io_uring_sqe_set_data64(sqe, user_data(UringTag::Conn, slot));
+  }
+
+  // Answer the request at the front of the buffer, or read more of it.
+  void dispatch(uint32_t slot) {
+    Conn& c = conns_[slot];
+    const auto req = parse_http_request(std::string_view(c.in.get(), c.have));
+    if (!req) {
+      if (c.have < MetricsServer::kRequestMax) return arm_recv(slot);
+      build_http_too_large(c.resp);
+      c.have = 0;
+    } else {
+      build_http_response(*req, cache_, c.resp);
+      // Drop the request; a pipelined one behind it is answered after this.
+      std::memmove(c.in.get(), c.in.get() + req->length, c.have - req->length);
+      c.have -= req->length;
+    }
+    // Head and body go out together without being concatenated.
+    c.iov[0] = {.iov_base = c.resp.head.data(), .iov_len = c.resp.head.size()};
+    c.iov[1] = {.iov_base = const_cast<char*>(c.resp.body.data()), .iov_len = c.resp.body.size()};
+    c.msg = {};
+    c.msg.msg_iov = c.iov;
+    c.msg.msg_iovlen = c.resp.body.empty() ? 1 : 2;
+    // The whole response, short sends included, gets one timeout.
+    c.deadline = Clock::now() + std::chrono::seconds(MetricsServer::kIoTimeoutSec);
+    arm_send(slot);
+  }
+
+  void on_conn(uint32_t slot, int res) {
+    Conn& c = conns_[slot];
+    if (res <= 0 || c.expired) return close_conn(slot);
+    if (!c.sending) {
+      // First byte of a request: its deadline starts now, once.
+      if (c.have == 0) c.deadline = Clock::now() + std::chrono::seconds(MetricsServer::kIoTimeoutSec);
+      c.have += static_cast<size_t>(res);
+      return dispatch(slot);
+    }
+    // Short send: step past what went out and send the rest.
+    size_t sent = static_cast<size_t>(res);
+    while (c.msg.msg_iovlen > 0 && sent >= c.msg.msg_iov->iov_len) {
+      sent -= c.msg.msg_iov->iov_len;
+      ++c.msg.msg_iov;
+      --c.msg.msg_iovlen;
+    }
+    if (c.msg.msg_iovlen > 0) {
+      c.msg.msg_iov->iov_base = static_cast<char*>(c.msg.msg_iov->iov_base) + sent;
+      c.msg.msg_iov->iov_len -= sent;
+      return arm_send(slot);
+    }
+    c.resp.exp.reset();
+    if (!c.resp.keep_alive) return close_conn(slot);
+    // A pipelined request already buffered starts its own deadline here.
+    if (c.have) c.deadline = Clock::now() + std::chrono::seconds(MetricsServer::kIoTimeoutSec);
+    dispatch(slot);
+  }
+
+  void arm_tick() {
+    auto* sqe = get_sqe();
+    io_uring_prep_timeout(sqe, &tick_ts_, 0, 0);
+    io_uring_sqe_set_data64(sqe, user_data(UringTag::Tick));
+  }
+
+  // Once a second: shut down every connection past its deadline. shutdown()
+  // completes its pending recv or send with an error, and that completion
+  // closes it -- so a slot is never freed under an op still in flight.
+  void on_tick() {
+    const auto now = Clock::now();
+    for (auto& c : conns_) {
+      if (c.fd < 0 || c.expired || now < c.deadline) continue;
+      ::shutdown(c.fd, SHUT_RDWR);
+      c.expired = true;
+    }
+    if (accept_paused_) {
+      accept_paused_ = false;
+      arm_accept();
+    }
+    arm_tick();
+  }
+
+  io_uring& ring_;
+  montauk::util::UringDyn& uring_;
+  int listen_fd_;
+  int stop_fd_;
+  MetricsCache& cache_;
+  std::vector<Conn> conns_;
+  std::vector<uint32_t> free_;  // free slots, lowest on top
+  struct __kernel_timespec tick_ts_{.tv_sec = 1, .tv_nsec = 0};
+  bool multishot_{true};
+  bool accept_paused_{false};
+  bool warned_full_{false};
+};
+
+}  // namespace
 
 MetricsServer::MetricsServer(const SnapshotBuffers& buffers, uint16_t port,
                              const TraceBuffers* trace)
-    : buffers_(buffers), trace_(trace), port_(port) {}
+    : buffers_(buffers), trace_(trace), cache_(buffers, trace), port_(port) {}
 
 MetricsServer::~MetricsServer() { stop(); }
 
@@ -34,7 +326,7 @@ void MetricsServer::stop() {
     // FORTIFY_SOURCE remaps write() to a fortified inline that re-applies
     // warn_unused_result, ignoring a plain (void) cast. Capture the return
     // and discard explicitly. The eventfd is best-effort wakeup; a failed
-    // write here just means the worker polls for stop_token instead.
+    // write here just means the worker sees the stop_token on its next tick.
     ssize_t r = ::write(stop_eventfd_, &val, sizeof(val));
     (void)r;
   }
@@ -67,7 +359,9 @@ void MetricsServer::run(std::stop_token st) {
     return;
   }
 
-  if (::listen(listen_fd_, 4) < 0) {
+  // A burst of scrapers connecting at once queues here instead of being
+  // refused while the loop works through the accept CQEs.
+  if (::listen(listen_fd_, SOMAXCONN) < 0) {
     montauk::util::log_error("metrics server: listen() failed: %s", std::strerror(errno));
     ::close(listen_fd_);
     listen_fd_ = -1;
@@ -97,8 +391,8 @@ void MetricsServer::run(std::stop_token st) {
 
   // Initialize io_uring
   struct io_uring ring{};
-  if (uring.queue_init(16, &ring, 0) < 0) {
-    montauk::util::log_error("metrics server: io_uring_queue_init() failed: %s", std::strerror(errno));
+  if (int rc = uring.queue_init(kRingEntries, &ring, 0); rc < 0) {
+    montauk::util::log_error("metrics server: io_uring_queue_init() failed: %s", std::strerror(-rc));
     ::close(stop_eventfd_);
     stop_eventfd_ = -1;
     ::close(listen_fd_);
@@ -106,123 +400,19 @@ void MetricsServer::run(std::stop_token st) {
     return;
   }
 
-  // Submit poll requests for listen_fd and stop_eventfd
-  auto submit_poll = [&](int fd, UringTag tag) {
-    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
-    io_uring_prep_poll_add(sqe, fd, POLLIN);
-    io_uring_sqe_set_data64(sqe, static_cast<uint64_t>(tag));
-  };
-
-  submit_poll(listen_fd_, UringTag::ListenPoll);
-  submit_poll(stop_eventfd_, UringTag::StopPoll);
-  uring.submit(&ring);
-
-  montauk::util::log_info("metrics server listening on :%d", port_);
-
-  // Event loop
-  while (!st.stop_requested()) {
-    struct io_uring_cqe* cqe = nullptr;
-    int ret = uring.wait_cqe(&ring, &cqe);
-    if (ret < 0) {
-      if (ret == -EINTR) continue;
-      break;
-    }
-
-    auto tag = static_cast<UringTag>(io_uring_cqe_get_data64(cqe));
-    int res = cqe->res;
-    io_uring_cqe_seen(&ring, cqe);
-
-    if (tag == UringTag::StopPoll || st.stop_requested()) {
-      break;
-    }
-
-    if (tag == UringTag::ListenPoll && res >= 0) {
-      // Accept and handle client
-      int client_fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
-      if (client_fd >= 0) {
-        handle_client(client_fd);
-        ::close(client_fd);
-      }
-      // Re-arm listen poll
-      submit_poll(listen_fd_, UringTag::ListenPoll);
-      uring.submit(&ring);
-    }
+  montauk::util::log_info("metrics server listening on :%d (up to %zu keep-alive connections)",
+                          port_, kMaxConns);
+  {
+    UringHttpLoop loop(ring, uring, listen_fd_, stop_eventfd_, cache_);
+    loop.run(st);  // reaps every connection op before returning
+    // run() has reaped every connection op, but the ring still goes before
+    // the loop: if a ring error cut the reap short, teardown cancels the
+    // leftovers while the Conn buffers they point into still exist.
+    uring.queue_exit(&ring);
   }
 
-  // Cleanup
-  uring.queue_exit(&ring);
   if (stop_eventfd_ >= 0) { ::close(stop_eventfd_); stop_eventfd_ = -1; }
   if (listen_fd_ >= 0) { ::close(listen_fd_); listen_fd_ = -1; }
 }
 
-void MetricsServer::handle_client(int fd) {
-  // Set timeouts to prevent slow clients from blocking the server
-  struct timeval tv{.tv_sec = 5, .tv_usec = 0};
-  (void)::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-  (void)::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-  int one = 1;
-  (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
-
-  // Read HTTP request
-  char reqbuf[4096];
-  ssize_t nr = ::recv(fd, reqbuf, sizeof(reqbuf) - 1, 0);
-  if (nr <= 0) return;
-  reqbuf[nr] = '\0';
-
-  // Find end of request line
-  std::string_view req(reqbuf, static_cast<size_t>(nr));
-  auto line_end = req.find('\r');
-  if (line_end == std::string_view::npos) line_end = req.find('\n');
-  std::string_view request_line = req.substr(0, line_end);
-
-  // Route
-  std::string headers;
-  std::string body;
-
-  if (request_line.contains("GET /metrics")) {
-    // Serve Prometheus metrics
-    MetricsSnapshot ms = read_metrics_snapshot(buffers_);
-    body = snapshot_to_prometheus(ms);
-    if (trace_) {
-      auto ts = read_trace_snapshot(*trace_);
-      body += trace_to_prometheus(ts);
-    }
-
-    headers = "HTTP/1.1 200 OK\r\n"
-              "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
-              "Connection: close\r\n"
-              "Content-Length: ";
-    char len_buf[16];
-    auto [ptr, ec] = std::to_chars(len_buf, len_buf + sizeof(len_buf), body.size());
-    headers.append(len_buf, ptr);
-    headers += "\r\n\r\n";
-  } else if (request_line.starts_with("GET / ") || request_line == "GET /") {
-    body = "montauk: use /metrics\n";
-    headers = "HTTP/1.1 200 OK\r\n"
-              "Content-Type: text/plain\r\n"
-              "Connection: close\r\n"
-              "Content-Length: ";
-    char len_buf[16];
-    auto [ptr, ec] = std::to_chars(len_buf, len_buf + sizeof(len_buf), body.size());
-    headers.append(len_buf, ptr);
-    headers += "\r\n\r\n";
-  } else {
-    body = "404 Not Found\n";
-    headers = "HTTP/1.1 404 Not Found\r\n"
-              "Content-Type: text/plain\r\n"
-              "Connection: close\r\n"
-              "Content-Length: 14\r\n\r\n";
-  }
-
-  // Send response via scatter-gather (headers + body, no concatenation)
-  struct iovec iov[2] = {
-    {.iov_base = headers.data(), .iov_len = headers.size()},
-    {.iov_base = body.data(), .iov_len = body.size()}
-  };
-  struct msghdr msg{};
-  msg.msg_iov = iov;
-  msg.msg_iovlen = 2;
-  (void)::sendmsg(fd, &msg, MSG_NOSIGNAL);
-}
-
 } // namespace montauk::app
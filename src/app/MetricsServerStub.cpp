@@ -4,7 +4,7 @@ namespace montauk::app {
 
 MetricsServer::MetricsServer(const SnapshotBuffers& buffers, uint16_t port,
                              const TraceBuffers* trace)
-    : buffers_(buffers), trace_(trace), port_(port) {}
+    : buffers_(buffers), trace_(trace), cache_(buffers, trace), port_(port) {}
 
 MetricsServer::~MetricsServer() = default;
 
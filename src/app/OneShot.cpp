@@ -0,0 +1,84 @@
+#include "app/OneShot.hpp"
+#include "app/AnomalyEnrichment.hpp"
+#include "app/Producer.hpp"
+#include "collectors/CgroupCollector.hpp"
+#include "collectors/CpuCollector.hpp"
+#include "collectors/DiskCollector.hpp"
+#include "collectors/FsCollector.hpp"
+#include "collectors/MemoryCollector.hpp"
+#include "collectors/NetCollector.hpp"
+#include "collectors/ProcIoPssSampler.hpp"
+#include "collectors/ProcessCollector.hpp"
+#include "collectors/PsiCollector.hpp"
+#include "collectors/ThermalCollector.hpp"
+#include "ui/Config.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+
+using namespace std::chrono;
+
+namespace montauk::app {
+
+OneShotStats sample_one_shot(montauk::model::Snapshot& out, milliseconds window) {
+  const auto t_start = steady_clock::now();
+  const auto& pcfg = montauk::ui::config().process;
+  const size_t max_procs = static_cast<size_t>(std::clamp(pcfg.max_procs, 32, 4096));
+  const size_t enrich_top = static_cast<size_t>(std::clamp(pcfg.enrich_top_n, 0, static_cast<int>(max_procs)));
+  const size_t scan_threads = pcfg.scan_threads > 0 ? static_cast<size_t>(pcfg.scan_threads) : 0;
+  // Two passes and exit: an fd cache would only ever be filled.
+  montauk::collectors::ProcessCollector procs(0, max_procs, enrich_top, scan_threads, 0,
+                                              montauk::collectors::CpuClock::Schedstat);
+  montauk::collectors::CpuCollector cpu;
+  montauk::collectors::NetCollector net;
+  montauk::collectors::DiskCollector disk;
+  montauk::collectors::ThermalCollector thermal;
+  montauk::collectors::CgroupCollector cgroups;
+  // The second pass's I/O rates span the window; PSS is read on the first.
+  montauk::collectors::ProcIoPssSampler io_pss(static_cast<size_t>(std::clamp(pcfg.io_top_k, 0, 4096)),
+                                               microseconds(std::max(pcfg.io_budget_us, 0)));
+  std::unordered_map<int32_t, uint64_t> prev_faults, prev_ctxsw;
+
+  // First pass: the rate baselines. Return values ignored as in the Producer.
+  out.collector_name = procs.name();
+  (void)cpu.sample(out.cpu);
+  (void)net.sample(out.net);
+  (void)disk.sample(out.disk);
+  (void)thermal.sample(out.thermal);
+  (void)cgroups.sample(out.cgroups);
+  const auto t0 = steady_clock::now();
+  (void)procs.sample(out.procs);
+  io_pss.sample(out.procs);
+  montauk::app::enrich_anomalies(out.procs, prev_faults, prev_ctxsw);  // seeds the fault/ctxsw deltas
+
+  OneShotStats st;
+  st.schedstat = procs.cpu_clock() == montauk::collectors::CpuClock::Schedstat;
+  if (!st.schedstat) window = std::max(window, Producer::kProcessInterval);
+
+  // Inside the window: the point-in-time collectors.
+  (void)montauk::collectors::MemoryCollector{}.sample(out.mem);
+  (void)montauk::collectors::FsCollector{}.sample(out.fs);
+  (void)montauk::collectors::PsiCollector{}.sample(out.psi);
+  std::this_thread::sleep_until(t0 + window);
+
+  // Second pass: every delta now spans the measured window.
+  (void)cpu.sample(out.cpu);
+  (void)net.sample(out.net);
+  (void)disk.sample(out.disk);
+  (void)thermal.sample(out.thermal);
+  (void)cgroups.sample(out.cgroups);
+  const auto t1 = steady_clock::now();
+  if (procs.sample(out.procs)) {
+    out.procs.sample_us = static_cast<uint64_t>(
+        duration_cast<microseconds>(steady_clock::now() - t1).count());
+  }
+  io_pss.sample(out.procs);
+  montauk::app::enrich_anomalies(out.procs, prev_faults, prev_ctxsw);
+
+  st.window = duration_cast<microseconds>(t1 - t0);
+  st.total = duration_cast<microseconds>(steady_clock::now() - t_start);
+  return st;
+}
+
+} // namespace montauk::app
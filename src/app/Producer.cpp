@@ -2,6 +2,8 @@
 #include "util/Log.hpp"
 #include "app/ChartHistories.hpp"
 #include "app/AnomalyEnrichment.hpp"
+#include <algorithm>
+#include <sys/resource.h>
 #include <unistd.h>
 #include <cstdio>
 #include <cstring>
@@ -9,11 +11,18 @@
 #include "app/GpuAttributor.hpp"
 #include "ui/Config.hpp"
 #include "util/Churn.hpp"
+#include "util/DeadlineScheduler.hpp"
 #include "collectors/ProcessCollector.hpp"
 #include "collectors/NetlinkProcessCollector.hpp"
+#ifdef MONTAUK_HAVE_URING
+#include "collectors/UringProcessCollector.hpp"
+#endif
 #ifdef MONTAUK_HAVE_KERNEL
 #include "collectors/KernelProcessCollector.hpp"
 #endif
+#ifdef MONTAUK_HAVE_BPF
+#include "collectors/BpfIterProcessCollector.hpp"
+#endif
 
 using namespace std::chrono;
 
@@ -45,9 +54,26 @@ double cpu_changepoint(const montauk::model::Snapshot& s) {
   const double div = fast - slow;
   return div < 0.0 ? -div : div;
 }
+
+// [psi] cgroups: "a.slice, b.slice/c.service" -> {"a.slice", "b.slice/c.service"}.
+std::vector<std::string> psi_cgroups() {
+  std::vector<std::string> out;
+  const std::string& list = montauk::ui::config().psi.cgroups;
+  size_t at = 0;
+  while (at <= list.size()) {
+    size_t comma = list.find(',', at);
+    if (comma == std::string::npos) comma = list.size();
+    std::string item = list.substr(at, comma - at);
+    item.erase(0, item.find_first_not_of(" \t"));
+    item.erase(item.find_last_not_of(" \t") + 1);
+    if (!item.empty()) out.push_back(std::move(item));
+    at = comma + 1;
+  }
+  return out;
+}
 }  // namespace
 
-Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers) {
+Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers), psi_(psi_cgroups()) {
   const auto& pcfg = montauk::ui::config().process;
   int max_procs = pcfg.max_procs;
   if (max_procs < 32) max_procs = 32;
@@ -55,14 +81,55 @@ Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers) {
   int enrich_top = pcfg.enrich_top_n;
   if (enrich_top < 0) enrich_top = 0;
   if (enrich_top > max_procs) enrich_top = max_procs;
+  const size_t scan_threads = pcfg.scan_threads > 0 ? static_cast<size_t>(pcfg.scan_threads) : 0;
+  // Hot-pid fd cache: three fds per enriched process by default, never more
+  // than a quarter of the soft RLIMIT_NOFILE so sockets, PMU and the rest of
+  // montauk keep their headroom.
+  size_t fd_cache = pcfg.fd_cache >= 0 ? static_cast<size_t>(pcfg.fd_cache)
+                                       : static_cast<size_t>(enrich_top) * 3;
+  {
+    struct rlimit rl{};
+    if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+      fd_cache = std::min<size_t>(fd_cache, static_cast<size_t>(rl.rlim_cur / 4));
+  }
+  using montauk::collectors::CpuClock;
+  CpuClock clock = CpuClock::Ticks;
+  if (pcfg.cpu_accounting == "schedstat") clock = CpuClock::Schedstat;
+  else if (pcfg.cpu_accounting != "ticks")
+    montauk::util::log_warn("unknown [process] cpu_accounting \"%s\"; using \"ticks\"", pcfg.cpu_accounting.c_str());
+  proc_interval_ = clock == CpuClock::Schedstat ? kSchedstatInterval : kProcessInterval;
+  if (pcfg.interval_ms > 0) {
+    proc_interval_ = std::clamp(milliseconds(pcfg.interval_ms), kMinProcessInterval, milliseconds(10000));
+    if (clock == CpuClock::Ticks && proc_interval_ < kProcessInterval)
+      montauk::util::log_warn("[process] interval_ms %lld with tick accounting: per-process CPU "
+                              "will be quantized; set cpu_accounting = \"schedstat\"",
+                              static_cast<long long>(proc_interval_.count()));
+  }
+  if (pcfg.io_budget_us > 0)
+    io_pss_ = std::make_unique<montauk::collectors::ProcIoPssSampler>(
+        static_cast<size_t>(std::clamp(pcfg.io_top_k, 0, max_procs)),
+        microseconds(std::min(pcfg.io_budget_us, 100000)));
   const auto& collector = pcfg.collector;
   auto make_traditional = [&](){
-    // Default to ~100ms min interval to allow quick warm-up; steady cadence remains ~1s
-    return std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::ProcessCollector(100, (size_t)max_procs, (size_t)enrich_top));
+    // Default to ~100ms min interval to allow quick warm-up; steady cadence is proc_interval_
+    return std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::ProcessCollector(100, (size_t)max_procs, (size_t)enrich_top, scan_threads, fd_cache, clock));
   };
 
   if (collector == "traditional" || collector == "procfs") {
     proc_ = make_traditional();
+  } else if (collector == "uring") {
+#ifdef MONTAUK_HAVE_URING
+    auto up = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::UringProcessCollector(100, (size_t)max_procs, (size_t)enrich_top, scan_threads, fd_cache, clock));
+    if (up->init()) {
+      proc_ = std::move(up);
+    } else {
+      montauk::util::log_error("io_uring collector unavailable. Falling back to traditional.");
+      proc_ = make_traditional();
+    }
+#else
+    montauk::util::log_error("io_uring collector not built (no liburing headers). Falling back to traditional.");
+    proc_ = make_traditional();
+#endif
 #ifdef MONTAUK_HAVE_KERNEL
   } else if (collector == "kernel") {
     auto kpc = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::KernelProcessCollector());
@@ -70,7 +137,7 @@ Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers) {
       proc_ = std::move(kpc);
     } else {
       montauk::util::log_error("Kernel module unavailable. Falling back to netlink.");
-      auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top));
+      auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top, scan_threads, fd_cache, clock));
       if (netlink->init()) {
         proc_ = std::move(netlink);
       } else {
@@ -78,8 +145,27 @@ Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers) {
       }
     }
 #endif
+  } else if (collector == "bpf") {
+#ifdef MONTAUK_HAVE_BPF
+    auto bpf = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::BpfIterProcessCollector((size_t)max_procs, (size_t)enrich_top));
+    if (bpf->init()) {
+      proc_ = std::move(bpf);
+    } else {
+      montauk::util::log_error("BPF process collector unavailable (need CAP_BPF?). Falling back to netlink.");
+    }
+#else
+    montauk::util::log_error("BPF process collector not built (no libbpf/bpftool/clang). Falling back to netlink.");
+#endif
+    if (!proc_) {
+      auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top, scan_threads, fd_cache, clock));
+      if (netlink->init()) {
+        proc_ = std::move(netlink);
+      } else {
+        proc_ = make_traditional();
+      }
+    }
   } else if (collector == "netlink") {
-    auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top));
+    auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top, scan_threads, fd_cache, clock));
     if (!netlink->init()) {
       montauk::util::log_error("Netlink collector unavailable (need CAP_NET_ADMIN?). Falling back to traditional.");
       proc_ = make_traditional();
@@ -95,7 +181,7 @@ Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers) {
     } else
 #endif
     {
-      auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top));
+      auto netlink = std::unique_ptr<montauk::collectors::IProcessCollector>(new montauk::collectors::NetlinkProcessCollector((size_t)max_procs, (size_t)enrich_top, scan_threads, fd_cache, clock));
       if (netlink->init()) {
         proc_ = std::move(netlink);
       } else {
@@ -103,10 +189,23 @@ Producer::Producer(SnapshotBuffers& buffers) : buffers_(buffers) {
       }
     }
   }
+  // The kernel takes trigger windows of 0.5-10 s and a stall shorter than
+  // the window.
+  const auto& psicfg = montauk::ui::config().psi;
+  if (psicfg.stall_ms > 0) {
+    const int window_ms = std::clamp(psicfg.window_ms, 500, 10000);
+    const int stall_ms = std::clamp(psicfg.stall_ms, 1, window_ms - 1);
+    (void)psi_.arm(milliseconds(stall_ms), milliseconds(window_ms));
+  }
 }
 
 void Producer::start() {
   if (thread_.joinable()) return;
+  gpu_worker_.start();
+  fs_worker_.start();
+  cgroup_worker_.start();
+  prov_worker_.start();
+  therm_worker_.start();
   thread_ = std::jthread([this](std::stop_token st){ run(st); });
 }
 
@@ -114,6 +213,11 @@ void Producer::stop() {
   if (!thread_.joinable()) return;
   thread_.request_stop();
   thread_.join();
+  gpu_worker_.stop();
+  fs_worker_.stop();
+  cgroup_worker_.stop();
+  prov_worker_.stop();
+  therm_worker_.stop();
 }
 
 Producer::~Producer() { stop(); }
@@ -122,6 +226,20 @@ Producer::~Producer() { stop(); }
 // explicitly is attached whether or not it appears in the process snapshot
 // (the collector's top-K cap is a display concern, not a measurement one); a
 // comm substring matches against the same cmd string the TUI shows.
+void Producer::sample_procs(montauk::model::ProcessSnapshot& procs) {
+  if (!proc_) return;
+  auto t0 = steady_clock::now();
+  // Return value intentionally ignored (see run()); sample_us is only
+  // stamped when the pass actually refreshed the snapshot.
+  if (proc_->sample(procs)) {
+    procs.sample_us = static_cast<uint64_t>(
+        duration_cast<microseconds>(steady_clock::now() - t0).count());
+    if (io_pss_) io_pss_->sample(procs);
+  }
+  last_proc_sample_ = steady_clock::now();
+  process_samples_.fetch_add(1, std::memory_order_release);
+}
+
 void Producer::refresh_pmu_targets(const montauk::model::ProcessSnapshot& procs) {
   std::vector<std::pair<int, std::string>> targets;
   for (int pid : pmu_pids_) targets.emplace_back(pid, std::string());
@@ -132,12 +250,14 @@ void Producer::refresh_pmu_targets(const montauk::model::ProcessSnapshot& procs)
     // operator never asked about. --trace excludes its own chain for the same
     // reason.
     const int self = static_cast<int>(::getpid());
-    for (const auto& p : procs.processes) {
-      if (p.pid == self) continue;
-      if (p.cmd.find(pmu_comm_) == std::string::npos) continue;
+    for (size_t i = 0; i < procs.size(); ++i) {
+      const int pid = procs.pid[i];
+      if (pid == self) continue;
+      const std::string_view cmd = procs.cmd_of(i);
+      if (cmd.find(pmu_comm_) == std::string_view::npos) continue;
       bool dup = false;
-      for (const auto& t : targets) if (t.first == p.pid) { dup = true; break; }
-      if (!dup) targets.emplace_back(p.pid, p.cmd);
+      for (const auto& t : targets) if (t.first == pid) { dup = true; break; }
+      if (!dup) targets.emplace_back(pid, std::string(cmd));
     }
   }
   pmu_.set_process_targets(targets);
@@ -154,33 +274,18 @@ void Producer::run(std::stop_token st) {
   }();
 
   // per-collector cadence
-  auto next_cpu = steady_clock::now();
-  auto next_pmu = steady_clock::now();
-  auto next_mem = steady_clock::now();
-  auto next_gpu = steady_clock::now();
-  auto next_net = steady_clock::now();
-  auto next_disk = steady_clock::now();
-  auto next_fs = steady_clock::now();
-  auto next_proc = steady_clock::now();
-  auto next_therm = steady_clock::now();
-  auto next_prov = steady_clock::now();
   const auto cpu_interval = 500ms;
   const auto pmu_interval = 500ms;
   const auto mem_interval = 500ms;
-  const auto gpu_interval = 1000ms;
   const auto net_interval = 1000ms;
   const auto disk_interval = 1000ms;
-  const auto fs_interval = 5000ms;
-  const auto proc_interval = Producer::kProcessInterval;
-  const auto therm_interval = 2000ms;
-  // Provider scrapes hit unix sockets with a bounded timeout; keep them off
-  // the fast path
-  const auto prov_interval = 1000ms;
+  // The kernel only recomputes PSI averages every 2 s; stalls arrive through
+  // the triggers, not this.
+  const auto psi_interval = 1000ms;
+  const auto proc_interval = proc_interval_;
   // Publish cadence to smooth UI updates (stable rhythm independent of collector jitter)
   const auto pub_interval = 250ms;
-  auto next_pub = steady_clock::now() + pub_interval;
   // Throttle heavy NVML per-process sampling to ~1s to keep UI snappy
-  auto next_nvml = steady_clock::now();
   const auto nvml_interval = 1000ms;
   if (!gpu_attr_) gpu_attr_ = std::make_unique<montauk::app::GpuAttributor>();
 
@@ -194,16 +299,13 @@ void Producer::run(std::stop_token st) {
     (void)cpu_.sample(s.cpu);
     if (pmu_enabled_) (void)pmu_.sample(s.pmu);
     (void)mem_.sample(s.mem);
-    (void)gpu_.sample(s.vram);
     (void)net_.sample(s.net);
     (void)disk_.sample(s.disk);
-    (void)fs_.sample(s.fs);
-    (void)providers_.sample(s.providers);
-    if (proc_) { (void)proc_->sample(s.procs); process_samples_.fetch_add(1, std::memory_order_release); }
+    (void)psi_.sample(s.psi);
+    sample_procs(s.procs);
     // Attach before the first PMU read so the warm-up interval is already
     // attributed rather than discarded.
     if (pmu_proc_enabled_) { refresh_pmu_targets(s.procs); (void)pmu_.sample(s.pmu); }
-    (void)thermal_.sample(s.thermal);
 
     // Time budget for warm-up (~180ms max)
     auto warm_start = steady_clock::now();
@@ -216,7 +318,7 @@ void Producer::run(std::stop_token st) {
       auto nap = milliseconds(std::min<int>(tick_ms, static_cast<int>(rem.count())));
       if (nap.count() > 0) std::this_thread::sleep_for(nap);
       (void)cpu_.sample(s.cpu);
-      if (proc_) { (void)proc_->sample(s.procs); process_samples_.fetch_add(1, std::memory_order_release); }
+      sample_procs(s.procs);
     }
 
     // Net + Disk: short spaced reads for non-zero bps/util
@@ -229,11 +331,23 @@ void Producer::run(std::stop_token st) {
       (void)disk_.sample(s.disk);
     }
 
-    // Re-sample memory/thermal/gpu once (non-rate or slow-changing)
+    // Re-sample memory once (non-rate)
     (void)mem_.sample(s.mem);
-    (void)thermal_.sample(s.thermal);
-    (void)gpu_.sample(s.vram);
-    
+
+    // The workers started with the Producer; give them what is left of the
+    // budget to land a first sample (a second for the rate-based ones), and
+    // publish without any that are still stuck.
+    (void)gpu_worker_.wait_samples(2, warm_deadline);
+    (void)therm_worker_.wait_samples(2, warm_deadline);
+    (void)fs_worker_.wait_samples(1, warm_deadline);
+    (void)cgroup_worker_.wait_samples(2, warm_deadline);
+    (void)prov_worker_.wait_samples(1, warm_deadline);
+    (void)gpu_worker_.merge_into(s.vram);
+    (void)therm_worker_.merge_into(s.thermal);
+    (void)fs_worker_.merge_into(s.fs);
+    (void)cgroup_worker_.merge_into(s.cgroups);
+    (void)prov_worker_.merge_into(s.providers);
+
     // Enrich GPU attribution once at startup for stable NVML display
     if (gpu_attr_) gpu_attr_->enrich(s);
 
@@ -250,31 +364,65 @@ void Producer::run(std::stop_token st) {
   }
 
   // Main collection loop. Sample return values intentionally ignored for resilience.
-  while (!st.stop_requested()) {
-    auto now = steady_clock::now();
-    bool ran = false;
-    auto& s = buffers_.begin_write();
-    if (now >= next_cpu) { (void)cpu_.sample(s.cpu); next_cpu = now + cpu_interval; ran = true; }
-    if (now >= next_pmu) {
+  // Every cadence is a DeadlineScheduler timer, so the thread sleeps until
+  // exactly the next one is due (timers sharing a phase share the wakeup) or
+  // until a slow collector's worker reports a fresh sample.
+  auto& s = buffers_.begin_write();
+  bool ran = false, time_to_publish = false, nvml_ran = false;
+  montauk::util::DeadlineScheduler sched;
+  const auto loop_start = steady_clock::now();
+  sched.every(cpu_interval, [&] { (void)cpu_.sample(s.cpu); ran = true; }, loop_start);
+  if (pmu_enabled_ || pmu_proc_enabled_) {
+    sched.every(pmu_interval, [&] {
       // Re-resolve the per-process selection before every read, so a workload
       // that starts (or restarts) mid-run is picked up rather than needing
       // montauk to have been launched after it.
       if (pmu_proc_enabled_) refresh_pmu_targets(s.procs);
-      if (pmu_enabled_ || pmu_proc_enabled_) { (void)pmu_.sample(s.pmu); ran = true; }
-      next_pmu = now + pmu_interval;
+      (void)pmu_.sample(s.pmu);
+      ran = true;
+    }, loop_start);
+  }
+  sched.every(mem_interval, [&] { (void)mem_.sample(s.mem); ran = true; }, loop_start);
+  sched.every(net_interval, [&] { (void)net_.sample(s.net); ran = true; }, loop_start);
+  sched.every(disk_interval, [&] { (void)disk_.sample(s.disk); ran = true; }, loop_start);
+  sched.every(proc_interval, [&] { sample_procs(s.procs); ran = true; }, loop_start);
+  sched.every(psi_interval, [&] { (void)psi_.sample(s.psi); ran = true; }, loop_start);
+  sched.every(pub_interval, [&] { time_to_publish = true; }, loop_start + pub_interval);
+  sched.every(nvml_interval, [&] { nvml_ran = true; }, loop_start);
+  // Slow collectors sample on their own threads; take whatever is newest as
+  // soon as it lands.
+  (void)sched.watch(gpu_worker_.ready_fd(), [&] { if (gpu_worker_.merge_into(s.vram)) ran = true; });
+  (void)sched.watch(fs_worker_.ready_fd(), [&] { if (fs_worker_.merge_into(s.fs)) ran = true; });
+  (void)sched.watch(cgroup_worker_.ready_fd(), [&] { if (cgroup_worker_.merge_into(s.cgroups)) ran = true; });
+  (void)sched.watch(therm_worker_.ready_fd(), [&] { if (therm_worker_.merge_into(s.thermal)) ran = true; });
+  (void)sched.watch(prov_worker_.ready_fd(), [&] { if (prov_worker_.merge_into(s.providers)) ran = true; });
+  // A PSI trigger firing is the one event worth breaking cadence for: re-read
+  // pressure, take an extra process sample (unless the last one is under
+  // kMinProcessInterval old) so the frame shows what was running into the
+  // stall, and publish now rather than on the next tick.
+  // Runs once per counted fire: each trigger fd sits in the scheduler's own
+  // epoll set (see PsiCollector::watch).
+  auto on_psi_stall = [&] {
+    psi_wakes_.fetch_add(1, std::memory_order_relaxed);
+    (void)psi_.sample(s.psi);
+    if (steady_clock::now() - last_proc_sample_ >= kMinProcessInterval) sample_procs(s.procs);
+    ran = time_to_publish = true;
+  };
+  if (psi_.armed() > 0) (void)psi_.watch(sched, on_psi_stall);
+  std::stop_callback wake_on_stop(st, [&] { sched.wake(); });
+
+  while (!st.stop_requested()) {
+    (void)sched.run_once();
+    wakeups_.store(sched.wakeups(), std::memory_order_relaxed);
+    if (st.stop_requested()) break;
+    if (!sched.ok()) {  // no epoll: nothing reports readiness, so poll the slots
+      if (gpu_worker_.merge_into(s.vram)) ran = true;
+      if (fs_worker_.merge_into(s.fs)) ran = true;
+      if (cgroup_worker_.merge_into(s.cgroups)) ran = true;
+      if (therm_worker_.merge_into(s.thermal)) ran = true;
+      if (prov_worker_.merge_into(s.providers)) ran = true;
+      if (psi_.drain_fires() > 0) on_psi_stall();
     }
-    if (now >= next_mem) { (void)mem_.sample(s.mem); next_mem = now + mem_interval; ran = true; }
-    if (now >= next_gpu) { (void)gpu_.sample(s.vram); next_gpu = now + gpu_interval; ran = true; }
-    if (now >= next_net) { (void)net_.sample(s.net); next_net = now + net_interval; ran = true; }
-    if (now >= next_disk){ (void)disk_.sample(s.disk); next_disk = now + disk_interval; ran = true; }
-    if (now >= next_fs)  { (void)fs_.sample(s.fs);     next_fs  = now + fs_interval; ran = true; }
-    if (now >= next_proc){ if (proc_) { (void)proc_->sample(s.procs); process_samples_.fetch_add(1, std::memory_order_release); } next_proc = now + proc_interval; ran = true; }
-    if (now >= next_therm){ (void)thermal_.sample(s.thermal); next_therm = now + therm_interval; ran = true; }
-    if (now >= next_prov){ (void)providers_.sample(s.providers); next_prov = now + prov_interval; ran = true; }
-    bool time_to_publish = false;
-    if (now >= next_pub) { time_to_publish = true; next_pub = now + pub_interval; }
-    bool nvml_ran = false;
-    if (now >= next_nvml) nvml_ran = true;
     if (ran || time_to_publish || nvml_ran) {
       if (proc_) { s.collector_name = proc_->name(); }
       {
@@ -290,23 +438,13 @@ void Producer::run(std::stop_token st) {
       if (nvml_ran) {
         // Attribute per-process GPU% across NVML/fdinfo backends
         gpu_attr_->enrich(s);
-        next_nvml = now + nvml_interval;
       }
       montauk::app::enrich_anomalies(s.procs, anomaly_prev_faults_, anomaly_prev_ctxsw_);
       s.cpu.changepoint_score = cpu_changepoint(s);  // before push: reads prior frames
       chart_histories().push_snapshot(s);
       buffers_.publish();
+      ran = time_to_publish = nvml_ran = false;
     }
-    // sleep until the earliest next_due or next_pub, bounded
-    auto next_due = std::min({next_cpu, next_pmu, next_mem, next_gpu, next_net, next_disk, next_proc, next_therm, next_prov, next_pub});
-    auto sleep_for = duration_cast<milliseconds>(next_due - steady_clock::now());
-    if (sleep_for < 20ms) {
-      sleep_for = 20ms;
-    }
-    if (sleep_for > 100ms) {
-      sleep_for = 100ms;
-    }
-    std::this_thread::sleep_for(sleep_for);
   }
   // gpu_attr_ cleanup handled by unique_ptr destructor
 }
@@ -9,14 +9,15 @@
 
 namespace montauk::app {
 
-std::string snapshot_to_prometheus(const MetricsSnapshot& s) {
-  PrometheusSink sink;
-  render_snapshot(sink, s);
+std::string snapshot_to_prometheus(const MetricsSnapshot& s, const MetricsSelection& sel) {
+  PrometheusSink sink(sel.filters_families() ? &sel : nullptr);
+  render_snapshot(sink, s, sel);
   return sink.finish();
 }
 
-std::string trace_to_prometheus(const montauk::model::TraceSnapshot& t) {
-  PrometheusSink sink;
+std::string trace_to_prometheus(const montauk::model::TraceSnapshot& t, const MetricsSelection& sel) {
+  if (!sel.wants(MetricsSection::Trace)) return {};
+  PrometheusSink sink(sel.filters_families() ? &sel : nullptr);
   render_trace(sink, t);
   return sink.finish();
 }
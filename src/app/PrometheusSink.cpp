@@ -85,6 +85,15 @@ PrometheusSink::Family& PrometheusSink::family_for(const MetricDesc& d) {
   return pending_.back();
 }
 
+bool PrometheusSink::drops(const char* prom_name) {
+  if (!filter_) return false;
+  if (prom_name != last_name_) {
+    last_name_ = prom_name;
+    last_drop_ = !filter_->wants_family(prom_name);
+  }
+  return last_drop_;
+}
+
 void PrometheusSink::flush_families() {
   for (auto& f : pending_) {
     emit_header(out_, f.name, f.help, f.kind == MetricKind::Counter ? "counter" : "gauge");
@@ -94,19 +103,19 @@ void PrometheusSink::flush_families() {
 }
 
 void PrometheusSink::f64(const MetricDesc& d, double v) {
-  if (!d.prom_name) return;
+  if (!d.prom_name || drops(d.prom_name)) return;
   emit_header(out_, d.prom_name, d.help, d.kind == MetricKind::Counter ? "counter" : "gauge");
   out_ += d.prom_name; out_ += ' '; append_double(out_, v); out_ += '\n';
 }
 
 void PrometheusSink::u64(const MetricDesc& d, uint64_t v) {
-  if (!d.prom_name) return;
+  if (!d.prom_name || drops(d.prom_name)) return;
   emit_header(out_, d.prom_name, d.help, d.kind == MetricKind::Counter ? "counter" : "gauge");
   out_ += d.prom_name; out_ += ' '; append_uint(out_, v); out_ += '\n';
 }
 
 void PrometheusSink::i64(const MetricDesc& d, int64_t v) {
-  if (!d.prom_name) return;
+  if (!d.prom_name || drops(d.prom_name)) return;
   emit_header(out_, d.prom_name, d.help, d.kind == MetricKind::Counter ? "counter" : "gauge");
   out_ += d.prom_name; out_ += ' '; append_int(out_, v); out_ += '\n';
 }
@@ -122,7 +131,7 @@ void PrometheusSink::str(const MetricDesc&, std::string_view) {
 }
 
 void PrometheusSink::labeled_f64(const MetricDesc& d, std::span<const Label> labels, double v) {
-  if (!d.prom_name) return;
+  if (!d.prom_name || drops(d.prom_name)) return;
   std::string line = labeled_line(d.prom_name, labels);
   append_double(line, v);
   line += '\n';
@@ -131,7 +140,7 @@ void PrometheusSink::labeled_f64(const MetricDesc& d, std::span<const Label> lab
 }
 
 void PrometheusSink::labeled_u64(const MetricDesc& d, std::span<const Label> labels, uint64_t v) {
-  if (!d.prom_name) return;
+  if (!d.prom_name || drops(d.prom_name)) return;
   std::string line = labeled_line(d.prom_name, labels);
   append_uint(line, v);
   line += '\n';
@@ -140,7 +149,7 @@ void PrometheusSink::labeled_u64(const MetricDesc& d, std::span<const Label> lab
 }
 
 void PrometheusSink::labeled_i64(const MetricDesc& d, std::span<const Label> labels, int64_t v) {
-  if (!d.prom_name) return;
+  if (!d.prom_name || drops(d.prom_name)) return;
   std::string line = labeled_line(d.prom_name, labels);
   append_int(line, v);
   line += '\n';
@@ -155,14 +164,38 @@ void PrometheusSink::info_line(const char* prom_name, const char* help, std::spa
   // exception (space-replacement, not backslash-escaping); that's handled
   // by pre-sanitizing its label values at the render_system() call site,
   // not here, so this stays the single shared escaping behavior.
+  if (drops(prom_name)) return;
   emit_header(out_, prom_name, help, "gauge");
   out_ += labeled_line(prom_name, labels);
   out_ += "1\n";
 }
 
 void PrometheusSink::provider(const montauk::model::Provider& p) {
-  out_ += p.raw_text;
-  if (!p.raw_text.empty() && p.raw_text.back() != '\n') out_ += '\n';
+  if (!filter_) {
+    out_ += p.raw_text;
+    if (!p.raw_text.empty() && p.raw_text.back() != '\n') out_ += '\n';
+    return;
+  }
+  // "# HELP name ...", "# TYPE name ..." and "name{...} value" all belong to
+  // `name`, as do a histogram's or summary's _bucket/_sum/_count samples;
+  // any other comment belongs to no family and is dropped.
+  std::string_view text = p.raw_text;
+  while (!text.empty()) {
+    const size_t nl = text.find('\n');
+    const std::string_view line = text.substr(0, nl);
+    text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+    std::string_view name = line;
+    if (name.starts_with("# HELP ") || name.starts_with("# TYPE ")) name.remove_prefix(7);
+    else if (name.starts_with('#')) continue;
+    name = name.substr(0, name.find_first_of("{ \t"));
+    if (name.empty()) continue;
+    bool keep = filter_->wants_family(name);
+    for (std::string_view suffix : {"_bucket", "_sum", "_count"})
+      if (!keep && name.ends_with(suffix)) keep = filter_->wants_family(name.substr(0, name.size() - suffix.size()));
+    if (!keep) continue;
+    out_ += line;
+    out_ += '\n';
+  }
 }
 
 void PrometheusSink::raw_comment(std::string_view text) {
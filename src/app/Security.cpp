@@ -7,6 +7,7 @@
 #include <cmath>
 #include <cstring>
 #include <sstream>
+#include <string_view>
 #include <unordered_set>
 
 namespace montauk::app {
@@ -39,7 +40,7 @@ class LiteralSet {
       sublimation_search_compile(&progs_[i++], l, std::strlen(l),
                                  SUBLIMATION_SEARCH_FIXED | SUBLIMATION_SEARCH_ICASE, 0);
   }
-  [[nodiscard]] bool any(const std::string& hay) const {
+  [[nodiscard]] bool any(std::string_view hay) const {
     return sublimation_search_selects(progs_.data(), static_cast<int>(progs_.size()),
                                       /*regex_face=*/0, hay.data(),
                                       std::min(hay.size(), kScanMax),
@@ -66,10 +67,8 @@ static std::string to_upper_copy(std::string s, size_t max_len = 512) {
   return s;
 }
 
-static std::string strip_deleted_suffix(const std::string& path) {
-  auto pos = path.find(" (deleted)");
-  if (pos != std::string::npos) return path.substr(0, pos);
-  return path;
+static std::string strip_deleted_suffix(std::string_view path) {
+  return std::string(path.substr(0, path.find(" (deleted)")));
 }
 
 static bool has_path_prefix(const std::string& path, const std::string& prefix) {
@@ -101,9 +100,9 @@ std::vector<SecurityFinding> collect_security_findings(const montauk::model::Sna
     "/tmp/", "/var/tmp/", "/dev/shm/", "/run/user/", "/home/"
   };
 
-  auto make_subject = [](const montauk::model::ProcSample& p, const std::string& extra){
+  auto make_subject = [](int32_t pid, std::string_view user, std::string_view extra){
     std::ostringstream os;
-    os << "PID " << p.pid << ' ' << (p.user_name.empty() ? "?" : p.user_name) << ' ' << extra;
+    os << "PID " << pid << ' ' << (user.empty() ? "?" : user) << ' ' << extra;
     return os.str();
   };
 
@@ -113,59 +112,63 @@ std::vector<SecurityFinding> collect_security_findings(const montauk::model::Sna
     }
   };
 
-  for (const auto& p : s.procs.processes) {
-    if (flagged_pids.count(p.pid)) continue;
-    const std::string exe_clean = strip_deleted_suffix(p.exe_path);
-    const bool is_root = (p.user_name == "root");
+  const auto& procs = s.procs;
+  for (size_t i = 0; i < procs.size(); ++i) {
+    const int32_t pid = procs.pid[i];
+    if (flagged_pids.count(pid)) continue;
+    const std::string& user = procs.user_of(i);
+    const std::string& cmd = procs.cmd_of(i);
+    const std::string exe_clean = strip_deleted_suffix(procs.exe_of(i));
+    const bool is_root = (user == "root");
 
     if (is_root && !exe_clean.empty()) {
       for (const auto& pref : writable_prefixes) {
         if (has_path_prefix(exe_clean, pref)) {
           std::string reason = "root exec in " + (pref.back() == '/' ? pref.substr(0, pref.size()-1) : pref);
-          add_finding(2, make_subject(p, exe_clean), reason);
-          flagged_pids.insert(p.pid);
+          add_finding(2, make_subject(pid, user, exe_clean), reason);
+          flagged_pids.insert(pid);
           break;
         }
       }
-      if (flagged_pids.count(p.pid)) continue;
+      if (flagged_pids.count(pid)) continue;
     }
 
-    if (!p.cmd.empty() && p.cmd.front() == '[' && p.cmd.back() == ']' && !exe_clean.empty()) {
-      add_finding(2, make_subject(p, p.cmd), "fake kernel thread");
-      flagged_pids.insert(p.pid);
+    if (!cmd.empty() && cmd.front() == '[' && cmd.back() == ']' && !exe_clean.empty()) {
+      add_finding(2, make_subject(pid, user, cmd), "fake kernel thread");
+      flagged_pids.insert(pid);
       continue;
     }
 
-    if (!flagged_pids.count(p.pid)) {
-      const bool has_curl = kDownloader.any(p.cmd);
-      const bool has_pipe_bash = kPipeToShell.any(p.cmd);
+    if (!flagged_pids.count(pid)) {
+      const bool has_curl = kDownloader.any(cmd);
+      const bool has_pipe_bash = kPipeToShell.any(cmd);
       if (has_curl && has_pipe_bash) {
-        add_finding(1, make_subject(p, p.cmd), "script download");
-        flagged_pids.insert(p.pid);
+        add_finding(1, make_subject(pid, user, cmd), "script download");
+        flagged_pids.insert(pid);
         continue;
       }
     }
 
-    if (!flagged_pids.count(p.pid)) {
+    if (!flagged_pids.count(pid)) {
       // python AND .py AND (in $HOME): three independent conditions, so three
       // sets rather than one -- kHomePath is the only genuine OR of the three.
-      if (kPython.any(p.cmd) && kPyFile.any(p.cmd) && kHomePath.any(p.cmd)) {
-        add_finding(1, make_subject(p, p.cmd), "home script");
-        flagged_pids.insert(p.pid);
+      if (kPython.any(cmd) && kPyFile.any(cmd) && kHomePath.any(cmd)) {
+        add_finding(1, make_subject(pid, user, cmd), "home script");
+        flagged_pids.insert(pid);
         continue;
       }
     }
 
-    if (!flagged_pids.count(p.pid) && !p.cmd.empty()) {
-      std::istringstream iss(p.cmd);
+    if (!flagged_pids.count(pid) && !cmd.empty()) {
+      std::istringstream iss(cmd);
       std::string first;
       if (iss >> first) {
         std::string first_lower = to_lower_copy(first);
-        auto is_shell = [](const std::string& cmd){
-          if (cmd == "sh" || cmd == "/bin/sh" || cmd == "/usr/bin/sh") return true;
-          if (cmd == "bash" || cmd == "/bin/bash" || cmd == "/usr/bin/bash") return true;
-          if (cmd.size() > 3 && cmd.rfind("/sh") == cmd.size() - 3) return true;
-          if (cmd.size() > 5 && cmd.rfind("/bash") == cmd.size() - 5) return true;
+        auto is_shell = [](const std::string& w){
+          if (w == "sh" || w == "/bin/sh" || w == "/usr/bin/sh") return true;
+          if (w == "bash" || w == "/bin/bash" || w == "/usr/bin/bash") return true;
+          if (w.size() > 3 && w.rfind("/sh") == w.size() - 3) return true;
+          if (w.size() > 5 && w.rfind("/bash") == w.size() - 5) return true;
           return false;
         };
         if (is_shell(first_lower)) {
@@ -176,12 +179,12 @@ std::vector<SecurityFinding> collect_security_findings(const montauk::model::Sna
             if (!clean.empty() && (clean.back() == '"' || clean.back() == '\'')) clean.pop_back();
             for (const auto& pref : writable_prefixes) {
               if (has_path_prefix(clean, pref)) {
-                add_finding(2, make_subject(p, p.cmd), "TMP SHELL SCRIPT");
-                flagged_pids.insert(p.pid);
+                add_finding(2, make_subject(pid, user, cmd), "TMP SHELL SCRIPT");
+                flagged_pids.insert(pid);
                 break;
               }
             }
-            if (flagged_pids.count(p.pid)) break;
+            if (flagged_pids.count(pid)) break;
           }
         }
       }
@@ -193,16 +196,19 @@ std::vector<SecurityFinding> collect_security_findings(const montauk::model::Sna
   // Threshold: 3+ churn events in 2s indicates sustained process thrashing, not a one-off.
   static constexpr int CHURN_THRESHOLD = 3;
   if (s.churn.recent_2s_events >= CHURN_THRESHOLD) {
-    for (const auto& p : s.procs.processes) {
+    for (size_t i = 0; i < procs.size(); ++i) {
       // Check if this auth-related process had a read failure during the churn storm
-      if (p.churn_reason == montauk::model::ChurnReason::None) continue;
-      if (kAuthProc.any(p.cmd)) {
+      if (procs.churn_reason[i] == montauk::model::ChurnReason::None) continue;
+      const int32_t pid = procs.pid[i];
+      const std::string& user = procs.user_of(i);
+      const std::string& cmd = procs.cmd_of(i);
+      if (kAuthProc.any(cmd)) {
         std::string reason = "auth crashloop";
         std::ostringstream subj;
-        subj << "PID " << p.pid << ' ' << (p.user_name.empty() ? "?" : p.user_name)
-             << ' ' << p.cmd << " • " << s.churn.recent_2s_events << " events/2s";
+        subj << "PID " << pid << ' ' << (user.empty() ? "?" : user)
+             << ' ' << cmd << " • " << s.churn.recent_2s_events << " events/2s";
         add_finding(2, subj.str(), reason);
-        flagged_pids.insert(p.pid);
+        flagged_pids.insert(pid);
       }
     }
   }
@@ -215,12 +221,11 @@ std::vector<SecurityFinding> collect_security_findings(const montauk::model::Sna
   }
   if (best_iface && best_rate > 500.0 * 1024.0) {
     bool has_owner = false;
-    size_t check = std::min<size_t>(s.procs.processes.size(), 64);
+    size_t check = std::min<size_t>(procs.size(), 64);
     for (size_t i=0; i<check; ++i) {
-      const auto& p = s.procs.processes[i];
-      if (p.churn_reason != montauk::model::ChurnReason::None) continue;
-      if (p.cpu_pct >= 2.0) { has_owner = true; break; }
-      if (kNetOwner.any(p.cmd)) {
+      if (procs.churn_reason[i] != montauk::model::ChurnReason::None) continue;
+      if (procs.cpu_pct[i] >= 2.0) { has_owner = true; break; }
+      if (kNetOwner.any(procs.cmd_of(i))) {
         has_owner = true;
         break;
       }
@@ -0,0 +1,194 @@
+#include "app/ShmExport.hpp"
+#include "util/Log.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace montauk::app {
+
+// The C test asserts the same: both sides of the segment must agree.
+static_assert(sizeof(montauk_shm_header) == 64 && offsetof(montauk_shm_segment, data) == 64);
+
+namespace {
+
+void copy_str(char* dst, size_t cap, const std::string& src) {
+  const size_t n = std::min(src.size(), cap - 1);
+  std::memcpy(dst, src.data(), n);
+  std::memset(dst + n, 0, cap - n);
+}
+
+uint64_t realtime_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+ShmExporter::ShmExporter(const SnapshotBuffers& buffers, std::filesystem::path path)
+    : buffers_(buffers), path_(std::move(path)), staging_(std::make_unique<montauk_shm_data>()) {}
+
+ShmExporter::~ShmExporter() {
+  stop();
+  close();
+}
+
+bool ShmExporter::open() {
+  if (seg_) return true;
+  const int fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0644);
+  if (fd < 0) {
+    montauk::util::log_error("ShmExporter: failed to open %s: %s", path_.c_str(), std::strerror(errno));
+    return false;
+  }
+  // One writer per segment: a second montauk on the same path would interleave
+  // seqlock bumps with ours. The lock dies with the fd, i.e. with the mapping.
+  if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    montauk::util::log_error("ShmExporter: %s is in use by another writer", path_.c_str());
+    ::close(fd);
+    return false;
+  }
+  constexpr size_t kLen = sizeof(montauk_shm_segment);
+  if (::ftruncate(fd, static_cast<off_t>(kLen)) != 0) {
+    montauk::util::log_error("ShmExporter: failed to size %s: %s", path_.c_str(), std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  void* p = ::mmap(nullptr, kLen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    montauk::util::log_error("ShmExporter: failed to map %s: %s", path_.c_str(), std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  lock_fd_ = fd;
+  seg_ = static_cast<montauk_shm_segment*>(p);
+
+  // Reusing a segment a previous run left: keep its seq moving forward (so a
+  // reader mid-copy sees a change) and even (a crash may have left it odd).
+  montauk_shm_header& h = seg_->hdr;
+  __atomic_store_n(&h.magic, 0, __ATOMIC_RELAXED);
+  const uint64_t seq = __atomic_load_n(&h.seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&h.seq, (seq + 1) & ~uint64_t{1}, __ATOMIC_RELAXED);
+  h.version = MONTAUK_SHM_VERSION;
+  h.header_size = sizeof(montauk_shm_header);
+  h.segment_size = kLen;
+  h.writer_pid = static_cast<uint32_t>(::getpid());
+  __atomic_store_n(&h.flags, MONTAUK_SHM_F_LIVE, __ATOMIC_RELAXED);
+  __atomic_store_n(&h.magic, MONTAUK_SHM_MAGIC, __ATOMIC_RELEASE);
+  return true;
+}
+
+void ShmExporter::close() {
+  if (!seg_) return;
+  __atomic_store_n(&seg_->hdr.flags, 0u, __ATOMIC_RELEASE);
+  ::munmap(seg_, sizeof(montauk_shm_segment));
+  seg_ = nullptr;
+  ::close(lock_fd_);
+  lock_fd_ = -1;
+}
+
+void ShmExporter::start() {
+  thread_ = std::jthread([this](std::stop_token st){ run(st); });
+}
+
+void ShmExporter::stop() {
+  if (thread_.joinable()) {
+    thread_.request_stop();
+    thread_.join();
+  }
+}
+
+void ShmExporter::fill(const montauk::model::Snapshot& s, montauk_shm_data& out) {
+  const auto& c = s.cpu;
+  auto& oc = out.cpu;
+  oc.usage_pct = c.usage_pct;
+  oc.pct_user = c.pct_user;
+  oc.pct_system = c.pct_system;
+  oc.pct_iowait = c.pct_iowait;
+  oc.pct_irq = c.pct_irq;
+  oc.pct_steal = c.pct_steal;
+  oc.freq_avg_mhz = c.has_freq ? c.freq_avg_mhz : 0.0;
+  oc.ctxt_per_sec = c.ctxt_per_sec;
+  oc.intr_per_sec = c.intr_per_sec;
+  oc.logical_threads = static_cast<uint32_t>(std::max(c.logical_threads, 0));
+  const size_t ncpus = std::min<size_t>(c.per_core_pct.size(), MONTAUK_SHM_MAX_CPUS);
+  oc.ncpus = static_cast<uint32_t>(ncpus);
+  std::copy_n(c.per_core_pct.begin(), ncpus, oc.per_core_pct);
+  std::fill(oc.per_core_pct + ncpus, oc.per_core_pct + MONTAUK_SHM_MAX_CPUS, 0.0);
+
+  const auto& m = s.mem;
+  out.mem = montauk_shm_mem{m.total_kb, m.used_kb, m.available_kb, m.cached_kb,
+                            m.buffers_kb, m.swap_total_kb, m.swap_used_kb, m.used_pct};
+
+  const auto& ps = s.procs;
+  out.total_processes = ps.total_processes;
+  out.running_processes = ps.state_running;
+  out.sleeping_processes = ps.state_sleeping;
+  out.zombie_processes = ps.state_zombie;
+  out.total_threads = ps.total_threads;
+  const size_t n = std::min<size_t>(ps.size(), MONTAUK_SHM_MAX_PROCS);
+  out.nprocs = static_cast<uint32_t>(n);
+  out.reserved = 0;
+  for (size_t i = 0; i < n; ++i) {
+    montauk_shm_proc& r = out.procs[i];
+    r.pid = ps.pid[i];
+    r.ppid = ps.ppid[i];
+    r.threads = static_cast<uint32_t>(std::max(ps.thread_count[i], 0));
+    r.flags = 0;
+    r.cpu_pct = ps.cpu_pct[i];
+    r.rss_kb = ps.rss_kb[i];
+    r.gpu_util_pct = ps.has_gpu_util[i] ? ps.gpu_util_pct[i] : 0.0;
+    r.gpu_mem_kb = ps.has_gpu_mem[i] ? ps.gpu_mem_kb[i] : 0;
+    if (ps.has_gpu_util[i] || ps.has_gpu_mem[i]) r.flags |= MONTAUK_SHM_PROC_GPU;
+    const bool has_io = ps.io_age_ms[i] != montauk::model::kAgeNever;
+    r.io_read_bps = has_io ? ps.io_read_bps[i] : 0.0;
+    r.io_write_bps = has_io ? ps.io_write_bps[i] : 0.0;
+    if (has_io) r.flags |= MONTAUK_SHM_PROC_IO;
+    const bool has_pss = ps.pss_age_ms[i] != montauk::model::kAgeNever;
+    r.pss_kb = has_pss ? ps.pss_kb[i] : 0;
+    if (has_pss) r.flags |= MONTAUK_SHM_PROC_PSS;
+    r.anomaly_score = ps.anomaly_score[i];
+    r.subtree_cpu_pct = ps.subtree_cpu_pct[i];
+    r.subtree_rss_kb = ps.subtree_rss_kb[i];
+    r.subtree_threads = ps.subtree_threads[i];
+    r.subtree_procs = ps.subtree_procs[i];
+    if (r.subtree_procs != 0) r.flags |= MONTAUK_SHM_PROC_TREE;
+    copy_str(r.user, sizeof(r.user), ps.user_of(i));
+    copy_str(r.cmd, sizeof(r.cmd), ps.cmd_of(i));
+  }
+}
+
+void ShmExporter::publish(const montauk::model::Snapshot& s) {
+  if (!seg_) return;
+  fill(s, *staging_);
+  montauk_shm_header& h = seg_->hdr;
+  montauk_shm_write_begin(&h);
+  std::memcpy(&seg_->data, staging_.get(), montauk_shm_data_bytes(staging_->nprocs));
+  __atomic_store_n(&h.generation, s.seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&h.publish_ns, realtime_ns(), __ATOMIC_RELAXED);
+  montauk_shm_write_end(&h);
+}
+
+void ShmExporter::run(std::stop_token st) {
+  montauk::util::log_info("ShmExporter: publishing to %s (%zu bytes)", path_.c_str(),
+                          sizeof(montauk_shm_segment));
+  // Sleep until the Producer publishes (or stop() wakes us); subscribed
+  // before the first seq() read, so no generation slips between the two.
+  PublishWaiter waiter(buffers_.signal());
+  std::stop_callback on_stop(st, [&waiter] { waiter.wake(); });
+  uint64_t last = 0;
+  while (!st.stop_requested()) {
+    const uint64_t seq = buffers_.seq();
+    if (seq != 0 && seq != last) {
+      const auto gen = buffers_.acquire();
+      publish(*gen);
+      last = gen->seq;
+    }
+    waiter.wait(-1);
+  }
+}
+
+} // namespace montauk::app
@@ -0,0 +1,102 @@
+#include "app/SnapshotClient.hpp"
+#include "util/Log.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace montauk::app {
+
+SnapshotClient::SnapshotClient(SnapshotBuffers& buffers, std::filesystem::path path)
+    : buffers_(buffers), path_(std::move(path)) {}
+
+SnapshotClient::~SnapshotClient() {
+  stop();
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool SnapshotClient::connect() {
+  const std::string p = path_.string();
+  if (p.size() >= sizeof(sockaddr_un::sun_path)) {
+    montauk::util::log_error("SnapshotClient: socket path too long: %s", p.c_str());
+    return false;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return false;
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, p.c_str(), p.size() + 1);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+    montauk::util::log_error("SnapshotClient: no montauk --serve on %s: %s", p.c_str(), std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  fd_ = fd;
+  connected_.store(true, std::memory_order_release);
+  return true;
+}
+
+void SnapshotClient::start() {
+  thread_ = std::jthread([this](std::stop_token st) { run(st); });
+}
+
+void SnapshotClient::stop() {
+  if (thread_.joinable()) {
+    thread_.request_stop();
+    thread_.join();
+  }
+}
+
+void SnapshotClient::run(std::stop_token st) {
+  std::string buf;
+  size_t have = 0;
+  auto hang_up = [&](const char* why) {
+    montauk::util::log_warn("SnapshotClient: %s: %s", path_.c_str(), why);
+    connected_.store(false, std::memory_order_release);
+  };
+  while (!st.stop_requested()) {
+    pollfd pfd{fd_, POLLIN, 0};
+    int r = ::poll(&pfd, 1, 200);  // bounded so stop is observed promptly
+    if (r < 0 && errno != EINTR) return hang_up(std::strerror(errno));
+    if (r <= 0) continue;
+
+    if (buf.size() - have < 64 * 1024) buf.resize(have + 256 * 1024);
+    ssize_t n = ::recv(fd_, buf.data() + have, buf.size() - have, 0);
+    if (n == 0) return hang_up("server closed the stream");
+    if (n < 0) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      return hang_up(std::strerror(errno));
+    }
+    have += static_cast<size_t>(n);
+
+    // Apply every complete frame; a partial one waits for more bytes.
+    size_t off = 0;
+    bool applied = false;
+    while (have - off >= sizeof(uint32_t)) {
+      uint32_t len = 0;
+      std::memcpy(&len, buf.data() + off, sizeof(len));
+      if (len > kFrameMax) return hang_up("oversized frame");
+      if (have - off - sizeof(len) < len) {
+        if (buf.size() < off + sizeof(len) + len) buf.resize(off + sizeof(len) + len);
+        break;
+      }
+      if (!decoder_.apply(std::string_view(buf.data() + off + sizeof(len), len), buffers_.back()))
+        return hang_up("undecodable frame");
+      off += sizeof(len) + len;
+      frames_.fetch_add(1, std::memory_order_relaxed);
+      applied = true;
+    }
+    // A burst of frames publishes once: only the newest is worth a render.
+    if (applied) buffers_.publish();
+    if (off > 0) {
+      std::memmove(buf.data(), buf.data() + off, have - off);
+      have -= off;
+    }
+  }
+}
+
+} // namespace montauk::app
@@ -0,0 +1,377 @@
+#include "app/SnapshotCodec.hpp"
+
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace montauk::app {
+
+using namespace montauk::model;
+
+namespace {
+
+template <typename T>
+inline constexpr bool kScalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+// Writer and reader share one field list per type: each struct below has a
+// single template taking either, so the two sides cannot drift apart.
+class Enc {
+public:
+  explicit Enc(std::string& out) : out_(out) {}
+
+  template <typename... A>
+  void operator()(const A&... a) { (put(a), ...); }
+
+  template <typename T, typename Fn>
+  void vec(const std::vector<T>& v, Fn&& fn) {
+    put(static_cast<uint32_t>(v.size()));
+    for (const auto& e : v) fn(e);
+  }
+
+private:
+  template <typename T> requires kScalar<T>
+  void put(const T& v) { out_.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+  void put(const bool& v) { out_.push_back(v ? 1 : 0); }
+  void put(const std::string& s) {
+    put(static_cast<uint32_t>(s.size()));
+    out_.append(s);
+  }
+  template <size_t N>
+  void put(const char (&s)[N]) { out_.append(s, N); }
+  template <typename T> requires kScalar<T>
+  void put(const std::vector<T>& v) {
+    put(static_cast<uint32_t>(v.size()));
+    out_.append(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+  }
+
+  std::string& out_;
+};
+
+class Dec {
+public:
+  explicit Dec(std::string_view in) : p_(in.data()), end_(in.data() + in.size()) {}
+
+  template <typename... A>
+  void operator()(A&... a) { (get(a), ...); }
+
+  template <typename T, typename Fn>
+  void vec(std::vector<T>& v, Fn&& fn) {
+    uint32_t n = 0;
+    get(n);
+    // Every element takes at least a byte: a count past the bytes left is
+    // corruption, not a reason to allocate.
+    if (!ok_ || n > static_cast<size_t>(end_ - p_)) { ok_ = false; v.clear(); return; }
+    v.resize(n);
+    for (auto& e : v) fn(e);
+  }
+
+  [[nodiscard]] bool ok() const { return ok_; }
+  [[nodiscard]] bool done() const { return ok_ && p_ == end_; }
+  [[nodiscard]] std::string_view take(size_t n) {
+    if (!ok_ || n > static_cast<size_t>(end_ - p_)) { ok_ = false; return {}; }
+    std::string_view s(p_, n);
+    p_ += n;
+    return s;
+  }
+
+  template <typename T> requires kScalar<T>
+  void get(T& v) {
+    if (!ok_ || sizeof(v) > static_cast<size_t>(end_ - p_)) { ok_ = false; v = T{}; return; }
+    std::memcpy(&v, p_, sizeof(v));
+    p_ += sizeof(v);
+  }
+
+private:
+  void get(bool& v) {
+    uint8_t b = 0;
+    get(b);
+    v = b != 0;
+  }
+  void get(std::string& s) {
+    uint32_t n = 0;
+    get(n);
+    s.assign(take(n));
+  }
+  template <size_t N>
+  void get(char (&s)[N]) {
+    auto b = take(N);
+    if (ok_) std::memcpy(s, b.data(), N);
+  }
+  template <typename T> requires kScalar<T>
+  void get(std::vector<T>& v) {
+    uint32_t n = 0;
+    get(n);
+    auto b = take(static_cast<size_t>(n) * sizeof(T));
+    if (!ok_) { v.clear(); return; }
+    v.resize(n);
+    std::memcpy(v.data(), b.data(), b.size());
+  }
+
+  const char* p_;
+  const char* end_;
+  bool ok_{true};
+};
+
+template <typename IO, typename C> void cpu_times(IO& io, C& t) {
+  io(t.user, t.nice, t.system, t.idle, t.iowait, t.irq, t.softirq, t.steal);
+}
+
+template <typename IO, typename C> void cpu(IO& io, C& c) {
+  cpu_times(io, c.total_times);
+  io.vec(c.per_core, [&](auto& t) { cpu_times(io, t); });
+  io(c.usage_pct, c.changepoint_score, c.per_core_pct, c.model, c.physical_cores, c.logical_threads,
+     c.has_freq, c.freq_avg_mhz, c.pct_user, c.pct_system, c.pct_iowait, c.pct_irq, c.pct_steal,
+     c.ctxt_per_sec, c.intr_per_sec);
+}
+
+template <typename IO, typename P> void pmu(IO& io, P& p) {
+  io(p.available, p.l3_available, p.nr_cpus, p.l2_misses, p.l2_refs, p.instructions, p.cycles,
+     p.context_switches, p.cpu_migrations, p.branch_misses, p.dtlb_load_misses, p.cache_misses,
+     p.instructions_total, p.cycles_total, p.context_switches_total, p.cpu_migrations_total,
+     p.branch_misses_total, p.l2_misses_total, p.dtlb_load_misses_total, p.cache_misses_total,
+     p.context_switches_per_sec, p.cpu_migrations_per_sec, p.branch_misses_per_sec, p.ipc,
+     p.l2_miss_pct, p.cycles_per_l2_miss, p.per_cpu_ids, p.per_cpu_l2_misses, p.per_cpu_l2_refs,
+     p.per_cpu_instructions, p.per_cpu_cycles);
+  io.vec(p.l3_per_cache_domain, [&](auto& d) { io(d.domain_cpu, d.accesses, d.misses, d.miss_pct); });
+  io(p.l3_accesses_total, p.l3_misses_total, p.per_process_available, p.per_process_user_only);
+  io.vec(p.per_process, [&](auto& r) {
+    io(r.pid, r.comm, r.instructions, r.cycles, r.dtlb_load_misses, r.cache_misses, r.ipc,
+       r.instructions_total, r.cycles_total, r.dtlb_load_misses_total, r.cache_misses_total,
+       r.dtlb_misses_per_kilo_instr, r.cache_misses_per_kilo_instr);
+  });
+  io(p.interval_s, p.instructions_per_sec, p.cycles_per_sec, p.l2_misses_per_sec);
+}
+
+template <typename IO, typename M> void mem(IO& io, M& m) {
+  io(m.total_kb, m.used_kb, m.available_kb, m.cached_kb, m.buffers_kb, m.swap_total_kb, m.swap_used_kb,
+     m.used_pct);
+}
+
+template <typename IO, typename V> void vram(IO& io, V& v) {
+  io.vec(v.devices, [&](auto& d) {
+    io(d.name, d.total_mb, d.used_mb, d.has_temp_edge, d.temp_edge_c, d.has_temp_hotspot, d.temp_hotspot_c,
+       d.has_temp_mem, d.temp_mem_c, d.has_thr_edge, d.thr_edge_c, d.has_thr_hotspot, d.thr_hotspot_c,
+       d.has_thr_mem, d.thr_mem_c, d.has_fan, d.fan_speed_pct);
+  });
+  io(v.total_mb, v.used_mb, v.used_pct, v.name, v.has_power, v.power_draw_w, v.has_power_limit,
+     v.power_limit_w, v.has_pstate, v.pstate, v.has_util, v.gpu_util_pct, v.has_mem_util, v.mem_util_pct,
+     v.has_encdec, v.enc_util_pct, v.dec_util_pct);
+}
+
+template <typename IO, typename N> void net(IO& io, N& n) {
+  io.vec(n.interfaces, [&](auto& i) { io(i.name, i.rx_bytes, i.tx_bytes, i.rx_bps, i.tx_bps, i.last_ts); });
+  io(n.agg_rx_bps, n.agg_tx_bps);
+}
+
+template <typename IO, typename D> void disk(IO& io, D& d) {
+  io.vec(d.devices, [&](auto& v) { io(v.name, v.read_bps, v.write_bps, v.util_pct); });
+  io(d.total_read_bps, d.total_write_bps);
+}
+
+template <typename IO, typename F> void fs(IO& io, F& f) {
+  io.vec(f.mounts, [&](auto& m) {
+    io(m.device, m.mountpoint, m.fstype, m.total_bytes, m.used_bytes, m.avail_bytes, m.used_pct);
+  });
+}
+
+template <typename IO, typename G> void cgroups(IO& io, G& g) {
+  io.vec(g.groups, [&](auto& c) {
+    io(c.path, c.depth, c.cpu_pct, c.throttled_pct, c.mem_bytes, c.anon_bytes, c.file_bytes, c.io_read_bps,
+       c.io_write_bps, c.pids);
+  });
+  io(g.total);
+}
+
+template <typename IO, typename L> void psi_line(IO& io, L& l) { io(l.avg10, l.avg60, l.avg300, l.total_us); }
+
+template <typename IO, typename P> void psi(IO& io, P& p) {
+  io.vec(p.entries, [&](auto& e) {
+    io(e.scope, e.resource);
+    psi_line(io, e.some);
+    psi_line(io, e.full);
+    io(e.has_full, e.armed, e.trigger_fires);
+  });
+  io(p.trigger_fires);
+}
+
+template <typename IO, typename V> void providers(IO& io, V& v) {
+  io.vec(v, [&](auto& p) {
+    io(p.name, p.raw_text);
+    io.vec(p.metrics, [&](auto& m) { io(m.name, m.labels, m.value); });
+  });
+}
+
+template <typename IO, typename V> void alerts(IO& io, V& v) {
+  io.vec(v, [&](auto& a) { io(a.severity, a.message); });
+}
+
+template <typename IO, typename T> void thermal(IO& io, T& t) {
+  io(t.has_temp, t.cpu_max_c, t.has_warn, t.warn_c, t.has_fan, t.fan_rpm, t.has_power, t.power_watts,
+     t.has_energy, t.energy_joules_total);
+  io.vec(t.cstates, [&](auto& c) { io(c.name, c.residency_pct); });
+}
+
+template <typename IO, typename N> void nvml(IO& io, N& n) {
+  io(n.available, n.devices, n.running_pids, n.sampled_pids, n.sample_age_ms, n.last_error, n.mig_enabled,
+     n.driver_version, n.nvml_version, n.cuda_version);
+}
+
+template <typename IO, typename S> void misc(IO& io, S& s) {
+  io(s.churn.recent_2s_events, s.churn.recent_2s_proc, s.churn.recent_2s_sys, s.collector_name);
+}
+
+template <typename IO, typename P> void proc_head(IO& io, P& p) {
+  io(p.total_processes, p.running_processes, p.enriched_count, p.tracked_count, p.state_running,
+     p.state_sleeping, p.state_zombie, p.total_threads, p.sample_us, p.scan_shards, p.anomaly_axis_mask);
+  io.vec(p.exited, [&](auto& e) { io(e.comm, e.exits, e.cpu_us, e.max_rss_kb, e.io_bytes); });
+}
+
+template <typename IO, typename R> void proc_row(IO& io, R& r) {
+  io(r.pid, r.total_time, r.rss_kb, r.cpu_pct, r.churn_reason, r.has_gpu_util, r.gpu_util_pct, r.has_gpu_mem,
+     r.gpu_mem_kb, r.user_name, r.cmd, r.exe_path, r.flt_raw, r.thread_count, r.start_time, r.vctx_raw,
+     r.nvctx_raw, r.fault_delta, r.ctxsw_delta, r.anomaly_score, r.anomaly_axis, r.io_read_bps,
+     r.io_write_bps, r.io_age_ms, r.pss_kb, r.pss_age_ms, r.ppid, r.subtree_cpu_pct, r.subtree_rss_kb,
+     r.subtree_threads, r.subtree_procs);
+}
+
+// The section table, in SnapshotSection order.
+template <typename IO, typename S> void section(IO& io, S& s, SnapshotSection id) {
+  switch (id) {
+    case SnapshotSection::Cpu: cpu(io, s.cpu); break;
+    case SnapshotSection::Pmu: pmu(io, s.pmu); break;
+    case SnapshotSection::Mem: mem(io, s.mem); break;
+    case SnapshotSection::Vram: vram(io, s.vram); break;
+    case SnapshotSection::Net: net(io, s.net); break;
+    case SnapshotSection::Disk: disk(io, s.disk); break;
+    case SnapshotSection::Fs: fs(io, s.fs); break;
+    case SnapshotSection::Cgroups: cgroups(io, s.cgroups); break;
+    case SnapshotSection::Psi: psi(io, s.psi); break;
+    case SnapshotSection::Providers: providers(io, s.providers); break;
+    case SnapshotSection::Alerts: alerts(io, s.alerts); break;
+    case SnapshotSection::Thermal: thermal(io, s.thermal); break;
+    case SnapshotSection::Nvml: nvml(io, s.nvml); break;
+    case SnapshotSection::Misc: misc(io, s); break;
+    case SnapshotSection::ProcHead: proc_head(io, s.procs); break;
+    case SnapshotSection::Count: break;
+  }
+}
+
+void put_u32(std::string& out, uint32_t v) { out.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+} // namespace
+
+EncodedSnapshot encode_snapshot(const Snapshot& s) {
+  EncodedSnapshot e;
+  e.seq = s.seq;
+  for (size_t i = 0; i < kSnapshotSections; ++i) {
+    Enc enc(e.sections[i]);
+    section(enc, s, static_cast<SnapshotSection>(i));
+  }
+  const auto& ps = s.procs;
+  e.row_pid.assign(ps.pid.begin(), ps.pid.end());
+  e.rows.resize(ps.size());
+  for (size_t i = 0; i < ps.size(); ++i) {
+    Enc enc(e.rows[i]);
+    const ProcSample r = ps.row(i);
+    proc_row(enc, r);
+  }
+  return e;
+}
+
+void encode_section(const Snapshot& s, SnapshotSection id, std::string& out) {
+  out.clear();
+  Enc enc(out);
+  section(enc, s, id);
+}
+
+void encode_frame(const EncodedSnapshot& cur, const EncodedSnapshot* base, std::string& out) {
+  const size_t start = out.size();
+  put_u32(out, 0);  // length, patched below
+  put_u32(out, kFrameMagic);
+  out.append(reinterpret_cast<const char*>(&kFrameVersion), sizeof(kFrameVersion));
+  out.push_back(base ? 1 : 0);
+  out.push_back(0);
+  const uint64_t base_seq = base ? base->seq : 0;
+  out.append(reinterpret_cast<const char*>(&cur.seq), sizeof(cur.seq));
+  out.append(reinterpret_cast<const char*>(&base_seq), sizeof(base_seq));
+
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kSnapshotSections; ++i)
+    if (!base || base->sections[i] != cur.sections[i]) mask |= 1u << i;
+  put_u32(out, mask);
+  for (size_t i = 0; i < kSnapshotSections; ++i) {
+    if (!(mask & (1u << i))) continue;
+    put_u32(out, static_cast<uint32_t>(cur.sections[i].size()));
+    out.append(cur.sections[i]);
+  }
+
+  std::unordered_map<int32_t, uint32_t> base_index;
+  if (base) {
+    base_index.reserve(base->row_pid.size());
+    for (size_t j = 0; j < base->row_pid.size(); ++j) base_index.emplace(base->row_pid[j], static_cast<uint32_t>(j));
+  }
+  put_u32(out, static_cast<uint32_t>(cur.rows.size()));
+  for (size_t i = 0; i < cur.rows.size(); ++i) {
+    if (base) {
+      auto it = base_index.find(cur.row_pid[i]);
+      if (it != base_index.end() && base->rows[it->second] == cur.rows[i]) {
+        put_u32(out, kRowRef | it->second);
+        continue;
+      }
+    }
+    put_u32(out, static_cast<uint32_t>(cur.rows[i].size()));
+    out.append(cur.rows[i]);
+  }
+
+  const auto len = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+  std::memcpy(out.data() + start, &len, sizeof(len));
+}
+
+bool SnapshotDecoder::apply(std::string_view payload, Snapshot& out) {
+  Dec d(payload);
+  uint32_t magic = 0, mask = 0, nrows = 0;
+  uint16_t version = 0;
+  uint8_t kind = 0, pad = 0;
+  uint64_t seq = 0, base_seq = 0;
+  d(magic, version, kind, pad, seq, base_seq, mask);
+  if (!d.ok() || magic != kFrameMagic || version != kFrameVersion || kind > 1) return false;
+  if (kind == 1 && (seq_ == 0 || base_seq != seq_)) return false;
+  if (kind == 0 && mask != (1u << kSnapshotSections) - 1) return false;  // a keyframe carries every section
+
+  for (size_t i = 0; i < kSnapshotSections; ++i) {
+    if (!(mask & (1u << i))) continue;
+    uint32_t len = 0;
+    d(len);
+    Dec sd(d.take(len));
+    if (!d.ok()) return false;
+    section(sd, out, static_cast<SnapshotSection>(i));
+    if (!sd.done()) return false;
+  }
+
+  d(nrows);
+  if (!d.ok() || nrows > payload.size()) return false;
+  std::vector<ProcSample> next(nrows);
+  for (auto& r : next) {
+    uint32_t tag = 0;
+    d(tag);
+    if (!d.ok()) return false;
+    if (tag & kRowRef) {
+      const uint32_t j = tag & ~kRowRef;
+      if (kind == 0 || j >= rows_.size()) return false;
+      r = rows_[j];
+      continue;
+    }
+    Dec rd(d.take(tag));
+    if (!d.ok()) return false;
+    proc_row(rd, r);
+    if (!rd.done()) return false;
+  }
+  if (!d.done()) return false;
+
+  rows_ = std::move(next);
+  out.procs.assign_rows(rows_);
+  seq_ = seq;
+  return true;
+}
+
+} // namespace montauk::app
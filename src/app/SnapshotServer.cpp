@@ -0,0 +1,218 @@
+#include "app/SnapshotServer.hpp"
+#include "util/Log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace montauk::app {
+
+namespace {
+
+// Make the socket path ours to bind. Nothing there: fine. A socket nobody
+// answers on is a previous run's leftover and is removed. Anything else -- a
+// live `--serve` (whose viewers we would strand) or a file that is not a
+// socket at all, e.g. a mistyped path -- is left alone and start() fails.
+bool claim_path(const sockaddr_un& addr) {
+  const char* p = addr.sun_path;
+  struct stat st{};
+  if (::lstat(p, &st) != 0) {
+    if (errno == ENOENT) return true;
+    montauk::util::log_error("SnapshotServer: cannot stat %s: %s", p, std::strerror(errno));
+    return false;
+  }
+  if (!S_ISSOCK(st.st_mode)) {
+    montauk::util::log_error("SnapshotServer: %s exists and is not a socket", p);
+    return false;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    montauk::util::log_error("SnapshotServer: socket: %s", std::strerror(errno));
+    return false;
+  }
+  const int err = ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0 ? 0 : errno;
+  ::close(fd);
+  if (err == ENOENT) return true;  // went away since the lstat
+  if (err != ECONNREFUSED) {
+    montauk::util::log_error("SnapshotServer: %s is in use by another server", p);
+    return false;
+  }
+  if (::unlink(p) != 0 && errno != ENOENT) {
+    montauk::util::log_error("SnapshotServer: cannot remove stale %s: %s", p, std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+SnapshotServer::SnapshotServer(const SnapshotBuffers& buffers, std::filesystem::path path)
+    : buffers_(buffers), path_(std::move(path)) {}
+
+SnapshotServer::~SnapshotServer() { stop(); }
+
+bool SnapshotServer::start() {
+  const std::string p = path_.string();
+  if (p.size() >= sizeof(sockaddr_un::sun_path)) {
+    montauk::util::log_error("SnapshotServer: socket path too long: %s", p.c_str());
+    return false;
+  }
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::memcpy(addr.sun_path, p.c_str(), p.size() + 1);
+  if (!claim_path(addr)) return false;
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    montauk::util::log_error("SnapshotServer: socket: %s", std::strerror(errno));
+    return false;
+  }
+  if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 16) < 0) {
+    montauk::util::log_error("SnapshotServer: failed to listen on %s: %s", p.c_str(), std::strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  listen_fd_ = fd;
+  montauk::util::log_info("SnapshotServer: serving snapshots on %s", p.c_str());
+  thread_ = std::jthread([this](std::stop_token st) { serve(st); });
+  return true;
+}
+
+void SnapshotServer::stop() {
+  if (thread_.joinable()) {
+    thread_.request_stop();
+    thread_.join();
+  }
+  for (auto& c : clients_) ::close(c.fd);
+  clients_.clear();
+  nclients_.store(0, std::memory_order_relaxed);
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+    ::unlink(path_.c_str());
+  }
+}
+
+void SnapshotServer::accept_clients() {
+  for (;;) {
+    int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;
+    if (clients_.size() >= kMaxClients) {
+      montauk::util::log_warn("SnapshotServer: refusing viewer, %zu already attached", clients_.size());
+      ::close(fd);
+      continue;
+    }
+    clients_.push_back(Client{fd, 0, nullptr, 0});
+    montauk::util::log_info("SnapshotServer: viewer attached (%zu)", clients_.size());
+  }
+}
+
+const EncodedSnapshot* SnapshotServer::history(uint64_t seq) const {
+  for (const auto& e : history_)
+    if (e.seq == seq) return &e;
+  return nullptr;
+}
+
+void SnapshotServer::refresh() {
+  // Nobody to send to: skip the encode, not just the send.
+  if (clients_.empty() || buffers_.seq() == 0) return;
+  if (!history_.empty() && history_.back().seq == buffers_.seq()) return;
+  const auto gen = buffers_.acquire();
+  if (!history_.empty() && history_.back().seq == gen->seq) return;
+  history_.push_back(encode_snapshot(*gen));
+  if (history_.size() > kHistory) history_.pop_front();
+  frames_cache_.clear();
+}
+
+void SnapshotServer::feed(Client& c) {
+  const EncodedSnapshot& cur = history_.back();
+  const EncodedSnapshot* base = c.sent_seq ? history(c.sent_seq) : nullptr;
+  const uint64_t key = base ? base->seq : 0;
+  std::shared_ptr<const std::string> frame;
+  for (const auto& [k, f] : frames_cache_)
+    if (k == key) frame = f;
+  if (!frame) {
+    auto built = std::make_shared<std::string>();
+    encode_frame(cur, base, *built);
+    frame = std::move(built);
+    frames_cache_.emplace_back(key, frame);
+  }
+  if (c.sent_seq != 0 && cur.seq > c.sent_seq + 1)
+    skipped_.fetch_add(cur.seq - c.sent_seq - 1, std::memory_order_relaxed);
+  c.out = std::move(frame);
+  c.off = 0;
+  c.sent_seq = cur.seq;
+  frames_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SnapshotServer::flush(Client& c) {
+  while (c.out && c.off < c.out->size()) {
+    // MSG_NOSIGNAL: a viewer that quit mid-frame must not SIGPIPE the server.
+    ssize_t n = ::send(c.fd, c.out->data() + c.off, c.out->size() - c.off, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    c.off += static_cast<size_t>(n);
+  }
+  c.out.reset();
+  return true;
+}
+
+void SnapshotServer::serve(std::stop_token st) {
+  // A publish or stop() makes the waiter readable, so the poll needs no
+  // timeout: with no viewers and no new generation the thread stays asleep.
+  PublishWaiter waiter(buffers_.signal());
+  std::stop_callback on_stop(st, [&waiter] { waiter.wake(); });
+  constexpr size_t kFirstClient = 2;
+  std::vector<pollfd> fds;
+  std::vector<uint8_t> gone;
+  while (!st.stop_requested()) {
+    fds.clear();
+    fds.push_back(pollfd{listen_fd_, POLLIN, 0});
+    fds.push_back(pollfd{waiter.fd(), POLLIN, 0});
+    for (const auto& c : clients_)
+      fds.push_back(pollfd{c.fd, static_cast<short>(POLLIN | (c.out ? POLLOUT : 0)), 0});
+    const int timeout = waiter.fd() < 0 ? 5 : -1;
+    if (::poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR) break;
+
+    if (fds[0].revents & POLLIN) accept_clients();
+    if (fds[1].revents & POLLIN) waiter.drain();
+    gone.assign(clients_.size(), 0);
+    for (size_t i = 0; i + kFirstClient < fds.size() && i < clients_.size(); ++i) {
+      const short ev = fds[i + kFirstClient].revents;
+      Client& c = clients_[i];
+      if (ev & POLLIN) {
+        // Viewers send nothing; a readable socket is EOF or stray bytes.
+        char buf[256];
+        ssize_t n = ::recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) gone[i] = 1;
+      }
+      if (ev & (POLLERR | POLLHUP | POLLNVAL)) gone[i] = 1;
+      if (!gone[i] && (ev & POLLOUT) && !flush(c)) gone[i] = 1;
+    }
+
+    refresh();
+    for (size_t i = 0; i < clients_.size(); ++i) {
+      Client& c = clients_[i];
+      if (gone[i] || c.out || history_.empty() || c.sent_seq == history_.back().seq) continue;
+      feed(c);
+      if (!flush(c)) gone[i] = 1;
+    }
+
+    for (size_t i = clients_.size(); i-- > 0;) {
+      if (!gone[i]) continue;
+      ::close(clients_[i].fd);
+      clients_.erase(clients_.begin() + static_cast<std::ptrdiff_t>(i));
+      montauk::util::log_info("SnapshotServer: viewer detached (%zu)", clients_.size());
+    }
+    nclients_.store(clients_.size(), std::memory_order_relaxed);
+  }
+}
+
+} // namespace montauk::app
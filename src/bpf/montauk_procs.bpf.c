@@ -0,0 +1,149 @@
+// montauk process table: the whole task list in one iterator pass
+//
+//   iter/task  → dump_tasks: one packed record per task (see montauk_procs.h)
+//
+// The procfs collectors open, read and parse a handful of text files per
+// process per sample; on a 50k-process host that is the sample. This walks
+// every task_struct in the kernel instead and writes what those files would
+// have said as fixed-size binary records, which BpfIterProcessCollector reads
+// off the iterator fd and folds per process. No maps, no attach points: the
+// program only runs when userspace reads the iterator.
+
+#include "vmlinux.h"
+#include <bpf/bpf_helpers.h>
+#include <bpf/bpf_tracing.h>
+#include <bpf/bpf_core_read.h>
+#include "montauk_procs.h"
+
+char LICENSE[] SEC("license") = "GPL";
+
+// task_struct.state became __state in 5.14. Both spelled as flavors, so the
+// program builds against either kernel's vmlinux.h.
+struct task_struct___pre514 {
+  long state;
+} __attribute__((preserve_access_index));
+
+struct task_struct___post514 {
+  unsigned int __state;
+} __attribute__((preserve_access_index));
+
+// mm->rss_stat was an array of atomics in struct mm_rss_stat until 6.2, and
+// is an array of percpu_counters since. The percpu_counter's count is the
+// folded global value; per-CPU deltas not yet folded in are left out, which
+// is the same approximation get_mm_counter() makes.
+struct mm_rss_stat___pre62 {
+  atomic_long_t count[4];
+} __attribute__((preserve_access_index));
+
+struct mm_struct___pre62 {
+  struct mm_rss_stat___pre62 rss_stat;
+} __attribute__((preserve_access_index));
+
+struct mm_struct___post62 {
+  struct percpu_counter rss_stat[4];
+} __attribute__((preserve_access_index));
+
+#define MM_FILEPAGES  0
+#define MM_ANONPAGES  1
+#define MM_SHMEMPAGES 3
+
+#define TASK_INTERRUPTIBLE   0x0001
+#define TASK_UNINTERRUPTIBLE 0x0002
+#define TASK_STOPPED_BIT     0x0004
+#define TASK_TRACED_BIT      0x0008
+#define TASK_NOLOAD          0x0400
+#define EXIT_DEAD            0x0010
+#define EXIT_ZOMBIE          0x0020
+
+static __always_inline s64 mm_counter(struct mm_struct *mm, int member) {
+  s64 v;
+  if (bpf_core_type_exists(struct mm_rss_stat___pre62)) {
+    struct mm_struct___pre62 *m = (void *)mm;
+    v = BPF_CORE_READ(m, rss_stat.count[member].counter);
+  } else {
+    struct mm_struct___post62 *m = (void *)mm;
+    v = BPF_CORE_READ(m, rss_stat[member].count);
+  }
+  return v > 0 ? v : 0;
+}
+
+// The letter fs/proc/array.c's get_task_state() would print.
+static __always_inline char task_state_letter(struct task_struct *task) {
+  unsigned int exit_state = BPF_CORE_READ(task, exit_state);
+  if (exit_state & EXIT_ZOMBIE)
+    return 'Z';
+  if (exit_state & EXIT_DEAD)
+    return 'X';
+  unsigned int state;
+  struct task_struct___post514 *t514 = (void *)task;
+  if (bpf_core_field_exists(t514->__state)) {
+    state = BPF_CORE_READ(t514, __state);
+  } else {
+    struct task_struct___pre514 *t = (void *)task;
+    state = (unsigned int)BPF_CORE_READ(t, state);
+  }
+  if (state == 0)
+    return 'R';
+  if (state & TASK_INTERRUPTIBLE)
+    return 'S';
+  if (state & TASK_UNINTERRUPTIBLE)
+    return (state & TASK_NOLOAD) ? 'I' : 'D';
+  if (state & TASK_STOPPED_BIT)
+    return 'T';
+  if (state & TASK_TRACED_BIT)
+    return 't';
+  return 'S';
+}
+
+SEC("iter/task")
+int dump_tasks(struct bpf_iter__task *ctx) {
+  struct seq_file *seq = ctx->meta->seq;
+  struct task_struct *task = ctx->task;
+  if (!task)
+    return 0;
+
+  u32 tgid = BPF_CORE_READ(task, tgid);
+  u32 tid = BPF_CORE_READ(task, pid);   // kernel 'pid' field = thread id
+  u64 run_ns = BPF_CORE_READ(task, se.sum_exec_runtime);
+  u64 cpu_ns = BPF_CORE_READ(task, utime) + BPF_CORE_READ(task, stime);
+  u64 nvcsw = BPF_CORE_READ(task, nvcsw);
+  u64 nivcsw = BPF_CORE_READ(task, nivcsw);
+  u64 flt = BPF_CORE_READ(task, min_flt) + BPF_CORE_READ(task, maj_flt);
+
+  if (tid != tgid) {
+    struct montauk_thread_rec r = {};
+    r.tgid   = tgid;
+    r.tid    = tid;
+    r.run_ns = run_ns;
+    r.cpu_ns = cpu_ns;
+    r.nvcsw  = nvcsw;
+    r.nivcsw = nivcsw;
+    r.flt    = flt;
+    bpf_seq_write(seq, &r, sizeof(r));
+    return 0;
+  }
+
+  // Leader: its own counters plus everything the group's dead threads left
+  // in signal_struct, then the per-process fields.
+  struct signal_struct *sig = BPF_CORE_READ(task, signal);
+  struct montauk_task_rec r = {};
+  r.tgid   = tgid;
+  r.tid    = tid;
+  r.run_ns = run_ns + BPF_CORE_READ(sig, sum_sched_runtime);
+  r.cpu_ns = cpu_ns + BPF_CORE_READ(sig, utime) + BPF_CORE_READ(sig, stime);
+  r.nvcsw  = nvcsw + BPF_CORE_READ(sig, nvcsw);
+  r.nivcsw = nivcsw + BPF_CORE_READ(sig, nivcsw);
+  r.flt    = flt + BPF_CORE_READ(sig, min_flt) + BPF_CORE_READ(sig, maj_flt);
+  r.start_ns   = BPF_CORE_READ(task, start_boottime);
+  r.ppid       = BPF_CORE_READ(task, real_parent, tgid);
+  r.uid        = BPF_CORE_READ(task, real_cred, uid.val);
+  r.nr_threads = BPF_CORE_READ(sig, nr_threads);
+  r.state      = task_state_letter(task);
+  struct mm_struct *mm = BPF_CORE_READ(task, mm);
+  if (mm)   // kernel threads have none
+    r.rss_pages = mm_counter(mm, MM_FILEPAGES) + mm_counter(mm, MM_ANONPAGES) +
+                  mm_counter(mm, MM_SHMEMPAGES);
+  BPF_CORE_READ_STR_INTO(&r.comm, task, comm);
+  bpf_seq_write(seq, &r, sizeof(r));
+  return 0;
+}
@@ -0,0 +1,47 @@
+// montauk process table: records the dump_tasks iterator writes, shared
+// between BPF (C) and userspace (C++). Both sides must agree byte for byte.
+
+#ifndef MONTAUK_PROCS_BPF_H
+#define MONTAUK_PROCS_BPF_H
+
+#ifndef __BPF__
+#include <linux/types.h>
+#endif
+
+// One record per task, back to back in the iterator's output with no framing.
+// Both kinds open with tgid and tid, which is what tells them apart: a group
+// leader (tid == tgid) is a montauk_task_rec, any other thread the shorter
+// montauk_thread_rec. Userspace sums a process's threads onto its leader.
+//
+// Times are nanoseconds. A leader's counters also carry its group's dead
+// threads (signal_struct totals), the same way /proc/PID/stat reports them.
+struct montauk_thread_rec {
+  __u32 tgid;
+  __u32 tid;
+  __u64 run_ns;    // se.sum_exec_runtime: precise on-CPU time
+  __u64 cpu_ns;    // utime + stime, tick-sampled
+  __u64 nvcsw;     // voluntary context switches
+  __u64 nivcsw;    // involuntary context switches
+  __u64 flt;       // minor + major page faults
+};
+
+struct montauk_task_rec {
+  __u32 tgid;
+  __u32 tid;
+  __u64 run_ns;
+  __u64 cpu_ns;
+  __u64 nvcsw;
+  __u64 nivcsw;
+  __u64 flt;
+  // Leader-only fields: one per process.
+  __u64 start_ns;    // start_boottime, ns after boot
+  __u64 rss_pages;   // file + anon + shmem
+  __u32 ppid;
+  __u32 uid;         // real uid
+  __u32 nr_threads;
+  char  state;       // /proc state letter: R S D T t Z X I
+  char  pad[3];
+  char  comm[16];
+};
+
+#endif // MONTAUK_PROCS_BPF_H
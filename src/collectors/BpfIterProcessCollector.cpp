@@ -0,0 +1,161 @@
+#include "collectors/BpfIterProcessCollector.hpp"
+#include "collectors/ProcessParsing.hpp"
+#include "util/Log.hpp"
+#include <bpf/libbpf.h>
+#include <bpf/bpf.h>
+#include <bpf/btf.h>
+// Must sit between the libbpf headers and the skeleton: it decltypes the
+// declarations above, and redirects the skeleton's own libbpf calls below.
+#include "util/BpfDyn.hpp"
+#include "montauk_procs.skel.h"
+#include <cerrno>
+#include <unistd.h>
+
+namespace montauk::collectors {
+
+namespace {
+// The iterator's seq_file fills at most a few pages per read(); a larger
+// buffer costs nothing and lets one call take whatever is ready.
+constexpr size_t kReadChunk = 256 * 1024;
+}  // namespace
+
+BpfIterProcessCollector::BpfIterProcessCollector(size_t max_procs, size_t enrich_top_n)
+  : max_procs_(max_procs), enrich_top_n_(enrich_top_n) {}
+
+BpfIterProcessCollector::~BpfIterProcessCollector() { shutdown(); }
+
+bool BpfIterProcessCollector::init() {
+  if (!montauk::util::bpf_api().ok) return false;
+  skel_ = montauk_procs_bpf__open_and_load();
+  if (!skel_) {
+    montauk::util::log_info("BPF process iterator did not load (need CAP_BPF and kernel BTF)");
+    return false;
+  }
+  link_ = bpf_program__attach_iter(skel_->progs.dump_tasks, nullptr);
+  if (!link_ || libbpf_get_error(link_)) {
+    montauk::util::log_info("BPF process iterator did not attach (kernel before 5.8?)");
+    link_ = nullptr;
+    shutdown();
+    return false;
+  }
+  buf_.resize(kReadChunk);
+  page_kb_ = static_cast<uint64_t>(::getpagesize() / 1024);
+  const long hz = ::sysconf(_SC_CLK_TCK);
+  ticks_per_sec_ = hz > 0 ? static_cast<uint64_t>(hz) : 100;
+  // One pass up front: it proves the iterator reads, and seeds the baseline
+  // so the first published sample already has rates.
+  if (!read_iterator()) {
+    montauk::util::log_info("BPF process iterator unreadable");
+    shutdown();
+    return false;
+  }
+  last_wall_ns_ = steady_ns();
+  for (const auto& p : procs_) last_[p.pid] = Baseline{p.start_ns, p.run_ns};
+  return true;
+}
+
+void BpfIterProcessCollector::shutdown() {
+  if (link_) {
+    bpf_link__destroy(link_);
+    link_ = nullptr;
+  }
+  if (skel_) {
+    montauk_procs_bpf__destroy(skel_);
+    skel_ = nullptr;
+  }
+}
+
+bool BpfIterProcessCollector::read_iterator() {
+  const int fd = bpf_iter_create(bpf_link__fd(link_));
+  if (fd < 0) return false;
+  ssize_t got = 0;
+  while ((got = ::read(fd, buf_.data(), buf_.size())) > 0 || (got < 0 && errno == EINTR))
+    if (got > 0) fold_.feed(buf_.data(), static_cast<size_t>(got));
+  ::close(fd);
+  // A torn tail means a record straddled a failed read; the whole pass is
+  // suspect, so it is dropped rather than half-published.
+  const bool clean = fold_.finish(procs_);
+  return got == 0 && clean;
+}
+
+bool BpfIterProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
+  // Reset everything but the string pool, which outlives the frame.
+  auto strings = std::move(out.strings);
+  out = {};
+  out.strings = std::move(strings);
+  rows_.clear();
+  if (!link_ || !read_iterator()) return false;
+  ids_.tick();
+
+  const uint64_t wall_ns = steady_ns();
+  const uint64_t dwall = wall_ns > last_wall_ns_ ? wall_ns - last_wall_ns_ : 0;
+  const uint64_t ns_per_tick = 1'000'000'000ull / ticks_per_sec_;
+  next_.clear();
+  next_.reserve(procs_.size());
+  rows_.reserve(procs_.size());
+  for (auto& p : procs_) {
+    montauk::model::ProcSample ps;
+    ps.pid = p.pid;
+    ps.ppid = p.ppid;
+    ps.total_time = p.cpu_ns / ns_per_tick;   // jiffies, as the procfs collectors report it
+    ps.rss_kb = p.rss_pages * page_kb_;
+    ps.start_time = p.start_ns / ns_per_tick;
+    ps.thread_count = static_cast<int>(p.nr_threads > 0 ? p.nr_threads : 1);
+    ps.flt_raw = p.flt;
+    ps.vctx_raw = p.nvcsw;
+    ps.nvctx_raw = p.nivcsw;
+    auto it = last_.find(p.pid);
+    if (it != last_.end() && it->second.start_ns == p.start_ns && dwall > 0 && p.run_ns > it->second.run_ns)
+      ps.cpu_pct = 100.0 * static_cast<double>(p.run_ns - it->second.run_ns) / static_cast<double>(dwall);
+    next_.emplace(p.pid, Baseline{p.start_ns, p.run_ns});
+    switch (p.state) {
+      case 'R': out.state_running++; break;
+      case 'S': case 'D': out.state_sleeping++; break;
+      case 'Z': out.state_zombie++; break;
+      default: break;
+    }
+    out.total_threads += static_cast<size_t>(ps.thread_count);
+    ps.cmd = std::move(p.comm);
+    ps.user_name = user_name_cached(p.uid);
+    rows_.push_back(std::move(ps));
+  }
+  last_.swap(next_);
+  last_wall_ns_ = wall_ns;
+  out.total_processes = rows_.size();
+  out.running_processes = out.state_running;
+
+  // Identities of pids that are gone or were recycled.
+  ids_.sweep([&](int32_t pid, uint64_t start) {
+    auto it = last_.find(pid);
+    return it == last_.end() || it->second.start_ns / ns_per_tick != start;
+  });
+  tree_.refresh(rows_);
+  top_k_by_cpu_pct(rows_, max_procs_);
+  // Same enrichment as the procfs collectors, and the only /proc this
+  // collector reads: exe for every kept row, cmdline for the top N, each once
+  // per process image.
+  out.tracked_count = rows_.size();
+  const size_t enrich_n = std::min(rows_.size(), enrich_top_n_);
+  out.enriched_count = enrich_n;
+  for (size_t i = 0; i < rows_.size(); ++i) {
+    auto& ps = rows_[i];
+    auto& id = ids_.at(ps.pid, ps.start_time, ps.cmd);
+    if (!id.exe) {
+      read_exe_path(rd_, ps.pid, ps.exe_path);
+      id.exe = ids_.intern(ps.exe_path);
+    } else {
+      ps.exe_path = *id.exe;
+    }
+    if (i >= enrich_n) continue;
+    if (!id.cmd) {
+      auto cmd = read_cmdline(rd_, ps.pid);
+      cap_cmdline(cmd);
+      id.cmd = ids_.intern(cmd);
+    }
+    if (!id.cmd->empty()) ps.cmd = *id.cmd;
+  }
+  out.assign_rows(rows_);
+  return true;
+}
+
+} // namespace montauk::collectors
@@ -0,0 +1,298 @@
+#include "collectors/CgroupCollector.hpp"
+#include "collectors/ProcessParsing.hpp"
+#include "util/Procfs.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace montauk::collectors {
+
+namespace {
+
+constexpr const char* kFileNames[] = {"cpu.stat", "memory.current", "memory.stat", "io.stat",
+                                      "pids.current"};
+enum { kCpuStat, kMemCurrent, kMemStat, kIoStat, kPidsCurrent };
+constexpr int kMaxDepth = 32;
+// Without inotify the tree is re-walked this often (in samples) instead.
+constexpr unsigned kRewalkEvery = 10;
+
+uint64_t to_u64(std::string_view t) {
+  uint64_t v = 0;
+  (void)std::from_chars(t.data(), t.data() + t.size(), v);
+  return v;
+}
+
+// fn(key, value) for each "key value" line of a flat-keyed cgroup file.
+template <typename Fn>
+void for_each_kv(std::string_view text, Fn&& fn) {
+  while (!text.empty()) {
+    const size_t nl = text.find('\n');
+    std::string_view line = text.substr(0, nl);
+    text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+    const size_t sp = line.find(' ');
+    if (sp == std::string_view::npos) continue;
+    fn(line.substr(0, sp), line.substr(sp + 1));
+  }
+}
+
+bool pread_all(int fd, std::string& buf) {
+  size_t len = 0;
+  if (buf.size() < 512) buf.resize(512);
+  for (;;) {
+    const ssize_t n = ::pread(fd, buf.data() + len, buf.size() - len, static_cast<off_t>(len));
+    if (n < 0) { if (errno == EINTR) continue; return false; }
+    if (n == 0) break;
+    len += static_cast<size_t>(n);
+    if (len == buf.size()) buf.resize(buf.size() * 2);
+  }
+  buf.resize(len);
+  return true;
+}
+
+}  // namespace
+
+void parse_cgroup_cpu_stat(std::string_view text, uint64_t& usage_usec, uint64_t& throttled_usec) {
+  usage_usec = throttled_usec = 0;
+  for_each_kv(text, [&](std::string_view k, std::string_view v) {
+    if (k == "usage_usec") usage_usec = to_u64(v);
+    else if (k == "throttled_usec") throttled_usec = to_u64(v);
+  });
+}
+
+void parse_cgroup_memory_stat(std::string_view text, uint64_t& anon, uint64_t& file) {
+  anon = file = 0;
+  for_each_kv(text, [&](std::string_view k, std::string_view v) {
+    if (k == "anon") anon = to_u64(v);
+    else if (k == "file") file = to_u64(v);
+  });
+}
+
+void parse_cgroup_io_stat(std::string_view text, uint64_t& rbytes, uint64_t& wbytes) {
+  rbytes = wbytes = 0;
+  // "8:0 rbytes=1 wbytes=2 rios=3 ..." per device.
+  for_each_kv(text, [&](std::string_view, std::string_view rest) {
+    while (!rest.empty()) {
+      const size_t sp = rest.find(' ');
+      const std::string_view kv = rest.substr(0, sp);
+      rest = sp == std::string_view::npos ? std::string_view{} : rest.substr(sp + 1);
+      const size_t eq = kv.find('=');
+      if (eq == std::string_view::npos) continue;
+      const std::string_view k = kv.substr(0, eq);
+      if (k == "rbytes") rbytes += to_u64(kv.substr(eq + 1));
+      else if (k == "wbytes") wbytes += to_u64(kv.substr(eq + 1));
+    }
+  });
+}
+
+std::string cgroup_v2_root() {
+  for (const char* p : {"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}) {
+    std::string dir = montauk::util::map_sys_path(p);
+    if (::access((dir + "/cgroup.controllers").c_str(), F_OK) == 0) return dir;
+  }
+  return {};
+}
+
+CgroupCollector::CgroupCollector(size_t fd_budget) : fd_budget_(fd_budget) {
+  // Leave the process collector's fd cache and everything else its headroom.
+  struct rlimit rl{};
+  if (::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY)
+    fd_budget_ = std::min<size_t>(fd_budget_, static_cast<size_t>(rl.rlim_cur / 4));
+}
+
+CgroupCollector::~CgroupCollector() {
+  drop_all();
+  if (inotify_fd_ >= 0) ::close(inotify_fd_);
+}
+
+bool CgroupCollector::locate_root() {
+  root_ = cgroup_v2_root();
+  if (root_.empty()) return false;
+  inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  return true;
+}
+
+void CgroupCollector::walk(const std::string& rel, int depth) {
+  if (depth > kMaxDepth) return;
+  auto it = nodes_.find(rel);
+  if (it == nodes_.end() && nodes_.size() >= kMaxGroups) return;
+  const std::string abs = root_ + rel;
+  DIR* d = ::opendir(abs.c_str());
+  if (!d) return;
+  ++dirs_walked_;
+  if (it == nodes_.end()) {
+    it = nodes_.emplace(rel, Node{}).first;
+    it->second.depth = depth;
+    if (inotify_fd_ >= 0) {
+      it->second.wd = ::inotify_add_watch(inotify_fd_, abs.c_str(),
+                                          IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+      if (it->second.wd >= 0) wd_rel_[it->second.wd] = rel;
+    }
+  }
+  it->second.gen = gen_;
+  while (auto* e = ::readdir(d)) {
+    const std::string_view name = e->d_name;
+    if (name == "." || name == "..") continue;
+    if (e->d_type == DT_UNKNOWN) {
+      struct stat st{};
+      if (::fstatat(::dirfd(d), e->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISDIR(st.st_mode)) continue;
+    } else if (e->d_type != DT_DIR) {
+      continue;
+    }
+    walk(rel + "/" + e->d_name, depth + 1);  // invalidates it; not used past here
+  }
+  ::closedir(d);
+}
+
+void CgroupCollector::close_node(Node& n) {
+  for (int& fd : n.fds) {
+    if (fd < 0) continue;
+    ::close(fd);
+    fd = -1;
+    --fds_open_;
+  }
+  if (n.wd >= 0) {
+    if (inotify_fd_ >= 0) (void)::inotify_rm_watch(inotify_fd_, n.wd);
+    wd_rel_.erase(n.wd);
+    n.wd = -1;
+  }
+}
+
+void CgroupCollector::drop(const std::string& rel) {
+  const std::string prefix = rel + "/";
+  for (auto it = nodes_.begin(); it != nodes_.end();) {
+    if (it->first != rel && !it->first.starts_with(prefix)) { ++it; continue; }
+    close_node(it->second);
+    it = nodes_.erase(it);
+  }
+}
+
+void CgroupCollector::drop_all() {
+  for (auto& [rel, n] : nodes_) close_node(n);
+  nodes_.clear();
+}
+
+void CgroupCollector::drain_events() {
+  if (inotify_fd_ < 0) return;
+  alignas(struct inotify_event) char buf[8192];
+  std::vector<std::string> created;
+  for (;;) {
+    const ssize_t got = ::read(inotify_fd_, buf, sizeof(buf));
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) break;  // EAGAIN: drained
+    for (ssize_t off = 0; off < got;) {
+      const auto* ev = reinterpret_cast<const struct inotify_event*>(buf + off);
+      off += static_cast<ssize_t>(sizeof(struct inotify_event) + ev->len);
+      if (ev->mask & IN_Q_OVERFLOW) { rewalk_ = true; continue; }
+      auto w = wd_rel_.find(ev->wd);
+      if (w == wd_rel_.end()) continue;
+      if (ev->mask & IN_IGNORED) {
+        // The kernel dropped the watch and may hand its wd to the next
+        // add_watch: forget it on the node too, so close_node() does not
+        // remove someone else's watch.
+        auto n = nodes_.find(w->second);
+        if (n != nodes_.end() && n->second.wd == ev->wd) n->second.wd = -1;
+        wd_rel_.erase(w);
+        continue;
+      }
+      if (!(ev->mask & IN_ISDIR) || ev->len == 0) continue;
+      std::string child = w->second + "/" + ev->name;
+      if (ev->mask & (IN_CREATE | IN_MOVED_TO)) created.push_back(std::move(child));
+      else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) drop(child);
+    }
+  }
+  if (rewalk_) return;  // the full walk covers them
+  for (const auto& rel : created) {
+    const size_t slash = rel.rfind('/');
+    auto parent = nodes_.find(rel.substr(0, slash));
+    if (parent != nodes_.end()) walk(rel, parent->second.depth + 1);
+  }
+}
+
+bool CgroupCollector::read_file(Node& n, const std::string& rel, int which, std::string& buf) {
+  int& fd = n.fds[which];
+  if (fd >= 0) return pread_all(fd, buf);
+  const std::string path = root_ + rel + "/" + kFileNames[which];
+  const int f = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (f < 0) return false;  // controller not enabled here; cheap to retry
+  const bool ok = pread_all(f, buf);
+  if (fds_open_ < fd_budget_) {
+    fd = f;
+    ++fds_open_;
+  } else {
+    ::close(f);
+  }
+  return ok;
+}
+
+bool CgroupCollector::sample(montauk::model::CgroupSnapshot& out) {
+  out.groups.clear();
+  out.total = 0;
+  if (root_.empty() && !locate_root()) return false;
+  drain_events();
+  if (inotify_fd_ < 0 && ++samples_ % kRewalkEvery == 0) rewalk_ = true;
+  if (rewalk_) {
+    // Mark and sweep, so surviving groups keep their fds and rate baselines.
+    ++gen_;
+    walk("", 0);
+    for (auto it = nodes_.begin(); it != nodes_.end();) {
+      if (it->second.gen == gen_) { ++it; continue; }
+      close_node(it->second);
+      it = nodes_.erase(it);
+    }
+    rewalk_ = false;
+  }
+
+  const double ts = now_secs();
+  out.groups.reserve(nodes_.size());
+  for (auto& [rel, n] : nodes_) {
+    montauk::model::CgroupStat g;
+    g.path = rel.empty() ? "/" : rel;
+    g.depth = n.depth;
+    uint64_t usage = 0, throttled = 0, rbytes = 0, wbytes = 0;
+    if (read_file(n, rel, kCpuStat, buf_)) parse_cgroup_cpu_stat(buf_, usage, throttled);
+    if (read_file(n, rel, kMemCurrent, buf_)) g.mem_bytes = to_u64(buf_);
+    if (read_file(n, rel, kMemStat, buf_)) parse_cgroup_memory_stat(buf_, g.anon_bytes, g.file_bytes);
+    if (read_file(n, rel, kIoStat, buf_)) parse_cgroup_io_stat(buf_, rbytes, wbytes);
+    if (read_file(n, rel, kPidsCurrent, buf_)) g.pids = to_u64(buf_);
+    if (n.have_prev && ts > n.ts) {
+      const double dt = ts - n.ts;
+      // A backwards counter (group recreated under the same name between
+      // samples) gives a zero-rate frame, as in DiskCollector.
+      if (usage >= n.usage_usec) g.cpu_pct = static_cast<double>(usage - n.usage_usec) / (dt * 1e4);
+      if (throttled >= n.throttled_usec)
+        g.throttled_pct = static_cast<double>(throttled - n.throttled_usec) / (dt * 1e4);
+      if (rbytes >= n.rbytes) g.io_read_bps = static_cast<double>(rbytes - n.rbytes) / dt;
+      if (wbytes >= n.wbytes) g.io_write_bps = static_cast<double>(wbytes - n.wbytes) / dt;
+    }
+    n.usage_usec = usage;
+    n.throttled_usec = throttled;
+    n.rbytes = rbytes;
+    n.wbytes = wbytes;
+    n.ts = ts;
+    n.have_prev = true;
+    out.groups.push_back(std::move(g));
+  }
+  out.total = out.groups.size();
+  auto busier = [](const montauk::model::CgroupStat& a, const montauk::model::CgroupStat& b) {
+    if (a.cpu_pct != b.cpu_pct) return a.cpu_pct > b.cpu_pct;
+    if (a.mem_bytes != b.mem_bytes) return a.mem_bytes > b.mem_bytes;
+    return a.path < b.path;
+  };
+  if (out.groups.size() > kPublish) {
+    std::partial_sort(out.groups.begin(), out.groups.begin() + kPublish, out.groups.end(), busier);
+    out.groups.resize(kPublish);
+  } else {
+    std::sort(out.groups.begin(), out.groups.end(), busier);
+  }
+  return true;
+}
+
+} // namespace montauk::collectors
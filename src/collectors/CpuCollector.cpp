@@ -92,15 +92,15 @@ bool CpuCollector::sample(montauk::model::CpuSnapshot& out) {
       physical_cores_ = phys_total;
     }
   }
-  auto txt_opt = montauk::util::read_file_string("/proc/stat");
+  auto txt_opt = rd_.read("stat");
   if (!txt_opt) return false;
-  const std::string& txt = *txt_opt;
+  const std::string_view txt = *txt_opt;
   montauk::model::CpuTimes agg{};
   std::vector<montauk::model::CpuTimes>& per = per_scratch_; per.clear();
   uint64_t ctxt = 0, intr = 0;
   size_t start = 0; bool after_cpu = false;
   while (start < txt.size()) {
-    size_t end = txt.find('\n', start); if (end == std::string::npos) end = txt.size();
+    size_t end = txt.find('\n', start); if (end == std::string_view::npos) end = txt.size();
     std::string_view line(txt.data() + start, end - start);
     if (line.starts_with("cpu ")) { parse_cpu_line(line, agg); after_cpu = true; }
     else if (after_cpu && line.starts_with("cpu")) { montauk::model::CpuTimes t{}; parse_cpu_line(line, t); per.push_back(t); }
@@ -142,7 +142,10 @@ bool CpuCollector::sample(montauk::model::CpuSnapshot& out) {
   last_sample_time_ = now;
   
   // compute deltas
-  double usage = 0.0; std::vector<double> per_pct(per.size(), 0.0);
+  // Fill the snapshot's own per-core vector in place: it keeps its capacity
+  // across publishes, where a fresh local moved in freed and reallocated it.
+  double usage = 0.0; std::vector<double>& per_pct = out.per_core_pct;
+  per_pct.assign(per.size(), 0.0);
   double pct_user = 0.0, pct_sys = 0.0, pct_iow = 0.0, pct_irq = 0.0, pct_steal = 0.0;
   if (has_last_) {
     auto td = agg.total() - last_total_.total();
@@ -167,7 +170,7 @@ bool CpuCollector::sample(montauk::model::CpuSnapshot& out) {
   // Swap the reused parse buffer into last_per_ (no copy); the one remaining
   // copy fills the published snapshot's warm per_core vector.
   last_total_ = agg; last_per_.swap(per); has_last_ = true;
-  out.total_times = agg; out.per_core = last_per_; out.usage_pct = usage; out.per_core_pct = std::move(per_pct);
+  out.total_times = agg; out.per_core = last_per_; out.usage_pct = usage;
   out.pct_user = pct_user; out.pct_system = pct_sys; out.pct_iowait = pct_iow; out.pct_irq = pct_irq; out.pct_steal = pct_steal;
   out.ctxt_per_sec = ctxt_per_sec;
   out.intr_per_sec = intr_per_sec;
@@ -181,23 +184,27 @@ bool CpuCollector::sample(montauk::model::CpuSnapshot& out) {
     double mhz_sum = 0.0;
     int nfreq = 0;
     const size_t ncpu = out.per_core_pct.size();
-    // Path strings built once (rebuilt only if the core count changes); the
-    // MONTAUK_SYS_ROOT remap still happens per read inside read_file_string.
+    // Path strings built once, already MONTAUK_SYS_ROOT-mapped (rebuilt only
+    // if the core count changes), and read into one reused buffer.
     if (freq_paths_.size() != ncpu) {
       freq_paths_.clear();
       freq_paths_.reserve(ncpu);
       for (size_t c = 0; c < ncpu; ++c) {
-        freq_paths_.push_back("/sys/devices/system/cpu/cpu" + std::to_string(c) +
-                              "/cpufreq/scaling_cur_freq");
+        freq_paths_.push_back(montauk::util::map_sys_path(
+            "/sys/devices/system/cpu/cpu" + std::to_string(c) + "/cpufreq/scaling_cur_freq"));
       }
     }
     for (const auto& path : freq_paths_) {
-      auto f = montauk::util::read_file_string(path);
-      if (!f) continue;
-      try {
-        mhz_sum += std::stoul(*f) / 1000.0;
-        ++nfreq;
-      } catch (...) {}
+      if (!montauk::util::read_file_into(path.c_str(), freq_buf_)) continue;
+      const char* b = freq_buf_.data();
+      const char* e = b + freq_buf_.size();
+      while (b < e && (*b == ' ' || *b == '\t')) ++b;
+      unsigned long khz = 0;
+      auto [ptr, ec] = std::from_chars(b, e, khz);
+      (void)ptr;
+      if (ec != std::errc{}) continue;
+      mhz_sum += khz / 1000.0;
+      ++nfreq;
     }
     if (nfreq > 0) { out.has_freq = true; out.freq_avg_mhz = mhz_sum / nfreq; }
   }
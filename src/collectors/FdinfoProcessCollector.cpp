@@ -1,71 +1,70 @@
 #include "collectors/FdinfoProcessCollector.hpp"
 #include "util/Procfs.hpp"
 
-#include <string>
-#include <sstream>
-#include <cctype>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <string_view>
 
 using namespace std::chrono;
 
 namespace montauk::collectors {
 
-static bool is_number(const std::string& s) {
-  if (s.empty()) return false;
-  for (char c : s) if (!std::isdigit((unsigned char)c)) return false;
-  return true;
-}
-
 // Parse a single fdinfo content. Fills partial intel/amd counters and vram_kb if present.
-static void parse_fdinfo_text(const std::string& txt, FdinfoProcessCollector::IntelCycles& intel,
+// Walks the buffer as views: this runs for every DRM fd of every process each
+// cycle, and the per-line key/value strings the old stream parse built were
+// the bulk of this collector's allocations.
+static void parse_fdinfo_text(std::string_view txt, FdinfoProcessCollector::IntelCycles& intel,
                               FdinfoProcessCollector::AmdEngines& amd, uint64_t& vram_kb) {
-  std::istringstream ss(txt);
-  std::string line;
-  auto starts_with = [](const std::string& s, const char* p){ return s.rfind(p, 0) == 0; };
-  while (std::getline(ss, line)) {
-    // Strip trailing CR
-    if (!line.empty() && (line.back()=='\r' || line.back()=='\n')) line.pop_back();
+  auto trim = [](std::string_view v) {
+    while (!v.empty() && (v.front() == ' ' || v.front() == '\t')) v.remove_prefix(1);
+    while (!v.empty() && (v.back() == ' ' || v.back() == '\t' || v.back() == '\r')) v.remove_suffix(1);
+    return v;
+  };
+  // Leading integer of val; false when there is none (the old stoull threw).
+  auto num = [](std::string_view val, uint64_t& out) {
+    auto [p, ec] = std::from_chars(val.data(), val.data() + val.size(), out);
+    (void)p;
+    return ec == std::errc{};
+  };
+  size_t start = 0;
+  while (start < txt.size()) {
+    size_t end = txt.find('\n', start);
+    if (end == std::string_view::npos) end = txt.size();
+    std::string_view line = txt.substr(start, end - start);
+    start = end + 1;
     // split at ':'
     auto colon = line.find(':');
-    if (colon == std::string::npos) continue;
-    std::string key = line.substr(0, colon);
-    std::string val = line.substr(colon + 1);
-    auto ltrim = [](std::string& s){ while(!s.empty() && (s.front()==' '||s.front()=='\t')) s.erase(s.begin()); };
-    auto rtrim = [](std::string& s){ while(!s.empty() && (s.back()==' '||s.back()=='\t')) s.pop_back(); };
-    ltrim(key); rtrim(key); ltrim(val); rtrim(val);
+    if (colon == std::string_view::npos) continue;
+    std::string_view key = trim(line.substr(0, colon));
+    std::string_view val = trim(line.substr(colon + 1));
+    uint64_t v = 0;
 
     // Intel XE cycles
-    if (starts_with(key, "drm-cycles-")) {
-      uint64_t v = 0; try { v = std::stoull(val); } catch (...) { continue; }
+    if (key.starts_with("drm-cycles-")) {
+      if (!num(val, v)) continue;
       if (key == "drm-cycles-rcs") intel.cycles_rcs = v;
       else if (key == "drm-cycles-ccs") intel.cycles_ccs = v;
       else if (key == "drm-cycles-vcs") intel.cycles_vcs = v;
-    } else if (starts_with(key, "drm-total-cycles-")) {
-      uint64_t v = 0; try { v = std::stoull(val); } catch (...) { continue; }
+    } else if (key.starts_with("drm-total-cycles-")) {
+      if (!num(val, v)) continue;
       if (key == "drm-total-cycles-rcs") intel.total_rcs = v;
       else if (key == "drm-total-cycles-ccs") intel.total_ccs = v;
       else if (key == "drm-total-cycles-vcs") intel.total_vcs = v;
     }
     // AMD new engines (nanoseconds busy time)
     else if (key == "drm-engine-gfx" || key == "gfx") {
-      uint64_t v = 0; try { v = std::stoull(val); } catch (...) { continue; } amd.gfx_ns = v; }
+      if (num(val, v)) amd.gfx_ns = v; }
     else if (key == "drm-engine-compute" || key == "compute") {
-      uint64_t v = 0; try { v = std::stoull(val); } catch (...) { continue; } amd.compute_ns = v; }
+      if (num(val, v)) amd.compute_ns = v; }
     else if (key == "drm-engine-enc" || key == "enc") {
-      uint64_t v = 0; try { v = std::stoull(val); } catch (...) { continue; } amd.enc_ns = v; }
+      if (num(val, v)) amd.enc_ns = v; }
     else if (key == "drm-engine-dec" || key == "dec") {
-      uint64_t v = 0; try { v = std::stoull(val); } catch (...) { continue; } amd.dec_ns = v; }
+      if (num(val, v)) amd.dec_ns = v; }
     // Per-process VRAM (KiB)
     else if (key == "drm-memory-vram" || key == "vram mem") {
-      // Expect "<num> kB|KiB"
-      // Extract leading integer
-      size_t pos = 0; while (pos < val.size() && std::isspace((unsigned char)val[pos])) ++pos;
-      size_t end = pos; while (end < val.size() && std::isdigit((unsigned char)val[end])) ++end;
-      if (end > pos) {
-        try {
-          uint64_t kib = std::stoull(val.substr(pos, end-pos));
-          vram_kb = kib;
-        } catch (...) { /* ignore */ }
-      }
+      // Expect "<num> kB|KiB"; leading integer only
+      if (num(val, v)) vram_kb = v;
     }
   }
 }
@@ -76,22 +75,21 @@ bool FdinfoProcessCollector::sample(std::unordered_map<int,int>& pid_to_gpu,
   pid_to_gpu.clear(); pid_to_gpu_mem_kb.clear(); running_pids.clear();
   bool any = false;
   auto now = Clock::now();
-  for (const auto& pd : montauk::util::list_dir("/proc")) {
-    if (!is_number(pd)) continue;
-    int pid = std::strtol(pd.c_str(), nullptr, 10);
+  const auto& live = rd_.pids();
+  pids_.assign(live.begin(), live.end());
+  for (int pid : pids_) {
     // Enumerate fdinfo files
-    std::string fdinfo_dir = std::string("/proc/") + pd + "/fdinfo";
-    auto fds = montauk::util::list_dir(fdinfo_dir);
-    if (fds.empty()) continue;
+    if (!rd_.list_numeric(pid, "fdinfo", fds_) || fds_.empty()) continue;
     IntelCycles intel_acc{}; AmdEngines amd_acc{}; uint64_t vram_kb = 0;
     bool saw_drm = false;
-    for (const auto& fn : fds) {
-      if (!is_number(fn)) continue;
-      auto content_opt = montauk::util::read_file_string(fdinfo_dir + "/" + fn);
+    for (int32_t fd : fds_) {
+      char rel[64];
+      std::snprintf(rel, sizeof(rel), "%d/fdinfo/%d", pid, fd);
+      auto content_opt = rd_.read(rel);
       if (!content_opt) continue;
-      const auto& txt = *content_opt;
+      std::string_view txt = *content_opt;
       // Quick filter: skip if no DRM keys
-      if (txt.find("drm-") == std::string::npos && txt.find("gfx") == std::string::npos && txt.find("compute") == std::string::npos)
+      if (txt.find("drm-") == std::string_view::npos && txt.find("gfx") == std::string_view::npos && txt.find("compute") == std::string_view::npos)
         continue;
       saw_drm = true; any = true;
       IntelCycles intel_part{}; AmdEngines amd_part{}; uint64_t vram_kb_part = 0;
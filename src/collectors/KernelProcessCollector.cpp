@@ -306,7 +306,7 @@ bool KernelProcessCollector::recv_snapshot(montauk::model::ProcessSnapshot& out)
             }
 
             out.total_threads += (uint64_t)(ps.thread_count > 0 ? ps.thread_count : 1);
-            out.processes.push_back(std::move(ps));
+            rows_.push_back(std::move(ps));
         } else if (attr_type == MONTAUK_ATTR_PROC_COUNT) {
             out.total_processes = *(uint32_t*)((char*)nla + NLA_HDRLEN);
         }
@@ -318,7 +318,7 @@ bool KernelProcessCollector::recv_snapshot(montauk::model::ProcessSnapshot& out)
     // Update state for next delta calculation and prune stale cmdline cache entries
     std::unordered_map<int32_t, uint64_t> next_last;
     std::unordered_set<int32_t> alive_pids;
-    for (const auto& p : out.processes) {
+    for (const auto& p : rows_) {
         next_last[p.pid] = p.total_time;
         alive_pids.insert(p.pid);
     }
@@ -333,11 +333,11 @@ bool KernelProcessCollector::recv_snapshot(montauk::model::ProcessSnapshot& out)
     have_last_ = true;
 
     // Sort by CPU% (descending, stable on ties)
-    sublimation_order_f64(out.processes, true,
+    sublimation_order_f64(rows_, true,
                           [](const auto& p) { return p.cpu_pct; });
 
     // Resolve cmdline from /proc in userspace (cached, one-shot per PID)
-    for (auto& ps : out.processes) {
+    for (auto& ps : rows_) {
         if (ps.pid <= 0) continue;
         auto it = cmdline_cache_.find(ps.pid);
         if (it != cmdline_cache_.end()) {
@@ -353,14 +353,19 @@ bool KernelProcessCollector::recv_snapshot(montauk::model::ProcessSnapshot& out)
         }
     }
 
-    out.tracked_count = out.processes.size();
-    out.enriched_count = out.processes.size();
+    out.tracked_count = rows_.size();
+    out.enriched_count = rows_.size();
+    out.assign_rows(rows_);
 
     return true;
 }
 
 bool KernelProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
+    // Reset everything but the string pool, which outlives the frame.
+    auto strings = std::move(out.strings);
     out = {};
+    out.strings = std::move(strings);
+    rows_.clear();
 
     if (nl_sock_ < 0 || family_id_ < 0) {
         return false;
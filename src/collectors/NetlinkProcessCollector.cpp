@@ -2,8 +2,11 @@
 #include "collectors/ProcessParsing.hpp"
 #include "util/Procfs.hpp"
 #include "util/Churn.hpp"
+#include "util/Log.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
@@ -15,8 +18,9 @@
 
 namespace montauk::collectors {
 
-NetlinkProcessCollector::NetlinkProcessCollector(size_t max_procs, size_t enrich_top_n)
-  : max_procs_(max_procs), enrich_top_n_(enrich_top_n) {}
+NetlinkProcessCollector::NetlinkProcessCollector(size_t max_procs, size_t enrich_top_n,
+                                                 size_t scan_threads, size_t fd_cache, CpuClock clock)
+  : scan_(scan_threads), fds_(fd_cache), ids_(std::max<size_t>(4 * max_procs, 1024)), clock_(clock), max_procs_(max_procs), enrich_top_n_(enrich_top_n) {}
 
 NetlinkProcessCollector::~NetlinkProcessCollector() { shutdown(); }
 
@@ -44,13 +48,18 @@ bool NetlinkProcessCollector::init() {
   // Events only tell us about NEW processes from this point forward!
   {
     std::lock_guard<std::mutex> lk(active_mu_);
-    for (auto& name : montauk::util::list_dir("/proc")) {
-      if (name.empty() || name[0] < '0' || name[0] > '9') continue;
-      int32_t pid = std::strtol(name.c_str(), nullptr, 10);
+    for (int32_t pid : rd_.pids()) {
       if (pid > 0) active_pids_.insert(pid);
     }
+    population_ = active_pids_;
   }
 
+  // Exit accounting: taskstats when the kernel offers it, else the exiting
+  // leader's /proc stat read on its EXIT event (see handle_cn_msg).
+  if (!exits_.start())
+    montauk::util::log_info("taskstats exit records unavailable (%s); short-lived process CPU "
+                            "read from /proc at exit", std::strerror(errno));
+
   running_ = true;
   event_thread_ = std::thread([this]{ this->event_loop(); });
   return true;
@@ -73,6 +82,7 @@ void NetlinkProcessCollector::shutdown() {
     
     // Now thread should wake up and exit
     if (event_thread_.joinable()) event_thread_.join();
+    exits_.stop();
   }
 }
 
@@ -80,9 +90,15 @@ bool NetlinkProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
   // Snapshot active pids and drain hot set under lock (minimize hold time)
   std::vector<int32_t> all_pids;
   std::vector<int32_t> hot;
+  std::vector<int32_t> exited, execed;
+  std::vector<TreeEvent> tree_events;
   size_t rr = 0;
   {
     std::lock_guard<std::mutex> lk(active_mu_);
+    exited.swap(exited_);
+    tree_events.swap(tree_events_);
+    execed.swap(execed_);
+    exit_batch_.swap(exit_records_);
     all_pids.reserve(active_pids_.size());
     for (auto pid : active_pids_) all_pids.push_back(pid);
     hot.reserve(hot_pids_.size());
@@ -91,11 +107,31 @@ bool NetlinkProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
     rr = rr_cursor_;
   }
 
-  uint64_t cpu_total = read_cpu_total();
-  if (ncpu_ == 0) ncpu_ = read_cpu_count();
+  fds_.tick();
+  ids_.tick();
+  for (int32_t pid : exited) { fds_.invalidate(pid); ids_.invalidate(pid); }
+  for (int32_t pid : execed) ids_.invalidate(pid);
+  for (const auto& e : tree_events) {
+    if (e.fork) tree_.on_fork(e.parent, e.pid);
+    else tree_.on_exit(e.pid);
+  }
+
+  // Same accounting switch as ProcessCollector::sample.
+  if (clock_ == CpuClock::Schedstat && !clock_probed_) {
+    clock_probed_ = true;
+    if (!rd_.read_pid(static_cast<int32_t>(::getpid()), "schedstat")) {
+      montauk::util::log_warn("/proc/<pid>/schedstat unreadable (CONFIG_SCHED_INFO off?); "
+                              "process CPU falls back to clock ticks");
+      clock_ = CpuClock::Ticks;
+    }
+  }
+  const bool schedstat = clock_ == CpuClock::Schedstat;
+  uint64_t cpu_total = schedstat ? steady_ns() : read_cpu_total(rd_);
+  if (ncpu_ == 0) ncpu_ = read_cpu_count(rd_);
+  const unsigned pct_cpus = schedstat ? 1u : ncpu_;
   const uint64_t page_kb = static_cast<uint64_t>(getpagesize() / 1024);
 
-  out.processes.clear(); out.total_processes = 0; out.running_processes = 0; out.state_running=0; out.state_sleeping=0; out.state_zombie=0;
+  rows_.clear(); out.total_processes = 0; out.running_processes = 0; out.state_running=0; out.state_sleeping=0; out.state_zombie=0;
   out.total_threads=0;
 
   std::unordered_map<int32_t, uint64_t> last_snapshot;
@@ -110,6 +146,22 @@ bool NetlinkProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
     }
   }
 
+  // Processes that exited without ever being part of the active population
+  // at a sample lived entirely between two samples: their time never reached
+  // a row, so it goes to the per-comm rollup instead. Membership is the
+  // population, not last_snapshot: the scan is budgeted, so a long-lived
+  // process it skipped last tick must not land here with its whole lifetime.
+  {
+    exits_.drain(exit_batch_);
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto& e : exit_batch_) {
+      if (population_.count(e.tgid)) continue;
+      exit_rollup_.add(e.comm, e.cpu_us, e.rss_kb, e.io_bytes, now);
+    }
+    exit_batch_.clear();
+    exit_rollup_.publish(out.exited, now);
+  }
+
   // Build candidate set within sampling budget: last top-K, hot events, then RR fill
   std::vector<int32_t> candidates; candidates.reserve(std::min(sample_budget_, all_pids.size()));
   std::unordered_set<int32_t> selected;
@@ -145,81 +197,126 @@ bool NetlinkProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
     rr_cursor_ = (rr + 1) % all_pids.size();
   }
 
-  for (int32_t pid : candidates) {
-    auto stat_path = std::string("/proc/") + std::to_string(pid) + "/stat";
-    auto cached_comm = [&](){
-      std::lock_guard<std::mutex> lk(active_mu_);
-      auto it = pid_to_comm_.find(pid);
-      if (it != pid_to_comm_.end() && !it->second.empty()) return it->second;
-      return std::string();
-    }();
-    auto content_opt = montauk::util::read_file_string(stat_path);
+  // Only the failure paths want the EXEC/COMM cache, so it is looked up there
+  // rather than copied out under the lock for every candidate.
+  auto cached_comm = [&](int32_t pid) {
+    std::lock_guard<std::mutex> lk(active_mu_);
+    auto it = pid_to_comm_.find(pid);
+    if (it != pid_to_comm_.end() && !it->second.empty()) return it->second;
+    return std::string();
+  };
+
+  out.scan_shards = scan_.run(candidates, rows_, out, [&](ShardedScan::Shard& sh, int32_t pid) {
+    // Lookup-only on the fd cache: the shards never change its structure.
+    auto content_opt = fds_.read_cached(sh.rd, pid, montauk::util::PidFdCache::Stat);
+    if (!content_opt) content_opt = sh.rd.read_pid(pid, "stat");
     if (!content_opt) {
       // Likely exited; record churn and surface placeholder row so UI can flag it.
       montauk::util::note_churn(montauk::util::ChurnKind::Proc);
       montauk::model::ProcSample ps;
       ps.pid = pid;
       ps.churn_reason = montauk::model::ChurnReason::ReadFailed;
-      ps.cmd = !cached_comm.empty() ? cached_comm : std::to_string(pid);
-      out.processes.push_back(std::move(ps));
-      continue;
+      auto cached = cached_comm(pid);
+      ps.cmd = !cached.empty() ? std::move(cached) : std::to_string(pid);
+      sh.rows.push_back(std::move(ps));
+      return;
     }
 
-    uint64_t ut=0, st=0; int64_t rssp=0; std::string comm; char stch='?';
-    uint64_t minflt=0, majflt=0; int nthreads=1;
-    if (!parse_stat_line(*content_opt, stch, ut, st, rssp, comm, minflt, majflt, nthreads)) {
+    uint64_t ut=0, st=0; int64_t rssp=0; char stch='?';
+    uint64_t minflt=0, majflt=0, start=0; int nthreads=1; int32_t ppid=0;
+    if (!parse_stat_line(*content_opt, stch, ut, st, rssp, sh.comm, minflt, majflt, nthreads, &start, &ppid)) {
       montauk::util::note_churn(montauk::util::ChurnKind::Proc);
       montauk::model::ProcSample ps;
       ps.pid = pid;
       ps.churn_reason = montauk::model::ChurnReason::ReadFailed;
-      ps.cmd = !comm.empty() ? comm : (!cached_comm.empty() ? cached_comm : std::to_string(pid));
-      out.processes.push_back(std::move(ps));
-      continue;
+      auto cached = cached_comm(pid);
+      ps.cmd = !sh.comm.empty() ? sh.comm : (!cached.empty() ? std::move(cached) : std::to_string(pid));
+      sh.rows.push_back(std::move(ps));
+      return;
     }
 
-    const uint64_t total_proc = ut + st;
+    uint64_t total_proc = ut + st;
+    if (schedstat) {
+      auto ns = read_process_run_ns(sh.rd, pid, nthreads, sh.tids);
+      if (!ns) {  // exited since its stat was read
+        montauk::util::note_churn(montauk::util::ChurnKind::Proc);
+        montauk::model::ProcSample ps;
+        ps.pid = pid;
+        ps.churn_reason = montauk::model::ChurnReason::ReadFailed;
+        ps.cmd = sh.comm;
+        sh.rows.push_back(std::move(ps));
+        return;
+      }
+      total_proc = *ns;
+    }
     double cpu_pct = 0.0;
     if (have_last_snapshot) {
       auto it = last_snapshot.find(pid);
       const uint64_t lastp = (it==last_snapshot.end()) ? total_proc : it->second;
       const uint64_t dp = (total_proc > lastp) ? (total_proc - lastp) : 0;
       const uint64_t dt = (cpu_total > last_cpu_total_snapshot) ? (cpu_total - last_cpu_total_snapshot) : 0;
-      if (dt > 0) cpu_pct = (100.0 * static_cast<double>(dp) / static_cast<double>(dt)) * static_cast<double>(ncpu_);
+      if (dt > 0) cpu_pct = (100.0 * static_cast<double>(dp) / static_cast<double>(dt)) * static_cast<double>(pct_cpus);
     }
 
     montauk::model::ProcSample ps; ps.pid = pid;
     ps.total_time = total_proc;
     ps.rss_kb = (rssp > 0 ? static_cast<uint64_t>(rssp) * page_kb : 0);
-    ps.cpu_pct = cpu_pct; ps.cmd = comm; // exe/command/user enriched after top-K below
-    ps.flt_raw = minflt + majflt; ps.thread_count = nthreads;
-    out.processes.push_back(std::move(ps));
-    if (stch == 'R') out.state_running++;
-    else if (stch == 'S' || stch == 'D') out.state_sleeping++;
-    else if (stch == 'Z') out.state_zombie++;
-  }
+    ps.cpu_pct = cpu_pct; ps.cmd = sh.comm; // exe/command/user enriched after top-K below
+    ps.flt_raw = minflt + majflt; ps.thread_count = nthreads; ps.start_time = start; ps.ppid = ppid;
+    sh.rows.push_back(std::move(ps));
+    sh.count_state(stch);
+  });
 
-  out.total_processes = out.processes.size();
+  out.total_processes = rows_.size();
   out.running_processes = out.state_running;
   // Baseline EVERY scanned pid before reducing to the top-K (see
   // ProcessCollector): capturing only the survivors made a process outside the
   // initial top-K read 0% forever and never surface.
   std::unordered_map<int32_t, uint64_t> next_last;
-  next_last.reserve(out.processes.size());
-  for (const auto& p : out.processes) next_last[p.pid] = p.total_time;
-  top_k_by_cpu_pct(out.processes, max_procs_);
+  next_last.reserve(rows_.size());
+  for (const auto& p : rows_) next_last[p.pid] = p.total_time;
+  // The scan covers a budgeted subset, so only a cached pid it did read can be
+  // judged: dropped if the read failed or found a recycled pid. Exits arrive
+  // through exited_ above; a hot pid outside the scan ages out of the LRU.
+  {
+    std::unordered_map<int32_t, uint64_t> seen_start;
+    seen_start.reserve(rows_.size());
+    for (const auto& p : rows_) seen_start[p.pid] = p.start_time;
+    auto recycled = [&](int32_t pid, uint64_t start) {
+      auto it = seen_start.find(pid);
+      return it != seen_start.end() && it->second != start;
+    };
+    if (fds_.enabled()) fds_.sweep(recycled);
+    ids_.sweep(recycled);
+  }
+  // Rows are this tick's candidates; the active set is the population.
+  tree_.refresh(rows_, all_pids);
+  top_k_by_cpu_pct(rows_, max_procs_);
 
   // Enrich survivors only: exe_path for every kept row (Security scans the
-  // whole published set), command/user for the top N
-  out.tracked_count = out.processes.size();
-  for (auto& ps : out.processes) {
-    if (ps.churn_reason == montauk::model::ChurnReason::None)
-      ps.exe_path = read_exe_path(ps.pid);
+  // whole published set), command/user for the top N. Each is read once per
+  // process image (ids_; see ProcessCollector::sample).
+  out.tracked_count = rows_.size();
+  for (auto& ps : rows_) {
+    if (ps.churn_reason != montauk::model::ChurnReason::None) continue;
+    auto& id = ids_.at(ps.pid, ps.start_time, ps.cmd);
+    if (id.exe) { ps.exe_path = *id.exe; continue; }
+    read_exe_path(rd_, ps.pid, ps.exe_path);
+    id.exe = ids_.intern(ps.exe_path);
   }
-  size_t enrich_n = std::min<size_t>(out.processes.size(), enrich_top_n_);
+  size_t enrich_n = std::min<size_t>(rows_.size(), enrich_top_n_);
   out.enriched_count = enrich_n;
   for (size_t i = 0; i < enrich_n; ++i) {
-    auto& ps = out.processes[i];
-    
+    auto& ps = rows_[i];
+    auto* id = ps.churn_reason == montauk::model::ChurnReason::None ? &ids_.at(ps.pid, ps.start_time, ps.cmd) : nullptr;
+    if (ps.start_time) fds_.open(rd_, ps.pid, ps.start_time, montauk::util::PidFdCache::Stat);
+    if (id && id->cmd && id->user) {
+      if (!id->cmd->empty()) ps.cmd = *id->cmd;
+      ps.user_name = *id->user;
+      out.total_threads += ps.thread_count;
+      continue;
+    }
+
     // Try command from EXEC/COMM cache first, fall back to /proc/cmdline
     bool need_cmdline = true;
     {
@@ -233,26 +330,27 @@ bool NetlinkProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
     }
     
     if (need_cmdline) {
-      auto cmd = read_cmdline(ps.pid);
+      auto cmd = read_cmdline(rd_, fds_, ps.pid, ps.start_time);
       if (!cmd.empty()) { cap_cmdline(cmd); ps.cmd = std::move(cmd); }
     }
     
     // User name and thread count from /proc/[pid]/status
-    auto info = info_from_status(ps.pid);
+    auto info = info_from_status(rd_, fds_, ps.pid, ps.start_time);
+    if (id && !info.user.empty()) { id->cmd = ids_.intern(ps.cmd); id->user = ids_.intern(info.user); }
     if (!info.user.empty()) ps.user_name = std::move(info.user);
     out.total_threads += info.thread_count;
   }
   
   // For non-enriched processes, estimate 1 thread each (conservative)
-  if (out.processes.size() > enrich_n) {
-    out.total_threads += (out.processes.size() - enrich_n);
+  if (rows_.size() > enrich_n) {
+    out.total_threads += (rows_.size() - enrich_n);
   }
 
   // The cpu% baseline (next_last) was captured over the full scan above; here
   // just remember the last published top-K for the active-set re-scan.
   std::vector<int32_t> next_top;
-  next_top.reserve(out.processes.size());
-  for (const auto& p : out.processes) next_top.push_back(p.pid);
+  next_top.reserve(rows_.size());
+  for (const auto& p : rows_) next_top.push_back(p.pid);
   {
     std::lock_guard<std::mutex> lk(active_mu_);
     last_per_proc_ = std::move(next_last);
@@ -260,6 +358,8 @@ bool NetlinkProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
     have_last_ = true;
     last_top_ = std::move(next_top);
   }
+  population_ = std::move(active_lookup);
+  out.assign_rows(rows_);
   return true;
 }
 
@@ -293,31 +393,60 @@ void NetlinkProcessCollector::handle_cn_msg(void* cn_msg_ptr, ssize_t /*len*/) {
 
   std::lock_guard<std::mutex> lk(active_mu_);
   switch (ev->what) {
-    case PROC_EVENT_FORK:
-      active_pids_.insert(ev->event_data.fork.child_pid);
-      hot_pids_.insert(ev->event_data.fork.child_pid);
+    case PROC_EVENT_FORK: {
+      const auto& f = ev->event_data.fork;
+      active_pids_.insert(f.child_pid);
+      hot_pids_.insert(f.child_pid);
+      // A new thread is not a new node; only a new thread group is.
+      if (f.child_pid == f.child_tgid)
+        tree_events_.push_back({true, static_cast<int32_t>(f.parent_tgid), static_cast<int32_t>(f.child_pid)});
       break;
+    }
     case PROC_EVENT_EXEC: {
       int32_t pid = ev->event_data.exec.process_pid;
       active_pids_.insert(pid);
       hot_pids_.insert(pid);
       // Update cached command best-effort
-      auto cmd = read_cmdline(pid);
+      auto cmd = read_cmdline(ev_rd_, pid);
       if (cmd.empty()) {
-        // Try comm as a fallback (mapped reader honors MONTAUK_PROC_ROOT)
-        auto comm = montauk::util::read_file_string("/proc/" + std::to_string(pid) + "/comm");
-        if (comm) {
-          cmd = *comm;
-          if (auto nl = cmd.find('\n'); nl != std::string::npos) cmd.resize(nl);
+        // Try comm as a fallback (the reader honors MONTAUK_PROC_ROOT)
+        if (auto comm = ev_rd_.read_pid(pid, "comm")) {
+          std::string_view v = *comm;
+          if (auto nl = v.find('\n'); nl != std::string_view::npos) v = v.substr(0, nl);
+          cmd.assign(v);
         }
       }
       if (!cmd.empty()) pid_to_comm_[pid] = std::move(cmd);
+      execed_.push_back(pid);
       break;
     }
-    case PROC_EVENT_EXIT:
-      active_pids_.erase(ev->event_data.exit.process_pid);
-      pid_to_comm_.erase(ev->event_data.exit.process_pid);
+    case PROC_EVENT_EXIT: {
+      const int32_t pid = ev->event_data.exit.process_pid;
+      // Without taskstats, the leader's stat is the exit record: the event
+      // fires in do_exit, and the task stays readable until it is reaped --
+      // usually long enough, though an auto-reaped child can be gone first.
+      // Its mm is already released, so there is no RSS, and no I/O either.
+      if (pid == ev->event_data.exit.process_tgid && !exits_.running() &&
+          exit_records_.size() < TaskstatsListener::kMaxPending) {
+        if (auto stat = ev_rd_.read_pid(pid, "stat")) {
+          uint64_t ut = 0, st = 0, minflt = 0, majflt = 0;
+          int64_t rssp = 0;
+          char state = '?';
+          int nthreads = 1;
+          std::string comm;
+          if (parse_stat_line(*stat, state, ut, st, rssp, comm, minflt, majflt, nthreads)) {
+            static const long hz = [] { long v = ::sysconf(_SC_CLK_TCK); return v > 0 ? v : 100; }();
+            exit_records_.push_back(TaskExit{pid, std::move(comm),
+                                             (ut + st) * 1'000'000 / static_cast<uint64_t>(hz), 0, 0});
+          }
+        }
+      }
+      active_pids_.erase(pid);
+      pid_to_comm_.erase(pid);
+      exited_.push_back(pid);
+      if (pid == ev->event_data.exit.process_tgid) tree_events_.push_back({false, 0, pid});
       break;
+    }
     case PROC_EVENT_COMM: {
       int32_t pid = ev->event_data.comm.process_pid;
       active_pids_.insert(pid);
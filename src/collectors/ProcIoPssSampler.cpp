@@ -0,0 +1,143 @@
+#include "collectors/ProcIoPssSampler.hpp"
+#include "collectors/ProcessParsing.hpp"
+
+#include <algorithm>
+#include <charconv>
+
+namespace montauk::collectors {
+
+namespace {
+
+uint64_t leading_u64(std::string_view t) {
+  while (!t.empty() && t.front() == ' ') t.remove_prefix(1);
+  uint64_t v = 0;
+  (void)std::from_chars(t.data(), t.data() + t.size(), v);
+  return v;
+}
+
+uint32_t age_ms(uint64_t now_ns, uint64_t then_ns) {
+  if (then_ns == 0) return montauk::model::kAgeNever;
+  const uint64_t ms = now_ns > then_ns ? (now_ns - then_ns) / 1'000'000 : 0;
+  return static_cast<uint32_t>(std::min<uint64_t>(ms, montauk::model::kAgeNever - 1));
+}
+
+}  // namespace
+
+std::optional<ProcIoCounters> parse_proc_io(std::string_view text) {
+  ProcIoCounters c;
+  bool have_r = false, have_w = false;
+  while (!text.empty()) {
+    const size_t nl = text.find('\n');
+    const std::string_view line = text.substr(0, nl);
+    text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+    if (line.starts_with("read_bytes:")) { c.read_bytes = leading_u64(line.substr(11)); have_r = true; }
+    else if (line.starts_with("write_bytes:")) { c.write_bytes = leading_u64(line.substr(12)); have_w = true; }
+  }
+  if (!have_r || !have_w) return std::nullopt;
+  return c;
+}
+
+std::optional<uint64_t> parse_smaps_rollup_pss_kb(std::string_view text) {
+  while (!text.empty()) {
+    const size_t nl = text.find('\n');
+    const std::string_view line = text.substr(0, nl);
+    text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+    if (line.starts_with("Pss:")) return leading_u64(line.substr(4));
+  }
+  return std::nullopt;
+}
+
+void ProcIoPssSampler::visit(Entry& e, int32_t pid, uint64_t deadline) {
+  if (auto txt = rd_.read_pid(pid, "io")) {
+    ++last_reads_;
+    if (auto io = parse_proc_io(*txt)) {
+      const uint64_t t = steady_ns();
+      // Counters that went backwards belong to some other process (a pid
+      // recycled within one start-time tick); take no rate from them.
+      if (e.io_ns != 0 && t > e.io_ns && io->read_bytes >= e.read_bytes && io->write_bytes >= e.write_bytes) {
+        const double dt = static_cast<double>(t - e.io_ns) / 1e9;
+        e.read_bps = static_cast<double>(io->read_bytes - e.read_bytes) / dt;
+        e.write_bps = static_cast<double>(io->write_bytes - e.write_bytes) / dt;
+        e.rate_ns = t;
+      }
+      e.read_bytes = io->read_bytes;
+      e.write_bytes = io->write_bytes;
+      e.io_ns = t;
+    }
+  }
+  const uint64_t now = steady_ns();
+  const uint64_t refresh_ns = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(kPssRefresh).count());
+  if (now >= deadline || (e.pss_ns != 0 && now - e.pss_ns < refresh_ns)) return;
+  if (auto txt = rd_.read_pid(pid, "smaps_rollup")) {
+    ++last_reads_;
+    if (auto pss = parse_smaps_rollup_pss_kb(*txt)) {
+      e.pss_kb = *pss;
+      e.pss_ns = steady_ns();
+    }
+  }
+}
+
+void ProcIoPssSampler::sample(montauk::model::ProcessSnapshot& procs) {
+  const size_t n = procs.size();
+  const uint64_t start = steady_ns();
+  const uint64_t deadline = start + budget_ns_;
+  ++gen_;
+  last_reads_ = 0;
+  last_budget_hit_ = false;
+
+  auto entry_for = [&](size_t i) -> Entry& {
+    Entry& e = cache_[procs.pid[i]];
+    if (e.gen == 0 || e.start_time != procs.start_time[i]) e = Entry{procs.start_time[i]};
+    e.gen = gen_;
+    return e;
+  };
+  auto out_of_budget = [&] {
+    if (steady_ns() < deadline) return false;
+    last_budget_hit_ = true;
+    return true;
+  };
+
+  // Every row is stamped with this tick's generation first, so the sweep
+  // below keeps exactly the live population, visited or not.
+  for (size_t i = 0; i < n; ++i) (void)entry_for(i);
+
+  const size_t top = std::min(top_k_, n);
+  for (size_t i = 0; i < top && !out_of_budget(); ++i) visit(entry_for(i), procs.pid[i], deadline);
+  rr_order_.clear();
+  for (size_t i = top; i < n; ++i) rr_order_.emplace_back(procs.pid[i], i);
+  if (!rr_order_.empty()) {
+    std::sort(rr_order_.begin(), rr_order_.end());
+    const size_t rest = rr_order_.size();
+    // Resume at the first pid after the last one visited; a pid that has
+    // since exited needs no special case.
+    const size_t rr = static_cast<size_t>(
+        std::upper_bound(rr_order_.begin(), rr_order_.end(), std::pair{rr_last_pid_, SIZE_MAX}) -
+        rr_order_.begin());
+    const size_t limit = std::min(rest, rotate_max_);
+    for (size_t taken = 0; taken < limit && !out_of_budget(); ++taken) {
+      const auto [pid, i] = rr_order_[(rr + taken) % rest];
+      visit(entry_for(i), pid, deadline);
+      rr_last_pid_ = pid;
+    }
+  }
+
+  std::erase_if(cache_, [&](const auto& kv) { return kv.second.gen != gen_; });
+
+  const uint64_t now = steady_ns();
+  procs.io_read_bps.assign(n, 0.0);
+  procs.io_write_bps.assign(n, 0.0);
+  procs.io_age_ms.assign(n, montauk::model::kAgeNever);
+  procs.pss_kb.assign(n, 0);
+  procs.pss_age_ms.assign(n, montauk::model::kAgeNever);
+  for (size_t i = 0; i < n; ++i) {
+    const Entry& e = cache_[procs.pid[i]];
+    procs.io_read_bps[i] = e.read_bps;
+    procs.io_write_bps[i] = e.write_bps;
+    procs.io_age_ms[i] = age_ms(now, e.rate_ns);
+    procs.pss_kb[i] = e.pss_kb;
+    procs.pss_age_ms[i] = age_ms(now, e.pss_ns);
+  }
+}
+
+} // namespace montauk::collectors
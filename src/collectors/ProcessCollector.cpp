@@ -4,11 +4,85 @@
 #include <algorithm>
 #include <unistd.h>
 #include "util/Churn.hpp"
+#include "util/Log.hpp"
 
 namespace montauk::collectors {
 
-ProcessCollector::ProcessCollector(unsigned min_interval_ms, size_t max_procs, size_t enrich_top_n)
-  : min_interval_ms_(min_interval_ms), max_procs_(max_procs), enrich_top_n_(enrich_top_n) {}
+ProcessCollector::ProcessCollector(unsigned min_interval_ms, size_t max_procs, size_t enrich_top_n,
+                                   size_t scan_threads, size_t fd_cache, CpuClock clock)
+  : fds_(fd_cache), ids_(std::max<size_t>(4 * max_procs, 1024)), scan_(scan_threads), min_interval_ms_(min_interval_ms), max_procs_(max_procs), enrich_top_n_(enrich_top_n), clock_(clock) {}
+
+bool ProcessCollector::parse_stat_row(ShardedScan::Shard& sh, const ScanCtx& c, int32_t pid,
+                                      std::optional<std::string_view> stat,
+                                      std::optional<std::string_view> sched) const {
+  if (!stat) {
+    // Record churn and emit a placeholder row so the user sees it happened
+    montauk::util::note_churn(montauk::util::ChurnKind::Proc);
+    montauk::model::ProcSample ps; ps.pid = pid; ps.total_time=0; ps.rss_kb=0; ps.cpu_pct=0.0; ps.churn_reason = montauk::model::ChurnReason::ReadFailed; ps.cmd = std::to_string(pid);
+    sh.rows.push_back(std::move(ps));
+    return false;
+  }
+  uint64_t ut=0, st=0; int64_t rssp=0;
+  uint64_t minflt=0, majflt=0; int nthreads=1;
+  char stch='?'; uint64_t start=0; int32_t ppid=0;
+  if (!parse_stat_line(*stat, stch, ut, st, rssp, sh.comm, minflt, majflt, nthreads, &start, &ppid)) {
+    montauk::util::note_churn(montauk::util::ChurnKind::Proc);
+    montauk::model::ProcSample ps; ps.pid = pid; ps.total_time=0; ps.rss_kb=0; ps.cpu_pct=0.0; ps.churn_reason = montauk::model::ChurnReason::ReadFailed; ps.cmd = sh.comm.empty()? std::to_string(pid) : sh.comm;
+    sh.rows.push_back(std::move(ps));
+    return false;
+  }
+  uint64_t total_proc = ut + st;
+  if (c.schedstat) {
+    auto ns = (sched && nthreads <= 1) ? parse_schedstat_run_ns(*sched)
+                                       : read_process_run_ns(sh.rd, pid, nthreads, sh.tids);
+    if (!ns) {  // exited since its stat was read
+      montauk::util::note_churn(montauk::util::ChurnKind::Proc);
+      montauk::model::ProcSample ps; ps.pid = pid; ps.churn_reason = montauk::model::ChurnReason::ReadFailed; ps.cmd = sh.comm;
+      sh.rows.push_back(std::move(ps));
+      return false;
+    }
+    total_proc = *ns;
+  }
+  double cpu_pct = 0.0;
+  if (c.have_last) {
+    auto it = std::lower_bound(last_per_proc_.begin(), last_per_proc_.end(), pid,
+                               [](const Baseline& e, int32_t p) { return e.pid < p; });
+    uint64_t lastp = (it != last_per_proc_.end() && it->pid == pid) ? it->total_time : total_proc;
+    uint64_t dp = (total_proc > lastp) ? (total_proc - lastp) : 0;
+    uint64_t dt = (c.cpu_total > c.last_cpu_total) ? (c.cpu_total - c.last_cpu_total) : 0;
+    if (dt>0) cpu_pct = (100.0 * static_cast<double>(dp) / static_cast<double>(dt)) * static_cast<double>(c.ncpu);
+  }
+  montauk::model::ProcSample ps; ps.pid=pid; ps.total_time=total_proc; ps.rss_kb = (rssp>0 ? static_cast<uint64_t>(rssp)*c.page_kb : 0);
+  ps.cpu_pct = cpu_pct; ps.cmd = sh.comm; // exe/command/user enriched after top-K below
+  ps.flt_raw = minflt + majflt; ps.thread_count = nthreads; ps.start_time = start; ps.ppid = ppid;
+  sh.rows.push_back(std::move(ps));
+  sh.count_state(stch);
+  return true;
+}
+
+// Sharded (see ShardedScan). Each task reads through its own shard's reader
+// and touches only shared state that is read-only here: the previous baseline
+// and the ScanCtx.
+size_t ProcessCollector::scan(std::span<const int32_t> pids, const ScanCtx& c,
+                              std::vector<montauk::model::ProcSample>& rows,
+                              montauk::model::ProcessSnapshot& out) {
+  return scan_.run(pids, rows, out, [&](ShardedScan::Shard& sh, int32_t pid) {
+    // Hot pids (last cycle's enriched rows) re-read through their cached fds;
+    // lookups only, so the shards never touch the cache's structure.
+    auto stat = fds_.read_cached(sh.rd, pid, montauk::util::PidFdCache::Stat);
+    if (!stat) stat = sh.rd.read_pid(pid, "stat");
+    if (!parse_stat_row(sh, c, pid, stat)) return;
+    // All-process, not top-K: the fusion below is cross-POPULATION, so a feature
+    // present for only the visible rows would compare a process against a
+    // sample rather than against its peers.
+    auto status = fds_.read_cached(sh.rd, pid, montauk::util::PidFdCache::Status);
+    if (!status) status = sh.rd.read_pid(pid, "status");
+    if (status) {
+      auto cs = parse_ctx_switches(*status);
+      sh.rows.back().vctx_raw = cs.voluntary; sh.rows.back().nvctx_raw = cs.involuntary;
+    }
+  });
+}
 
 bool ProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
   auto now = std::chrono::steady_clock::now();
@@ -19,96 +93,93 @@ bool ProcessCollector::sample(montauk::model::ProcessSnapshot& out) {
     }
   }
   last_run_ = now;
+  fds_.tick();
+  ids_.tick();
 
-  uint64_t cpu_total = read_cpu_total();
-  if (ncpu_ == 0) ncpu_ = read_cpu_count();
+  if (clock_ == CpuClock::Schedstat && !clock_probed_) {
+    clock_probed_ = true;
+    if (!rd_.read_pid(static_cast<int32_t>(::getpid()), "schedstat")) {
+      montauk::util::log_warn("/proc/<pid>/schedstat unreadable (CONFIG_SCHED_INFO off?); "
+                              "process CPU falls back to clock ticks");
+      clock_ = CpuClock::Ticks;
+    }
+  }
+  const bool schedstat = clock_ == CpuClock::Schedstat;
+  uint64_t cpu_total = schedstat ? steady_ns() : read_cpu_total(rd_);
+  if (ncpu_ == 0) ncpu_ = read_cpu_count(rd_);
   const uint64_t page_kb = static_cast<uint64_t>(getpagesize() / 1024);
-  out.processes.clear(); out.total_processes=0; out.running_processes=0; out.state_running=0; out.state_sleeping=0; out.state_zombie=0;
+  rows_.clear(); out.total_processes=0; out.running_processes=0; out.state_running=0; out.state_sleeping=0; out.state_zombie=0;
   out.total_threads=0;
 
-  for (auto& name : montauk::util::list_dir("/proc")) {
-    if (name.empty() || name[0]<'0' || name[0]>'9') continue; // numeric
-    int32_t pid = std::strtol(name.c_str(), nullptr, 10);
-    auto stat_path = std::string("/proc/")+name+"/stat";
-    std::optional<std::string> content_opt;
-    try { content_opt = montauk::util::read_file_string(stat_path); }
-    catch(...) { content_opt = std::nullopt; }
-    if (!content_opt) {
-      // Record churn and emit a placeholder row so the user sees it happened
-      montauk::util::note_churn(montauk::util::ChurnKind::Proc);
-      montauk::model::ProcSample ps; ps.pid = pid; ps.total_time=0; ps.rss_kb=0; ps.cpu_pct=0.0; ps.churn_reason = montauk::model::ChurnReason::ReadFailed; ps.cmd = name;
-      out.processes.push_back(std::move(ps));
-      continue;
-    }
-    uint64_t ut=0, st=0; int64_t rssp=0; std::string comm;
-    uint64_t minflt=0, majflt=0; int nthreads=1;
-    char stch='?';
-    if (!parse_stat_line(*content_opt, stch, ut, st, rssp, comm, minflt, majflt, nthreads)) {
-      montauk::util::note_churn(montauk::util::ChurnKind::Proc);
-      montauk::model::ProcSample ps; ps.pid = pid; ps.total_time=0; ps.rss_kb=0; ps.cpu_pct=0.0; ps.churn_reason = montauk::model::ChurnReason::ReadFailed; ps.cmd = comm.empty()? name : comm;
-      out.processes.push_back(std::move(ps));
-      continue;
-    }
-    uint64_t total_proc = ut + st;
-    double cpu_pct = 0.0;
-    if (have_last_) {
-      auto it = last_per_proc_.find(pid);
-      uint64_t lastp = (it==last_per_proc_.end()) ? total_proc : it->second;
-      uint64_t dp = (total_proc > lastp) ? (total_proc - lastp) : 0;
-      uint64_t dt = (cpu_total > last_cpu_total_) ? (cpu_total - last_cpu_total_) : 0;
-      if (dt>0) cpu_pct = (100.0 * static_cast<double>(dp) / static_cast<double>(dt)) * static_cast<double>(ncpu_);
-    }
-    montauk::model::ProcSample ps; ps.pid=pid; ps.total_time=total_proc; ps.rss_kb = (rssp>0 ? static_cast<uint64_t>(rssp)*page_kb : 0);
-    ps.cpu_pct = cpu_pct; ps.cmd = comm; // exe/command/user enriched after top-K below
-    ps.flt_raw = minflt + majflt; ps.thread_count = nthreads;
-    // All-process, not top-K: the fusion below is cross-POPULATION, so a feature
-    // present for only the visible rows would compare a process against a
-    // sample rather than against its peers.
-    {
-      auto cs = montauk::collectors::ctx_switches_from_status(pid);
-      ps.vctx_raw = cs.voluntary; ps.nvctx_raw = cs.involuntary;
-    }
-    out.processes.push_back(std::move(ps));
-    // Count process states
-    if (stch == 'R') out.state_running++;
-    else if (stch == 'S' || stch == 'D') out.state_sleeping++;
-    else if (stch == 'Z') out.state_zombie++;
-  }
-  out.total_processes = out.processes.size();
+  // Parse phase (see scan())
+  const auto& live = rd_.pids();
+  pids_.assign(live.begin(), live.end());
+  const ScanCtx ctx{have_last_, cpu_total, last_cpu_total_, page_kb, schedstat ? 1u : ncpu_, schedstat};
+  out.scan_shards = scan(pids_, ctx, rows_, out);
+  out.total_processes = rows_.size();
   out.running_processes = out.state_running;
   // Baseline EVERY scanned pid before reducing to the top-K, so a process that
   // is quiet now but spikes later still has a prior sample to diff against.
   // Capturing only the survivors (below the top_k call) made any process outside
-  // the initial top-K read 0% forever and never surface.
-  last_per_proc_.clear();
-  for (auto& p : out.processes) last_per_proc_[p.pid] = p.total_time;
+  // the initial top-K read 0% forever and never surface. /proc lists tgids in
+  // ascending order, so the sort is a verification pass in the common case.
+  next_per_proc_.clear();
+  for (auto& p : rows_) next_per_proc_.push_back({p.pid, p.total_time, p.start_time});
+  if (!std::is_sorted(next_per_proc_.begin(), next_per_proc_.end()))
+    std::sort(next_per_proc_.begin(), next_per_proc_.end());
+  last_per_proc_.swap(next_per_proc_);
+  // Cached fds and identities of pids that exited (or whose read failed,
+  // start_time 0) or were recycled since they were cached.
+  auto gone = [&](int32_t pid, uint64_t start) {
+    auto it = std::lower_bound(last_per_proc_.begin(), last_per_proc_.end(), pid,
+                               [](const Baseline& e, int32_t p) { return e.pid < p; });
+    return it == last_per_proc_.end() || it->pid != pid || it->start_time != start;
+  };
+  fds_.sweep(gone);
+  ids_.sweep(gone);
   last_cpu_total_ = cpu_total; have_last_ = true;
-  top_k_by_cpu_pct(out.processes, max_procs_);
+  tree_.refresh(rows_);
+  top_k_by_cpu_pct(rows_, max_procs_);
   // enrich survivors only: exe_path for every kept row (Security scans the
-  // whole published set), cmdline/user/threads for the top N
-  out.tracked_count = out.processes.size();
-  for (auto& ps : out.processes) {
-    if (ps.churn_reason == montauk::model::ChurnReason::None)
-      ps.exe_path = read_exe_path(ps.pid);
+  // whole published set), cmdline/user/threads for the top N. All three are
+  // fixed at exec, so each is read once per process image (ids_, keyed on the
+  // comm still in ps.cmd) and a steady-state row costs nothing here.
+  out.tracked_count = rows_.size();
+  for (auto& ps : rows_) {
+    if (ps.churn_reason != montauk::model::ChurnReason::None) continue;
+    auto& id = ids_.at(ps.pid, ps.start_time, ps.cmd);
+    if (id.exe) { ps.exe_path = *id.exe; continue; }
+    read_exe_path(rd_, ps.pid, ps.exe_path);
+    id.exe = ids_.intern(ps.exe_path);
   }
-  size_t enrich_n = std::min<size_t>(out.processes.size(), enrich_top_n_);
+  size_t enrich_n = std::min<size_t>(rows_.size(), enrich_top_n_);
   out.enriched_count = enrich_n;
   for (size_t i=0;i<enrich_n;i++) {
-    auto& ps = out.processes[i];
-    auto cmd = read_cmdline(ps.pid);
-    if (!cmd.empty()) {
-      cap_cmdline(cmd);
-      ps.cmd = std::move(cmd);
+    auto& ps = rows_[i];
+    auto* id = ps.churn_reason == montauk::model::ChurnReason::None ? &ids_.at(ps.pid, ps.start_time, ps.cmd) : nullptr;
+    if (ps.start_time) fds_.open(rd_, ps.pid, ps.start_time, montauk::util::PidFdCache::Stat);
+    if (id && id->cmd && id->user) {
+      if (!id->cmd->empty()) ps.cmd = *id->cmd;
+      ps.user_name = *id->user;
+      out.total_threads += ps.thread_count;  // from this tick's stat, not the cache
+      continue;
     }
-    auto info = info_from_status(ps.pid);
+    auto cmd = read_cmdline(rd_, fds_, ps.pid, ps.start_time);
+    cap_cmdline(cmd);
+    if (!cmd.empty()) ps.cmd = cmd;
+    auto info = info_from_status(rd_, fds_, ps.pid, ps.start_time);
+    // An empty user means status was unreadable: leave the entry to retry
+    // rather than caching the miss.
+    if (id && !info.user.empty()) { id->cmd = ids_.intern(cmd); id->user = ids_.intern(info.user); }
     if (!info.user.empty()) ps.user_name = std::move(info.user);
     out.total_threads += info.thread_count;
   }
   // Non-enriched rows never read /proc/pid/status, but num_threads was already
   // parsed from /proc/pid/stat during the scan -- sum the real value rather than
   // estimating 1 per process.
-  for (size_t i = enrich_n; i < out.processes.size(); ++i)
-    out.total_threads += out.processes[i].thread_count;
+  for (size_t i = enrich_n; i < rows_.size(); ++i)
+    out.total_threads += rows_[i].thread_count;
+  out.assign_rows(rows_);
   return true;
 }
 
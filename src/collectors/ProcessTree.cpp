@@ -0,0 +1,149 @@
+#include "collectors/ProcessTree.hpp"
+
+#include <algorithm>
+
+namespace montauk::collectors {
+
+void ProcessTree::unlink(int32_t pid, Node& n) {
+  if (n.ppid > 0) {
+    if (auto it = nodes_.find(n.ppid); it != nodes_.end()) {
+      auto& kids = it->second.children;
+      if (auto k = std::find(kids.begin(), kids.end(), pid); k != kids.end()) {
+        *k = kids.back();
+        kids.pop_back();
+      }
+    }
+  }
+  n.ppid = 0;
+}
+
+void ProcessTree::link(int32_t pid, Node& n, int32_t ppid) {
+  if (ppid == pid) ppid = 0;
+  if (n.ppid == ppid) return;
+  unlink(pid, n);
+  n.ppid = ppid;
+  // A parent not seen yet gets an empty node: it is either read later in this
+  // pass or, if it is already gone, swept with everything else not live.
+  // unordered_map references survive the insert, so n stays valid.
+  if (ppid > 0) nodes_[ppid].children.push_back(pid);
+}
+
+void ProcessTree::erase(int32_t pid) {
+  auto it = nodes_.find(pid);
+  if (it == nodes_.end()) return;
+  unlink(pid, it->second);
+  // Orphans are roots until their own next stat names the reaper.
+  for (int32_t c : it->second.children)
+    if (auto ct = nodes_.find(c); ct != nodes_.end() && ct->second.ppid == pid) ct->second.ppid = 0;
+  nodes_.erase(it);
+}
+
+void ProcessTree::on_fork(int32_t parent, int32_t child) {
+  // A node already under this pid is an earlier process whose exit was lost.
+  erase(child);
+  Node& n = nodes_[child];
+  n.gen = gen_;
+  link(child, n, parent);
+}
+
+void ProcessTree::on_exit(int32_t pid) { erase(pid); }
+
+int32_t ProcessTree::parent_of(int32_t pid) const {
+  auto it = nodes_.find(pid);
+  return it == nodes_.end() ? 0 : it->second.ppid;
+}
+
+void ProcessTree::merge(std::span<montauk::model::ProcSample> rows) {
+  for (const auto& r : rows) {
+    Node& n = nodes_[r.pid];
+    n.gen = gen_;
+    // A failed read says nothing about the edge; keep what the tree has.
+    if (r.churn_reason != montauk::model::ChurnReason::None) continue;
+    if (n.start_time != 0 && n.start_time != r.start_time) {
+      // Recycled pid: the old process's children were reparented elsewhere.
+      for (int32_t c : n.children)
+        if (auto ct = nodes_.find(c); ct != nodes_.end()) ct->second.ppid = 0;
+      n.children.clear();
+    }
+    n.start_time = r.start_time;
+    n.cpu_pct = r.cpu_pct;
+    n.rss_kb = r.rss_kb;
+    n.threads = static_cast<uint32_t>(std::max(r.thread_count, 0));
+    link(r.pid, n, r.ppid);
+  }
+}
+
+void ProcessTree::sweep() {
+  std::vector<int32_t> gone;
+  for (const auto& [pid, n] : nodes_)
+    if (n.gen != gen_) gone.push_back(pid);
+  for (int32_t pid : gone) erase(pid);
+}
+
+void ProcessTree::rollup() {
+  ++walk_;
+  auto enter = [&](Node& n) {
+    n.visit = walk_;
+    n.sub_cpu_pct = n.cpu_pct;
+    n.sub_rss_kb = n.rss_kb;
+    n.sub_threads = n.threads;
+    n.sub_procs = 1;
+    stack_.emplace_back(&n, 0);
+  };
+  for (auto& [pid, root] : nodes_) {
+    if (root.ppid > 0 && nodes_.contains(root.ppid)) continue;  // reached from its root
+    enter(root);
+    while (!stack_.empty()) {
+      auto& [node, next] = stack_.back();
+      if (next < node->children.size()) {
+        auto it = nodes_.find(node->children[next++]);
+        if (it != nodes_.end() && it->second.visit != walk_) enter(it->second);  // invalidates node/next
+        continue;
+      }
+      const Node* done = node;
+      stack_.pop_back();
+      if (stack_.empty()) break;
+      Node* up = stack_.back().first;
+      up->sub_cpu_pct += done->sub_cpu_pct;
+      up->sub_rss_kb += done->sub_rss_kb;
+      up->sub_threads += done->sub_threads;
+      up->sub_procs += done->sub_procs;
+    }
+  }
+}
+
+void ProcessTree::annotate(std::span<montauk::model::ProcSample> rows) const {
+  for (auto& r : rows) {
+    auto it = nodes_.find(r.pid);
+    if (it == nodes_.end()) continue;
+    const Node& n = it->second;
+    r.ppid = n.ppid;
+    // A node no root reaches sits on a cycle of stale edges (recycled pids
+    // mid-update); it stands alone until the next scan straightens it out.
+    const bool walked = n.visit == walk_;
+    r.subtree_cpu_pct = walked ? n.sub_cpu_pct : n.cpu_pct;
+    r.subtree_rss_kb = walked ? n.sub_rss_kb : n.rss_kb;
+    r.subtree_threads = walked ? n.sub_threads : n.threads;
+    r.subtree_procs = walked ? n.sub_procs : 1;
+  }
+}
+
+void ProcessTree::refresh(std::span<montauk::model::ProcSample> rows) {
+  ++gen_;
+  merge(rows);
+  sweep();
+  rollup();
+  annotate(rows);
+}
+
+void ProcessTree::refresh(std::span<montauk::model::ProcSample> rows, std::span<const int32_t> live) {
+  ++gen_;
+  merge(rows);
+  for (int32_t pid : live)
+    if (auto it = nodes_.find(pid); it != nodes_.end()) it->second.gen = gen_;
+  sweep();
+  rollup();
+  annotate(rows);
+}
+
+} // namespace montauk::collectors
@@ -0,0 +1,213 @@
+#include "collectors/PsiCollector.hpp"
+#include "collectors/CgroupCollector.hpp"
+#include "util/Log.hpp"
+#include "util/Procfs.hpp"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+namespace montauk::collectors {
+
+namespace {
+
+constexpr const char* kResources[] = {"cpu", "memory", "io"};
+
+double to_f64(std::string_view t) {
+  double v = 0.0;
+  (void)std::from_chars(t.data(), t.data() + t.size(), v);
+  return v;
+}
+
+// "some avg10=0.12 avg60=0.05 avg300=0.01 total=12345"
+bool parse_line(std::string_view line, montauk::model::PsiLine& out) {
+  out = {};
+  bool any = false;
+  while (!line.empty()) {
+    const size_t sp = line.find(' ');
+    const std::string_view kv = line.substr(0, sp);
+    line = sp == std::string_view::npos ? std::string_view{} : line.substr(sp + 1);
+    const size_t eq = kv.find('=');
+    if (eq == std::string_view::npos) continue;
+    const std::string_view k = kv.substr(0, eq), v = kv.substr(eq + 1);
+    if (k == "avg10") out.avg10 = to_f64(v);
+    else if (k == "avg60") out.avg60 = to_f64(v);
+    else if (k == "avg300") out.avg300 = to_f64(v);
+    else if (k == "total") (void)std::from_chars(v.data(), v.data() + v.size(), out.total_us);
+    else continue;
+    any = true;
+  }
+  return any;
+}
+
+// Triggers only mean something to the kernel's own files; written into a
+// remapped test tree they would just overwrite the fixture.
+bool is_kernel_psi_file(int fd) {
+  struct statfs sf{};
+  if (::fstatfs(fd, &sf) != 0) return false;
+  return sf.f_type == PROC_SUPER_MAGIC || sf.f_type == CGROUP2_SUPER_MAGIC;
+}
+
+}  // namespace
+
+bool parse_psi(std::string_view text, montauk::model::PsiLine& some, montauk::model::PsiLine& full,
+               bool& has_full) {
+  some = full = {};
+  has_full = false;
+  bool have_some = false;
+  while (!text.empty()) {
+    const size_t nl = text.find('\n');
+    const std::string_view line = text.substr(0, nl);
+    text = nl == std::string_view::npos ? std::string_view{} : text.substr(nl + 1);
+    if (line.starts_with("some ")) have_some = parse_line(line.substr(5), some);
+    else if (line.starts_with("full ")) has_full = parse_line(line.substr(5), full);
+  }
+  return have_some || has_full;
+}
+
+PsiCollector::PsiCollector(std::vector<std::string> cgroups) : cgroups_(std::move(cgroups)) {}
+
+PsiCollector::~PsiCollector() {
+  for (auto& src : sources_)
+    if (src.fd >= 0) ::close(src.fd);
+}
+
+void PsiCollector::open_sources() {
+  opened_ = true;
+  auto add = [&](std::string scope, const char* resource, std::string path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;  // no PSI (CONFIG_PSI off, psi=0) or no such controller
+    sources_.push_back(Source{std::move(scope), resource, std::move(path), fd});
+  };
+  for (const char* r : kResources)
+    add("system", r, montauk::util::map_proc_path(std::string("/proc/pressure/") + r));
+  if (cgroups_.empty()) return;
+  const std::string root = cgroup_v2_root();
+  if (root.empty()) {
+    montauk::util::log_warn("[psi] cgroups set but there is no cgroup v2 hierarchy; ignoring it");
+    return;
+  }
+  for (std::string cg : cgroups_) {
+    if (!cg.starts_with('/')) cg.insert(cg.begin(), '/');
+    while (cg.size() > 1 && cg.back() == '/') cg.pop_back();
+    for (const char* r : kResources)
+      add(cg, r, root + (cg == "/" ? "" : cg) + "/" + r + ".pressure");
+  }
+}
+
+size_t PsiCollector::arm(std::chrono::microseconds stall, std::chrono::microseconds window) {
+  if (!opened_) open_sources();
+  auto spec_for = [](std::chrono::microseconds st, std::chrono::microseconds win) {
+    char b[64];
+    std::snprintf(b, sizeof(b), "some %lld %lld", static_cast<long long>(st.count()),
+                  static_cast<long long>(win.count()));
+    return std::string(b);
+  };
+  std::string spec = spec_for(stall, window);
+  // Without CAP_SYS_RESOURCE the kernel only takes windows that are a multiple
+  // of 2 s (EINVAL otherwise); keep the same stall ratio on the rounded one.
+  constexpr std::chrono::microseconds kUnprivStep{2'000'000};
+  std::string fallback;
+  if (window % kUnprivStep != std::chrono::microseconds::zero()) {
+    const auto win = (window / kUnprivStep + 1) * kUnprivStep;
+    fallback = spec_for(stall * win.count() / window.count(), win);
+  }
+  bool warned = false;
+  for (size_t i = 0; i < sources_.size(); ++i) {
+    Source& src = sources_[i];
+    if (src.armed || !is_kernel_psi_file(src.fd)) continue;
+    // A trigger lives on the fd it was written to, so it needs its own
+    // read-write open; averages are read back through the same fd.
+    const int fd = ::open(src.path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) continue;
+    bool ok = ::write(fd, spec.c_str(), spec.size() + 1) >= 0;
+    if (!ok && errno == EINVAL && !fallback.empty() &&
+        ::write(fd, fallback.c_str(), fallback.size() + 1) >= 0) {
+      montauk::util::log_info("PSI trigger \"%s\" needs CAP_SYS_RESOURCE; using \"%s\"", spec.c_str(),
+                              fallback.c_str());
+      spec = std::move(fallback);
+      fallback.clear();
+      ok = true;
+    }
+    if (!ok) {
+      if (!warned)
+        montauk::util::log_info("PSI trigger \"%s\" refused on %s: %s", spec.c_str(), src.path.c_str(),
+                                std::strerror(errno));
+      warned = true;
+      ::close(fd);
+      continue;
+    }
+    ::close(src.fd);
+    src.fd = fd;
+    src.armed = true;
+    ++armed_;
+  }
+  return armed_;
+}
+
+bool PsiCollector::on_event(Source& src, bool fired, bool error) {
+  if (error) {
+    // The cgroup was removed under the trigger; stop counting it.
+    src.armed = false;
+    --armed_;
+    return false;
+  }
+  if (fired) ++src.fires;
+  return fired;
+}
+
+bool PsiCollector::watch(montauk::util::DeadlineScheduler& sched, std::function<void()> on_fire) {
+  bool all = true;
+  for (auto& src : sources_) {
+    if (!src.armed) continue;
+    Source* p = &src;  // sources_ is not resized once armed
+    all &= sched.watch(src.fd, EPOLLPRI, [this, p, &sched, on_fire](uint32_t ev) {
+      const bool error = (ev & EPOLLERR) != 0;
+      if (error) sched.unwatch(p->fd);
+      if (on_event(*p, (ev & EPOLLPRI) != 0, error)) on_fire();
+    });
+  }
+  return all;
+}
+
+size_t PsiCollector::drain_fires() {
+  if (!armed_) return 0;
+  size_t fired = 0;
+  for (auto& src : sources_) {
+    if (!src.armed) continue;
+    pollfd p{src.fd, POLLPRI, 0};
+    if (::poll(&p, 1, 0) <= 0) continue;
+    if (on_event(src, (p.revents & POLLPRI) != 0, (p.revents & POLLERR) != 0)) ++fired;
+  }
+  return fired;
+}
+
+bool PsiCollector::sample(montauk::model::PsiSnapshot& out) {
+  if (!opened_) open_sources();
+  out.entries.clear();
+  out.trigger_fires = 0;
+  if (buf_.size() < 512) buf_.resize(512);
+  for (const auto& src : sources_) {
+    const ssize_t got = ::pread(src.fd, buf_.data(), buf_.size(), 0);
+    if (got <= 0) continue;
+    montauk::model::PsiResource r;
+    if (!parse_psi(std::string_view(buf_.data(), static_cast<size_t>(got)), r.some, r.full, r.has_full))
+      continue;
+    r.scope = src.scope;
+    r.resource = src.resource;
+    r.armed = src.armed;
+    r.trigger_fires = src.fires;
+    out.trigger_fires += src.fires;
+    out.entries.push_back(std::move(r));
+  }
+  return !out.entries.empty();
+}
+
+} // namespace montauk::collectors
@@ -0,0 +1,63 @@
+#include "collectors/TaskIterRecords.hpp"
+#include "montauk_procs.h"
+
+#include <cstring>
+
+namespace montauk::collectors {
+
+size_t TaskIterFold::consume(const uint8_t* p, size_t len) {
+  size_t used = 0;
+  while (len - used >= sizeof(montauk_thread_rec)) {
+    __u32 ids[2];
+    std::memcpy(ids, p + used, sizeof(ids));
+    const bool leader = ids[0] == ids[1];
+    const size_t need = leader ? sizeof(montauk_task_rec) : sizeof(montauk_thread_rec);
+    if (len - used < need) break;
+    // The leading fields are laid out alike, so a thread record reads as the
+    // head of a task record.
+    montauk_task_rec r{};
+    std::memcpy(&r, p + used, need);
+    used += need;
+    auto& proc = procs_[static_cast<int32_t>(r.tgid)];
+    proc.run_ns += r.run_ns;
+    proc.cpu_ns += r.cpu_ns;
+    proc.nvcsw += r.nvcsw;
+    proc.nivcsw += r.nivcsw;
+    proc.flt += r.flt;
+    if (!leader) continue;
+    proc.pid = static_cast<int32_t>(r.tgid);
+    proc.ppid = static_cast<int32_t>(r.ppid);
+    proc.uid = r.uid;
+    proc.nr_threads = r.nr_threads;
+    proc.state = r.state;
+    proc.start_ns = r.start_ns;
+    proc.rss_pages = r.rss_pages;
+    proc.comm.assign(r.comm, ::strnlen(r.comm, sizeof(r.comm)));
+  }
+  return used;
+}
+
+void TaskIterFold::feed(const void* data, size_t len) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  if (!carry_.empty()) {
+    carry_.insert(carry_.end(), p, p + len);
+    const size_t used = consume(carry_.data(), carry_.size());
+    carry_.erase(carry_.begin(), carry_.begin() + static_cast<std::ptrdiff_t>(used));
+    return;
+  }
+  const size_t used = consume(p, len);
+  carry_.assign(p + used, p + len);
+}
+
+bool TaskIterFold::finish(std::vector<TaskIterProc>& out) {
+  out.clear();
+  out.reserve(procs_.size());
+  for (auto& [tgid, proc] : procs_)
+    if (proc.pid != 0) out.push_back(std::move(proc));  // 0: no leader record
+  procs_.clear();
+  const bool clean = carry_.empty();
+  carry_.clear();
+  return clean;
+}
+
+} // namespace montauk::collectors
@@ -0,0 +1,239 @@
+#include "collectors/TaskstatsListener.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <unistd.h>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+
+namespace montauk::collectors {
+
+namespace {
+
+// Walk the netlink attributes in [p, p+len): fn(type, payload, payload_len).
+template <typename Fn>
+void for_each_attr(const uint8_t* p, size_t len, Fn&& fn) {
+  while (len >= NLA_HDRLEN) {
+    struct nlattr a;
+    std::memcpy(&a, p, sizeof(a));
+    if (a.nla_len < NLA_HDRLEN || a.nla_len > len) return;
+    fn(static_cast<uint16_t>(a.nla_type & NLA_TYPE_MASK), p + NLA_HDRLEN,
+       static_cast<size_t>(a.nla_len - NLA_HDRLEN));
+    const size_t step = NLA_ALIGN(a.nla_len);
+    if (step >= len) return;
+    p += step;
+    len -= step;
+  }
+}
+
+uint32_t attr_u32(const uint8_t* p, size_t len) {
+  uint32_t v = 0;
+  if (len >= sizeof(v)) std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// "0-N" over every configured CPU: exits are reported on the CPU they run on.
+std::string all_cpus_mask() {
+  const long n = ::sysconf(_SC_NPROCESSORS_CONF);
+  return n > 1 ? "0-" + std::to_string(n - 1) : std::string("0");
+}
+
+void add_into(TaskExit& into, const TaskExit& e) {
+  into.cpu_us += e.cpu_us;
+  into.rss_kb = std::max(into.rss_kb, e.rss_kb);  // threads share one mm
+  into.io_bytes += e.io_bytes;
+}
+
+}  // namespace
+
+bool parse_taskstats_record(const void* attrs, size_t len, TaskRecord& out) {
+  bool have_pid = false;
+  out = TaskRecord{};
+  for_each_attr(static_cast<const uint8_t*>(attrs), len, [&](uint16_t type, const uint8_t* p, size_t n) {
+    if (type == TASKSTATS_TYPE_AGGR_TGID) { out.group_dead = true; return; }
+    if (type != TASKSTATS_TYPE_AGGR_PID) return;
+    for_each_attr(p, n, [&](uint16_t inner, const uint8_t* q, size_t m) {
+      if (inner == TASKSTATS_TYPE_PID) {
+        out.pid = static_cast<int32_t>(attr_u32(q, m));
+        have_pid = true;
+      } else if (inner == TASKSTATS_TYPE_STATS) {
+        // The kernel's struct may be older (shorter) or newer than ours;
+        // fields past its end read as zero.
+        struct taskstats ts{};
+        std::memcpy(&ts, q, std::min(m, sizeof(ts)));
+        const size_t comm_len = ::strnlen(ts.ac_comm, sizeof(ts.ac_comm));
+        out.stats.comm.assign(ts.ac_comm, comm_len);
+        out.stats.cpu_us = ts.ac_utime + ts.ac_stime;
+        out.stats.rss_kb = ts.hiwater_rss;
+        out.stats.io_bytes = ts.read_bytes + ts.write_bytes;
+        out.tgid = static_cast<int32_t>(ts.ac_tgid);
+      }
+    });
+  });
+  if (!have_pid) return false;
+  if (out.tgid == 0) out.tgid = out.pid;  // pre-v10 kernel: no ac_tgid
+  out.stats.tgid = out.tgid;
+  return true;
+}
+
+void TaskExitAssembler::add(const TaskRecord& r, std::vector<TaskExit>& out) {
+  auto it = groups_.find(r.tgid);
+  const bool leader = r.pid == r.tgid;
+  if (it == groups_.end()) {
+    if (r.group_dead || leader) { out.push_back(r.stats); return; }
+    if (groups_.size() >= kMaxGroups) { ++dropped_; return; }
+    groups_.emplace(r.tgid, r.stats);
+    return;
+  }
+  add_into(it->second, r.stats);
+  if (leader) it->second.comm = r.stats.comm;  // a worker thread may carry its own name
+  if (r.group_dead) {
+    out.push_back(std::move(it->second));
+    groups_.erase(it);
+  }
+}
+
+bool TaskstatsListener::send_genl(uint16_t type, uint8_t cmd, uint16_t attr, const void* data,
+                                  size_t len) {
+  struct {
+    struct nlmsghdr nl;
+    struct genlmsghdr genl;
+    char attrs[256];
+  } msg{};
+  const size_t attr_len = NLA_HDRLEN + len;
+  if (NLA_ALIGN(attr_len) > sizeof(msg.attrs)) return false;
+  struct nlattr a{};
+  a.nla_type = attr;
+  a.nla_len = static_cast<uint16_t>(attr_len);
+  std::memcpy(msg.attrs, &a, sizeof(a));
+  std::memcpy(msg.attrs + NLA_HDRLEN, data, len);
+  msg.nl.nlmsg_len = static_cast<uint32_t>(NLMSG_LENGTH(GENL_HDRLEN + NLA_ALIGN(attr_len)));
+  msg.nl.nlmsg_type = type;
+  msg.nl.nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+  msg.genl.cmd = cmd;
+  msg.genl.version = 1;
+  return ::send(sock_, &msg, msg.nl.nlmsg_len, 0) == static_cast<ssize_t>(msg.nl.nlmsg_len);
+}
+
+// Read until the ack for the last request: true on success. A family lookup
+// also yields its id. Exit records that race in ahead of the ack are dropped.
+bool TaskstatsListener::await_reply(uint16_t type, uint16_t* family_id) {
+  alignas(NLMSG_ALIGNTO) char buf[8192];
+  for (int tries = 0; tries < 64; ++tries) {
+    const ssize_t got = ::recv(sock_, buf, sizeof(buf), 0);
+    if (got <= 0) return false;
+    int len = static_cast<int>(got);
+    for (auto* nh = reinterpret_cast<struct nlmsghdr*>(buf); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+      if (nh->nlmsg_type == NLMSG_ERROR) {
+        const auto* err = static_cast<const struct nlmsgerr*>(NLMSG_DATA(nh));
+        if (err->error != 0) errno = -err->error;
+        return err->error == 0;
+      }
+      if (family_id && nh->nlmsg_type == type) {
+        const auto* p = static_cast<const uint8_t*>(NLMSG_DATA(nh)) + GENL_HDRLEN;
+        const size_t n = nh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+        for_each_attr(p, n, [&](uint16_t t, const uint8_t* q, size_t m) {
+          if (t == CTRL_ATTR_FAMILY_ID && m >= sizeof(uint16_t)) std::memcpy(family_id, q, sizeof(uint16_t));
+        });
+      }
+    }
+  }
+  return false;
+}
+
+bool TaskstatsListener::start() {
+  if (running_) return true;
+  sock_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+  if (sock_ < 0) return false;
+  auto fail = [this] {
+    ::close(sock_);
+    sock_ = -1;
+    return false;
+  };
+  struct sockaddr_nl addr{};
+  addr.nl_family = AF_NETLINK;
+  if (::bind(sock_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) return fail();
+  // Bounded setup: a reply that never comes must not hang init().
+  struct timeval tv{1, 0};
+  (void)::setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  // A fork storm outruns the default receive buffer; overruns are counted.
+  const int rcvbuf = 1 << 20;
+  (void)::setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  static constexpr char kFamily[] = TASKSTATS_GENL_NAME;
+  if (!send_genl(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, CTRL_ATTR_FAMILY_NAME, kFamily, sizeof(kFamily)) ||
+      !await_reply(GENL_ID_CTRL, &family_) || family_ == 0)
+    return fail();
+  cpumask_ = all_cpus_mask();
+  if (!send_genl(family_, TASKSTATS_CMD_GET, TASKSTATS_CMD_ATTR_REGISTER_CPUMASK, cpumask_.c_str(),
+                 cpumask_.size() + 1) ||
+      !await_reply(family_, nullptr))
+    return fail();  // EPERM without CAP_NET_ADMIN
+
+  tv = {0, 0};
+  (void)::setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  running_ = true;
+  thread_ = std::thread([this] { loop(); });
+  return true;
+}
+
+void TaskstatsListener::stop() {
+  if (!running_.exchange(false)) return;
+  const int sock = sock_;
+  // Best-effort deregister, then wake the blocked recv() (see
+  // NetlinkProcessCollector::shutdown).
+  (void)send_genl(family_, TASKSTATS_CMD_GET, TASKSTATS_CMD_ATTR_DEREGISTER_CPUMASK,
+                  cpumask_.c_str(), cpumask_.size() + 1);
+  ::shutdown(sock, SHUT_RDWR);
+  if (thread_.joinable()) thread_.join();
+  ::close(sock);
+  sock_ = -1;
+}
+
+void TaskstatsListener::drain(std::vector<TaskExit>& out) {
+  std::lock_guard<std::mutex> lk(mu_);
+  if (out.empty()) { out.swap(pending_); return; }
+  std::move(pending_.begin(), pending_.end(), std::back_inserter(out));
+  pending_.clear();
+}
+
+void TaskstatsListener::loop() {
+  alignas(NLMSG_ALIGNTO) char buf[16384];
+  std::vector<TaskExit> done;
+  uint64_t assembler_dropped = 0;
+  while (running_) {
+    const ssize_t got = ::recv(sock_, buf, sizeof(buf), 0);
+    if (got < 0 && errno == ENOBUFS) { dropped_.fetch_add(1, std::memory_order_relaxed); continue; }
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) break;  // shut down
+    int len = static_cast<int>(got);
+    for (auto* nh = reinterpret_cast<struct nlmsghdr*>(buf); NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+      if (nh->nlmsg_type != family_ || nh->nlmsg_len < NLMSG_LENGTH(GENL_HDRLEN)) continue;
+      const auto* genl = static_cast<const struct genlmsghdr*>(NLMSG_DATA(nh));
+      if (genl->cmd != TASKSTATS_CMD_NEW) continue;
+      TaskRecord rec;
+      if (parse_taskstats_record(reinterpret_cast<const uint8_t*>(genl) + GENL_HDRLEN,
+                                 nh->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN), rec))
+        assembler_.add(rec, done);
+    }
+    if (assembler_.dropped() != assembler_dropped) {
+      dropped_.fetch_add(assembler_.dropped() - assembler_dropped, std::memory_order_relaxed);
+      assembler_dropped = assembler_.dropped();
+    }
+    if (done.empty()) continue;
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& e : done) {
+      if (pending_.size() >= kMaxPending) { dropped_.fetch_add(1, std::memory_order_relaxed); continue; }
+      pending_.push_back(std::move(e));
+    }
+    done.clear();
+  }
+}
+
+} // namespace montauk::collectors
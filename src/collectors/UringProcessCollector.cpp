@@ -0,0 +1,38 @@
+#include "collectors/UringProcessCollector.hpp"
+#include "collectors/ProcessParsing.hpp"
+
+namespace montauk::collectors {
+
+namespace {
+// schedstat rides along only under CpuClock::Schedstat; a multi-threaded
+// process still walks its task/ directory synchronously.
+constexpr const char* kLeaves[] = {"stat", "status", "schedstat"};
+}
+
+size_t UringProcessCollector::scan(std::span<const int32_t> pids, const ScanCtx& c,
+                                   std::vector<montauk::model::ProcSample>& rows,
+                                   montauk::model::ProcessSnapshot& out) {
+  if (!batch_.ok()) return ProcessCollector::scan(pids, c, rows, out);
+  // The batch already collapses the syscalls, so the parse runs on this
+  // thread, in completion-chunk order (which is pid order).
+  sh_.rows.clear();
+  sh_.running = sh_.sleeping = sh_.zombie = 0;
+  const std::span<const char* const> leaves(kLeaves, c.schedstat ? 3 : 2);
+  const bool done = batch_.read_all(rd_.root_fd(), pids, leaves, [&](size_t i) {
+    if (!parse_stat_row(sh_, c, pids[i], batch_.view(i, 0), c.schedstat ? batch_.view(i, 2) : std::nullopt)) return;
+    if (auto status = batch_.view(i, 1)) {
+      auto cs = parse_ctx_switches(*status);
+      sh_.rows.back().vctx_raw = cs.voluntary; sh_.rows.back().nvctx_raw = cs.involuntary;
+    }
+  });
+  for (auto& r : sh_.rows) rows.push_back(std::move(r));
+  sh_.rows.clear();
+  out.state_running += sh_.running;
+  out.state_sleeping += sh_.sleeping;
+  out.state_zombie += sh_.zombie;
+  if (done) return 1;
+  // Ring failed mid-scan: finish the pids it never reached synchronously.
+  return ProcessCollector::scan(pids.subspan(batch_.done_count()), c, rows, out);
+}
+
+} // namespace montauk::collectors
@@ -3,13 +3,18 @@
 #include <cstring>
 #include "app/SnapshotBuffers.hpp"
 #include "app/Producer.hpp"
+#include "app/OneShot.hpp"
 #include "collectors/CpuCollector.hpp"
 #include <cmath>
 #include <algorithm>
 #include "sublimation_signal.h"
 #include "sublimation_spectral.h"
 #include "app/MetricsServer.hpp"
+#include "app/JsonStream.hpp"
 #include "app/LogWriter.hpp"
+#include "app/ShmExport.hpp"
+#include "app/SnapshotClient.hpp"
+#include "app/SnapshotServer.hpp"
 #include "app/TraceBuffers.hpp"
 #ifdef MONTAUK_HAVE_BPF
 #include "collectors/BpfTraceCollector.hpp"
@@ -117,7 +122,11 @@ int main(int argc, char** argv) {
   int self_test_secs = 0; // if >0, run self-test and print stats
   uint16_t metrics_port = 0; // >0 enables Prometheus metrics endpoint
   std::filesystem::path log_dir; // non-empty enables LogWriter
+  std::filesystem::path shm_path; // non-empty enables ShmExporter
+  std::filesystem::path serve_path;  // non-empty enables SnapshotServer
+  std::filesystem::path attach_path; // non-empty: render a served stream, no Producer
   int log_interval_ms = 1000;    // default 1s write interval
+  auto log_format = montauk::app::LogFormat::Text;  // --log-format text|delta|binary
   bool headless = false;     // --headless: skip TUI, daemon mode
   std::string trace_pattern; // --trace PATTERN: trace process group
   std::string trace_out;     // --trace-out FILE: raw binary event log
@@ -133,6 +142,8 @@ int main(int argc, char** argv) {
   [[maybe_unused]] uint64_t trace_ring_bytes = 0;
   [[maybe_unused]] uint64_t trace_class_mask = 0;
   bool json_once = false;      // --json: one-shot structured snapshot to stdout, then exit
+  bool json_stream = false;    // --json-stream: an NDJSON line per published generation, changes only
+  int  json_interval_ms = 0;   // --interval MS: with --json-stream, at most one line per MS
   int  cpu_window = 0;         // --cpu-window N: sample aggregate CPU N times, emit the series
   int  anomalies_n = 0;        // --anomalies N: rank the published anomaly scores
   int  similar_pid = 0;        // --similar PID: processes behaving like PID
@@ -149,6 +160,8 @@ int main(int argc, char** argv) {
     std::string a = argv[i];
     if (a == "--iterations" && i + 1 < argc) iterations = parse_int_arg(argv[++i], iterations);
     else if (a == "--json") json_once = true;
+    else if (a == "--json-stream") json_stream = true;
+    else if (a == "--interval" && i + 1 < argc) json_interval_ms = parse_int_arg(argv[++i], json_interval_ms);
     else if (a == "--cpu-window" && i + 1 < argc) cpu_window = parse_int_arg(argv[++i], cpu_window);
     else if (a == "--anomalies") anomalies_n = (i + 1 < argc && argv[i+1][0] != '-') ? parse_int_arg(argv[++i], 5) : 5;
     else if (a == "--similar" && i + 1 < argc) similar_pid = parse_int_arg(argv[++i], 0);
@@ -157,7 +170,20 @@ int main(int argc, char** argv) {
     else if (a == "--self-test-seconds" && i + 1 < argc) self_test_secs = parse_int_arg(argv[++i], self_test_secs);
     else if (a == "--metrics" && i + 1 < argc) metrics_port = static_cast<uint16_t>(parse_int_arg(argv[++i], metrics_port));
     else if (a == "--log" && i + 1 < argc) log_dir = argv[++i];
+    else if (a == "--shm" && i + 1 < argc) shm_path = argv[++i];
+    else if (a == "--serve" && i + 1 < argc) serve_path = argv[++i];
+    else if (a == "--attach" && i + 1 < argc) attach_path = argv[++i];
     else if (a == "--log-interval-ms" && i + 1 < argc) log_interval_ms = parse_int_arg(argv[++i], log_interval_ms);
+    else if (a == "--log-format" && i + 1 < argc) {
+      std::string_view f = argv[++i];
+      if (f == "text") log_format = montauk::app::LogFormat::Text;
+      else if (f == "delta") log_format = montauk::app::LogFormat::Delta;
+      else if (f == "binary") log_format = montauk::app::LogFormat::Binary;
+      else {
+        montauk::util::log_error("--log-format: expected text, delta or binary, got '%s'", argv[i]);
+        return 1;
+      }
+    }
     else if (a == "--headless") headless = true;
     else if (a == "--trace" && i + 1 < argc) trace_pattern = argv[++i];
     else if (a == "--trace-out" && i + 1 < argc) trace_out = argv[++i];
@@ -300,15 +326,20 @@ int main(int argc, char** argv) {
     }
     else if (a == "-h" || a == "--help") {
       montauk_sink_appendf(&g_out, "Usage: montauk [--self-test-seconds S] [--iterations N]\n");
-      montauk_sink_appendf(&g_out, "               [--metrics PORT] [--log DIR] [--log-interval-ms MS] [--headless]\n");
+      montauk_sink_appendf(&g_out, "               [--metrics PORT] [--log DIR] [--log-interval-ms MS] [--log-format text|delta|binary] [--shm PATH] [--headless]\n");
+      montauk_sink_appendf(&g_out, "               [--serve SOCKET] [--attach SOCKET]\n");
       montauk_sink_appendf(&g_out, "               [--trace PATTERN] [--trace-out FILE] [--stream-out DEVICE] [--sched-detail] [--init-theme]\n");
       montauk_sink_appendf(&g_out, "               [--pmu-comm SUBSTR] [--pmu-pid N]\n"
-               "               [--json] [--anomalies N] [--similar PID] [--regime N] [--cpu-window N]\n");
+               "               [--json] [--json-stream [--interval MS]] [--anomalies N] [--similar PID] [--regime N] [--cpu-window N]\n");
       montauk_sink_appendf(&g_out, "Notes: Text UI runs until Ctrl+C by default.\n");
       montauk_sink_appendf(&g_out, "       --metrics PORT        Enable Prometheus endpoint on PORT\n");
       montauk_sink_appendf(&g_out, "       --log DIR             Write timestamped snapshots to DIR\n");
       montauk_sink_appendf(&g_out, "       --log-interval-ms MS  Write interval in ms (default: 1000)\n");
-      montauk_sink_appendf(&g_out, "       --headless            Daemon mode (no TUI, requires --metrics or --log)\n");
+      montauk_sink_appendf(&g_out, "       --log-format FMT      text: hourly .prom exposition chunks (default); delta: the same .prom chunks holding only changed series, with a full keyframe each minute; binary: hourly .mhist columnar chunks. --analyze reads all three\n");
+      montauk_sink_appendf(&g_out, "       --shm PATH            Publish each snapshot into a shared-memory segment at PATH (e.g. /dev/shm/montauk) for local readers; layout and reader in <montauk/shm_snapshot.h>\n");
+      montauk_sink_appendf(&g_out, "       --serve SOCKET        Stream snapshots to --attach viewers on a unix socket, so one collector serves every viewer on the box; a slow viewer skips generations instead of queueing them\n");
+      montauk_sink_appendf(&g_out, "       --attach SOCKET       Render the stream of a montauk --serve instead of collecting locally (composes with --log, --metrics, --shm)\n");
+      montauk_sink_appendf(&g_out, "       --headless            Daemon mode (no TUI, requires --metrics, --log, --shm or --serve)\n");
       montauk_sink_appendf(&g_out, "       --trace PATTERN       Trace process group matching PATTERN (headless)\n");
       montauk_sink_appendf(&g_out, "       --trace-out FILE      Write raw binary event log; decode with --decode\n");
       montauk_sink_appendf(&g_out, "       --stream-out DEVICE   Second, independent binary stream (same format as --trace-out), meant for a character device (e.g. a qemu-backed serial port) so capture survives a hang that takes --trace-out's filesystem down with it\n");
@@ -319,6 +350,8 @@ int main(int argc, char** argv) {
       montauk_sink_appendf(&g_out, "       --pmu-comm SUBSTR     Attach hardware counters to processes whose command matches SUBSTR (instructions, cycles, dTLB load misses, cache misses, per process). Needs no root and no sysctl, unlike --trace's system-wide PMU; re-resolved every tick, so a workload started later is picked up\n");
       montauk_sink_appendf(&g_out, "       --pmu-pid N           Same, for one explicit pid (repeatable; composes with --pmu-comm)\n");
       montauk_sink_appendf(&g_out, "       --json                One-shot structured system snapshot to stdout, then exit\n");
+      montauk_sink_appendf(&g_out, "       --json-stream         Keep collecting and write one JSON line per snapshot: the --json object first, then only what changed, process rows keyed by pid\n");
+      montauk_sink_appendf(&g_out, "       --interval MS         With --json-stream, at most one line per MS, each covering every change since the last (default: every snapshot)\n");
       montauk_sink_appendf(&g_out, "       --anomalies [N]       Rank what is anomalous right now (default 5) with each process's dominant axis, as JSON. The conclusion, not the matrix: ~600 bytes against --json's ~67,000\n");
       montauk_sink_appendf(&g_out, "       --similar PID         Processes behaving like PID, by effective resistance over a self-tuning affinity graph. Identical feature vectors collapse to one node first, since a process table is mostly idle duplicates and an uncollapsed graph ties every one of them\n");
       montauk_sink_appendf(&g_out, "       --similar-top N       How many neighbours --similar returns (default 5)\n");
@@ -356,30 +389,59 @@ int main(int argc, char** argv) {
   // --json, the very mode the message below recommends.
   const bool one_shot = json_once || cpu_window > 0 || anomalies_n > 0
                      || similar_pid > 0 || regime_n > 0;
-  if (!headless && !one_shot && !::isatty(STDOUT_FILENO)) {
+  if (!headless && !one_shot && !json_stream && !::isatty(STDOUT_FILENO)) {
     montauk::util::log_error(
         "stdout is not a terminal: the TUI needs one. Use --headless with "
-        "--metrics/--log, or --json / --anomalies / --regime for piped output");
+        "--metrics/--log, or --json / --json-stream / --anomalies / --regime for piped output");
     return 2;
   }
 
-  if (headless && metrics_port == 0 && log_dir.empty() && trace_pattern.empty()) {
-    montauk::util::log_error("--headless requires --metrics PORT or --log DIR");
+  if (headless && metrics_port == 0 && log_dir.empty() && shm_path.empty() && serve_path.empty() &&
+      trace_pattern.empty()) {
+    montauk::util::log_error("--headless requires --metrics PORT, --log DIR, --shm PATH or --serve SOCKET");
+    return 1;
+  }
+  if (json_stream && one_shot) {
+    montauk::util::log_error("--json-stream runs until stopped; it does not combine with the one-shot modes");
+    return 1;
+  }
+  // An attached montauk has no Producer: nothing to trace, warm up or self-test.
+  if (!attach_path.empty() && (!trace_pattern.empty() || one_shot || self_test_secs > 0)) {
+    montauk::util::log_error("--attach renders a served stream; it does not combine with --trace, "
+                             "--self-test-seconds or the one-shot modes");
     return 1;
   }
 
   try {
     montauk::app::SnapshotBuffers buffers;
-    montauk::app::Producer producer(buffers);
-    // PMU counters (perf_event_open) belong to the trace→analyze pipeline,
-    // not the monitor: they need CAP_PERFMON or perf_event_paranoid<=0,
-    // which a plain `montauk` TUI run must never demand. Only trace mode
-    // opts in.
-    if (!trace_pattern.empty()) producer.enable_pmu();
-    // Per-process attribution is the unprivileged half and stands on its own.
-    if (!pmu_comm.empty() || !pmu_pids.empty())
-      producer.set_pmu_process_filter(pmu_comm, pmu_pids);
-    producer.start();
+    // The one-shot modes without --trace never start the Producer (no NVML,
+    // no workers, no warm-up): --cpu-window and --regime sample CpuCollector
+    // themselves, and --json, --anomalies and --similar read one snapshot from
+    // sample_one_shot()'s short schedstat window. With --trace the snapshot
+    // has to ride along with a warmed-up trace, so the Producer path stays.
+    std::unique_ptr<montauk::app::Producer> producer;
+    std::unique_ptr<montauk::app::SnapshotClient> attach;
+    if (one_shot && trace_pattern.empty()) {
+      if (json_once || anomalies_n > 0 || similar_pid > 0) {
+        (void)montauk::app::sample_one_shot(buffers.back());
+        buffers.publish();
+      }
+    } else if (!attach_path.empty()) {
+      attach = std::make_unique<montauk::app::SnapshotClient>(buffers, attach_path);
+      if (!attach->connect()) return 1;
+      attach->start();
+    } else {
+      producer = std::make_unique<montauk::app::Producer>(buffers);
+      // PMU counters (perf_event_open) belong to the trace→analyze pipeline,
+      // not the monitor: they need CAP_PERFMON or perf_event_paranoid<=0,
+      // which a plain `montauk` TUI run must never demand. Only trace mode
+      // opts in.
+      if (!trace_pattern.empty()) producer->enable_pmu();
+      // Per-process attribution is the unprivileged half and stands on its own.
+      if (!pmu_comm.empty() || !pmu_pids.empty())
+        producer->set_pmu_process_filter(pmu_comm, pmu_pids);
+      producer->start();
+    }
 
     // Trace subsystem (optional, parallel to main pipeline). Constructed
     // before the --json one-shot branch below so that branch can warm it up
@@ -406,9 +468,10 @@ int main(int argc, char** argv) {
     }
 #endif
 
-    // --json: one-shot structured snapshot. Warm up two producer cycles so the
-    // rate deltas (cpu ctxt/s, net bps, disk bps) are real, read one snapshot
-    // via the seqlock, serialize to JSON, print and exit. No TUI, no server, no
+    // --json: one-shot structured snapshot. Two collector passes a short
+    // window apart (sample_one_shot) so the rate deltas (cpu ctxt/s, net bps,
+    // disk bps, per-process cpu) are real, read the one snapshot, serialize to
+    // JSON, print and exit. No TUI, no server, no
     // daemon -- the agent-facing analog of `montauk --analyze --json` for the live
     // monitor. With --trace PATTERN also given, a second JSON line follows with
     // the trace snapshot (JSON-lines style: one structured record per line).
@@ -480,7 +543,9 @@ int main(int argc, char** argv) {
     }
 
     if (json_once || anomalies_n > 0 || similar_pid > 0) {
-      for (int spins = 0; buffers.seq() < 2 && !g_stop.load() && spins < 4000; ++spins)
+      // Only the --trace case gets here with a Producer; the fast path has
+      // already published its one snapshot.
+      for (int spins = 0; producer && buffers.seq() < 2 && !g_stop.load() && spins < 4000; ++spins)
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
       // The warm-up above only guarantees the deltas EXIST, not that they span
       // a usable window: it fires several process samples a kernel tick apart,
@@ -488,13 +553,13 @@ int main(int argc, char** argv) {
       // accrue no jiffy at all and read 0 (so top-K by cpu_pct ranks
       // arbitrarily and misses the real burners), while an unlucky one catches
       // a whole jiffy and reads far above 100% per core. Wait for a
-      // steady-loop sample, which only lands a full kProcessInterval later,
+      // steady-loop sample, which only lands a full process_interval() later,
       // then for the publish that carries it. The TUI needs none of this; it
       // resamples and settles on its own.
-      {
-        const uint64_t warm_samples = producer.process_samples();
+      if (producer) {
+        const uint64_t warm_samples = producer->process_samples();
         for (int spins = 0; !g_stop.load() && spins < 8000; ++spins) {
-          if (producer.process_samples() > warm_samples) break;
+          if (producer->process_samples() > warm_samples) break;
           std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
         const auto settled_seq = buffers.seq();
@@ -661,7 +726,7 @@ int main(int argc, char** argv) {
 #ifdef MONTAUK_HAVE_BPF
       if (trace_collector) trace_collector->stop();
 #endif
-      producer.stop();
+      if (producer) producer->stop();
       return 0;
     }
 
@@ -676,12 +741,38 @@ int main(int argc, char** argv) {
     if (!log_dir.empty()) {
       log_writer = std::make_unique<montauk::app::LogWriter>(
           buffers, log_dir, std::chrono::milliseconds(log_interval_ms),
-          trace_buffers.get());
+          trace_buffers.get(), log_format);
       log_writer->start();
     }
 
-    // Headless mode: no TUI, just run Producer + outputs until Ctrl+C
-    if (headless) {
+    std::unique_ptr<montauk::app::ShmExporter> shm_exporter;
+    if (!shm_path.empty()) {
+      shm_exporter = std::make_unique<montauk::app::ShmExporter>(buffers, shm_path);
+      if (!shm_exporter->open()) {
+        if (log_writer) log_writer->stop();
+        if (metrics) metrics->stop();
+        if (producer) producer->stop();
+        return 1;
+      }
+      shm_exporter->start();
+    }
+
+    std::unique_ptr<montauk::app::SnapshotServer> server;
+    if (!serve_path.empty()) {
+      server = std::make_unique<montauk::app::SnapshotServer>(buffers, serve_path);
+      if (!server->start()) {
+        if (shm_exporter) shm_exporter->stop();
+        if (log_writer) log_writer->stop();
+        if (metrics) metrics->stop();
+        if (producer) producer->stop();
+        return 1;
+      }
+    }
+
+    // Headless mode: no TUI, just run Producer + outputs until Ctrl+C.
+    // --json-stream runs the same way, writing a line per generation (at most
+    // one per --interval) to stdout; see JsonStream.hpp for the line format.
+    if (headless || json_stream) {
 #ifdef MONTAUK_HAVE_BPF
       // Wait briefly for BPF to initialize, then check for failure
       if (trace_collector) {
@@ -689,45 +780,79 @@ int main(int argc, char** argv) {
         if (trace_collector->failed()) {
           montauk::util::log_error("--trace requires root or CAP_BPF + CAP_PERFMON");
           trace_collector->stop();
-          producer.stop();
+          producer->stop();
           return 1;
         }
       }
 #endif
-      while (!g_stop.load()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));  // snappy Ctrl+C response
+      montauk::app::JsonStream stream;
+      std::string line;
+      uint64_t streamed = 0;
+      auto due = std::chrono::steady_clock::now();
+      montauk::app::PublishWaiter waiter(buffers.signal());
+      while (!g_stop.load() && (!attach || attach->connected())) {
+        // Snappy Ctrl+C response: never sleep longer than this.
+        constexpr int kStopPollMs = 100;
+        if (!json_stream) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(kStopPollMs));
+          continue;
+        }
+        int wait_ms = kStopPollMs;
+        const auto gen = buffers.acquire();
+        if (gen->seq != 0 && gen->seq != streamed) {
+          const auto now = std::chrono::steady_clock::now();
+          if (now >= due) {
+            line.clear();
+            stream.next(*gen, line);
+            montauk_sink_append(&g_out, line.data(), line.size());
+            drain_out();
+            streamed = gen->seq;
+            due = std::chrono::steady_clock::now() + std::chrono::milliseconds(json_interval_ms);
+          } else {
+            // A generation is waiting on --interval: wake at the deadline.
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(due - now).count();
+            wait_ms = static_cast<int>(std::min<long long>(left, kStopPollMs));
+          }
+        }
+        // Otherwise sleep until the next publish.
+        waiter.wait(wait_ms);
       }
 #ifdef MONTAUK_HAVE_BPF
       if (trace_collector) trace_collector->stop();
 #endif
+      if (server) server->stop();
+      if (shm_exporter) shm_exporter->stop();
       if (log_writer) log_writer->stop();
       if (metrics) metrics->stop();
-      producer.stop();
+      if (producer) producer->stop();
+      if (attach) attach->stop();
       return 0;
     }
 
-  // No JSON stream output path
-
   if (self_test_secs > 0) {
     using clock = std::chrono::steady_clock;
     auto start = clock::now();
     auto endt  = start + std::chrono::seconds(self_test_secs);
     uint64_t last = buffers.seq();
     uint64_t updates = 0;
+    const uint64_t wake0 = producer->wakeups();
     while (clock::now() < endt) {
       auto seq = buffers.seq();
       if (seq != last) { updates++; last = seq; }
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
     double secs = std::chrono::duration<double>(clock::now() - start).count();
-    montauk_sink_appendf(&g_out, "Self-test: updates=%llu in %gs (~%g/s)\n",
-                         (unsigned long long)updates, secs, updates / secs);
-    producer.stop();
+    const uint64_t wakes = producer->wakeups() - wake0;
+    montauk_sink_appendf(&g_out, "Self-test: updates=%llu in %gs (~%g/s), producer wakeups ~%g/s, psi stall wakes %llu\n",
+                         (unsigned long long)updates, secs, updates / secs, wakes / secs,
+                         (unsigned long long)producer->psi_wakes());
+    producer->stop();
     return 0;
   }
 
   // Wait for Producer's warm-up to complete (~200ms) so first frame has real deltas
-  while (buffers.seq() == 0 && !g_stop.load()) {
+  // (attached: for the server's first keyframe)
+  while (buffers.seq() == 0 && !g_stop.load() && (!attach || attach->connected())) {
     std::this_thread::sleep_for(std::chrono::microseconds(500));
   }
 
@@ -742,10 +867,7 @@ int main(int argc, char** argv) {
   montauk::ui::Renderer renderer;
   renderer.seed_from_config();
 
-  // Snapshot copy target lives outside the render loop so its vector
-  // members reuse capacity across frames instead of reallocating.
-  montauk::model::Snapshot s_copy;
-  for (int i = 0; i < iterations && !g_stop.load(); ++i) {
+  for (int i = 0; i < iterations && !g_stop.load() && (!attach || attach->connected()); ++i) {
     // Non-blocking input with poll. Bytes → InputEvents → Renderer.
     struct pollfd pfd{.fd=STDIN_FILENO,.events=POLLIN,.revents=0};
     int to = (i == 0) ? 0 : renderer.sleep_ms();
@@ -764,18 +886,25 @@ int main(int argc, char** argv) {
         if (renderer.should_quit()) g_stop.store(true);
       }
     }
-    // Concurrency hardening: copy the front snapshot under the buffer's reuse
-    // guard so the writer cannot recycle it (freeing its vectors) mid-copy.
-    s_copy = buffers.read([](const montauk::model::Snapshot& s) { return s; });
-    renderer.render(s_copy);
+    // Render straight from the published generation: it is immutable, and the
+    // reference keeps it alive however many publishes land mid-frame.
+    const auto snap = buffers.acquire();
+    renderer.render(*snap);
   }
 #ifdef MONTAUK_HAVE_BPF
   if (trace_collector) trace_collector->stop();
 #endif
+  if (server) server->stop();
+  if (shm_exporter) shm_exporter->stop();
   if (log_writer) log_writer->stop();
   if (metrics) metrics->stop();
-  producer.stop();
+  if (producer) producer->stop();
   montauk::ui::stop_async_writer();
+  if (attach && !attach->connected()) {
+    restore_terminal_minimal();
+    montauk::util::log_error("--attach: the serving montauk went away");
+    return 1;
+  }
   return 0;
 
   } catch (const std::exception& e) {
@@ -0,0 +1,677 @@
+#include "model/HistoryLog.hpp"
+
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+
+namespace montauk::model {
+
+namespace {
+
+// Frames above this are corruption, not data: a block of 60 scrapes over a
+// few thousand series is well under a megabyte.
+constexpr uint32_t kMaxFrameLen = 64u << 20;
+constexpr uint32_t kMaxBlockScrapes = 1u << 16;
+
+void put_uv(std::string& out, uint64_t v) {
+  while (v >= 0x80) {
+    out += static_cast<char>(v | 0x80);
+    v >>= 7;
+  }
+  out += static_cast<char>(v);
+}
+
+void put_sv(std::string& out, int64_t v) {
+  put_uv(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+void put_str(std::string& out, std::string_view s) {
+  put_uv(out, s.size());
+  out += s;
+}
+
+uint64_t bits_of(double v) { return std::bit_cast<uint64_t>(v); }
+
+void put_xor(std::string& out, uint64_t& prev, double v) {
+  const uint64_t bits = bits_of(v);
+  const uint64_t x = bits ^ prev;
+  prev = bits;
+  if (x == 0) {
+    out += static_cast<char>(0x80);
+    return;
+  }
+  const int lead = std::countl_zero(x) / 8;
+  const int trail = std::countr_zero(x) / 8;
+  out += static_cast<char>(lead << 4 | trail);
+  for (int i = trail; i < 8 - lead; ++i) out += static_cast<char>(x >> (8 * i));
+}
+
+// Bounds-checked cursor over one frame payload; any overrun sets `bad` and
+// reads as zero from then on, so a decoder checks once at the end of a step.
+struct Cursor {
+  const uint8_t* p;
+  const uint8_t* end;
+  bool bad{false};
+
+  uint8_t u8() {
+    if (p == end) { bad = true; return 0; }
+    return *p++;
+  }
+  uint64_t uv() {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      const uint8_t b = u8();
+      if (bad) return 0;
+      v |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    bad = true;
+    return 0;
+  }
+  int64_t sv() {
+    const uint64_t u = uv();
+    return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+  }
+  std::string_view str() {
+    const uint64_t n = uv();
+    if (bad || n > static_cast<uint64_t>(end - p)) { bad = true; return {}; }
+    std::string_view s(reinterpret_cast<const char*>(p), n);
+    p += n;
+    return s;
+  }
+  const uint8_t* bytes(size_t n) {
+    if (n > static_cast<size_t>(end - p)) { bad = true; return nullptr; }
+    const uint8_t* b = p;
+    p += n;
+    return b;
+  }
+  double raw_f64() {
+    const uint8_t* b = bytes(8);
+    if (!b) return 0.0;
+    uint64_t bits;
+    std::memcpy(&bits, b, 8);
+    return std::bit_cast<double>(bits);
+  }
+  double xor_next(uint64_t& prev) {
+    const uint8_t ctrl = u8();
+    const int lead = ctrl >> 4, trail = ctrl & 0x0f;
+    if (lead + trail > 8) { bad = true; return 0.0; }
+    uint64_t x = 0;
+    for (int i = trail; i < 8 - lead; ++i) x |= static_cast<uint64_t>(u8()) << (8 * i);
+    prev ^= x;
+    return std::bit_cast<double>(prev);
+  }
+};
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r' || s.back() == '\n'))
+    s.remove_suffix(1);
+  return s;
+}
+
+SeriesKind kind_from_text(std::string_view t) {
+  if (t == "gauge") return SeriesKind::Gauge;
+  if (t == "counter") return SeriesKind::Counter;
+  if (t == "histogram") return SeriesKind::Histogram;
+  if (t == "summary") return SeriesKind::Summary;
+  return SeriesKind::Untyped;
+}
+
+constexpr std::string_view kTimestampComment = "# montauk_scrape_timestamp_ms ";
+constexpr uint32_t kNoPos = UINT32_MAX;
+
+// One sample line of Prometheus text, split where its name or label set
+// ends: name[{labels}] value [timestamp].
+struct PromSample {
+  std::string_view name, labels;
+  std::string_view key;   // name{labels}: the series' identity
+  std::string_view rest;  // the value, then anything after it
+};
+
+// The label scan honors quotes, since a '}' inside a quoted value is legal.
+bool split_sample(std::string_view ln, PromSample& out) {
+  const size_t name_end = ln.find_first_of("{ \t");
+  if (name_end == std::string_view::npos) return false;
+  out.name = ln.substr(0, name_end);
+  out.labels = {};
+  size_t after = name_end;
+  if (ln[name_end] == '{') {
+    size_t close = std::string_view::npos;
+    bool in_quote = false;
+    for (size_t j = name_end + 1; j < ln.size(); ++j) {
+      const char ch = ln[j];
+      if (in_quote) {
+        if (ch == '\\') ++j;
+        else if (ch == '"') in_quote = false;
+      } else if (ch == '"') {
+        in_quote = true;
+      } else if (ch == '}') {
+        close = j;
+        break;
+      }
+    }
+    if (close == std::string_view::npos) return false;
+    out.labels = ln.substr(name_end + 1, close - name_end - 1);
+    after = close + 1;
+  }
+  const size_t v = ln.find_first_not_of(" \t", after);
+  if (v == std::string_view::npos) return false;
+  out.key = ln.substr(0, after);
+  out.rest = ln.substr(v);
+  return true;
+}
+
+}  // namespace
+
+// ---- writer ---------------------------------------------------------------
+
+HistoryWriter::~HistoryWriter() { close(); }
+
+bool HistoryWriter::open(const char* path, int64_t now_ms) {
+  close();
+  f_ = std::fopen(path, "ab");
+  if (!f_) return false;
+  HistoryFileHeader hdr{};
+  std::memcpy(hdr.magic, kHistoryMagic, sizeof(hdr.magic));
+  hdr.version = kHistoryFormatVersion;
+  hdr.created_ms = now_ms;
+  if (std::fwrite(&hdr, sizeof(hdr), 1, f_) != 1 || std::fflush(f_) != 0) {
+    const int err = errno;
+    std::fclose(f_);
+    f_ = nullptr;
+    errno = err;
+    return false;
+  }
+  seg_pos_ = sizeof(hdr);
+  ids_.clear();
+  new_series_.clear();
+  cols_.clear();
+  ts_.clear();
+  index_.clear();
+  return true;
+}
+
+void HistoryWriter::close() {
+  if (!f_) return;
+  (void)write_block();
+  buf_.clear();
+  put_uv(buf_, index_.size());
+  for (const auto& e : index_) {
+    put_uv(buf_, e.offset);
+    put_sv(buf_, e.first_ms);
+    put_sv(buf_, e.last_ms);
+    put_uv(buf_, e.scrapes);
+  }
+  (void)write_frame(kHistoryTagIndex, buf_);
+  std::fclose(f_);
+  f_ = nullptr;
+}
+
+void HistoryWriter::begin_scrape(int64_t ts_ms) { ts_.push_back(ts_ms); }
+
+void HistoryWriter::sample(std::string_view name, std::string_view labels, SeriesKind kind, double v) {
+  key_.assign(name);
+  if (!labels.empty()) {
+    key_ += '{';
+    key_ += labels;
+    key_ += '}';
+  }
+  uint32_t id;
+  if (auto it = ids_.find(std::string_view(key_)); it != ids_.end()) {
+    id = it->second;
+  } else {
+    id = static_cast<uint32_t>(cols_.size());
+    ids_.emplace(key_, id);
+    new_series_.push_back({std::string(name), std::string(labels), kind});
+    cols_.emplace_back();
+  }
+  const uint32_t row = static_cast<uint32_t>(ts_.size() - 1);
+  Column& c = cols_[id];
+  if (!c.rows.empty() && c.rows.back() == row) {
+    c.vals.back() = v;
+  } else {
+    c.rows.push_back(row);
+    c.vals.push_back(v);
+  }
+}
+
+bool HistoryWriter::end_scrape() {
+  if (ts_.size() < kBlockScrapes && ts_.back() - ts_.front() < kBlockSpanMs) return true;
+  return write_block();
+}
+
+bool HistoryWriter::write_block() {
+  if (ts_.empty()) return true;
+  const size_t n = ts_.size();
+  buf_.clear();
+  put_uv(buf_, new_series_.size());
+  for (const auto& s : new_series_) {
+    buf_ += static_cast<char>(s.kind);
+    put_str(buf_, s.name);
+    put_str(buf_, s.labels);
+  }
+  put_uv(buf_, n);
+  put_uv(buf_, cols_.size());
+  put_sv(buf_, ts_[0]);
+  int64_t prev_delta = 0;
+  for (size_t i = 1; i < n; ++i) {
+    const int64_t delta = ts_[i] - ts_[i - 1];
+    put_sv(buf_, delta - prev_delta);
+    prev_delta = delta;
+  }
+
+  for (auto& c : cols_) {
+    if (c.rows.empty()) {
+      buf_ += static_cast<char>(HistoryColumn::Absent);
+      continue;
+    }
+    uint64_t prev = 0;
+    if (c.rows.size() == n) {
+      bool constant = true;
+      for (double v : c.vals) constant = constant && bits_of(v) == bits_of(c.vals[0]);
+      if (constant) {
+        buf_ += static_cast<char>(HistoryColumn::Const);
+        const uint64_t bits = bits_of(c.vals[0]);
+        buf_.append(reinterpret_cast<const char*>(&bits), 8);
+      } else {
+        buf_ += static_cast<char>(HistoryColumn::Xor);
+        for (double v : c.vals) put_xor(buf_, prev, v);
+      }
+    } else {
+      buf_ += static_cast<char>(HistoryColumn::Sparse);
+      const size_t at = buf_.size();
+      buf_.append((n + 7) / 8, '\0');
+      for (uint32_t r : c.rows) buf_[at + r / 8] = static_cast<char>(buf_[at + r / 8] | (1 << (r % 8)));
+      for (double v : c.vals) put_xor(buf_, prev, v);
+    }
+    c.rows.clear();
+    c.vals.clear();
+  }
+
+  index_.push_back({seg_pos_, ts_.front(), ts_.back(), static_cast<uint32_t>(n)});
+  new_series_.clear();
+  ts_.clear();
+  return write_frame(kHistoryTagBlock, buf_) && std::fflush(f_) == 0;
+}
+
+bool HistoryWriter::write_frame(uint32_t tag, const std::string& payload) {
+  const uint32_t head[2] = {tag, static_cast<uint32_t>(payload.size())};
+  if (std::fwrite(head, sizeof(head), 1, f_) != 1) return false;
+  if (!payload.empty() && std::fwrite(payload.data(), payload.size(), 1, f_) != 1) return false;
+  seg_pos_ += sizeof(head) + payload.size();
+  return true;
+}
+
+// ---- reader ---------------------------------------------------------------
+
+HistoryReader::~HistoryReader() { close(); }
+
+void HistoryReader::close() {
+  if (f_) {
+    std::fclose(f_);
+    f_ = nullptr;
+  }
+  std::free(line_);
+  line_ = nullptr;
+  line_cap_ = 0;
+}
+
+HistoryReadStatus HistoryReader::open(const char* path) {
+  close();
+  series_.clear();
+  ids_.clear();
+  local_.clear();
+  block_.clear();
+  block_next_ = 0;
+  types_.clear();
+  text_started_ = false;
+  text_next_ts_ = -1;
+  prev_ids_.clear();
+  prev_values_.clear();
+  text_delta_ = false;
+  status_ = HistoryReadStatus::Ok;
+
+  f_ = std::fopen(path, "rb");
+  if (!f_) return status_ = HistoryReadStatus::OpenFailed;
+  char magic[sizeof(kHistoryMagic)] = {};
+  const size_t got = std::fread(magic, 1, sizeof(magic), f_);
+  binary_ = got == sizeof(magic) && std::memcmp(magic, kHistoryMagic, sizeof(magic)) == 0;
+  std::rewind(f_);
+  if (binary_ && !read_segment_header()) {
+    close();
+    return status_;
+  }
+  return status_;
+}
+
+bool HistoryReader::next(HistoryScrape& out) {
+  if (!f_) return false;
+  return binary_ ? next_binary(out) : next_text(out);
+}
+
+uint32_t HistoryReader::intern(std::string_view name, std::string_view labels, SeriesKind kind) {
+  key_.assign(name);
+  if (!labels.empty()) {
+    key_ += '{';
+    key_ += labels;
+    key_ += '}';
+  }
+  if (auto it = ids_.find(std::string_view(key_)); it != ids_.end()) return it->second;
+  const auto id = static_cast<uint32_t>(series_.size());
+  ids_.emplace(key_, id);
+  series_.push_back({std::string(name), std::string(labels), kind});
+  return id;
+}
+
+bool HistoryReader::read_segment_header() {
+  HistoryFileHeader hdr{};
+  if (std::fread(&hdr, sizeof(hdr), 1, f_) != 1 ||
+      std::memcmp(hdr.magic, kHistoryMagic, sizeof(hdr.magic)) != 0) {
+    status_ = HistoryReadStatus::Corrupt;
+    return false;
+  }
+  if (hdr.version != kHistoryFormatVersion) {
+    status_ = HistoryReadStatus::BadVersion;
+    return false;
+  }
+  local_.clear();
+  return true;
+}
+
+bool HistoryReader::next_binary(HistoryScrape& out) {
+  while (block_next_ >= block_.size()) {
+    uint32_t head[2];
+    const size_t got = std::fread(head, 1, 4, f_);
+    if (got == 0) return false;  // clean end
+    if (got != 4) {
+      status_ = HistoryReadStatus::Corrupt;
+      return false;
+    }
+    // A segment appended by a writer that reopened the file mid-hour.
+    if (std::memcmp(head, kHistoryMagic, 4) == 0) {
+      if (std::fseek(f_, -4, SEEK_CUR) != 0 || !read_segment_header()) return false;
+      continue;
+    }
+    if (std::fread(&head[1], 4, 1, f_) != 1 || head[1] > kMaxFrameLen) {
+      status_ = HistoryReadStatus::Corrupt;
+      return false;
+    }
+    frame_.resize(head[1]);
+    if (head[1] && std::fread(frame_.data(), head[1], 1, f_) != 1) {
+      status_ = HistoryReadStatus::Corrupt;  // cut off mid-frame
+      return false;
+    }
+    if (head[0] == kHistoryTagBlock && !decode_block(frame_)) {
+      status_ = HistoryReadStatus::Corrupt;
+      return false;
+    }
+  }
+  HistoryScrape& s = block_[block_next_++];
+  out.ts_ms = s.ts_ms;
+  out.ids.swap(s.ids);
+  out.values.swap(s.values);
+  return true;
+}
+
+bool HistoryReader::decode_block(const std::vector<uint8_t>& payload) {
+  Cursor c{payload.data(), payload.data() + payload.size()};
+  const uint64_t n_new = c.uv();
+  for (uint64_t i = 0; i < n_new && !c.bad; ++i) {
+    const uint8_t kind = c.u8();
+    const std::string_view name = c.str();
+    const std::string_view labels = c.str();
+    if (c.bad || kind > static_cast<uint8_t>(SeriesKind::Summary)) return false;
+    local_.push_back(intern(name, labels, static_cast<SeriesKind>(kind)));
+  }
+  const uint64_t n = c.uv();
+  const uint64_t n_series = c.uv();
+  if (c.bad || n == 0 || n > kMaxBlockScrapes || n_series > local_.size()) return false;
+
+  block_.resize(n);
+  block_next_ = 0;
+  int64_t ts = c.sv(), delta = 0;
+  for (uint64_t r = 0; r < n; ++r) {
+    if (r > 0) {
+      delta += c.sv();
+      ts += delta;
+    }
+    block_[r].ts_ms = ts;
+    block_[r].ids.clear();
+    block_[r].values.clear();
+  }
+
+  for (uint64_t sid = 0; sid < n_series && !c.bad; ++sid) {
+    const uint32_t id = local_[sid];
+    const auto enc = static_cast<HistoryColumn>(c.u8());
+    uint64_t prev = 0;
+    switch (enc) {
+      case HistoryColumn::Absent:
+        break;
+      case HistoryColumn::Const: {
+        const double v = c.raw_f64();
+        for (auto& s : block_) {
+          s.ids.push_back(id);
+          s.values.push_back(v);
+        }
+        break;
+      }
+      case HistoryColumn::Xor:
+        for (auto& s : block_) {
+          s.ids.push_back(id);
+          s.values.push_back(c.xor_next(prev));
+        }
+        break;
+      case HistoryColumn::Sparse: {
+        const uint8_t* bitmap = c.bytes((n + 7) / 8);
+        if (!bitmap) return false;
+        for (uint64_t r = 0; r < n; ++r) {
+          if (!(bitmap[r / 8] & (1u << (r % 8)))) continue;
+          block_[r].ids.push_back(id);
+          block_[r].values.push_back(c.xor_next(prev));
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  if (c.bad) {
+    block_.clear();
+    return false;
+  }
+  return true;
+}
+
+SeriesKind HistoryReader::text_kind(std::string_view name) const {
+  if (auto it = types_.find(name); it != types_.end()) return it->second;
+  for (std::string_view suffix : {"_bucket", "_sum", "_count"}) {
+    if (!name.ends_with(suffix)) continue;
+    auto it = types_.find(name.substr(0, name.size() - suffix.size()));
+    if (it != types_.end() && (it->second == SeriesKind::Histogram || it->second == SeriesKind::Summary))
+      return it->second;
+  }
+  return SeriesKind::Untyped;
+}
+
+void HistoryReader::begin_text_delta(HistoryScrape& out) {
+  // The block restates nothing that did not change: start from the previous
+  // scrape and let the lines that follow overwrite, add and remove.
+  out.ids = prev_ids_;
+  out.values = prev_values_;
+  text_pos_.assign(series_.size(), kNoPos);
+  for (size_t i = 0; i < out.ids.size(); ++i) text_pos_[out.ids[i]] = static_cast<uint32_t>(i);
+  text_delta_ = true;
+}
+
+void HistoryReader::end_text_scrape(HistoryScrape& out) {
+  if (text_delta_) {
+    size_t w = 0;
+    for (size_t i = 0; i < out.ids.size(); ++i) {
+      if (out.ids[i] == kNoPos) continue;  // removed by the block
+      out.ids[w] = out.ids[i];
+      out.values[w++] = out.values[i];
+    }
+    out.ids.resize(w);
+    out.values.resize(w);
+    text_delta_ = false;
+  }
+  prev_ids_ = out.ids;
+  prev_values_ = out.values;
+}
+
+bool HistoryReader::next_text(HistoryScrape& out) {
+  out.ts_ms = text_next_ts_;
+  out.ids.clear();
+  out.values.clear();
+  bool open = text_started_;
+  ssize_t len;
+  while ((len = ::getline(&line_, &line_cap_, f_)) != -1) {
+    const std::string_view ln = trim(std::string_view(line_, static_cast<size_t>(len)));
+    if (ln.empty()) continue;
+    if (ln[0] == '#') {
+      if (ln.starts_with(kTimestampComment)) {
+        const int64_t ts = std::strtoll(ln.data() + kTimestampComment.size(), nullptr, 10);
+        if (open || !out.ids.empty()) {
+          text_next_ts_ = ts;
+          text_started_ = true;
+          end_text_scrape(out);
+          return true;
+        }
+        out.ts_ms = ts;
+        open = true;
+      } else if (ln == kPromDeltaComment) {
+        if (out.ids.empty() && !text_delta_) begin_text_delta(out);
+      } else if (ln.starts_with(kPromRemovedComment)) {
+        auto it = ids_.find(ln.substr(kPromRemovedComment.size()));
+        if (text_delta_ && it != ids_.end() && it->second < text_pos_.size() &&
+            text_pos_[it->second] != kNoPos) {
+          out.ids[text_pos_[it->second]] = kNoPos;
+          text_pos_[it->second] = kNoPos;
+        }
+      } else if (ln.starts_with("# TYPE ")) {
+        std::string_view rest = ln.substr(7);
+        const size_t sp = rest.find(' ');
+        if (sp != std::string_view::npos)
+          types_.insert_or_assign(std::string(rest.substr(0, sp)), kind_from_text(trim(rest.substr(sp + 1))));
+      }
+      continue;
+    }
+
+    PromSample smp;
+    if (!split_sample(ln, smp)) continue;
+    // The line buffer is NUL-terminated past the trimmed view, so strtod
+    // stops at the first space or the end of the line either way.
+    char* end = nullptr;
+    const double val = std::strtod(smp.rest.data(), &end);
+    if (end == smp.rest.data()) continue;
+
+    uint32_t id;
+    if (auto it = ids_.find(smp.key); it != ids_.end()) id = it->second;
+    else id = intern(smp.name, smp.labels, text_kind(smp.name));
+    if (text_delta_) {
+      if (id >= text_pos_.size()) text_pos_.resize(id + 1, kNoPos);
+      if (text_pos_[id] != kNoPos) {
+        out.values[text_pos_[id]] = val;
+        continue;
+      }
+      text_pos_[id] = static_cast<uint32_t>(out.ids.size());
+    }
+    out.ids.push_back(id);
+    out.values.push_back(val);
+  }
+  text_started_ = false;
+  text_next_ts_ = -1;
+  if (!open && out.ids.empty()) return false;
+  end_text_scrape(out);
+  return true;
+}
+
+// ---- change-only text -----------------------------------------------------
+
+void PromDeltaEncoder::encode(int64_t ts_ms, std::string_view body, std::string& out) {
+  const bool keyframe = keyframe_ms_ < 0 || ts_ms < keyframe_ms_ || ts_ms - keyframe_ms_ >= kKeyframeMs;
+  ++gen_;
+  if (keyframe) {
+    keyframe_ms_ = ts_ms;
+    ++keyframe_gen_;
+  }
+  char ts_buf[24];
+  auto [ptr, ec] = std::to_chars(ts_buf, ts_buf + sizeof(ts_buf), ts_ms);
+  out += kTimestampComment;
+  out.append(ts_buf, ptr);
+  out += '\n';
+  if (!keyframe) {
+    out += kPromDeltaComment;
+    out += '\n';
+  }
+
+  // The HELP/TYPE lines of the family being walked, written ahead of its
+  // first changed sample unless this keyframe span already has them.
+  std::string_view family, header;
+  for (std::string_view text = body; !text.empty();) {
+    const size_t nl = text.find('\n');
+    const std::string_view raw = text.substr(0, nl == std::string_view::npos ? text.size() : nl + 1);
+    text.remove_prefix(raw.size());
+    const std::string_view ln = trim(raw);
+    if (ln.empty()) continue;
+    if (ln[0] == '#') {
+      if (!ln.starts_with("# HELP ") && !ln.starts_with("# TYPE ")) continue;
+      const std::string_view name = ln.substr(7, ln.find(' ', 7) - 7);
+      if (name != family) {
+        family = name;
+        header = raw;
+      } else {
+        header = std::string_view(header.data(), raw.data() + raw.size() - header.data());
+      }
+      if (keyframe) {
+        if (auto it = headed_.find(name); it != headed_.end()) it->second = keyframe_gen_;
+        else headed_.emplace(name, keyframe_gen_);
+      }
+      continue;
+    }
+
+    PromSample smp;
+    if (!split_sample(ln, smp)) continue;
+    bool changed = true;
+    if (auto it = last_.find(smp.key); it == last_.end()) {
+      last_.emplace(smp.key, Entry{std::string(smp.rest), gen_});
+    } else {
+      changed = it->second.value != smp.rest;
+      if (changed) it->second.value.assign(smp.rest);
+      it->second.gen = gen_;
+    }
+    if (keyframe || !changed) continue;
+    if (!family.empty() && smp.name.starts_with(family)) {
+      auto it = headed_.find(family);
+      if (it == headed_.end() || it->second != keyframe_gen_) {
+        out += header;
+        if (it != headed_.end()) it->second = keyframe_gen_;
+        else headed_.emplace(family, keyframe_gen_);
+      }
+    }
+    out += ln;
+    out += '\n';
+  }
+  if (keyframe) {
+    out += body;
+    if (!body.empty() && body.back() != '\n') out += '\n';
+  }
+
+  for (auto it = last_.begin(); it != last_.end();) {
+    if (it->second.gen == gen_) {
+      ++it;
+      continue;
+    }
+    if (!keyframe) {
+      out += kPromRemovedComment;
+      out += it->first;
+      out += '\n';
+    }
+    it = last_.erase(it);
+  }
+}
+
+} // namespace montauk::model
@@ -0,0 +1,143 @@
+#include "model/Process.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+namespace montauk::model {
+
+namespace {
+
+// Every column, in declaration order; the one list the bulk operations below
+// share, so a new column is added here and in the struct and nowhere else.
+template <typename S>
+auto columns(S& s) {
+  return std::tie(s.pid, s.total_time, s.rss_kb, s.cpu_pct, s.churn_reason,
+                  s.has_gpu_util, s.gpu_util_pct, s.has_gpu_mem, s.gpu_mem_kb,
+                  s.user_name, s.cmd, s.exe_path, s.flt_raw, s.thread_count,
+                  s.start_time, s.vctx_raw, s.nvctx_raw, s.fault_delta,
+                  s.ctxsw_delta, s.anomaly_score, s.anomaly_axis, s.io_read_bps,
+                  s.io_write_bps, s.io_age_ms, s.pss_kb, s.pss_age_ms, s.ppid,
+                  s.subtree_cpu_pct, s.subtree_rss_kb, s.subtree_threads,
+                  s.subtree_procs);
+}
+
+template <typename Fn>
+void for_each_column(ProcessSnapshot& s, Fn&& fn) {
+  std::apply([&](auto&... col) { (fn(col), ...); }, columns(s));
+}
+
+void append(ProcessSnapshot& s, StringPool& pool, const ProcSample& r) {
+  s.pid.push_back(r.pid);
+  s.total_time.push_back(r.total_time);
+  s.rss_kb.push_back(r.rss_kb);
+  s.cpu_pct.push_back(r.cpu_pct);
+  s.churn_reason.push_back(r.churn_reason);
+  s.has_gpu_util.push_back(r.has_gpu_util);
+  s.gpu_util_pct.push_back(r.gpu_util_pct);
+  s.has_gpu_mem.push_back(r.has_gpu_mem);
+  s.gpu_mem_kb.push_back(r.gpu_mem_kb);
+  s.user_name.push_back(pool.intern(r.user_name));
+  s.cmd.push_back(pool.intern(r.cmd));
+  s.exe_path.push_back(pool.intern(r.exe_path));
+  s.flt_raw.push_back(r.flt_raw);
+  s.thread_count.push_back(r.thread_count);
+  s.start_time.push_back(r.start_time);
+  s.vctx_raw.push_back(r.vctx_raw);
+  s.nvctx_raw.push_back(r.nvctx_raw);
+  s.fault_delta.push_back(r.fault_delta);
+  s.ctxsw_delta.push_back(r.ctxsw_delta);
+  s.anomaly_score.push_back(r.anomaly_score);
+  s.anomaly_axis.push_back(r.anomaly_axis);
+  s.io_read_bps.push_back(r.io_read_bps);
+  s.io_write_bps.push_back(r.io_write_bps);
+  s.io_age_ms.push_back(r.io_age_ms);
+  s.pss_kb.push_back(r.pss_kb);
+  s.pss_age_ms.push_back(r.pss_age_ms);
+  s.ppid.push_back(r.ppid);
+  s.subtree_cpu_pct.push_back(r.subtree_cpu_pct);
+  s.subtree_rss_kb.push_back(r.subtree_rss_kb);
+  s.subtree_threads.push_back(r.subtree_threads);
+  s.subtree_procs.push_back(r.subtree_procs);
+}
+
+}  // namespace
+
+void ProcessSnapshot::assign_rows(std::span<const ProcSample> rows) {
+  // Rotating here, before this frame's strings go in, leaves the new pool
+  // holding exactly the live rows' strings.
+  if (!strings || strings->size() >= kPoolBudget) strings = std::make_shared<StringPool>();
+  clear_rows();
+  for_each_column(*this, [&](auto& col) { col.reserve(rows.size()); });
+  for (const auto& r : rows) append(*this, *strings, r);
+}
+
+void ProcessSnapshot::push_back(const ProcSample& r) {
+  if (!strings) strings = std::make_shared<StringPool>();
+  append(*this, *strings, r);
+}
+
+ProcSample ProcessSnapshot::row(size_t i) const {
+  ProcSample r;
+  r.pid = pid[i];
+  r.total_time = total_time[i];
+  r.rss_kb = rss_kb[i];
+  r.cpu_pct = cpu_pct[i];
+  r.churn_reason = churn_reason[i];
+  r.has_gpu_util = has_gpu_util[i] != 0;
+  r.gpu_util_pct = gpu_util_pct[i];
+  r.has_gpu_mem = has_gpu_mem[i] != 0;
+  r.gpu_mem_kb = gpu_mem_kb[i];
+  r.user_name = user_of(i);
+  r.cmd = cmd_of(i);
+  r.exe_path = exe_of(i);
+  r.flt_raw = flt_raw[i];
+  r.thread_count = thread_count[i];
+  r.start_time = start_time[i];
+  r.vctx_raw = vctx_raw[i];
+  r.nvctx_raw = nvctx_raw[i];
+  r.fault_delta = fault_delta[i];
+  r.ctxsw_delta = ctxsw_delta[i];
+  r.anomaly_score = anomaly_score[i];
+  r.anomaly_axis = anomaly_axis[i];
+  r.io_read_bps = io_read_bps[i];
+  r.io_write_bps = io_write_bps[i];
+  r.io_age_ms = io_age_ms[i];
+  r.pss_kb = pss_kb[i];
+  r.pss_age_ms = pss_age_ms[i];
+  r.ppid = ppid[i];
+  r.subtree_cpu_pct = subtree_cpu_pct[i];
+  r.subtree_rss_kb = subtree_rss_kb[i];
+  r.subtree_threads = subtree_threads[i];
+  r.subtree_procs = subtree_procs[i];
+  return r;
+}
+
+void ProcessSnapshot::assign_prefix(const ProcessSnapshot& src, size_t n) {
+  if (n > src.size()) n = src.size();
+  auto dst_cols = columns(*this);
+  auto src_cols = columns(src);
+  [&]<size_t... I>(std::index_sequence<I...>) {
+    (std::get<I>(dst_cols).assign(std::get<I>(src_cols).begin(),
+                                  std::get<I>(src_cols).begin() + static_cast<std::ptrdiff_t>(n)), ...);
+  }(std::make_index_sequence<std::tuple_size_v<decltype(dst_cols)>>{});
+  strings = src.strings;
+  total_processes = src.total_processes;
+  running_processes = src.running_processes;
+  enriched_count = src.enriched_count;
+  tracked_count = src.tracked_count;
+  state_running = src.state_running;
+  state_sleeping = src.state_sleeping;
+  state_zombie = src.state_zombie;
+  total_threads = src.total_threads;
+  sample_us = src.sample_us;
+  scan_shards = src.scan_shards;
+  anomaly_axis_mask = src.anomaly_axis_mask;
+  exited = src.exited;
+}
+
+void ProcessSnapshot::clear_rows() {
+  for_each_column(*this, [](auto& col) { col.clear(); });
+}
+
+}  // namespace montauk::model
@@ -0,0 +1,25 @@
+#include "model/StringPool.hpp"
+
+namespace montauk::model {
+
+StringPool::StringPool() {
+  chunks_[0] = std::make_unique<std::string[]>(kChunkSize);
+  count_ = 1;  // id 0 is the empty string
+  index_.emplace(std::string_view{}, kEmpty);
+}
+
+auto StringPool::intern(std::string_view s) -> Id {
+  if (auto it = index_.find(s); it != index_.end()) return it->second;
+  // A full pool degrades to "" rather than failing; assign_rows rotates to a
+  // fresh pool long before this (see kPoolBudget).
+  if (count_ == kCapacity) return kEmpty;
+  const size_t c = count_ >> kChunkShift;
+  if (!chunks_[c]) chunks_[c] = std::make_unique<std::string[]>(kChunkSize);
+  std::string& slot = chunks_[c][count_ & (kChunkSize - 1)];
+  slot.assign(s);
+  const Id id = static_cast<Id>(count_++);
+  index_.emplace(std::string_view(slot), id);
+  return id;
+}
+
+}  // namespace montauk::model
@@ -5,6 +5,7 @@
 #include "sublimation_stats.h"   // min/max reductions
 
 #include "prom_stats.hpp"
+#include "model/HistoryLog.hpp"
 #include "util/Log.hpp"
 #include "util/json.h"          // write-only JSON serializer on the sink (the --json renderer)
 
@@ -282,6 +283,39 @@ struct Hist {
   std::map<double, long long> buckets;  // le -> cumulative count
 };
 
+bool has_suffix(const std::string& s, const char* suffix) {
+  const size_t n = std::strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+// Every reader below consumes a recording file through HistoryReader, which
+// hands .prom text and .mhist binary out as the same scrapes of interned
+// series -- the readers match on a series once, by id, instead of on every
+// line's text.
+bool open_history(model::HistoryReader& r, const std::string& path) {
+  return r.open(path.c_str()) == model::HistoryReadStatus::Ok;
+}
+
+// A binary log cut short by a crash decodes up to its last whole block; say
+// that the rest was dropped rather than pass a short read off as the file.
+void note_history_end(const model::HistoryReader& r, const std::string& path) {
+  if (r.status() == model::HistoryReadStatus::Corrupt)
+    util::log_warn("%s: undecodable data after the last whole block, ignored", path.c_str());
+}
+
+// Per-id memo of what a reader makes of each series: filled the first time
+// an id appears, so classifying a series costs once per file, not per sample.
+template <class T>
+T& memo_at(std::vector<T>& memo, std::vector<bool>& seen, uint32_t id, bool& fresh) {
+  if (id >= memo.size()) {
+    memo.resize(id + 1);
+    seen.resize(id + 1, false);
+  }
+  fresh = !seen[id];
+  seen[id] = true;
+  return memo[id];
+}
+
 }  // namespace
 
 std::vector<std::string> glob_proms(const std::string& dir) {
@@ -290,7 +324,8 @@ std::vector<std::string> glob_proms(const std::string& dir) {
   if (!d) return out;
   for (dirent* e; (e = ::readdir(d)) != nullptr;) {
     std::string name = e->d_name;
-    if (name.size() < 6 || name.compare(name.size() - 5, 5, ".prom") != 0)
+    if (!((name.size() > 5 && has_suffix(name, ".prom")) ||
+          (name.size() > 6 && has_suffix(name, ".mhist"))))
       continue;
     if (name.rfind("analysis-", 0) == 0) continue;  // our own outputs
     out.push_back(dir + "/" + name);
@@ -306,76 +341,55 @@ std::vector<ScrapeSeries> scrape_series(const std::string& dir) {
   // in a diff, and a stable order is what makes that diff mean anything.
   std::unordered_map<std::string, size_t> idx;
   std::vector<ScrapeSeries> out;
-  std::unordered_map<std::string, double> sum;
+  std::vector<double> sum;          // parallel to `out`
   std::set<std::string> counters;  // families declared `# TYPE ... counter`
 
   for (const auto& path : glob_proms(dir)) {
-    FILE* fp = std::fopen(path.c_str(), "r");
-    if (!fp) continue;
-    char* line = nullptr;
-    size_t cap = 0;
-    ssize_t len;
-    while ((len = ::getline(&line, &cap, fp)) != -1) {
-      std::string ln = strip(std::string(line, len > 0 ? static_cast<size_t>(len) : 0));
-      if (ln.empty()) continue;
-      if (ln[0] == '#') {
-        // "# TYPE <name> counter" -- the declaration that decides whether the
-        // natural reduction is `last` (cumulative) or `mean` (instantaneous).
-        if (ln.rfind("# TYPE ", 0) != 0) continue;
-        size_t a = 7;
-        size_t b = ln.find(' ', a);
-        if (b == std::string::npos) continue;
-        if (ln.compare(b + 1, std::string::npos, "counter") == 0)
-          counters.insert(ln.substr(a, b - a));
-        continue;
-      }
-      // name[{labels}] value [timestamp]. Value is the FIRST token after the
-      // name or label set; a trailing Prometheus timestamp is ignored.
-      size_t brace = ln.find('{');
-      std::string key, valstr, family;
-      if (brace != std::string::npos) {
-        size_t close = ln.rfind('}');
-        if (close == std::string::npos || close < brace) continue;
-        family = ln.substr(0, brace);
-        key = ln.substr(0, close + 1);
-        size_t v = ln.find_first_not_of(" \t", close + 1);
-        if (v == std::string::npos) continue;
-        valstr = ln.substr(v);
-      } else {
-        size_t sp = ln.find(' ');
-        if (sp == std::string::npos) continue;
-        family = ln.substr(0, sp);
-        key = family;
-        size_t v = ln.find_first_not_of(" \t", sp);
-        if (v == std::string::npos) continue;
-        valstr = ln.substr(v);
-      }
-      char* end = nullptr;
-      double val = std::strtod(valstr.c_str(), &end);
-      if (end == valstr.c_str()) continue;
-      auto it = idx.find(key);
-      if (it == idx.end()) {
-        idx.emplace(key, out.size());
-        ScrapeSeries ss{};
-        ss.key = key;
-        ss.last = ss.max = ss.min = val;
-        ss.samples = 1;
-        out.push_back(ss);
-        sum[key] = val;
-      } else {
-        ScrapeSeries& ss = out[it->second];
+    model::HistoryReader reader;
+    if (!open_history(reader, path)) continue;
+    // A series' slot in `out`, resolved by key once per file. The TYPE
+    // declaration arrives as the series' kind: it decides whether the natural
+    // reduction is `last` (cumulative) or `mean` (instantaneous).
+    std::vector<size_t> slot;
+    std::vector<bool> seen;
+    model::HistoryScrape scrape;
+    while (reader.next(scrape)) {
+      for (size_t i = 0; i < scrape.ids.size(); ++i) {
+        const uint32_t id = scrape.ids[i];
+        const double val = scrape.values[i];
+        bool fresh;
+        size_t& at = memo_at(slot, seen, id, fresh);
+        if (fresh) {
+          const model::HistorySeries& series = reader.series()[id];
+          if (series.kind == model::SeriesKind::Counter) counters.insert(series.name);
+          std::string key = series.key();
+          auto it = idx.find(key);
+          if (it == idx.end()) {
+            it = idx.emplace(key, out.size()).first;
+            ScrapeSeries ss{};
+            ss.key = std::move(key);
+            out.push_back(std::move(ss));
+            sum.push_back(0.0);
+          }
+          at = it->second;
+        }
+        ScrapeSeries& ss = out[at];
+        if (ss.samples == 0) {
+          ss.max = ss.min = val;
+        } else {
+          ss.max = std::max(ss.max, val);
+          ss.min = std::min(ss.min, val);
+        }
         ss.last = val;
-        ss.max = std::max(ss.max, val);
-        ss.min = std::min(ss.min, val);
         ++ss.samples;
-        sum[key] += val;
+        sum[at] += val;
       }
     }
-    std::free(line);
-    std::fclose(fp);
+    note_history_end(reader, path);
   }
-  for (auto& ss : out) {
-    ss.mean = ss.samples > 0 ? sum[ss.key] / static_cast<double>(ss.samples) : 0.0;
+  for (size_t i = 0; i < out.size(); ++i) {
+    ScrapeSeries& ss = out[i];
+    ss.mean = ss.samples > 0 ? sum[i] / static_cast<double>(ss.samples) : 0.0;
     size_t brace = ss.key.find('{');
     std::string family = brace == std::string::npos ? ss.key : ss.key.substr(0, brace);
     ss.is_counter = counters.count(family) > 0;
@@ -416,8 +430,8 @@ void reconstruct(const Hist& h, std::vector<double>& out) {
 std::string capture_key_from_path(const std::string& path) {
   size_t slash = path.find_last_of('/');
   std::string base = (slash == std::string::npos) ? path : path.substr(slash + 1);
-  if (base.size() >= 5 && base.compare(base.size() - 5, 5, ".prom") == 0)
-    base.resize(base.size() - 5);
+  if (has_suffix(base, ".prom")) base.resize(base.size() - 5);
+  else if (has_suffix(base, ".mhist")) base.resize(base.size() - 6);
   std::string found;
   for (size_t i = 0; i + 15 <= base.size(); ++i) {
     bool ok = base[i + 8] == '-';
@@ -433,8 +447,8 @@ std::string capture_key_from_path(const std::string& path) {
 void parse_file(const std::string& path, const PopOptions& opt,
                 std::map<std::string, Family>& data, ParseStats& ps,
                 DiagLabelValues& diag) {
-  FILE* f = std::fopen(path.c_str(), "r");
-  if (!f) {
+  model::HistoryReader reader;
+  if (!open_history(reader, path)) {
     util::log_error("cannot open %s", path.c_str());
     return;
   }
@@ -448,7 +462,8 @@ void parse_file(const std::string& path, const PopOptions& opt,
     auto git = opt.file_group.find(path);
     if (git != opt.file_group.end()) group = git->second;
   }
-  // TYPE lines precede their series in the bench .prom, so a single pass works.
+  // TYPE lines precede their series in the bench .prom, so a single pass works;
+  // the reader carries each one as its series' kind.
   // family -> cellkey -> axis value -> cumulative-bucket histogram.
   std::map<std::string, std::map<std::string, std::map<std::string, Hist>>> file_hist;
   std::map<std::string, LabelVec> file_hist_disp;  // cellkey -> display
@@ -481,149 +496,114 @@ void parse_file(const std::string& path, const PopOptions& opt,
     drop_for_gauge.insert(l);
   }
 
-  char* line = nullptr;
-  size_t cap = 0;
-  ssize_t len;
-  while ((len = ::getline(&line, &cap, f)) != -1) {
-    std::string s = strip(std::string(line, len > 0 ? len : 0));
-    if (s.empty()) continue;
-    if (s[0] == '#') {
-      // "# TYPE <name> histogram"
-      if (s.rfind("# TYPE", 0) == 0) {
-        std::vector<std::string> tok;
-        size_t i = 0;
-        while (i < s.size()) {
-          while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
-          size_t j = i;
-          while (j < s.size() && !std::isspace(static_cast<unsigned char>(s[j]))) ++j;
-          if (j > i) tok.push_back(s.substr(i, j - i));
-          i = j;
+  // What a series is, worked out the first time its id appears: its labels
+  // parsed, and whether it is a *_info identity row. Values arrive already
+  // split from the name and label set; a trailing Prometheus timestamp never
+  // reaches them.
+  struct SeriesMemo {
+    LabelVec labels;
+    bool info{false};
+  };
+  std::vector<SeriesMemo> memo;
+  std::vector<bool> seen;
+  model::HistoryScrape scrape;
+  while (reader.next(scrape)) {
+    for (size_t si = 0; si < scrape.ids.size(); ++si) {
+      const uint32_t id = scrape.ids[si];
+      const double val = scrape.values[si];
+      if (!std::isfinite(val)) continue;
+      const model::HistorySeries& series = reader.series()[id];
+      const std::string& name = series.name;
+      bool fresh;
+      SeriesMemo& m = memo_at(memo, seen, id, fresh);
+      if (fresh) {
+        m.labels = parse_labels(series.labels);
+        m.info = name.size() > 5 && has_suffix(name, "_info");
+        // "# TYPE <name> histogram", as the kind of its _bucket/_sum/_count.
+        if (series.kind == model::SeriesKind::Histogram) {
+          for (const char* suffix : {"_bucket", "_sum", "_count"})
+            if (name.size() > std::strlen(suffix) && has_suffix(name, suffix))
+              hist_families.insert(alias_family(name.substr(0, name.size() - std::strlen(suffix)), opt));
         }
-        if (tok.size() >= 4 && tok[3] == "histogram")
-          hist_families.insert(alias_family(tok[2], opt));
-      }
-      continue;
-    }
-    // name[{labels}] value [timestamp]. The value is the FIRST token after
-    // the name or label set; a trailing Prometheus timestamp is tolerated
-    // and ignored on both paths (the braceless path used to take the LAST
-    // whitespace field, so `up 1 1720000000000` parsed as value 1.72e12).
-    // strtod stops at the space, so first-token semantics fall out of the
-    // parse itself once the split points are right.
-    size_t brace = s.find('{');
-    std::string name, labelstr, valstr;
-    if (brace != std::string::npos) {
-      name = s.substr(0, brace);
-      // Quote-aware close scan: a '}' inside a quoted label value is legal
-      // Prometheus text and must not terminate the label set.
-      size_t close = std::string::npos;
-      bool in_quote = false;
-      for (size_t j = brace + 1; j < s.size(); ++j) {
-        char c = s[j];
-        if (in_quote) {
-          if (c == '\\') {
-            ++j;
+        // Fragmenting-label diagnostic: record each raw label's value per file. A
+        // label constant within a file but distinct across files is a per-run key
+        // that fragments every cell to N=1; the post-parse scan names it and the
+        // exact --drop-label that unfragments the run. A series' labels are the
+        // same at every sample, so its first one says it all.
+        for (const auto& kv : m.labels) {
+          if (m.info || kv.first == opt.compare_axis || kv.first == "le" ||
+              kv.first == "capture")
             continue;
-          }
-          if (c == '"') in_quote = false;
-        } else if (c == '"') {
-          in_quote = true;
-        } else if (c == '}') {
-          close = j;
-          break;
+          bool dropped = false;
+          for (const auto& d : opt.drop_labels)
+            if (d == kv.first) { dropped = true; break; }
+          if (!dropped) diag[kv.first][path].insert(kv.second);
         }
       }
-      if (close == std::string::npos) continue;
-      labelstr = s.substr(brace + 1, close - brace - 1);
-      valstr = strip(s.substr(close + 1));
-    } else {
-      size_t sp = s.find_first_of(" \t");
-      if (sp == std::string::npos) continue;
-      name = strip(s.substr(0, sp));
-      valstr = strip(s.substr(sp + 1));
-    }
-    char* end = nullptr;
-    double val = std::strtod(valstr.c_str(), &end);
-    if (end == valstr.c_str() || !std::isfinite(val)) continue;
-
-    LabelVec labels = parse_labels(labelstr);
-
-    // version/commit: any *_info family carrying the label.
-    if (name.size() > 5 && name.compare(name.size() - 5, 5, "_info") == 0) {
-      std::string v = label_get(labels, "version");
-      if (!v.empty()) version = v;
-      std::string c = label_get(labels, "git_commit");
-      if (!c.empty()) commit = c;
-      continue;
-    }
 
-    // Fragmenting-label diagnostic: record each raw label's value per file. A
-    // label constant within a file but distinct across files is a per-run key
-    // that fragments every cell to N=1; the post-parse scan names it and the
-    // exact --drop-label that unfragments the run.
-    for (const auto& kv : labels) {
-      if (kv.first == opt.compare_axis || kv.first == "le" ||
-          kv.first == "capture")
+      // version/commit: any *_info family carrying the label.
+      if (m.info) {
+        std::string v = label_get(m.labels, "version");
+        if (!v.empty()) version = v;
+        std::string c = label_get(m.labels, "git_commit");
+        if (!c.empty()) commit = c;
         continue;
-      bool dropped = false;
-      for (const auto& d : opt.drop_labels)
-        if (d == kv.first) { dropped = true; break; }
-      if (!dropped) diag[kv.first][path].insert(kv.second);
-    }
+      }
+      LabelVec labels = m.labels;
+
+      // Histogram component? The base is aliased before the lookup, so a
+      // renamed histogram family's buckets land under the new name alongside
+      // the TYPE line's own aliased insert.
+      auto is_hist_part = [&](const std::string& suffix) {
+        if (name.size() <= suffix.size()) return std::string();
+        if (name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+          return std::string();
+        std::string base =
+            alias_family(name.substr(0, name.size() - suffix.size()), opt);
+        return hist_families.count(base) ? base : std::string();
+      };
+      std::string hb = is_hist_part("_bucket");
+      bool is_sum = !is_hist_part("_sum").empty();
+      bool is_count = !is_hist_part("_count").empty();
+      if (!hb.empty()) {
+        labels.emplace_back("version", version);
+        labels.emplace_back("commit", commit);
+        labels.emplace_back("capture", capture);
+        if (!group.empty()) labels.emplace_back("group", group);
+        ++ps.samples;
+        std::string axv = label_get(labels, opt.compare_axis);
+        if (axv.empty()) {
+          ++ps.no_axis;
+          continue;
+        }
+        std::string ck = cell_key(labels, drop_for_cell);  // drops le + axis
+        file_hist[hb][ck][axv].buckets[le_value(label_get(labels, "le"))] =
+            static_cast<long long>(val);
+        if (!file_hist_disp.count(ck))
+          file_hist_disp[ck] = cell_display(labels, drop_for_cell);
+        continue;
+      }
+      if (is_sum || is_count) continue;  // histogram scalars: ignore
 
-    // Histogram component? The base is aliased before the lookup, so a
-    // renamed histogram family's buckets land under the new name alongside
-    // the TYPE line's own aliased insert.
-    auto is_hist_part = [&](const std::string& suffix) {
-      if (name.size() <= suffix.size()) return std::string();
-      if (name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
-        return std::string();
-      std::string base =
-          alias_family(name.substr(0, name.size() - suffix.size()), opt);
-      return hist_families.count(base) ? base : std::string();
-    };
-    std::string hb = is_hist_part("_bucket");
-    bool is_sum = !is_hist_part("_sum").empty();
-    bool is_count = !is_hist_part("_count").empty();
-    if (!hb.empty()) {
+      // Plain gauge: one per-run scalar for (family, full labels).
       labels.emplace_back("version", version);
       labels.emplace_back("commit", commit);
       labels.emplace_back("capture", capture);
       if (!group.empty()) labels.emplace_back("group", group);
       ++ps.samples;
-      std::string axv = label_get(labels, opt.compare_axis);
-      if (axv.empty()) {
+      std::string axis = label_get(labels, opt.compare_axis);
+      if (axis.empty()) {
         ++ps.no_axis;
-        continue;
+        continue;  // cannot place without the compare axis
       }
-      std::string ck = cell_key(labels, drop_for_cell);  // drops le + axis
-      file_hist[hb][ck][axv].buckets[le_value(label_get(labels, "le"))] =
-          static_cast<long long>(val);
-      if (!file_hist_disp.count(ck))
-        file_hist_disp[ck] = cell_display(labels, drop_for_cell);
-      continue;
-    }
-    if (is_sum || is_count) continue;  // histogram scalars: ignore
-
-    // Plain gauge: one per-run scalar for (family, full labels).
-    labels.emplace_back("version", version);
-    labels.emplace_back("commit", commit);
-    labels.emplace_back("capture", capture);
-    if (!group.empty()) labels.emplace_back("group", group);
-    ++ps.samples;
-    std::string axis = label_get(labels, opt.compare_axis);
-    if (axis.empty()) {
-      ++ps.no_axis;
-      continue;  // cannot place without the compare axis
+      std::string ck = cell_key(labels, drop_for_gauge);
+      Family& fam = data[alias_family(name, opt)];
+      Cell& cell = fam.cells[ck];
+      if (cell.display.empty()) cell.display = cell_display(labels, drop_for_gauge);
+      cell.runs[axis].push_back(val);
     }
-    std::string ck = cell_key(labels, drop_for_gauge);
-    Family& fam = data[alias_family(name, opt)];
-    Cell& cell = fam.cells[ck];
-    if (cell.display.empty()) cell.display = cell_display(labels, drop_for_gauge);
-    cell.runs[axis].push_back(val);
   }
-  std::free(line);
-  std::fclose(f);
+  note_history_end(reader, path);
   if (version != "unknown") ++ps.files_with_version;
 
   // Fold this file's reconstructed histograms into the population pools,
@@ -1427,19 +1407,16 @@ int run_population(const std::vector<std::string>& files, const PopOptions& opt)
 SystemInfo system_info_data(const std::string& dir) {
   std::string labels;  // last montauk_system_info{...} wins
   for (const auto& path : glob_proms(dir)) {
-    FILE* fp = std::fopen(path.c_str(), "r");
-    if (!fp) continue;
-    char* line = nullptr;
-    size_t cap = 0;
-    ssize_t len;
-    while ((len = ::getline(&line, &cap, fp)) != -1) {
-      std::string ln(line, len > 0 ? static_cast<size_t>(len) : 0);
-      if (ln.rfind("montauk_system_info{", 0) != 0) continue;
-      size_t br = ln.find('{'), cb = ln.find('}', br);
-      if (cb != std::string::npos) labels = ln.substr(br + 1, cb - br - 1);
+    model::HistoryReader reader;
+    if (!open_history(reader, path)) continue;
+    model::HistoryScrape scrape;
+    while (reader.next(scrape)) {
+      for (uint32_t id : scrape.ids) {
+        const model::HistorySeries& series = reader.series()[id];
+        if (series.name == "montauk_system_info" && !series.labels.empty()) labels = series.labels;
+      }
     }
-    std::free(line);
-    std::fclose(fp);
+    note_history_end(reader, path);
   }
   SystemInfo info;
   if (labels.empty()) return info;
@@ -1494,45 +1471,38 @@ ScxStability scx_stability_data(const std::string& dir) {
   ScxStability s;
   std::vector<std::string> seen;  // dedup key: the formatted line, as before
   for (const auto& path : glob_proms(dir)) {
-    FILE* fp = std::fopen(path.c_str(), "r");
-    if (!fp) continue;
-    char* line = nullptr;
-    size_t cap = 0;
-    ssize_t len;
-    while ((len = ::getline(&line, &cap, fp)) != -1) {
-      std::string ln = strip(std::string(line, len > 0 ? static_cast<size_t>(len) : 0));
-      if (ln.rfind("montauk_scx_ejected{", 0) == 0) {
-        size_t br = ln.find('{'), cb = ln.find('}', br);
-        if (cb == std::string::npos) continue;
-        LabelVec L = parse_labels(ln.substr(br + 1, cb - br - 1));
-        ScxEjection e{label_get(L, "scheduler"), label_get(L, "reason"),
-                      label_get(L, "phase"), label_get(L, "cores")};
-        std::string key = format_ejection(e);
-        if (std::find(seen.begin(), seen.end(), key) == seen.end()) {
-          seen.push_back(key);
-          s.ejections.push_back(std::move(e));
-        }
-      } else if (ln.rfind("montauk_cleanroom{", 0) == 0) {
-        size_t br = ln.find('{'), cb = ln.find('}', br);
-        if (cb == std::string::npos) continue;
-        LabelVec L = parse_labels(ln.substr(br + 1, cb - br - 1));
-        s.cleanroom_verdict = label_get(L, "verdict");
-        s.cleanroom_detail = label_get(L, "detail");
-      } else if (ln.rfind("montauk_watchdog_proximity_pct", 0) == 0) {
-        size_t sp = ln.rfind(' ');
-        double v = sp != std::string::npos ? std::atof(ln.c_str() + sp + 1) : 0;
-        std::string where;
-        size_t br = ln.find('{'), cb = ln.find('}', br);
-        if (cb != std::string::npos && br != std::string::npos) {
-          LabelVec L = parse_labels(ln.substr(br + 1, cb - br - 1));
-          std::string ph = label_get(L, "phase"), co = label_get(L, "cores");
-          where = ph + (co.empty() ? "" : (ph.empty() ? "" : " ") + co + "c");
+    model::HistoryReader reader;
+    if (!open_history(reader, path)) continue;
+    model::HistoryScrape scrape;
+    while (reader.next(scrape)) {
+      for (size_t i = 0; i < scrape.ids.size(); ++i) {
+        const model::HistorySeries& series = reader.series()[scrape.ids[i]];
+        if (series.name == "montauk_scx_ejected" && !series.labels.empty()) {
+          LabelVec L = parse_labels(series.labels);
+          ScxEjection e{label_get(L, "scheduler"), label_get(L, "reason"),
+                        label_get(L, "phase"), label_get(L, "cores")};
+          std::string key = format_ejection(e);
+          if (std::find(seen.begin(), seen.end(), key) == seen.end()) {
+            seen.push_back(key);
+            s.ejections.push_back(std::move(e));
+          }
+        } else if (series.name == "montauk_cleanroom" && !series.labels.empty()) {
+          LabelVec L = parse_labels(series.labels);
+          s.cleanroom_verdict = label_get(L, "verdict");
+          s.cleanroom_detail = label_get(L, "detail");
+        } else if (series.name == "montauk_watchdog_proximity_pct") {
+          const double v = scrape.values[i];
+          std::string where;
+          if (!series.labels.empty()) {
+            LabelVec L = parse_labels(series.labels);
+            std::string ph = label_get(L, "phase"), co = label_get(L, "cores");
+            where = ph + (co.empty() ? "" : (ph.empty() ? "" : " ") + co + "c");
+          }
+          if (v > s.watchdog_worst_pct) { s.watchdog_worst_pct = v; s.watchdog_where = where; }
         }
-        if (v > s.watchdog_worst_pct) { s.watchdog_worst_pct = v; s.watchdog_where = where; }
       }
     }
-    std::free(line);
-    std::fclose(fp);
+    note_history_end(reader, path);
   }
   return s;
 }
@@ -1576,64 +1546,73 @@ ThermalPower thermal_power_data(const std::string& dir) {
   double br_sum = 0; int br_n = 0;
   double e_min = -1.0, e_max = -1.0; int e_n = 0;  // package energy counter -> integral
   std::map<std::string, std::pair<double, int>> cstate;  // name -> (sum%, n)
-  const std::string kTemp = "montauk_thermal_cpu_temperature_celsius ";
-  const std::string kFan = "montauk_thermal_fan_speed_rpm ";
-  const std::string kPow = "montauk_power_watts ";
-  const std::string kFreq = "montauk_cpu_frequency_mhz_avg ";
-  const std::string kEpi = "montauk_energy_per_instruction_pj ";
-  const std::string kCtx = "montauk_pmu_context_switches_per_second ";
-  const std::string kMig = "montauk_pmu_cpu_migrations_per_second ";
-  const std::string kBr = "montauk_pmu_branch_misses_per_second ";
-  const std::string kCst = "montauk_cstate_residency_percent{state=\"";
-  const std::string kEnergy = "montauk_package_energy_joules_total ";
+  // Unlabeled series by exact name, plus the per-state C-state residency.
+  enum Role : uint8_t { kNone, kTemp, kFan, kPow, kFreq, kEpi, kCtx, kMig, kBr, kEnergy, kCst };
+  static constexpr std::pair<const char*, Role> kRoles[] = {
+      {"montauk_thermal_cpu_temperature_celsius", kTemp},
+      {"montauk_thermal_fan_speed_rpm", kFan},
+      {"montauk_power_watts", kPow},
+      {"montauk_cpu_frequency_mhz_avg", kFreq},
+      {"montauk_energy_per_instruction_pj", kEpi},
+      {"montauk_pmu_context_switches_per_second", kCtx},
+      {"montauk_pmu_cpu_migrations_per_second", kMig},
+      {"montauk_pmu_branch_misses_per_second", kBr},
+      {"montauk_package_energy_joules_total", kEnergy},
+  };
+  const std::string kCstState = "state=\"";
+  struct RoleMemo {
+    Role role{kNone};
+    std::string cstate;
+  };
   for (const auto& path : glob_proms(dir)) {
-    FILE* fp = std::fopen(path.c_str(), "r");
-    if (!fp) continue;
-    char* line = nullptr;
-    size_t cap = 0;
-    ssize_t len;
-    while ((len = ::getline(&line, &cap, fp)) != -1) {
-      std::string ln = strip(std::string(line, len > 0 ? static_cast<size_t>(len) : 0));
-      if (ln.rfind(kTemp, 0) == 0) {
-        double v = std::strtod(ln.c_str() + kTemp.size(), nullptr);
-        temp_peak = std::max(temp_peak, v);
-        temp_sum += v;
-        ++temp_n;
-      } else if (ln.rfind(kFan, 0) == 0) {
-        fan_peak = std::max(fan_peak, std::strtod(ln.c_str() + kFan.size(), nullptr));
-      } else if (ln.rfind(kPow, 0) == 0) {
-        double v = std::strtod(ln.c_str() + kPow.size(), nullptr);
-        if (v > 0.0) { pw_peak = std::max(pw_peak, v); pw_sum += v; ++pw_n; }
-      } else if (ln.rfind(kFreq, 0) == 0) {
-        double v = std::strtod(ln.c_str() + kFreq.size(), nullptr);
-        if (v > 0.0) { fq_peak = std::max(fq_peak, v); fq_sum += v; ++fq_n; }
-      } else if (ln.rfind(kEpi, 0) == 0) {
-        double v = std::strtod(ln.c_str() + kEpi.size(), nullptr);
-        if (v > 0.0) { epi_sum += v; ++epi_n; }
-      } else if (ln.rfind(kCtx, 0) == 0) {
-        ctx_sum += std::strtod(ln.c_str() + kCtx.size(), nullptr); ++ctx_n;
-      } else if (ln.rfind(kMig, 0) == 0) {
-        mig_sum += std::strtod(ln.c_str() + kMig.size(), nullptr); ++mig_n;
-      } else if (ln.rfind(kBr, 0) == 0) {
-        br_sum += std::strtod(ln.c_str() + kBr.size(), nullptr); ++br_n;
-      } else if (ln.rfind(kEnergy, 0) == 0) {
-        double v = std::strtod(ln.c_str() + kEnergy.size(), nullptr);
-        if (e_min < 0.0 || v < e_min) e_min = v;
-        if (v > e_max) e_max = v;
-        ++e_n;
-      } else if (ln.rfind(kCst, 0) == 0) {
-        size_t q = ln.find('"', kCst.size());
-        size_t b = ln.find("} ", kCst.size());
-        if (q != std::string::npos && b != std::string::npos) {
-          std::string name = ln.substr(kCst.size(), q - kCst.size());
-          double v = std::strtod(ln.c_str() + b + 2, nullptr);
-          auto& e = cstate[name];
-          e.first += v; e.second += 1;
+    model::HistoryReader reader;
+    if (!open_history(reader, path)) continue;
+    std::vector<RoleMemo> memo;
+    std::vector<bool> seen;
+    model::HistoryScrape scrape;
+    while (reader.next(scrape)) {
+      for (size_t i = 0; i < scrape.ids.size(); ++i) {
+        bool fresh;
+        RoleMemo& m = memo_at(memo, seen, scrape.ids[i], fresh);
+        if (fresh) {
+          const model::HistorySeries& series = reader.series()[scrape.ids[i]];
+          if (series.labels.empty()) {
+            for (const auto& [name, role] : kRoles)
+              if (series.name == name) m.role = role;
+          } else if (series.name == "montauk_cstate_residency_percent" &&
+                     series.labels.starts_with(kCstState)) {
+            size_t q = series.labels.find('"', kCstState.size());
+            if (q != std::string::npos) {
+              m.role = kCst;
+              m.cstate = series.labels.substr(kCstState.size(), q - kCstState.size());
+            }
+          }
+        }
+        const double v = scrape.values[i];
+        switch (m.role) {
+          case kNone: break;
+          case kTemp: temp_peak = std::max(temp_peak, v); temp_sum += v; ++temp_n; break;
+          case kFan: fan_peak = std::max(fan_peak, v); break;
+          case kPow: if (v > 0.0) { pw_peak = std::max(pw_peak, v); pw_sum += v; ++pw_n; } break;
+          case kFreq: if (v > 0.0) { fq_peak = std::max(fq_peak, v); fq_sum += v; ++fq_n; } break;
+          case kEpi: if (v > 0.0) { epi_sum += v; ++epi_n; } break;
+          case kCtx: ctx_sum += v; ++ctx_n; break;
+          case kMig: mig_sum += v; ++mig_n; break;
+          case kBr: br_sum += v; ++br_n; break;
+          case kEnergy:
+            if (e_min < 0.0 || v < e_min) e_min = v;
+            if (v > e_max) e_max = v;
+            ++e_n;
+            break;
+          case kCst: {
+            auto& e = cstate[m.cstate];
+            e.first += v; e.second += 1;
+            break;
+          }
         }
       }
     }
-    std::free(line);
-    std::fclose(fp);
+    note_history_end(reader, path);
   }
   ThermalPower t;
   t.temp_peak_c = temp_peak; t.temp_avg_c = temp_n > 0 ? temp_sum / temp_n : 0.0; t.temp_n = temp_n;
@@ -1730,46 +1709,57 @@ L2Shares compute_l2_shares(const std::string& dir) {
   std::vector<std::string> files = glob_proms(dir);
   if (files.empty()) return r;
 
-  // A montauk recording is a concatenation of per-scrape expositions; one
-  // "# HELP montauk_cpu_usage_percent" opens each scrape. Per scrape we keep the
-  // aggregate L2 (to find the busy/storm window) and the per-CPU breakdown.
+  // A montauk recording is a concatenation of per-scrape expositions, and
+  // montauk_cpu_usage_percent is the first series of each one -- it opens a
+  // scrape even in a bench .prom that carries no timestamp comments. Per
+  // scrape we keep the aggregate L2 (to find the busy/storm window) and the
+  // per-CPU breakdown.
   struct Scrape { double total = 0.0; std::map<int, double> per_cpu; };
   std::vector<Scrape> scrapes;
   Scrape cur;
   bool open = false;
-  const std::string kDelim = "# HELP montauk_cpu_usage_percent";
-  const std::string kIval  = "montauk_pmu_l2_misses_interval ";
-  const std::string kPer   = "montauk_pmu_l2_misses_per_cpu{";
+  enum Role : uint8_t { kNone, kDelim, kIval, kPer };
+  struct RoleMemo {
+    Role role{kNone};
+    int cpu{0};
+  };
 
   for (const auto& path : files) {
-    FILE* fp = std::fopen(path.c_str(), "r");
-    if (!fp) continue;
-    char* line = nullptr;
-    size_t cap = 0;
-    ssize_t len;
-    while ((len = ::getline(&line, &cap, fp)) != -1) {
-      std::string ln = strip(std::string(line, len > 0 ? static_cast<size_t>(len) : 0));
-      if (ln.rfind(kDelim, 0) == 0) {
-        if (open) scrapes.push_back(cur);
-        cur = Scrape{};
+    model::HistoryReader reader;
+    if (!open_history(reader, path)) continue;
+    std::vector<RoleMemo> memo;
+    std::vector<bool> seen;
+    model::HistoryScrape scrape;
+    while (reader.next(scrape)) {
+      for (size_t i = 0; i < scrape.ids.size(); ++i) {
+        bool fresh;
+        RoleMemo& m = memo_at(memo, seen, scrape.ids[i], fresh);
+        if (fresh) {
+          const model::HistorySeries& series = reader.series()[scrape.ids[i]];
+          if (series.name == "montauk_cpu_usage_percent" && series.labels.empty()) {
+            m.role = kDelim;
+          } else if (series.name == "montauk_pmu_l2_misses_interval" && series.labels.empty()) {
+            m.role = kIval;
+          } else if (series.name == "montauk_pmu_l2_misses_per_cpu") {
+            std::string cpu = label_get(parse_labels(series.labels), "cpu");
+            if (!cpu.empty()) {
+              m.role = kPer;
+              m.cpu = std::atoi(cpu.c_str());
+            }
+          }
+        }
+        if (m.role == kDelim) {
+          if (open) scrapes.push_back(cur);
+          cur = Scrape{};
+        } else if (m.role == kIval) {
+          cur.total = scrape.values[i];
+        } else if (m.role == kPer) {
+          cur.per_cpu[m.cpu] += scrape.values[i];
+        }
         open = true;
-        continue;
-      }
-      open = true;
-      if (ln.rfind(kIval, 0) == 0) {
-        cur.total = std::strtod(ln.c_str() + kIval.size(), nullptr);
-      } else if (ln.rfind(kPer, 0) == 0) {
-        size_t br = ln.find('{'), cb = ln.find('}', br);
-        if (cb == std::string::npos) continue;
-        LabelVec labels = parse_labels(ln.substr(br + 1, cb - br - 1));
-        std::string cpu = label_get(labels, "cpu");
-        if (cpu.empty()) continue;
-        cur.per_cpu[std::atoi(cpu.c_str())] +=
-            std::strtod(strip(ln.substr(cb + 1)).c_str(), nullptr);
       }
     }
-    std::free(line);
-    std::fclose(fp);
+    note_history_end(reader, path);
   }
   if (open) scrapes.push_back(cur);
   r.scrapes = scrapes.size();
@@ -1805,7 +1795,7 @@ int run_l2_by_cpu(const std::string& dir, bool want_json) {
   ensure_pop_out();
   std::vector<std::string> files = glob_proms(dir);
   if (files.empty()) {
-    util::log_error("no montauk_*.prom in %s", dir.c_str());
+    util::log_error("no montauk_*.prom or *.mhist in %s", dir.c_str());
     return 1;
   }
   util::log_info("l2-by-cpu: %zu scrape file(s) in %s", files.size(), dir.c_str());
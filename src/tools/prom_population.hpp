@@ -86,7 +86,8 @@ struct HotCpu {
 };
 HotCpu l2_hot_cpu(const std::string& dir);
 
-// All `*.prom` in `dir` except the analyzer's own `analysis-*` outputs.
+// All `*.prom` and binary `*.mhist` logs in `dir` except the analyzer's own
+// `analysis-*` outputs. Every reader here takes either format.
 std::vector<std::string> glob_proms(const std::string& dir);
 
 // EVERY gauge in a recording's scrapes, reduced to one value per
@@ -7417,7 +7417,7 @@ int montauk_analyze_main(int argc, char** argv) {
         "                        UNKNOWN completeness declines unless\n"
         "                        --allow-unknown, since absence of the drop counter\n"
         "                        is not evidence of a lossless capture)\n"
-        "       montauk --analyze DIR|FILE.prom [more.prom...] [--by LABEL]\n"
+        "       montauk --analyze DIR|FILE.prom|FILE.mhist [more...] [--by LABEL]\n"
         "                       [--pairs adjacent|all|vs-best] [--trajectory]\n"
         "                       [--metric substr] [--full] [--higher-better]\n"
         "                       [--alias OLD=NEW] [--alias-axis OLD=NEW]\n"
@@ -7467,7 +7467,8 @@ int montauk_analyze_main(int argc, char** argv) {
     struct stat st{};
     bool is_dir = (::stat(path, &st) == 0 && S_ISDIR(st.st_mode));
     std::string p1 = path;
-    bool is_prom = p1.size() > 5 && p1.compare(p1.size() - 5, 5, ".prom") == 0;
+    bool is_prom = (p1.size() > 5 && p1.compare(p1.size() - 5, 5, ".prom") == 0) ||
+                   (p1.size() > 6 && p1.compare(p1.size() - 6, 6, ".mhist") == 0);
     bool has_group = false;
     for (int i = 1; i < argc; ++i)
       if (std::string(argv[i]) == "--group") has_group = true;
@@ -168,6 +168,17 @@ const Config& config() {
     c.process.max_procs    = resolve_int(toml, have_toml, "process", "max_procs",    "MONTAUK_MAX_PROCS", 256);
     c.process.enrich_top_n = resolve_int(toml, have_toml, "process", "enrich_top_n", "MONTAUK_ENRICH_TOP_N", c.process.max_procs);
     c.process.collector    = resolve_string(toml, have_toml, "process", "collector",  "MONTAUK_COLLECTOR", "auto");
+    c.process.scan_threads = resolve_int(toml, have_toml, "process", "scan_threads", "MONTAUK_SCAN_THREADS", 0);
+    c.process.fd_cache     = resolve_int(toml, have_toml, "process", "fd_cache",     "MONTAUK_FD_CACHE", -1);
+    c.process.cpu_accounting = resolve_string(toml, have_toml, "process", "cpu_accounting", "MONTAUK_CPU_ACCOUNTING", "ticks");
+    c.process.interval_ms  = resolve_int(toml, have_toml, "process", "interval_ms",  "MONTAUK_PROC_INTERVAL_MS", 0);
+    c.process.io_budget_us = resolve_int(toml, have_toml, "process", "io_budget_us", "MONTAUK_IO_BUDGET_US", 2000);
+    c.process.io_top_k     = resolve_int(toml, have_toml, "process", "io_top_k",     "MONTAUK_IO_TOP_K", 16);
+
+    // --- [psi] ---
+    c.psi.stall_ms  = resolve_int(toml, have_toml, "psi", "stall_ms",  "MONTAUK_PSI_STALL_MS", 150);
+    c.psi.window_ms = resolve_int(toml, have_toml, "psi", "window_ms", "MONTAUK_PSI_WINDOW_MS", 1000);
+    c.psi.cgroups   = resolve_string(toml, have_toml, "psi", "cgroups", "MONTAUK_PSI_CGROUPS", "");
 
     // --- [nvidia] ---
     c.nvidia.smi_path            = resolve_string(toml, have_toml, "nvidia", "smi_path",            "MONTAUK_NVIDIA_SMI_PATH", "auto");
@@ -118,7 +118,12 @@ void best_effort_write(int fd, const char* buf, size_t len) {
 }
 
 void restore_terminal_minimal() {
-  // Async-signal-safe restoration: exit alt screen first, then show cursor, reset SGR
+  // Async-signal-safe restoration: exit alt screen first, then show cursor, reset SGR.
+  // Only on a terminal: piped output (--json-stream, --headless > file) is data,
+  // and a Ctrl+C or SIGTERM must not append escapes to it. tcgetattr, unlike
+  // isatty, is on the async-signal-safe list.
+  termios t{};
+  if (tcgetattr(STDOUT_FILENO, &t) != 0) return;
   const char* alt_off = "\x1B[?1049l";
   const char* show_cur = "\x1B[?25h";
   const char* reset = "\x1B[0m";
@@ -15,6 +15,7 @@
 #include <iomanip>
 #include <numeric>
 #include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace montauk::ui::widgets {
@@ -38,6 +39,72 @@ std::string format_pct_digits(double pct) {
   return oss.str();
 }
 
+// Re-thread the sorted, filtered rows depth-first under their parents,
+// siblings keeping the active sort order. A row whose parent is not in the
+// table (outside the top-K, or filtered out) starts a root; children of a
+// collapsed row are left out. One pass to link, one to walk.
+void thread_tree(const montauk::model::ProcessSnapshot& procs,
+                 const std::unordered_set<int32_t>& collapsed,
+                 std::vector<size_t>& order, std::vector<int>& depth,
+                 std::vector<uint8_t>& has_kids) {
+  constexpr size_t kNone = static_cast<size_t>(-1);
+  const size_t n = procs.size();
+  thread_local std::unordered_map<int32_t, size_t> row_of;
+  thread_local std::vector<size_t> first, last, next, cursor, stack, out;
+  thread_local std::vector<uint8_t> emitted;
+  row_of.clear();
+  for (size_t r : order) row_of.emplace(procs.pid[r], r);
+  first.assign(n, kNone); last.assign(n, kNone); next.assign(n, kNone);
+  depth.assign(n, 0);
+  has_kids.assign(n, 0);
+  emitted.assign(n, 0);
+  for (size_t r : order) {
+    auto it = procs.ppid[r] > 0 ? row_of.find(procs.ppid[r]) : row_of.end();
+    if (it == row_of.end() || it->second == r) continue;
+    const size_t p = it->second;
+    if (first[p] == kNone) first[p] = r; else next[last[p]] = r;
+    last[p] = r;
+    has_kids[p] = 1;
+  }
+  cursor = first;
+  out.clear();
+  auto walk = [&](size_t root) {
+    emitted[root] = 1;
+    out.push_back(root);
+    stack.assign(1, root);
+    while (!stack.empty()) {
+      const size_t top = stack.back();
+      size_t c = collapsed.contains(procs.pid[top]) ? kNone : cursor[top];
+      while (c != kNone && emitted[c]) c = next[c];
+      if (c == kNone) { stack.pop_back(); continue; }
+      cursor[top] = next[c];
+      emitted[c] = 1;
+      depth[c] = depth[top] + 1;
+      out.push_back(c);
+      stack.push_back(c);
+    }
+  };
+  for (size_t r : order) {
+    auto it = procs.ppid[r] > 0 ? row_of.find(procs.ppid[r]) : row_of.end();
+    if (it == row_of.end() || it->second == r) walk(r);
+  }
+  // What is left sits under a collapsed row, or on a cycle of stale parents
+  // (a pid recycled between two scans), which still gets its lines.
+  for (size_t r : order) {
+    if (emitted[r]) continue;
+    bool hidden = false;
+    int32_t p = procs.ppid[r];
+    for (int hops = 0; p > 0 && hops < 64 && !hidden; ++hops) {
+      auto it = row_of.find(p);
+      if (it == row_of.end()) break;
+      hidden = collapsed.contains(p);
+      p = procs.ppid[it->second];
+    }
+    if (!hidden) walk(r);
+  }
+  order.swap(out);
+}
+
 void draw_command_classified(widget::Canvas& canvas, int x, int y,
                              int max_width, std::string_view cmd,
                              const UIConfig& ui, int row_severity) {
@@ -96,6 +163,8 @@ void ProcessTable::reset_view() {
   gpu_scale_   = GPUScale::Utilization;
   filter_query_.clear();
   search_mode_ = false;
+  tree_mode_   = false;
+  collapsed_.clear();
 }
 
 void ProcessTable::handle_input(const widget::InputEvent& ev) {
@@ -135,6 +204,12 @@ void ProcessTable::handle_input(const widget::InputEvent& ev) {
     return;
   }
 
+  // Tree mode: collapse / expand the row at the top of the view.
+  if (tree_mode_ && top_pid_ >= 0) {
+    if (ev.is(widget::Key::ArrowLeft))  { collapsed_.insert(top_pid_); return; }
+    if (ev.is(widget::Key::ArrowRight)) { collapsed_.erase(top_pid_);  return; }
+  }
+
   // Scroll keys.
   const int max_scroll = std::max(0, last_total_ - last_page_rows_);
   if (ev.is(widget::Key::ArrowUp))   { if (scroll_ > 0) --scroll_; return; }
@@ -159,6 +234,7 @@ void ProcessTable::handle_input(const widget::InputEvent& ev) {
     case 'n': sort_mode_ = SortMode::NAME; scroll_ = 0; break;
     case 'g': sort_mode_ = SortMode::GPU;  scroll_ = 0; break;
     case 'v': sort_mode_ = SortMode::GMEM; scroll_ = 0; break;
+    case 'T': tree_mode_ = !tree_mode_;    scroll_ = 0; break;
     case '/':
       search_mode_ = true;
       filter_query_.clear();
@@ -196,7 +272,8 @@ void ProcessTable::render(widget::Canvas& canvas,
   // pattern the sort dispatch already uses for its scratch.
   thread_local std::vector<size_t> order;
   thread_local std::vector<double> sm;
-  order.resize(s.procs.processes.size());
+  const auto& procs = s.procs;
+  order.resize(procs.size());
   std::iota(order.begin(), order.end(), 0);
   sm.assign(order.size(), 0.0);
   {
@@ -206,17 +283,17 @@ void ProcessTable::render(widget::Canvas& canvas,
     char keybuf[32];
     std::memcpy(keybuf, "proc.cpu.", 9);
     for (size_t i = 0; i < order.size(); ++i) {
-      const auto& p = s.procs.processes[i];
-      auto [end, ec] = std::to_chars(keybuf + 9, keybuf + sizeof keybuf, p.pid);
+      auto [end, ec] = std::to_chars(keybuf + 9, keybuf + sizeof keybuf, procs.pid[i]);
       if (ec != std::errc{}) continue;       // pid longer than the buffer: cannot happen
       sm[i] = montauk::ui::smooth_value(
           std::string_view(keybuf, static_cast<size_t>(end - keybuf)),
-          scale_proc_cpu(p.cpu_pct), 0.35);
+          scale_proc_cpu(procs.cpu_pct[i]), 0.35);
     }
   }
 
   // Sort via sublimation (montauk's only sort backend). Build a uint32_t
-  // index permutation and sort it by the active mode's key.
+  // index permutation and sort it by the active mode's key, each key read
+  // straight off its column.
   {
     const size_t n = order.size();
     std::vector<uint32_t> idx32(n);
@@ -229,27 +306,27 @@ void ProcessTable::render(widget::Canvas& canvas,
       }
       case SortMode::MEM: {
         std::vector<uint32_t> keys(n);
-        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<uint32_t>(s.procs.processes[i].rss_kb);
+        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<uint32_t>(procs.rss_kb[i]);
         montauk::util::sort_by_key_u32(keys, idx32, /*descending=*/true); break;
       }
       case SortMode::PID: {
         std::vector<uint32_t> keys(n);
-        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<uint32_t>(s.procs.processes[i].pid);
+        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<uint32_t>(procs.pid[i]);
         montauk::util::sort_by_key_u32(keys, idx32, /*descending=*/false); break;
       }
       case SortMode::GPU: {
         std::vector<float> keys(n);
-        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<float>(s.procs.processes[i].gpu_util_pct);
+        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<float>(procs.gpu_util_pct[i]);
         montauk::util::sort_by_key_f32(keys, idx32, /*descending=*/true); break;
       }
       case SortMode::GMEM: {
         std::vector<uint32_t> keys(n);
-        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<uint32_t>(s.procs.processes[i].gpu_mem_kb);
+        for (size_t i = 0; i < n; ++i) keys[i] = static_cast<uint32_t>(procs.gpu_mem_kb[i]);
         montauk::util::sort_by_key_u32(keys, idx32, /*descending=*/true); break;
       }
       case SortMode::NAME: {
         std::vector<const char*> ptrs(n);
-        for (size_t i = 0; i < n; ++i) ptrs[i] = s.procs.processes[i].cmd.c_str();
+        for (size_t i = 0; i < n; ++i) ptrs[i] = procs.cmd_of(i).c_str();
         montauk::util::sort_by_string(ptrs, idx32); break;
       }
     }
@@ -281,6 +358,17 @@ void ProcessTable::render(widget::Canvas& canvas,
     });
   }
 
+  // Tree mode threads the rows under their parents; depth and has_kids are
+  // indexed by row like sm.
+  thread_local std::vector<int> depth;
+  thread_local std::vector<uint8_t> has_kids;
+  if (tree_mode_) thread_tree(procs, collapsed_, order, depth, has_kids);
+  // A collapsed row with descendants stands for its subtree: CPU and MEM show
+  // the rollups the collector summed over every descendant, listed or not.
+  auto rolled = [&](size_t r) {
+    return tree_mode_ && procs.subtree_procs[r] > 1 && collapsed_.contains(procs.pid[r]);
+  };
+
   // 2. Layout / pagination.
   const int search_rows = search_mode_ ? 2 : 0;
   const int main_h = std::max(3, target_rows - search_rows);
@@ -293,23 +381,25 @@ void ProcessTable::render(widget::Canvas& canvas,
 
   const int skip = scroll_;
   const int take = desired_rows;
-  std::vector<size_t> displayed;  // process indices — index into both s.procs.processes and sm
+  std::vector<size_t> displayed;  // row indices — index into both the procs columns and sm
   displayed.reserve(static_cast<size_t>(take));
   int limit = std::min(static_cast<int>(order.size()), skip + take);
   for (int i = skip; i < limit; ++i) displayed.push_back(order[i]);
+  top_pid_ = displayed.empty() ? -1 : procs.pid[displayed.front()];
 
   // 3. Sticky column widths.
   int pid_w_meas = 5, user_w_meas = 4, gpu_d_meas = 3, mem_w_meas = 4, gmem_w_meas = 4;
   for (size_t i = 0; i < order.size(); ++i) {
-    const auto& p = s.procs.processes[order[i]];
-    pid_w_meas  = std::max(pid_w_meas,  static_cast<int>(std::to_string(p.pid).size()));
-    user_w_meas = std::max(user_w_meas, static_cast<int>(p.user_name.size()));
-    if (p.has_gpu_util) {
+    const size_t r = order[i];
+    pid_w_meas  = std::max(pid_w_meas,  static_cast<int>(std::to_string(procs.pid[r]).size()));
+    user_w_meas = std::max(user_w_meas, static_cast<int>(procs.user_of(r).size()));
+    if (procs.has_gpu_util[r]) {
       gpu_d_meas = std::max(gpu_d_meas,
-          static_cast<int>(std::to_string(static_cast<int>(p.gpu_util_pct + 0.5)).size()));
+          static_cast<int>(std::to_string(static_cast<int>(procs.gpu_util_pct[r] + 0.5)).size()));
     }
-    mem_w_meas  = std::max(mem_w_meas,  static_cast<int>(format_size_kib(p.rss_kb).size()));
-    gmem_w_meas = std::max(gmem_w_meas, static_cast<int>(format_size_kib(p.gpu_mem_kb).size()));
+    mem_w_meas  = std::max(mem_w_meas,  static_cast<int>(format_size_kib(
+        rolled(r) ? procs.subtree_rss_kb[r] : procs.rss_kb[r]).size()));
+    gmem_w_meas = std::max(gmem_w_meas, static_cast<int>(format_size_kib(procs.gpu_mem_kb[r]).size()));
   }
   pid_w_meas  = std::clamp(pid_w_meas,  5,  8);
   user_w_meas = std::clamp(user_w_meas, 4, 12);
@@ -337,10 +427,10 @@ void ProcessTable::render(widget::Canvas& canvas,
 
   canvas.draw_rect(rect.x, rect.y, rect.width, main_h, border_style);
 
-  std::string title = "PROCESS MONITOR";
+  std::string title = tree_mode_ ? "PROCESS TREE" : "PROCESS MONITOR";
   if (!filter_query_.empty()) {
     std::string suffix = (order.size() == 1) ? " RESULT" : " RESULTS";
-    title = "PROCESS MONITOR: " + std::to_string(order.size()) + suffix;
+    title += ": " + std::to_string(order.size()) + suffix;
   }
   const std::string title_text = " " + title + " ";
   int title_x = rect.x + (rect.width - static_cast<int>(title_text.size())) / 2;
@@ -381,22 +471,22 @@ void ProcessTable::render(widget::Canvas& canvas,
   canvas.draw_text(x_cmd,                             header_y, "COMMAND", title_style);
 
   for (size_t i = 0; i < displayed.size(); ++i) {
-    const auto* p = &s.procs.processes[displayed[i]];
+    const size_t r = displayed[i];
     const int y = inner_y + 1 + static_cast<int>(i);
     if (y >= rect.y + main_h - 1) break;
 
-    const double smooth_cpu = sm[displayed[i]];
+    const double smooth_cpu = rolled(r) ? scale_proc_cpu(procs.subtree_cpu_pct[r]) : sm[r];
     const int row_severity = compute_severity(static_cast<int>(smooth_cpu + 0.5),
                                                ui.caution_pct, ui.warning_pct);
     const widget::Style row_style = severity_style(row_severity);
 
     {
-      std::string pid_str = std::to_string(p->pid);
+      std::string pid_str = std::to_string(procs.pid[r]);
       canvas.draw_text(right_align_x(inner_x, pidw, static_cast<int>(pid_str.size())),
                        y, pid_str, row_style);
     }
     {
-      std::string u = p->user_name;
+      std::string u = procs.user_of(r);
       if (static_cast<int>(u.size()) > userw) u = u.substr(0, static_cast<size_t>(userw));
       canvas.draw_text(x_user, y, u, row_style);
     }
@@ -410,8 +500,8 @@ void ProcessTable::render(widget::Canvas& canvas,
     {
       const int ngpu_dev = std::max(1, s.nvml.devices);
       double display_gpu = (gpu_scale_ == GPUScale::Capacity)
-                              ? p->gpu_util_pct / static_cast<double>(ngpu_dev)
-                              : p->gpu_util_pct;
+                              ? procs.gpu_util_pct[r] / static_cast<double>(ngpu_dev)
+                              : procs.gpu_util_pct[r];
       std::string digits = format_pct_digits(display_gpu);
       std::string field  = digits + "%";
       widget::Style gpu_style = row_style;
@@ -424,19 +514,30 @@ void ProcessTable::render(widget::Canvas& canvas,
                        y, field, gpu_style);
     }
     if (show_gmem_) {
-      std::string g = format_size_kib(p->gpu_mem_kb);
+      std::string g = format_size_kib(procs.gpu_mem_kb[r]);
       canvas.draw_text(right_align_x(x_gmem, gmemw, static_cast<int>(g.size())),
                        y, g, row_style);
     }
     {
-      std::string m = format_size_kib(p->rss_kb);
+      std::string m = format_size_kib(rolled(r) ? procs.subtree_rss_kb[r] : procs.rss_kb[r]);
       canvas.draw_text(right_align_x(x_mem, memw, static_cast<int>(m.size())),
                        y, m, row_style);
     }
     {
-      std::string raw = p->cmd.empty() ? std::to_string(p->pid)
-                                       : sanitize_for_display(p->cmd, cmd_w + 10);
-      draw_command_classified(canvas, x_cmd, y, cmd_w, raw, ui, row_severity);
+      int cx = x_cmd, cw = cmd_w;
+      if (tree_mode_) {
+        // Indent two columns a level (capped so the command stays legible),
+        // then the fold marker: expanded with children listed, or collapsed.
+        const int indent = std::min(2 * depth[r], cmd_w / 3);
+        const bool folded = collapsed_.contains(procs.pid[r]) && (has_kids[r] || procs.subtree_procs[r] > 1);
+        const char* mark = folded ? "\xE2\x96\xB8 " : has_kids[r] ? "\xE2\x96\xBE " : "  ";
+        canvas.draw_text(cx + indent, y, mark, muted_style);
+        cx += indent + 2;
+        cw -= indent + 2;
+      }
+      std::string raw = procs.cmd_of(r).empty() ? std::to_string(procs.pid[r])
+                                       : sanitize_for_display(procs.cmd_of(r), cw + 10);
+      draw_command_classified(canvas, cx, y, cw, raw, ui, row_severity);
     }
   }
 
@@ -486,10 +486,10 @@ void section_security(std::vector<Row>& out, const Snapshot& s, int budget) {
   // Mutually exclusive: PROC CHURN takes precedence over PROC SECURITY when
   // the system is actively spawning processes.
   if (s.churn.recent_2s_events > 0) {
-    std::vector<const montauk::model::ProcSample*> churned;
-    for (const auto& p : s.procs.processes) {
-      if (p.churn_reason == montauk::model::ChurnReason::None) continue;
-      churned.push_back(&p);
+    std::vector<size_t> churned;
+    for (size_t i = 0; i < s.procs.size(); ++i) {
+      if (s.procs.churn_reason[i] == montauk::model::ChurnReason::None) continue;
+      churned.push_back(i);
     }
     out.push_back(Row::header("PROC CHURN"));
     std::ostringstream rr;
@@ -498,8 +498,8 @@ void section_security(std::vector<Row>& out, const Snapshot& s, int budget) {
     int max_show = std::min<int>(static_cast<int>(churned.size()),
                                  std::max(0, budget - static_cast<int>(out.size())));
     for (int i = 0; i < max_show; ++i) {
-      std::ostringstream lbl; lbl << "PID:" << churned[i]->pid;
-      out.push_back(Row::kv(lbl.str(), churned[i]->cmd));
+      std::ostringstream lbl; lbl << "PID:" << s.procs.pid[churned[i]];
+      out.push_back(Row::kv(lbl.str(), std::string(s.procs.cmd_of(churned[i]))));
     }
     return;
   }
@@ -0,0 +1,158 @@
+#include "util/DeadlineScheduler.hpp"
+#include "util/Log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace montauk::util {
+
+namespace {
+// epoll tags: the timerfd, the wake eventfd, then watch i at kWatchBase + i.
+constexpr uint64_t kTagTimer = 0;
+constexpr uint64_t kTagWake = 1;
+constexpr uint64_t kWatchBase = 2;
+// Timers due this close to a wakeup fire with it instead of costing their own.
+constexpr auto kCoalesce = std::chrono::milliseconds{1};
+
+bool add_fd(int epfd, int fd, uint64_t tag, uint32_t events = EPOLLIN) {
+  struct epoll_event ev{};
+  ev.events = events;
+  ev.data.u64 = tag;
+  return ::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+}
+
+void drain(int fd) {
+  uint64_t v = 0;
+  ssize_t r = ::read(fd, &v, sizeof(v));  // see MetricsServer::stop() on (void)
+  (void)r;
+}
+}  // namespace
+
+DeadlineScheduler::DeadlineScheduler() {
+  epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  tfd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  wakefd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (ok() && add_fd(epfd_, tfd_, kTagTimer) && add_fd(epfd_, wakefd_, kTagWake)) return;
+  log_warn("DeadlineScheduler: epoll/timerfd unavailable (%s); falling back to sleeping",
+           std::strerror(errno));
+  for (int* fd : {&epfd_, &tfd_, &wakefd_}) {
+    if (*fd >= 0) ::close(*fd);
+    *fd = -1;
+  }
+}
+
+DeadlineScheduler::~DeadlineScheduler() {
+  for (int fd : {epfd_, tfd_, wakefd_}) {
+    if (fd >= 0) ::close(fd);
+  }
+}
+
+void DeadlineScheduler::every(std::chrono::milliseconds period, std::function<void()> fn,
+                              Clock::time_point first) {
+  timers_.push_back(Timer{first, std::max(period, std::chrono::milliseconds{1}), std::move(fn)});
+  heap_.push_back(timers_.size() - 1);
+  std::push_heap(heap_.begin(), heap_.end(), [this](size_t a, size_t b) {
+    return timers_[a].due > timers_[b].due;
+  });
+  arm();
+}
+
+bool DeadlineScheduler::watch(int fd, std::function<void()> fn) {
+  return watch(fd, EPOLLIN, [fn = std::move(fn)](uint32_t) { fn(); });
+}
+
+bool DeadlineScheduler::watch(int fd, uint32_t events, std::function<void(uint32_t)> fn) {
+  if (!ok() || fd < 0) return false;
+  if (!add_fd(epfd_, fd, kWatchBase + watches_.size(), events)) return false;
+  watches_.push_back(Watch{fd, std::move(fn)});
+  return true;
+}
+
+void DeadlineScheduler::unwatch(int fd) {
+  for (auto& w : watches_) {
+    if (w.fd != fd || fd < 0) continue;
+    (void)::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, nullptr);
+    w.fd = -1;  // fn is left alone: it may be the one running
+  }
+}
+
+void DeadlineScheduler::wake() {
+  if (wakefd_ < 0) return;
+  const uint64_t one = 1;
+  ssize_t r = ::write(wakefd_, &one, sizeof(one));  // a failed write is a missed nudge
+  (void)r;
+}
+
+void DeadlineScheduler::arm() {
+  if (tfd_ < 0) return;
+  struct itimerspec its{};
+  if (!heap_.empty()) {
+    // steady_clock is CLOCK_MONOTONIC, so its epoch is the timerfd's. An
+    // all-zero it_value would disarm the timer; a deadline already passed
+    // becomes the earliest representable one and fires immediately.
+    const auto ns = std::max<int64_t>(
+        1, std::chrono::duration_cast<std::chrono::nanoseconds>(
+               timers_[heap_.front()].due.time_since_epoch()).count());
+    its.it_value.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+    its.it_value.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+  }
+  (void)::timerfd_settime(tfd_, TFD_TIMER_ABSTIME, &its, nullptr);
+}
+
+size_t DeadlineScheduler::fire_due(Clock::time_point now) {
+  auto later = [this](size_t a, size_t b) { return timers_[a].due > timers_[b].due; };
+  due_.clear();
+  while (!heap_.empty() && timers_[heap_.front()].due <= now + kCoalesce) {
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    due_.push_back(heap_.back());
+    heap_.pop_back();
+  }
+  std::sort(due_.begin(), due_.end());
+  for (size_t i : due_) {
+    Timer& t = timers_[i];
+    t.due += t.period;
+    if (t.due <= now) t.due = now + t.period;
+    heap_.push_back(i);
+    std::push_heap(heap_.begin(), heap_.end(), later);
+  }
+  for (size_t i : due_) timers_[i].fn();
+  return due_.size();
+}
+
+size_t DeadlineScheduler::run_once() {
+  size_t ran = 0;
+  if (!ok()) {
+    const auto now = Clock::now();
+    auto until = now + kFallbackSlice;
+    if (!heap_.empty()) until = std::min(until, timers_[heap_.front()].due);
+    std::this_thread::sleep_until(until);
+    ++wakeups_;
+    return fire_due(Clock::now());
+  }
+
+  struct epoll_event evs[16];
+  const int n = ::epoll_wait(epfd_, evs, 16, -1);
+  ++wakeups_;
+  for (int i = 0; i < n; ++i) {
+    const uint64_t tag = evs[i].data.u64;
+    if (tag == kTagTimer) drain(tfd_);
+    else if (tag == kTagWake) drain(wakefd_);
+    else if (tag - kWatchBase < watches_.size()) {
+      Watch& w = watches_[tag - kWatchBase];
+      if (w.fd < 0) continue;  // unwatched earlier in this batch
+      w.fn(evs[i].events);
+      ++ran;
+    }
+  }
+  ran += fire_due(Clock::now());
+  arm();
+  return ran;
+}
+
+}  // namespace montauk::util
@@ -0,0 +1,63 @@
+#include "util/ExitRollup.hpp"
+
+#include <algorithm>
+
+namespace montauk::util {
+
+namespace {
+void fold(montauk::model::ExitedComm& into, const montauk::model::ExitedComm& e) {
+  into.exits += e.exits;
+  into.cpu_us += e.cpu_us;
+  into.max_rss_kb = std::max(into.max_rss_kb, e.max_rss_kb);
+  into.io_bytes += e.io_bytes;
+}
+}  // namespace
+
+void ExitRollup::rotate(Clock::time_point now) {
+  if (started_ == Clock::time_point{}) { started_ = now; return; }
+  if (now - started_ < kGeneration) return;
+  if (now - started_ < 2 * kGeneration) prev_.swap(cur_);
+  else prev_.clear();  // idle for a whole generation: the old one is stale too
+  cur_.clear();
+  started_ = now;
+}
+
+void ExitRollup::add(std::string_view comm, uint64_t cpu_us, uint64_t rss_kb, uint64_t io_bytes,
+                     Clock::time_point now) {
+  rotate(now);
+  auto it = cur_.find(std::string(comm));
+  if (it == cur_.end()) {
+    if (cur_.size() >= kMaxComms) comm = kOther;
+    it = cur_.try_emplace(std::string(comm)).first;
+    it->second.comm = comm;
+  }
+  fold(it->second, montauk::model::ExitedComm{{}, 1, cpu_us, rss_kb, io_bytes});
+}
+
+void ExitRollup::publish(std::vector<montauk::model::ExitedComm>& out, Clock::time_point now,
+                         size_t n) {
+  rotate(now);
+  out.clear();
+  Gen merged = prev_;
+  for (const auto& [comm, e] : cur_) {
+    auto [it, fresh] = merged.try_emplace(comm, e);
+    if (!fresh) fold(it->second, e);
+  }
+  out.reserve(std::min(merged.size(), n + 1));
+  montauk::model::ExitedComm other{std::string(kOther), 0, 0, 0, 0};
+  if (auto it = merged.find(other.comm); it != merged.end()) {
+    other = it->second;
+    merged.erase(it);
+  }
+  for (auto& kv : merged) out.push_back(std::move(kv.second));
+  std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+    return a.cpu_us != b.cpu_us ? a.cpu_us > b.cpu_us : a.comm < b.comm;
+  });
+  if (out.size() > n) {
+    for (size_t i = n; i < out.size(); ++i) fold(other, out[i]);
+    out.resize(n);
+  }
+  if (other.exits) out.push_back(std::move(other));
+}
+
+} // namespace montauk::util
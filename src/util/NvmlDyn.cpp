@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <dlfcn.h>
+#include <mutex>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -20,8 +21,12 @@ NvmlDyn& NvmlDyn::instance() {
 
 
 bool NvmlDyn::load_once() {
-  if (loaded_) return handle_ != nullptr;
-  loaded_ = true;
+  // Two threads get here: the Producer's VRAM worker and GpuAttributor.
+  std::call_once(loaded_, [this] { (void)load(); });
+  return handle_ != nullptr;
+}
+
+bool NvmlDyn::load() {
   const auto& nvcfg = montauk::ui::config().nvidia;
   if (nvcfg.disable_nvml) { suppressed_ = true; return false; }
 
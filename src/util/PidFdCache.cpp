@@ -0,0 +1,89 @@
+#include "util/PidFdCache.hpp"
+
+#include <algorithm>
+#include <unistd.h>
+#include <vector>
+
+namespace montauk::util {
+
+namespace {
+constexpr const char* kLeafName[] = {"stat", "status", "cmdline"};
+}
+
+PidFdCache::Entry* PidFdCache::entry(ProcReader& rd, int32_t pid, uint64_t starttime, Leaf leaf) {
+  auto it = map_.find(pid);
+  if (it != map_.end() && it->second.starttime != starttime) {
+    // Recycled pid: the cached fds belong to a process that no longer exists.
+    close_entry(it->second);
+    map_.erase(it);
+    it = map_.end();
+  }
+  if (it == map_.end()) it = map_.emplace(pid, Entry{starttime, clock_, {-1, -1, -1}}).first;
+  Entry& e = it->second;
+  e.last_use = clock_;
+  if (e.fd[leaf] < 0) {
+    // The cap holds per fd, so every leaf open is checked, not just a new
+    // pid's first. Only other pids are evicted; this one alone always fits.
+    while (open_fds_ + 1 > max_fds_ && map_.size() > 1) evict(pid);
+    e.fd[leaf] = rd.open_pid(pid, kLeafName[leaf]);
+    if (e.fd[leaf] < 0) return nullptr;
+    ++open_fds_;
+  }
+  return &e;
+}
+
+bool PidFdCache::open(ProcReader& rd, int32_t pid, uint64_t starttime, Leaf leaf) {
+  return enabled() && entry(rd, pid, starttime, leaf) != nullptr;
+}
+
+auto PidFdCache::read(ProcReader& rd, int32_t pid, uint64_t starttime, Leaf leaf)
+    -> std::optional<std::string_view> {
+  if (!enabled()) return rd.read_pid(pid, kLeafName[leaf]);
+  Entry* e = entry(rd, pid, starttime, leaf);
+  if (!e) return std::nullopt;
+  auto out = rd.read_fd(e->fd[leaf]);
+  if (!out) invalidate(pid);
+  return out;
+}
+
+auto PidFdCache::read_cached(ProcReader& rd, int32_t pid, Leaf leaf)
+    -> std::optional<std::string_view> {
+  auto it = map_.find(pid);
+  if (it == map_.end() || it->second.fd[leaf] < 0) return std::nullopt;
+  it->second.last_use = clock_;
+  return rd.read_fd(it->second.fd[leaf]);
+}
+
+void PidFdCache::invalidate(int32_t pid) {
+  auto it = map_.find(pid);
+  if (it == map_.end()) return;
+  close_entry(it->second);
+  map_.erase(it);
+}
+
+void PidFdCache::clear() {
+  for (auto& [pid, e] : map_) close_entry(e);
+  map_.clear();
+}
+
+void PidFdCache::close_entry(Entry& e) {
+  for (int& fd : e.fd) {
+    if (fd >= 0) { ::close(fd); fd = -1; --open_fds_; }
+  }
+}
+
+// Evict the least recently used eighth of the pids in one pass rather than
+// one pid per miss, so a cold start filling the cache does not rescan the
+// map on every insert. `keep` (the pid being opened) is never a candidate.
+void PidFdCache::evict(int32_t keep) {
+  std::vector<std::pair<uint64_t, int32_t>> age;
+  age.reserve(map_.size());
+  for (const auto& [pid, e] : map_)
+    if (pid != keep) age.emplace_back(e.last_use, pid);
+  if (age.empty()) return;
+  const size_t n = std::max<size_t>(1, age.size() / 8);
+  std::nth_element(age.begin(), age.begin() + static_cast<std::ptrdiff_t>(n - 1), age.end());
+  for (size_t i = 0; i < n; ++i) invalidate(age[i].second);
+}
+
+}  // namespace montauk::util
@@ -0,0 +1,58 @@
+#include "util/ProcIdentityCache.hpp"
+
+#include <vector>
+
+namespace montauk::util {
+
+auto ProcIdentityCache::at(int32_t pid, uint64_t starttime, std::string_view comm) -> Entry& {
+  const size_t h = std::hash<std::string_view>{}(comm);
+  auto it = map_.find(pid);
+  if (it == map_.end()) {
+    if (map_.size() >= max_entries_) evict();
+    it = map_.emplace(pid, Entry{}).first;
+  } else if (it->second.starttime == starttime && it->second.comm_hash == h) {
+    it->second.last_use = clock_;
+    return it->second;
+  }
+  // New pid, recycled pid or a new image: nothing cached applies to it.
+  it->second = Entry{};
+  it->second.starttime = starttime;
+  it->second.comm_hash = h;
+  it->second.last_use = clock_;
+  return it->second;
+}
+
+const std::string* ProcIdentityCache::intern(std::string_view s) {
+  auto it = pool_.find(s);
+  if (it == pool_.end()) it = pool_.emplace(s).first;
+  return &*it;
+}
+
+// Drop the least recently used eighth in one pass (see PidFdCache::evict).
+void ProcIdentityCache::evict() {
+  std::vector<std::pair<uint64_t, int32_t>> age;
+  age.reserve(map_.size());
+  for (const auto& [pid, e] : map_) age.emplace_back(e.last_use, pid);
+  if (age.empty()) return;
+  const size_t n = std::max<size_t>(1, age.size() / 8);
+  std::nth_element(age.begin(), age.begin() + static_cast<std::ptrdiff_t>(n - 1), age.end());
+  for (size_t i = 0; i < n; ++i) map_.erase(age[i].second);
+}
+
+// Erase pool strings no entry points at. Erasing from a node-based set leaves
+// the surviving nodes -- and every pointer an entry holds -- where they are.
+void ProcIdentityCache::compact() {
+  std::unordered_set<const std::string*> live;
+  live.reserve(map_.size() * 3);
+  for (const auto& [pid, e] : map_) {
+    if (e.exe) live.insert(e.exe);
+    if (e.cmd) live.insert(e.cmd);
+    if (e.user) live.insert(e.user);
+  }
+  for (auto it = pool_.begin(); it != pool_.end();) {
+    if (!live.count(&*it)) it = pool_.erase(it);
+    else ++it;
+  }
+}
+
+}  // namespace montauk::util
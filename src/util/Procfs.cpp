@@ -8,6 +8,7 @@
 
 #include <limits.h>
 #include <cerrno>
+#include <charconv>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
@@ -74,6 +75,23 @@ auto read_file_bytes(const std::string& abs) -> std::optional<std::vector<unsign
   }
 }
 
+auto read_file_into(const char* path, std::string& buf) -> bool {
+  int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  size_t len = 0;
+  if (buf.size() < 256) buf.resize(256);
+  for (;;) {
+    ssize_t n = ::pread(fd, buf.data() + len, buf.size() - len, static_cast<off_t>(len));
+    if (n < 0) { if (errno == EINTR) continue; ::close(fd); return false; }
+    if (n == 0) break;
+    len += static_cast<size_t>(n);
+    if (len == buf.size()) buf.resize(buf.size() * 2);
+  }
+  ::close(fd);
+  buf.resize(len);
+  return true;
+}
+
 auto list_dir(const std::string& abs) -> std::vector<std::string> {
   std::vector<std::string> out;
   auto path = map_path(abs);
@@ -97,4 +115,130 @@ auto read_symlink(const std::string& abs) -> std::optional<std::string> {
   return std::string(buf);
 }
 
+// ---- ProcReader ----
+
+ProcReader::~ProcReader() {
+  if (dirfd_ >= 0) ::close(dirfd_);
+}
+
+// Reopen the /proc dirfd when MONTAUK_PROC_ROOT differs from the root it was
+// opened under. The comparison is against the cached string, so the steady
+// state costs one getenv and no allocation; tests that swap roots between
+// cases still see the new tree.
+bool ProcReader::ensure_root() {
+  const char* env = std::getenv("MONTAUK_PROC_ROOT");
+  const bool set = env && *env;
+  if (dirfd_ >= 0 && set == root_set_ && (!set || root_ == env)) return true;
+  if (dirfd_ >= 0) { ::close(dirfd_); dirfd_ = -1; }
+  root_set_ = set;
+  if (set) root_.assign(env); else root_.clear();
+  dirfd_ = ::open(map_proc_path("/proc").c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  return dirfd_ >= 0;
+}
+
+auto ProcReader::read_at(const char* rel) -> std::optional<std::string_view> {
+  int fd = ::openat(dirfd_, rel, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return std::nullopt;
+  auto out = read_fd(fd);
+  ::close(fd);
+  return out;
+}
+
+auto ProcReader::read_fd(int fd) -> std::optional<std::string_view> {
+  // procfs reports st_size 0, so read to EOF, doubling on a full buffer. The
+  // buffer never shrinks: the largest file seen sets the steady-state size.
+  if (buf_.size() < 4096) buf_.resize(4096);
+  size_t len = 0;
+  for (;;) {
+    ssize_t n = ::pread(fd, buf_.data() + len, buf_.size() - len, static_cast<off_t>(len));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      // ESRCH: the task exited since the fd was opened
+      note_churn(ChurnKind::Proc);
+      return std::nullopt;
+    }
+    if (n == 0) break;
+    len += static_cast<size_t>(n);
+    if (len == buf_.size()) buf_.resize(buf_.size() * 2);
+  }
+  return std::string_view(buf_.data(), len);
+}
+
+auto ProcReader::read(const char* rel) -> std::optional<std::string_view> {
+  if (!ensure_root()) return std::nullopt;
+  return read_at(rel);
+}
+
+// "<pid>/<leaf>" formatted on the stack; leaf is always a short literal.
+static bool format_pid_path(char (&out)[64], int32_t pid, const char* leaf) {
+  auto [p, ec] = std::to_chars(out, out + 16, pid);
+  if (ec != std::errc{}) return false;
+  *p++ = '/';
+  size_t n = std::strlen(leaf);
+  if (static_cast<size_t>(out + sizeof(out) - p) <= n) return false;
+  std::memcpy(p, leaf, n + 1);
+  return true;
+}
+
+auto ProcReader::read_pid(int32_t pid, const char* leaf) -> std::optional<std::string_view> {
+  char rel[64];
+  if (!format_pid_path(rel, pid, leaf) || !ensure_root()) return std::nullopt;
+  return read_at(rel);
+}
+
+int ProcReader::open_pid(int32_t pid, const char* leaf) {
+  char rel[64];
+  if (!format_pid_path(rel, pid, leaf) || !ensure_root()) return -1;
+  return ::openat(dirfd_, rel, O_RDONLY | O_CLOEXEC);
+}
+
+auto ProcReader::readlink_pid(int32_t pid, const char* leaf) -> std::optional<std::string_view> {
+  char rel[64];
+  if (!format_pid_path(rel, pid, leaf) || !ensure_root()) return std::nullopt;
+  if (buf_.size() < PATH_MAX) buf_.resize(PATH_MAX);
+  ssize_t len = ::readlinkat(dirfd_, rel, buf_.data(), buf_.size());
+  if (len < 0) return std::nullopt;
+  return std::string_view(buf_.data(), static_cast<size_t>(len));
+}
+
+// getdents64 straight into a stack buffer: opendir/readdir would malloc a DIR
+// per listing, and /proc is listed every cycle.
+void ProcReader::fill_numeric(int dfd, std::vector<int32_t>& out) {
+  alignas(struct dirent64) char dbuf[16384];
+  for (;;) {
+    ssize_t n = ::getdents64(dfd, dbuf, sizeof(dbuf));
+    if (n <= 0) break;
+    for (ssize_t off = 0; off < n;) {
+      auto* de = reinterpret_cast<struct dirent64*>(dbuf + off);
+      off += de->d_reclen;
+      const char* name = de->d_name;
+      if (*name < '0' || *name > '9') continue;
+      int32_t v = 0;
+      auto [p, ec] = std::from_chars(name, name + std::strlen(name), v);
+      if (ec == std::errc{} && *p == '\0') out.push_back(v);
+    }
+  }
+}
+
+auto ProcReader::pids() -> const std::vector<int32_t>& {
+  pids_.clear();
+  if (!ensure_root()) return pids_;
+  // Rewind the long-lived dirfd rather than reopening /proc each cycle; a
+  // fresh getdents pass from offset 0 re-enumerates the live task list.
+  if (::lseek(dirfd_, 0, SEEK_SET) < 0) return pids_;
+  fill_numeric(dirfd_, pids_);
+  return pids_;
+}
+
+auto ProcReader::list_numeric(int32_t pid, const char* sub, std::vector<int32_t>& out) -> bool {
+  out.clear();
+  char rel[64];
+  if (!format_pid_path(rel, pid, sub) || !ensure_root()) return false;
+  int dfd = ::openat(dirfd_, rel, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dfd < 0) return false;
+  fill_numeric(dfd, out);
+  ::close(dfd);
+  return true;
+}
+
 } // namespace montauk::util
@@ -21,7 +21,7 @@ bool UringDyn::load_once() {
                                                     : "liburing.so.2";
   handle_ = ::dlopen(lib, RTLD_LAZY | RTLD_LOCAL);
   if (!handle_) {
-    log_info("liburing not available (%s): metrics endpoint disabled", lib);
+    log_info("liburing not available (%s): io_uring features disabled", lib);
     return false;
   }
 
@@ -30,9 +30,10 @@ bool UringDyn::load_once() {
   p_submit     = reinterpret_cast<decltype(p_submit)>(L("io_uring_submit"));
   p_get_cqe    = reinterpret_cast<decltype(p_get_cqe)>(L("__io_uring_get_cqe"));
   p_queue_exit = reinterpret_cast<decltype(p_queue_exit)>(L("io_uring_queue_exit"));
+  p_submit_and_wait = reinterpret_cast<decltype(p_submit_and_wait)>(L("io_uring_submit_and_wait"));
 
   if (!p_queue_init || !p_submit || !p_get_cqe || !p_queue_exit) {
-    log_warn("liburing loaded but is missing expected symbols: endpoint disabled");
+    log_warn("liburing loaded but is missing expected symbols: io_uring features disabled");
     ::dlclose(handle_);
     handle_ = nullptr;
     return false;
@@ -57,6 +58,15 @@ int UringDyn::wait_cqe(struct io_uring* ring, struct io_uring_cqe** cqe_ptr) {
   return p_get_cqe(ring, cqe_ptr, 0, 1, nullptr);
 }
 
+int UringDyn::submit_and_wait(struct io_uring* ring, unsigned wait_nr) {
+  if (p_submit_and_wait) return p_submit_and_wait(ring, wait_nr);
+  int submitted = p_submit(ring);
+  if (submitted < 0 || wait_nr == 0) return submitted;
+  struct io_uring_cqe* cqe = nullptr;
+  int ret = p_get_cqe(ring, &cqe, 0, wait_nr, nullptr);
+  return ret < 0 ? ret : submitted;
+}
+
 void UringDyn::queue_exit(struct io_uring* ring) { p_queue_exit(ring); }
 
 }  // namespace montauk::util
@@ -0,0 +1,195 @@
+#include "util/UringProcBatch.hpp"
+#include "util/UringDyn.hpp"
+#include "util/Churn.hpp"
+#include "util/Log.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace montauk::util {
+
+UringProcBatch::~UringProcBatch() {
+  abandon();
+  if (ring_ok_) UringDyn::instance().queue_exit(&ring_);
+}
+
+bool UringProcBatch::init(unsigned depth) {
+  if (ring_ok_) return !disabled_;
+  auto& uring = UringDyn::instance();
+  if (!uring.load_once()) return false;
+  // Each submit carries one chunk's opens plus the previous chunk's closes.
+  if (uring.queue_init(depth * 2, &ring_, 0) < 0) {
+    log_info("io_uring procfs scan unavailable: io_uring_queue_init() failed: %s", std::strerror(errno));
+    return false;
+  }
+  ring_ok_ = true;
+  depth_ = depth;
+  slots_.resize(depth);
+  paths_.resize(depth);
+  arena_.resize(static_cast<size_t>(depth) * kSlotBytes);
+  return true;
+}
+
+bool UringProcBatch::read_all_impl(int dirfd, std::span<const int32_t> pids,
+                                   std::span<const char* const> leaves,
+                                   void (*cb)(void*, size_t), void* user) {
+  enters_ = 0;
+  done_ = 0;
+  if (!ok() || dirfd < 0 || leaves.empty() || leaves.size() > depth_) return false;
+  nleaves_ = leaves.size();
+  const size_t per_chunk = depth_ / nleaves_;
+
+  for (size_t base = 0; base < pids.size(); base += per_chunk) {
+    const size_t npids = std::min(per_chunk, pids.size() - base);
+    const size_t nslots = npids * nleaves_;
+    chunk_base_ = base;
+    spill_.clear();
+
+    // Phase 1: the previous chunk's closes + this chunk's opens, one enter.
+    unsigned queued = 0;
+    if (!queue_closes(queued)) { abandon(); return false; }
+    for (size_t s = 0; s < nslots; ++s) {
+      slots_[s] = Slot{};
+      auto& path = paths_[s];
+      auto [p, ec] = std::to_chars(path.data(), path.data() + 16, pids[base + s / nleaves_]);
+      const char* leaf = leaves[s % nleaves_];
+      const size_t ln = std::strlen(leaf);
+      if (ec != std::errc{} || static_cast<size_t>(path.data() + path.size() - p) <= ln + 1) continue;
+      *p++ = '/';
+      std::memcpy(p, leaf, ln + 1);
+      struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+      if (!sqe) { abandon(); return false; }
+      io_uring_prep_openat(sqe, dirfd, path.data(), O_RDONLY | O_CLOEXEC, 0);
+      io_uring_sqe_set_data64(sqe, kOpOpen | s);
+      ++queued;
+    }
+    if (queued && !flush(queued)) { abandon(); return false; }
+    if (disabled_) {
+      log_warn("io_uring procfs scan: kernel rejected IORING_OP_OPENAT; using synchronous reads");
+      abandon();
+      return false;
+    }
+
+    // Phase 2: one read per opened file, one enter.
+    queued = 0;
+    for (size_t s = 0; s < nslots; ++s) {
+      if (slots_[s].fd < 0) continue;
+      struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+      if (!sqe) { abandon(); return false; }
+      io_uring_prep_read(sqe, slots_[s].fd, arena_.data() + s * kSlotBytes, kSlotBytes, 0);
+      io_uring_sqe_set_data64(sqe, kOpRead | s);
+      ++queued;
+    }
+    if (queued && !flush(queued)) { abandon(); return false; }
+
+    for (size_t s = 0; s < nslots; ++s) {
+      if (slots_[s].fd < 0) continue;
+      if (slots_[s].len == static_cast<int32_t>(kSlotBytes)) finish_spill(s);
+      closing_.push_back(slots_[s].fd);
+      slots_[s].fd = -1;
+    }
+    for (size_t i = 0; i < npids; ++i) cb(user, base + i);
+    done_ = base + npids;
+  }
+
+  unsigned queued = 0;
+  if (!queue_closes(queued)) { abandon(); return false; }
+  if (queued && !flush(queued)) { abandon(); return false; }
+  return true;
+}
+
+bool UringProcBatch::queue_closes(unsigned& queued) {
+  while (!closing_.empty()) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (!sqe) return false;
+    io_uring_prep_close(sqe, closing_.back());
+    io_uring_sqe_set_data64(sqe, kOpClose);
+    closing_.pop_back();
+    ++queued;
+  }
+  return true;
+}
+
+bool UringProcBatch::flush(unsigned expect) {
+  auto& uring = UringDyn::instance();
+  int ret = uring.submit_and_wait(&ring_, expect);
+  ++enters_;
+  // EINTR interrupts the wait, not the submission: the reap below picks up
+  // whatever completed and waits for the rest.
+  if (ret < 0 && ret != -EINTR) { disabled_ = true; return false; }
+
+  unsigned seen = 0;
+  while (seen < expect) {
+    unsigned head = 0, n = 0;
+    struct io_uring_cqe* cqe = nullptr;
+    io_uring_for_each_cqe(&ring_, head, cqe) {
+      const uint64_t d = io_uring_cqe_get_data64(cqe);
+      const size_t s = static_cast<size_t>(d & kIndexMask);
+      const int res = cqe->res;
+      switch (d & ~kIndexMask) {
+        case kOpOpen:
+          if (res >= 0) slots_[s].fd = res;
+          else if (res == -EINVAL) disabled_ = true;  // opcode unknown to this kernel
+          break;
+        case kOpRead:
+          if (res >= 0) slots_[s].len = res;
+          else note_churn(ChurnKind::Proc);  // ESRCH: exited between open and read
+          break;
+        default:
+          break;
+      }
+      ++n;
+    }
+    io_uring_cq_advance(&ring_, n);
+    seen += n;
+    if (seen < expect) {
+      int r = uring.wait_cqe(&ring_, &cqe);
+      ++enters_;
+      if (r < 0 && r != -EINTR) { disabled_ = true; return false; }
+    }
+  }
+  return true;
+}
+
+void UringProcBatch::finish_spill(size_t s) {
+  std::string out(arena_.data() + s * kSlotBytes, kSlotBytes);
+  size_t len = out.size();
+  for (;;) {
+    if (len == out.size()) out.resize(out.size() * 2);
+    ssize_t n = ::pread(slots_[s].fd, out.data() + len, out.size() - len, static_cast<off_t>(len));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    len += static_cast<size_t>(n);
+  }
+  out.resize(len);
+  slots_[s].spill = static_cast<int32_t>(spill_.size());
+  slots_[s].len = static_cast<int32_t>(len);
+  spill_.push_back(std::move(out));
+}
+
+auto UringProcBatch::view(size_t pid_idx, size_t leaf_idx) const -> std::optional<std::string_view> {
+  if (pid_idx < chunk_base_ || leaf_idx >= nleaves_) return std::nullopt;
+  const size_t s = (pid_idx - chunk_base_) * nleaves_ + leaf_idx;
+  if (s >= slots_.size()) return std::nullopt;
+  const Slot& sl = slots_[s];
+  if (sl.len < 0) return std::nullopt;
+  if (sl.spill >= 0) return std::string_view(spill_[static_cast<size_t>(sl.spill)]);
+  return std::string_view(arena_.data() + s * kSlotBytes, static_cast<size_t>(sl.len));
+}
+
+void UringProcBatch::abandon() {
+  // A failed flush disables the batch (disabled_), so completions still in
+  // flight on the abandoned ring are never read back.
+  for (auto& sl : slots_) {
+    if (sl.fd >= 0) { ::close(sl.fd); sl.fd = -1; }
+  }
+  for (int fd : closing_) ::close(fd);
+  closing_.clear();
+}
+
+}  // namespace montauk::util
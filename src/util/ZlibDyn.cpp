@@ -0,0 +1,71 @@
+#include "util/ZlibDyn.hpp"
+
+#include <dlfcn.h>
+#include <cstdlib>
+
+#include "util/Log.hpp"
+
+namespace montauk::util {
+
+ZlibDyn& ZlibDyn::instance() {
+  static ZlibDyn inst;
+  return inst;
+}
+
+bool ZlibDyn::load_once() {
+  // Concurrent /metrics requests can be the first to ask for gzip.
+  std::call_once(loaded_, [this] { (void)load(); });
+  return handle_ != nullptr;
+}
+
+bool ZlibDyn::load() {
+  const char* override_path = std::getenv("MONTAUK_ZLIB_PATH");
+  const char* lib = override_path && *override_path ? override_path : "libz.so.1";
+  void* h = ::dlopen(lib, RTLD_LAZY | RTLD_LOCAL);
+  if (!h) {
+    log_info("zlib not available (%s): /metrics served uncompressed", lib);
+    return false;
+  }
+
+  auto L = [&](const char* sym) { return ::dlsym(h, sym); };
+  p_deflateInit2_ = reinterpret_cast<decltype(p_deflateInit2_)>(L("deflateInit2_"));
+  p_deflate       = reinterpret_cast<decltype(p_deflate)>(L("deflate"));
+  p_deflateEnd    = reinterpret_cast<decltype(p_deflateEnd)>(L("deflateEnd"));
+  p_deflateBound  = reinterpret_cast<decltype(p_deflateBound)>(L("deflateBound"));
+
+  if (!p_deflateInit2_ || !p_deflate || !p_deflateEnd || !p_deflateBound) {
+    log_warn("zlib loaded but is missing expected symbols: /metrics served uncompressed");
+    ::dlclose(h);
+    return false;
+  }
+  handle_ = h;
+  return true;
+}
+
+bool ZlibDyn::gzip(std::string_view in, std::string& out) {
+  out.clear();
+  if (!load_once()) return false;
+
+  z_stream zs{};
+  // windowBits 15 + 16: a gzip header and trailer instead of zlib's.
+  if (p_deflateInit2_(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                      Z_DEFAULT_STRATEGY, ZLIB_VERSION, static_cast<int>(sizeof(zs))) != Z_OK)
+    return false;
+  // deflateBound covers the whole input, so one Z_FINISH call always completes.
+  out.resize(p_deflateBound(&zs, static_cast<uLong>(in.size())));
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = static_cast<uInt>(in.size());
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = static_cast<uInt>(out.size());
+  const int rc = p_deflate(&zs, Z_FINISH);
+  const size_t produced = zs.total_out;
+  p_deflateEnd(&zs);
+  if (rc != Z_STREAM_END) {
+    out.clear();
+    return false;
+  }
+  out.resize(produced);
+  return true;
+}
+
+}  // namespace montauk::util
@@ -0,0 +1,134 @@
+// Text vs change-only text vs binary history log: size on disk and full-scan
+// read time for the same recording.
+//
+//   montauk_history_bench LOG.prom [OUTDIR]
+//
+// Re-encodes a .prom log written by `montauk --log DIR` as the change-only
+// text of --log-format delta and as the binary format of --log-format binary
+// (scrape timestamps, series kinds and values carried over unchanged), then
+// reads each back through HistoryReader, the path --analyze takes, and reports
+// bytes, scrapes, samples and the best of five full scans. The copies land in
+// OUTDIR (default: the system temp directory).
+#include "model/HistoryLog.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+namespace {
+
+using montauk::model::HistoryReader;
+using montauk::model::HistoryReadStatus;
+using montauk::model::HistoryScrape;
+using montauk::model::HistoryWriter;
+using montauk::model::PromDeltaEncoder;
+using clk = std::chrono::steady_clock;
+
+struct Scan {
+  size_t scrapes = 0, samples = 0;
+  double checksum = 0.0;  // keeps the scan from being optimized out
+  double ms = 0.0;
+};
+
+Scan scan(const std::string& path) {
+  Scan best;
+  for (int rep = 0; rep < 5; ++rep) {
+    Scan s;
+    auto t0 = clk::now();
+    HistoryReader r;
+    if (r.open(path.c_str()) != HistoryReadStatus::Ok) return s;
+    HistoryScrape sc;
+    while (r.next(sc)) {
+      ++s.scrapes;
+      s.samples += sc.ids.size();
+      for (double v : sc.values) s.checksum += v == v ? v : 0.0;
+    }
+    s.ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+    if (rep == 0 || s.ms < best.ms) best = s;
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: montauk_history_bench LOG.prom [OUTDIR]\n");
+    return 2;
+  }
+  const std::string in = argv[1];
+  const std::filesystem::path dir = argc > 2 ? argv[2] : std::filesystem::temp_directory_path();
+  const std::string stem = std::filesystem::path(in).stem().string();
+  const std::string out = (dir / (stem + ".mhist")).string();
+  const std::string delta_out = (dir / (stem + ".delta.prom")).string();
+  std::filesystem::remove(out);
+
+  {
+    // The text log is already one exposition per timestamp comment; hand
+    // each to the encoder as LogWriter would have.
+    std::ifstream f(in);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    const std::string text = ss.str();
+    const std::string_view marker = "# montauk_scrape_timestamp_ms ";
+    std::string encoded;
+    PromDeltaEncoder enc;
+    for (size_t pos = text.find(marker); pos != std::string::npos;) {
+      const size_t body = text.find('\n', pos) + 1;
+      const size_t next = text.find(marker, body);
+      const int64_t ts = std::strtoll(text.c_str() + pos + marker.size(), nullptr, 10);
+      enc.encode(ts, std::string_view(text).substr(body, next == std::string::npos ? std::string::npos : next - body),
+                 encoded);
+      pos = next;
+    }
+    std::ofstream(delta_out, std::ios::trunc) << encoded;
+  }
+
+  {
+    HistoryReader r;
+    if (r.open(in.c_str()) != HistoryReadStatus::Ok || r.binary()) {
+      std::fprintf(stderr, "%s: not a readable .prom log\n", in.c_str());
+      return 1;
+    }
+    HistoryWriter w;
+    if (!w.open(out.c_str(), 0)) {
+      std::perror(out.c_str());
+      return 1;
+    }
+    HistoryScrape sc;
+    int64_t ts = 0;
+    while (r.next(sc)) {
+      // A bench .prom without timestamp comments: number the scrapes.
+      ts = sc.ts_ms >= 0 ? sc.ts_ms : ts + 1000;
+      w.begin_scrape(ts);
+      for (size_t i = 0; i < sc.ids.size(); ++i) {
+        const auto& series = r.series()[sc.ids[i]];
+        w.sample(series.name, series.labels, series.kind, sc.values[i]);
+      }
+      if (!w.end_scrape()) {
+        std::perror(out.c_str());
+        return 1;
+      }
+    }
+  }
+
+  const Scan text = scan(in), delta = scan(delta_out), bin = scan(out);
+  const auto text_bytes = std::filesystem::file_size(in);
+  std::printf("%-7s %12s %8s %10s %10s %8s\n", "format", "bytes", "scrapes", "samples", "read ms", "size");
+  bool same = true;
+  for (auto [name, path, sc] : {std::tuple{"text", in, text}, std::tuple{"delta", delta_out, delta},
+                                std::tuple{"binary", out, bin}}) {
+    const auto bytes = std::filesystem::file_size(path);
+    std::printf("%-7s %12ju %8zu %10zu %10.2f %7.1fx\n", name, static_cast<uintmax_t>(bytes), sc.scrapes,
+                sc.samples, sc.ms,
+                static_cast<double>(text_bytes) / static_cast<double>(std::max<uintmax_t>(bytes, 1)));
+    same = same && sc.samples == text.samples && sc.checksum == text.checksum;
+  }
+  std::printf("decoded samples and checksums %s\n", same ? "match" : "DIFFER");
+  return same ? 0 : 1;
+}
@@ -0,0 +1,343 @@
+// /metrics load test: a few hundred concurrent scrapers against montauk's
+// Prometheus endpoint, reporting scrapes/s and latency percentiles.
+//
+//   montauk_metrics_bench
+//   montauk_metrics_bench --clients 500 --secs 10 --gzip
+//   montauk_metrics_bench --stalled 50            # plus 50 clients that send half a request and hang
+//   montauk_metrics_bench --trickle 50 --secs 10  # plus 50 sending one header byte every --trickle-ms
+//   montauk_metrics_bench --port 9101 --close     # a running montauk, new connection per scrape
+//   montauk_metrics_bench --path '/metrics/procs?top=10'
+//
+// Without --port it serves a synthetic --procs snapshot from an in-process
+// MetricsServer (needs a liburing build), republished every --publish-ms so
+// the per-generation render cache is exercised too. Each --threads driver
+// runs its share of the clients as non-blocking sockets under poll(): a
+// client sends a request, reads the whole response, records the latency and
+// goes again -- on the same connection unless --close.
+#include "app/MetricsServer.hpp"
+#include "model/Snapshot.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using clk = std::chrono::steady_clock;
+
+struct Opts {
+  int port = 0;  // 0: in-process server on --listen
+  int listen = 19191;
+  int clients = 300;
+  int threads = 4;
+  int stalled = 0;
+  int trickle = 0;
+  int trickle_ms = 1000;
+  int procs = 2000;
+  int publish_ms = 1000;
+  double secs = 5.0;
+  bool close = false;
+  bool gzip = false;
+  std::string path = "/metrics";
+};
+
+struct Result {
+  std::vector<double> lat_ms;
+  unsigned long long bytes = 0;
+  unsigned long long errors = 0;
+  unsigned long long connects = 0;
+};
+
+void fill(montauk::model::Snapshot& s, int procs, int gen) {
+  std::vector<montauk::model::ProcSample> rows(static_cast<size_t>(procs));
+  for (int i = 0; i < procs; ++i) {
+    auto& r = rows[static_cast<size_t>(i)];
+    r.pid = 1000 + i;
+    r.cpu_pct = (i + gen) % 100;
+    r.rss_kb = static_cast<uint64_t>(i) * 4;
+    r.cmd = "/usr/bin/worker --shard=" + std::to_string(i % 257);
+    r.user_name = "user" + std::to_string(i % 13);
+  }
+  s.procs.assign_rows(rows);
+  s.procs.total_processes = static_cast<size_t>(procs);
+  s.cpu.usage_pct = gen % 100;
+  s.cpu.per_core_pct.assign(64, 12.5);
+  s.mem.total_kb = 64ull << 20;
+}
+
+int open_client(int port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  int one = 1;
+  (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 && errno != EINPROGRESS) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+struct Client {
+  enum class St { Connecting, Sending, Reading } st{St::Connecting};
+  int fd{-1};
+  size_t sent{0};
+  std::string in;
+  size_t need{0};  // head + body once the head is parsed, else 0
+  clk::time_point t0{};
+};
+
+// Total response length once its head is in, or 0 if it is not yet.
+size_t response_length(const std::string& in) {
+  const size_t end = in.find("\r\n\r\n");
+  if (end == std::string::npos) return 0;
+  const std::string_view head(in.data(), end);
+  size_t len = 0;
+  if (size_t p = head.find("Content-Length: "); p != std::string_view::npos) {
+    const char* s = head.data() + p + 16;
+    std::from_chars(s, head.data() + head.size(), len);
+  }
+  return end + 4 + len;
+}
+
+void drive(const Opts& o, int nclients, const std::string& request, clk::time_point until, Result& res) {
+  std::vector<Client> cs(static_cast<size_t>(nclients));
+  auto reconnect = [&](Client& c) {
+    if (c.fd >= 0) ::close(c.fd);
+    c = Client{};
+    // A fresh connection's clock starts at connect(): a server that leaves
+    // clients in its accept backlog does not get that wait for free.
+    c.t0 = clk::now();
+    c.fd = open_client(o.port);
+    ++res.connects;
+    if (c.fd < 0) ++res.errors;
+  };
+  for (auto& c : cs) reconnect(c);
+
+  std::vector<pollfd> pfds(cs.size());
+  char buf[65536];
+  while (clk::now() < until) {
+    for (size_t i = 0; i < cs.size(); ++i) {
+      if (cs[i].fd < 0) reconnect(cs[i]);
+      const short ev = cs[i].st == Client::St::Reading ? POLLIN : POLLOUT;
+      pfds[i] = pollfd{cs[i].fd, ev, 0};
+    }
+    if (::poll(pfds.data(), pfds.size(), 100) <= 0) continue;
+
+    for (size_t i = 0; i < cs.size(); ++i) {
+      Client& c = cs[i];
+      const short rev = pfds[i].revents;
+      if (!rev) continue;
+      if (c.st == Client::St::Connecting) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        (void)::getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err) { ++res.errors; reconnect(c); continue; }
+        c.st = Client::St::Sending;
+      }
+      if (c.st == Client::St::Sending) {
+        ssize_t n = ::send(c.fd, request.data() + c.sent, request.size() - c.sent, MSG_NOSIGNAL);
+        if (n < 0) {
+          if (errno != EAGAIN) { ++res.errors; reconnect(c); }
+          continue;
+        }
+        c.sent += static_cast<size_t>(n);
+        if (c.sent == request.size()) c.st = Client::St::Reading;
+        continue;
+      }
+      ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+      if (n <= 0) {
+        if (n < 0 && errno == EAGAIN) continue;
+        ++res.errors;  // the server hung up mid-response
+        reconnect(c);
+        continue;
+      }
+      c.in.append(buf, static_cast<size_t>(n));
+      if (!c.need) c.need = response_length(c.in);
+      if (!c.need || c.in.size() < c.need) continue;
+
+      res.lat_ms.push_back(std::chrono::duration<double, std::milli>(clk::now() - c.t0).count());
+      res.bytes += c.need;
+      if (o.close) {
+        reconnect(c);
+      } else {
+        c.in.clear();
+        c.need = 0;
+        c.sent = 0;
+        c.st = Client::St::Sending;
+        c.t0 = clk::now();
+      }
+    }
+  }
+  for (auto& c : cs)
+    if (c.fd >= 0) ::close(c.fd);
+}
+
+double pct(const std::vector<double>& v, double p) {
+  if (v.empty()) return 0.0;
+  return v[std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())))];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Opts o;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    auto next = [&] { return i + 1 < argc ? argv[++i] : "0"; };
+    if (a == "--port") o.port = std::atoi(next());
+    else if (a == "--listen") o.listen = std::atoi(next());
+    else if (a == "--clients") o.clients = std::atoi(next());
+    else if (a == "--threads") o.threads = std::atoi(next());
+    else if (a == "--stalled") o.stalled = std::atoi(next());
+    else if (a == "--trickle") o.trickle = std::atoi(next());
+    else if (a == "--trickle-ms") o.trickle_ms = std::max(1, std::atoi(next()));
+    else if (a == "--procs") o.procs = std::atoi(next());
+    else if (a == "--publish-ms") o.publish_ms = std::atoi(next());
+    else if (a == "--secs") o.secs = std::atof(next());
+    else if (a == "--close") o.close = true;
+    else if (a == "--gzip") o.gzip = true;
+    else if (a == "--path") o.path = next();
+    else {
+      std::fprintf(stderr, "usage: montauk_metrics_bench [--port P | --listen P] [--clients N] [--threads N]\n"
+                           "         [--stalled N] [--trickle N] [--trickle-ms MS] [--procs N] [--publish-ms MS]\n"
+                           "         [--secs S] [--close] [--gzip]\n"
+                           "         [--path TARGET]\n");
+      return 2;
+    }
+  }
+  o.threads = std::clamp(o.threads, 1, std::max(1, o.clients));
+
+  montauk::app::SnapshotBuffers buffers;
+  std::unique_ptr<montauk::app::MetricsServer> server;
+  std::atomic<bool> done{false};
+  std::jthread publisher;
+  if (o.port == 0) {
+#ifndef MONTAUK_HAVE_URING
+    std::fprintf(stderr, "montauk_metrics_bench: built without liburing; pass --port of a running montauk --metrics\n");
+    return 2;
+#endif
+    fill(buffers.back(), o.procs, 0);
+    buffers.publish();
+    o.port = o.listen;
+    server = std::make_unique<montauk::app::MetricsServer>(buffers, static_cast<uint16_t>(o.port));
+    server->start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    publisher = std::jthread([&] {
+      for (int gen = 1; !done.load(); ++gen) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(o.publish_ms));
+        fill(buffers.back(), o.procs, gen);
+        buffers.publish();
+      }
+    });
+  }
+
+  std::string request = "GET " + o.path + " HTTP/1.1\r\nHost: localhost\r\n";
+  if (o.gzip) request += "Accept-Encoding: gzip\r\n";
+  if (o.close) request += "Connection: close\r\n";
+  request += "\r\n";
+
+  // Stalled clients: half a request, then silence -- what used to hold the
+  // single-threaded endpoint for its whole 5 s receive timeout.
+  std::vector<int> stalled;
+  for (int i = 0; i < o.stalled; ++i) {
+    int fd = open_client(o.port);
+    if (fd < 0) continue;
+    pollfd pfd{fd, POLLOUT, 0};
+    (void)::poll(&pfd, 1, 1000);
+    (void)::send(fd, "GET /metr", 9, MSG_NOSIGNAL);
+    stalled.push_back(fd);
+  }
+
+  // Trickling clients: a header byte every --trickle-ms, never finishing the
+  // request. A deadline refreshed on every byte would keep them forever; the
+  // server's per-request deadline has to cut them off.
+  std::vector<int> trickle;
+  for (int i = 0; i < o.trickle; ++i) {
+    int fd = open_client(o.port);
+    if (fd < 0) continue;
+    pollfd pfd{fd, POLLOUT, 0};
+    (void)::poll(&pfd, 1, 1000);
+    trickle.push_back(fd);
+  }
+  std::atomic<int> trickle_cut{0};
+  std::jthread trickler;
+  if (!trickle.empty()) {
+    trickler = std::jthread([&](std::stop_token st) {
+      const std::string head = "GET " + o.path + " HTTP/1.1\r\nX-Trickle: ";
+      std::vector<uint8_t> alive(trickle.size(), 1);
+      for (size_t pos = 0; !st.stop_requested(); ++pos) {
+        const char b = pos < head.size() ? head[pos] : 'x';
+        for (size_t i = 0; i < trickle.size(); ++i) {
+          if (!alive[i]) continue;
+          char sink;
+          bool closed = ::recv(trickle[i], &sink, 1, MSG_DONTWAIT) == 0;
+          if (!closed && ::send(trickle[i], &b, 1, MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+            closed = errno != EAGAIN && errno != EWOULDBLOCK;
+          if (closed) { alive[i] = 0; trickle_cut.fetch_add(1); }
+        }
+        for (int slept = 0; slept < o.trickle_ms && !st.stop_requested(); slept += 10)
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    });
+  }
+
+  const auto t0 = clk::now();
+  const auto until = t0 + std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(o.secs));
+  std::vector<Result> results(static_cast<size_t>(o.threads));
+  {
+    std::vector<std::jthread> drivers;
+    for (int t = 0; t < o.threads; ++t) {
+      const int n = o.clients / o.threads + (t < o.clients % o.threads ? 1 : 0);
+      drivers.emplace_back([&, t, n] { drive(o, n, request, until, results[static_cast<size_t>(t)]); });
+    }
+  }
+  const double elapsed = std::chrono::duration<double>(clk::now() - t0).count();
+  done.store(true);
+  for (int fd : stalled) ::close(fd);
+  if (trickler.joinable()) {
+    trickler.request_stop();
+    trickler.join();
+  }
+  for (int fd : trickle) ::close(fd);
+
+  Result all;
+  for (auto& r : results) {
+    all.lat_ms.insert(all.lat_ms.end(), r.lat_ms.begin(), r.lat_ms.end());
+    all.bytes += r.bytes;
+    all.errors += r.errors;
+    all.connects += r.connects;
+  }
+  std::sort(all.lat_ms.begin(), all.lat_ms.end());
+  const double n = static_cast<double>(all.lat_ms.size());
+  std::printf("%s: clients %d (+%zu stalled), %s%s, %.1f s\n", o.path.c_str(), o.clients, stalled.size(),
+              o.close ? "close" : "keep-alive", o.gzip ? ", gzip" : "", elapsed);
+  std::printf("  scrapes      %llu (%.0f/s)\n", static_cast<unsigned long long>(all.lat_ms.size()), n / elapsed);
+  std::printf("  body         %.1f KB avg, %.1f MB/s\n", n ? static_cast<double>(all.bytes) / n / 1024.0 : 0.0,
+              static_cast<double>(all.bytes) / elapsed / (1024.0 * 1024.0));
+  std::printf("  latency ms   p50 %.2f  p99 %.2f  max %.2f\n", pct(all.lat_ms, 0.50), pct(all.lat_ms, 0.99),
+              all.lat_ms.empty() ? 0.0 : all.lat_ms.back());
+  std::printf("  connects     %llu, errors %llu\n", all.connects, all.errors);
+  if (!trickle.empty())
+    std::printf("  trickling    %d of %zu cut off (one byte per %d ms)\n", trickle_cut.load(), trickle.size(),
+                o.trickle_ms);
+  if (server) server->stop();
+  return all.lat_ms.empty() ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+// `montauk --json` end-to-end latency: what a fleet tool pays per host when it
+// shells out for one snapshot. Two figures per run:
+//
+//   in-process  sample_one_shot() itself -- measured window and total
+//   end-to-end  posix_spawn of `montauk --json` to exit, stdout to /dev/null
+//
+//   montauk_oneshot_bench
+//   montauk_oneshot_bench --runs 50 --montauk build/montauk --target-ms 100
+//
+// --montauk defaults to the montauk binary next to this one. Exits 1 when the
+// end-to-end p50 misses --target-ms, so a script can gate on it; the suite
+// only builds it, since the number depends on the host.
+#include "app/OneShot.hpp"
+#include "model/Snapshot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace {
+
+using clk = std::chrono::steady_clock;
+
+double pct(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())))];
+}
+
+void report(const char* name, const std::vector<double>& ms) {
+  std::printf("%-22s %9.1f %9.1f %9.1f\n", name, pct(ms, 0.5), pct(ms, 0.99), pct(ms, 1.0));
+}
+
+// Wall milliseconds for one `bin --json`, or -1 if it could not run or failed.
+double spawn_once(const std::string& bin) {
+  posix_spawn_file_actions_t fa;
+  posix_spawn_file_actions_init(&fa);
+  posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  char* argv[] = {const_cast<char*>(bin.c_str()), const_cast<char*>("--json"), nullptr};
+  const auto t0 = clk::now();
+  pid_t pid = -1;
+  const int rc = ::posix_spawn(&pid, bin.c_str(), &fa, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&fa);
+  if (rc != 0) return -1.0;
+  int status = 0;
+  if (::waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1.0;
+  return std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int runs = 20;
+  double target_ms = 100.0;
+  std::string bin = (std::filesystem::read_symlink("/proc/self/exe").parent_path() / "montauk").string();
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--runs") && i + 1 < argc) runs = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--montauk") && i + 1 < argc) bin = argv[++i];
+    else if (!std::strcmp(argv[i], "--target-ms") && i + 1 < argc) target_ms = std::atof(argv[++i]);
+    else {
+      std::fprintf(stderr, "usage: %s [--runs N] [--montauk PATH] [--target-ms MS]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<double> window_ms, total_ms, e2e_ms;
+  bool schedstat = true;
+  for (int r = 0; r < runs; ++r) {
+    montauk::model::Snapshot s;
+    const auto st = montauk::app::sample_one_shot(s);
+    schedstat = schedstat && st.schedstat;
+    window_ms.push_back(static_cast<double>(st.window.count()) / 1000.0);
+    total_ms.push_back(static_cast<double>(st.total.count()) / 1000.0);
+  }
+  for (int r = 0; r < runs; ++r) {
+    const double ms = spawn_once(bin);
+    if (ms < 0) {
+      std::fprintf(stderr, "%s --json failed to run\n", bin.c_str());
+      return 2;
+    }
+    e2e_ms.push_back(ms);
+  }
+
+  std::printf("runs %d  cpu accounting %s  target p50 %.0f ms\n", runs,
+              schedstat ? "schedstat" : "ticks (fallback)", target_ms);
+  std::printf("%-22s %9s %9s %9s\n", "", "p50 ms", "p99 ms", "max ms");
+  report("in-process window", window_ms);
+  report("in-process total", total_ms);
+  report("end-to-end --json", e2e_ms);
+  return pct(e2e_ms, 0.5) <= target_ms ? 0 : 1;
+}
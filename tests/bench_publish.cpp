@@ -0,0 +1,161 @@
+// Snapshot publication contention benchmark: DoubleBuffer (copy under a
+// shared lock) against RcuBuffer (refcounted immutable generations), the same
+// Snapshot on both, the same reader population.
+//
+//   montauk_publish_bench
+//   montauk_publish_bench --procs 20000 --readers 8 --hold-us 2000 --secs 3
+//
+// Each reader does what the render loop and read_metrics_snapshot used to do
+// with a DoubleBuffer -- copy the front snapshot under its lock -- or, for
+// RcuBuffer, acquire the current generation. --hold-us keeps each reader on its
+// snapshot that long before letting go (a /metrics scrape serializing a large
+// host). The writer publishes every --pub-us and records how long each
+// begin_write..publish took: the number that shows whether a slow reader can
+// stall the Producer.
+#include "app/DoubleBuffer.hpp"
+#include "app/RcuBuffer.hpp"
+#include "model/Snapshot.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using montauk::model::Snapshot;
+using clk = std::chrono::steady_clock;
+
+struct Opts {
+  int procs = 5000;
+  int readers = 4;
+  int hold_us = 0;
+  int pub_us = 1000;
+  double secs = 2.0;
+};
+
+struct Result {
+  std::vector<double> pub_us;  // per-publish writer latency
+  unsigned long long reads = 0;
+};
+
+void fill(Snapshot& s, int procs) {
+  std::vector<montauk::model::ProcSample> rows(static_cast<size_t>(procs));
+  for (int i = 0; i < procs; ++i) {
+    auto& r = rows[static_cast<size_t>(i)];
+    r.pid = 1000 + i;
+    r.cpu_pct = i % 100;
+    r.rss_kb = static_cast<uint64_t>(i) * 4;
+    r.cmd = "/usr/bin/worker --shard=" + std::to_string(i % 257);
+    r.user_name = "user" + std::to_string(i % 13);
+    r.exe_path = "/usr/bin/worker";
+  }
+  s.procs.assign_rows(rows);
+  s.procs.total_processes = static_cast<size_t>(procs);
+  s.cpu.per_core_pct.assign(64, 12.5);
+}
+
+void spin_for(int us) {
+  if (us <= 0) return;
+  const auto until = clk::now() + std::chrono::microseconds(us);
+  while (clk::now() < until) {}
+}
+
+// Buf: DoubleBuffer<Snapshot> or RcuBuffer<Snapshot>. read_one(buf, hold_us)
+// performs one reader access and returns something derived from it.
+template <typename Buf, typename ReadOne>
+Result run(const Opts& o, ReadOne read_one) {
+  Buf buf;
+  fill(buf.back(), o.procs);
+  buf.publish();
+  fill(buf.begin_write(), o.procs);
+  buf.publish();
+
+  std::atomic<bool> stop{false};
+  std::atomic<unsigned long long> reads{0};
+  std::atomic<size_t> sink{0};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < o.readers; ++r) {
+    readers.emplace_back([&] {
+      unsigned long long n = 0;
+      size_t acc = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        acc += read_one(buf, o.hold_us);
+        ++n;
+      }
+      reads.fetch_add(n);
+      sink.fetch_add(acc);
+    });
+  }
+
+  Result res;
+  const auto end = clk::now() + std::chrono::duration<double>(o.secs);
+  auto next = clk::now();
+  while (clk::now() < end) {
+    next += std::chrono::microseconds(o.pub_us);
+    const auto t0 = clk::now();
+    auto& s = buf.begin_write();
+    s.cpu.usage_pct = static_cast<double>(res.pub_us.size() % 100);
+    buf.publish();
+    res.pub_us.push_back(std::chrono::duration<double, std::micro>(clk::now() - t0).count());
+    std::this_thread::sleep_until(next);
+  }
+  stop.store(true);
+  for (auto& t : readers) t.join();
+  res.reads = reads.load();
+  if (sink.load() == 1) std::printf(" ");  // keep the reads observable
+  return res;
+}
+
+double pct(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())))];
+}
+
+void report(const char* name, const Result& r, double secs) {
+  std::printf("%-14s %10.1f %10.1f %10.1f %12.0f\n", name, pct(r.pub_us, 0.5), pct(r.pub_us, 0.99),
+              pct(r.pub_us, 1.0), static_cast<double>(r.reads) / secs);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Opts o;
+  for (int i = 1; i < argc; ++i) {
+    if (!std::strcmp(argv[i], "--procs") && i + 1 < argc) o.procs = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--readers") && i + 1 < argc) o.readers = std::max(0, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--hold-us") && i + 1 < argc) o.hold_us = std::max(0, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--pub-us") && i + 1 < argc) o.pub_us = std::max(1, std::atoi(argv[++i]));
+    else if (!std::strcmp(argv[i], "--secs") && i + 1 < argc) o.secs = std::max(0.1, std::atof(argv[++i]));
+    else {
+      std::fprintf(stderr, "usage: %s [--procs N] [--readers R] [--hold-us U] [--pub-us P] [--secs S]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  const Result dbl = run<montauk::app::DoubleBuffer<Snapshot>>(o, [](const auto& b, int hold) {
+    return b.read([&](const Snapshot& s) {
+      Snapshot copy = s;
+      spin_for(hold);
+      return copy.procs.size();
+    });
+  });
+  const Result rcu = run<montauk::app::RcuBuffer<Snapshot>>(o, [](const auto& b, int hold) {
+    const auto s = b.acquire();
+    spin_for(hold);
+    return s->procs.size();
+  });
+
+  std::printf("procs %d  readers %d  hold %d us  publish every %d us\n",
+              o.procs, o.readers, o.hold_us, o.pub_us);
+  std::printf("%-14s %10s %10s %10s %12s\n", "primitive", "pub p50us", "pub p99us", "pub maxus", "reads/s");
+  report("double-buffer", dbl, o.secs);
+  report("rcu", rcu, o.secs);
+  return 0;
+}
@@ -130,16 +130,18 @@ inline montauk::app::MetricsSnapshot make_fixture_snapshot() {
   s.state_sleeping = 300;
   s.state_zombie = 0;
   s.total_threads = 900;
-  s.top_procs_count = 2;
+  s.proc_sample_us = 4200;
+  s.proc_scan_shards = 2;
   {
-    ProcSample& p0 = s.top_procs[0];
+    ProcSample p0;
     p0.pid = 805;
     p0.cmd = "montauk";
     p0.user_name = "mod";
     p0.cpu_pct = 1.5;
     p0.rss_kb = 45548;
     // has_gpu_util/has_gpu_mem deliberately left false on this one.
-    ProcSample& p1 = s.top_procs[1];
+    s.top_procs.push_back(p0);
+    ProcSample p1;
     p1.pid = 939;
     p1.cmd = "gpu-process";
     p1.user_name = "mod";
@@ -149,6 +151,7 @@ inline montauk::app::MetricsSnapshot make_fixture_snapshot() {
     p1.gpu_util_pct = 9.0;
     p1.has_gpu_mem = true;
     p1.gpu_mem_kb = 54984;
+    s.top_procs.push_back(p1);
   }
 
   // Anomaly feature matrix over the fused population, exercising the JSON-only
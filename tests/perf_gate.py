@@ -10,6 +10,8 @@ Three defenses, stacked so no box or load level flakes:
     order-of-magnitude regression at ~zero flake risk)
   - a GROWTH bound (2x the input must cost < 4x the CPU) that catches
     superlinear parse or pairing regressions machine-independently
+  - one wall-clock envelope, for `montauk --json`, whose latency is the
+    product
   - a self-calibrating oracle for the CLI: sublimation sort races real
     sort -n on the same input in the same run; "never grossly slower than
     the tool it replaces" is the envelope that matters, and it cancels
@@ -23,6 +25,7 @@ import shutil
 import subprocess
 import sys
 import tempfile
+import time
 from pathlib import Path
 
 import gen_synthetic_prom as gen
@@ -97,6 +100,20 @@ def main() -> int:
         else:
             note("skip analyzer-ceiling (no synthetic.mtk; run corpus_check)")
 
+        # --json one-shot latency. The one envelope that is wall time, because
+        # wall time is what a fleet tool shelling out per host pays. Target is
+        # ~100 ms (tests/bench_oneshot.cpp reports it); the ceiling is the
+        # regression class it replaced -- a Producer warm-up plus a full
+        # 1 s process interval.
+        walls = []
+        for _ in range(5):
+            t0 = time.monotonic()
+            subprocess.run([str(harness.MONTAUK), "--json"], check=True,
+                           stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            walls.append(time.monotonic() - t0)
+        wall = sorted(walls)[len(walls) // 2]
+        check("json-oneshot-latency", wall < 0.5, f"p50 {wall * 1000:.0f} ms wall")
+
         # CLI oracle: sublimation sort vs coreutils sort -n on 2M lines.
         stream = td / "stream.txt"
         with open(stream, "w") as f:
@@ -2,7 +2,8 @@
 """montauk test runner -- one entry point for the whole suite.
 
 Four layers, one command, a clear split:
-  unit   -- the C++ montauk_tests aggregate, the C23 montauk_sink_c_test,
+  unit   -- the C++ montauk_tests aggregate, the C23 montauk_sink_c_test and
+            montauk_shm_c_test,
             sublimation_fuzz_diff (seeded sort differential vs std::sort, all
             types, multiset + order, heavy on few-unique / NaN / signed-zero),
             and the work-stealing DFS engine tests: test_wsdeque / test_dfspool
@@ -43,7 +44,7 @@ SUB_CORE_TESTS = ["test_basic", "test_tier1", "test_tier2", "test_tier4",
                   "test_strings", "test_randomness", "test_profile_contract",
                   "test_search", "test_affinity"]
 
-TARGETS = ["montauk", "montauk_tests", "montauk_sink_c_test",
+TARGETS = ["montauk", "montauk_tests", "montauk_sink_c_test", "montauk_shm_c_test",
            "montauk_json_test", "montauk_stats_test", "sublimation_fuzz_diff",
            "test_wsdeque", "test_dfspool", "test_radix", "test_radix_par",
            "test_smerge_par", "test_pack",
@@ -93,7 +94,7 @@ def build():
 
 def layer_unit():
     ok = True
-    for exe in ("montauk_tests", "montauk_sink_c_test", "montauk_json_test",
+    for exe in ("montauk_tests", "montauk_sink_c_test", "montauk_shm_c_test", "montauk_json_test",
                 "montauk_stats_test", "sublimation_fuzz_diff",
                 "test_wsdeque", "test_dfspool", "test_radix", "test_radix_par",
                 "test_smerge_par", "test_pack", *SUB_CORE_TESTS):
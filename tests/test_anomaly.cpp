@@ -18,44 +18,44 @@ static ProcessSnapshot make_pop(size_t n) {
     p.pid = static_cast<int32_t>(1000 + i);
     p.cpu_pct = 1.0 + static_cast<double>(i % 3);      // 1..3, a tight cluster
     p.rss_kb = 40000 + (i % 5) * 1000;                 // ~40 MB cluster
-    ps.processes.push_back(p);
+    ps.push_back(p);
   }
   return ps;
 }
 
 static size_t top_scored(const ProcessSnapshot& ps) {
   size_t top = 0;
-  for (size_t i = 1; i < ps.processes.size(); ++i)
-    if (ps.processes[i].anomaly_score > ps.processes[top].anomaly_score) top = i;
+  for (size_t i = 1; i < ps.size(); ++i)
+    if (ps.anomaly_score[i] > ps.anomaly_score[top]) top = i;
   return top;
 }
 
 TEST(anomaly_flags_cpu_outlier) {
   auto ps = make_pop(30);
-  ps.processes[7].cpu_pct = 99.0;                      // a CPU burner
+  ps.cpu_pct[7] = 99.0;                      // a CPU burner
   std::unordered_map<int32_t, uint64_t> pf, pc;
   montauk::app::enrich_anomalies(ps, pf, pc);
   ASSERT_EQ(top_scored(ps), static_cast<size_t>(7));
-  ASSERT_EQ(static_cast<int>(ps.processes[7].anomaly_axis), 0);  // cpu
+  ASSERT_EQ(static_cast<int>(ps.anomaly_axis[7]), 0);  // cpu
 }
 
 TEST(anomaly_flags_rss_outlier) {
   auto ps = make_pop(30);
-  ps.processes[12].rss_kb = 8000000;                   // a ~8 GB memory hog
+  ps.rss_kb[12] = 8000000;                   // a ~8 GB memory hog
   std::unordered_map<int32_t, uint64_t> pf, pc;
   montauk::app::enrich_anomalies(ps, pf, pc);
   ASSERT_EQ(top_scored(ps), static_cast<size_t>(12));
-  ASSERT_EQ(static_cast<int>(ps.processes[12].anomaly_axis), 1);  // rss
+  ASSERT_EQ(static_cast<int>(ps.anomaly_axis[12]), 1);  // rss
 }
 
 TEST(anomaly_skips_tiny_population) {
   auto ps = make_pop(5);                               // fewer than 8: unscored
-  ps.processes[2].cpu_pct = 99.0;
+  ps.cpu_pct[2] = 99.0;
   std::unordered_map<int32_t, uint64_t> pf, pc;
   montauk::app::enrich_anomalies(ps, pf, pc);
-  for (const auto& p : ps.processes) {
-    ASSERT_EQ(p.anomaly_score, 0.0);
-    ASSERT_EQ(static_cast<int>(p.anomaly_axis), -1);
+  for (size_t i = 0; i < ps.size(); ++i) {
+    ASSERT_EQ(ps.anomaly_score[i], 0.0);
+    ASSERT_EQ(static_cast<int>(ps.anomaly_axis[i]), -1);
   }
 }
 
@@ -69,16 +69,16 @@ TEST(anomaly_skips_tiny_population) {
 TEST(anomaly_flags_involuntary_ctxsw_outlier) {
   auto ps = make_pop(30);
   std::unordered_map<int32_t, uint64_t> pf, pc;
-  for (auto& p : ps.processes) p.nvctx_raw = 100;
+  for (auto& v : ps.nvctx_raw) v = 100;
   montauk::app::enrich_anomalies(ps, pf, pc);            // seeds pc
-  for (const auto& p : ps.processes) ASSERT_EQ(p.ctxsw_delta, 0.0);
+  for (double d : ps.ctxsw_delta) ASSERT_EQ(d, 0.0);
 
-  for (auto& p : ps.processes) p.nvctx_raw = 110;        // everyone drifts
-  ps.processes[19].nvctx_raw = 900000;                   // one is thrashed
+  for (auto& v : ps.nvctx_raw) v = 110;        // everyone drifts
+  ps.nvctx_raw[19] = 900000;                   // one is thrashed
   montauk::app::enrich_anomalies(ps, pf, pc);
-  ASSERT_EQ(ps.processes[19].ctxsw_delta, 899900.0);
+  ASSERT_EQ(ps.ctxsw_delta[19], 899900.0);
   ASSERT_EQ(top_scored(ps), static_cast<size_t>(19));
-  ASSERT_EQ(static_cast<int>(ps.processes[19].anomaly_axis), 5);  // ctxsw
+  ASSERT_EQ(static_cast<int>(ps.anomaly_axis[19]), 5);  // ctxsw
 }
 
 // VOLUNTARY switches are read but deliberately NOT fused: a process choosing to
@@ -88,11 +88,11 @@ TEST(anomaly_flags_involuntary_ctxsw_outlier) {
 TEST(anomaly_ignores_voluntary_ctxsw) {
   auto ps = make_pop(30);
   std::unordered_map<int32_t, uint64_t> pf, pc;
-  for (auto& p : ps.processes) { p.nvctx_raw = 100; p.vctx_raw = 100; }
+  ps.nvctx_raw.assign(ps.size(), 100); ps.vctx_raw.assign(ps.size(), 100);
   montauk::app::enrich_anomalies(ps, pf, pc);
-  for (auto& p : ps.processes) { p.nvctx_raw = 110; p.vctx_raw = 110; }
-  ps.processes[3].vctx_raw = 900000;                     // voluntary only
+  ps.nvctx_raw.assign(ps.size(), 110); ps.vctx_raw.assign(ps.size(), 110);
+  ps.vctx_raw[3] = 900000;                     // voluntary only
   montauk::app::enrich_anomalies(ps, pf, pc);
-  ASSERT_EQ(ps.processes[3].ctxsw_delta, 10.0);          // unmoved by voluntary
-  ASSERT_EQ(static_cast<int>(ps.processes[3].anomaly_axis) == 5, false);
+  ASSERT_EQ(ps.ctxsw_delta[3], 10.0);          // unmoved by voluntary
+  ASSERT_EQ(static_cast<int>(ps.anomaly_axis[3]) == 5, false);
 }
@@ -0,0 +1,123 @@
+// CgroupCollector: cgroup v2 file parsing, rates, and incremental re-walks
+// over a fake hierarchy under MONTAUK_SYS_ROOT.
+#include "minitest.hpp"
+#include "env_guard.hpp"
+#include "collectors/CgroupCollector.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::path make_root_cgroup(const char* tag) {
+  auto root = fs::temp_directory_path() / (std::string("montauk_test_cgroup_") + tag + "_" +
+                                           std::to_string(::getpid()));
+  fs::remove_all(root);
+  fs::create_directories(root / "sys/fs/cgroup");
+  std::ofstream(root / "sys/fs/cgroup/cgroup.controllers") << "cpu io memory pids\n";
+  return root;
+}
+
+void write_group(const fs::path& dir, uint64_t usage_usec, uint64_t mem, uint64_t rbytes) {
+  fs::create_directories(dir);
+  std::ofstream(dir / "cpu.stat") << "usage_usec " << usage_usec << "\nuser_usec 0\nsystem_usec 0\n"
+                                  << "nr_periods 0\nnr_throttled 0\nthrottled_usec 0\n";
+  std::ofstream(dir / "memory.current") << mem << "\n";
+  std::ofstream(dir / "memory.stat") << "anon " << mem / 2 << "\nfile " << mem / 4 << "\nkernel 0\n";
+  std::ofstream(dir / "io.stat") << "8:0 rbytes=" << rbytes << " wbytes=0 rios=1 wios=0 dbytes=0 dios=0\n";
+  std::ofstream(dir / "pids.current") << "3\n";
+}
+
+const montauk::model::CgroupStat* find(const montauk::model::CgroupSnapshot& s, const std::string& path) {
+  auto it = std::find_if(s.groups.begin(), s.groups.end(), [&](const auto& g) { return g.path == path; });
+  return it == s.groups.end() ? nullptr : &*it;
+}
+
+}  // namespace
+
+TEST(cgroup_stat_parsers) {
+  uint64_t usage = 0, thr = 0;
+  montauk::collectors::parse_cgroup_cpu_stat(
+      "usage_usec 1234\nuser_usec 1000\nsystem_usec 234\nnr_periods 5\nnr_throttled 2\nthrottled_usec 77\n",
+      usage, thr);
+  ASSERT_EQ(usage, 1234u);
+  ASSERT_EQ(thr, 77u);
+  uint64_t anon = 0, file = 0;
+  montauk::collectors::parse_cgroup_memory_stat("anon 4096\nfile 8192\nfile_mapped 10\n", anon, file);
+  ASSERT_EQ(anon, 4096u);
+  ASSERT_EQ(file, 8192u);
+  uint64_t r = 0, w = 0;
+  montauk::collectors::parse_cgroup_io_stat(
+      "8:0 rbytes=100 wbytes=10 rios=1 wios=1 dbytes=0 dios=0\n259:0 rbytes=5 wbytes=1 rios=1 wios=1\n", r, w);
+  ASSERT_EQ(r, 105u);
+  ASSERT_EQ(w, 11u);
+}
+
+TEST(cgroup_collector_reads_groups_and_rates) {
+  auto root = make_root_cgroup("rates");
+  const auto cg = root / "sys/fs/cgroup";
+  write_group(cg / "system.slice", 1'000'000, 1 << 20, 0);
+  write_group(cg / "system.slice/web.service", 500'000, 1 << 19, 4096);
+  TempRootGuard sys_root("MONTAUK_SYS_ROOT", root.string());
+  montauk::collectors::CgroupCollector c;
+  montauk::model::CgroupSnapshot s;
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(s.total, 3u);  // root + two
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  write_group(cg / "system.slice/web.service", 550'000, 1 << 19, 8192);
+  ASSERT_TRUE(c.sample(s));
+  const auto* web = find(s, "/system.slice/web.service");
+  ASSERT_TRUE(web != nullptr);
+  ASSERT_EQ(web->depth, 2);
+  ASSERT_EQ(web->mem_bytes, uint64_t{1} << 19);
+  ASSERT_EQ(web->anon_bytes, uint64_t{1} << 18);
+  ASSERT_EQ(web->pids, 3u);
+  // 50 ms of CPU in ~100 ms of wall: about half a core.
+  ASSERT_TRUE(web->cpu_pct > 10.0 && web->cpu_pct <= 60.0);
+  ASSERT_TRUE(web->io_read_bps > 0.0);
+  ASSERT_TRUE(s.groups.front().path == "/system.slice/web.service");  // busiest first
+  fs::remove_all(root);
+}
+
+TEST(cgroup_collector_walks_only_changed_subtrees) {
+  auto root = make_root_cgroup("incr");
+  const auto cg = root / "sys/fs/cgroup";
+  write_group(cg / "a", 1, 1, 0);
+  write_group(cg / "a/a1", 1, 1, 0);
+  write_group(cg / "b", 1, 1, 0);
+  TempRootGuard sys_root("MONTAUK_SYS_ROOT", root.string());
+  montauk::collectors::CgroupCollector c;
+  montauk::model::CgroupSnapshot s;
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(c.dirs_walked(), 4u);
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(c.dirs_walked(), 4u);  // nothing changed: no walk at all
+
+  write_group(cg / "b/new", 1, 1, 0);
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(s.total, 5u);
+  ASSERT_EQ(c.dirs_walked(), 5u);  // just the new directory
+  ASSERT_TRUE(find(s, "/b/new") != nullptr);
+
+  fs::remove_all(cg / "a");
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(s.total, 3u);
+  ASSERT_TRUE(find(s, "/a/a1") == nullptr);
+  ASSERT_EQ(c.dirs_walked(), 5u);
+  fs::remove_all(root);
+}
+
+TEST(cgroup_collector_without_v2_hierarchy) {
+  auto root = fs::temp_directory_path() / ("montauk_test_cgroup_none_" + std::to_string(::getpid()));
+  fs::create_directories(root / "sys/fs/cgroup/cpu");
+  TempRootGuard sys_root("MONTAUK_SYS_ROOT", root.string());
+  montauk::collectors::CgroupCollector c;
+  montauk::model::CgroupSnapshot s;
+  ASSERT_TRUE(!c.sample(s));
+  ASSERT_TRUE(s.groups.empty());
+  fs::remove_all(root);
+}
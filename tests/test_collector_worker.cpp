@@ -0,0 +1,36 @@
+// CollectorWorker: a stalled slow collector never holds up the merge.
+#include "minitest.hpp"
+#include "app/CollectorWorker.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+TEST(collector_worker_merge_never_waits_on_a_stalled_sample) {
+  std::atomic<bool> release{false};
+  std::atomic<int> calls{0};
+  montauk::app::CollectorWorker<int> w(1ms, [&](int& v) {
+    v = ++calls;
+    while (calls.load() == 2 && !release.load()) std::this_thread::sleep_for(1ms);
+  });
+  w.start();
+  ASSERT_TRUE(w.wait_samples(1, std::chrono::steady_clock::now() + 2s));
+  int out = 0;
+  ASSERT_TRUE(w.merge_into(out));
+  ASSERT_EQ(out, 1);
+
+  // The second sample is now stuck inside the collector.
+  for (int i = 0; i < 2000 && calls.load() < 2; ++i) std::this_thread::sleep_for(1ms);
+  const auto t0 = std::chrono::steady_clock::now();
+  ASSERT_TRUE(!w.merge_into(out));
+  ASSERT_TRUE(std::chrono::steady_clock::now() - t0 < 50ms);
+  ASSERT_EQ(out, 1);
+
+  release.store(true);
+  ASSERT_TRUE(w.wait_samples(2, std::chrono::steady_clock::now() + 2s));
+  ASSERT_TRUE(w.merge_into(out));
+  ASSERT_TRUE(out >= 2);
+  w.stop();
+}
@@ -0,0 +1,109 @@
+// DeadlineScheduler: timers wake on their deadline, share coincident
+// wakeups, keep phase, and external fds / wake() interrupt the wait.
+#include "minitest.hpp"
+#include "util/DeadlineScheduler.hpp"
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+using montauk::util::DeadlineScheduler;
+
+TEST(deadline_scheduler_coincident_timers_share_a_wakeup_in_order) {
+  DeadlineScheduler sched;
+  ASSERT_TRUE(sched.ok());
+  std::string order;
+  const auto t0 = DeadlineScheduler::Clock::now() + 20ms;
+  sched.every(100ms, [&] { order += 'a'; }, t0);
+  sched.every(50ms, [&] { order += 'b'; }, t0);
+  ASSERT_EQ(sched.run_once(), 2u);  // both due at t0: one wakeup
+  ASSERT_TRUE(DeadlineScheduler::Clock::now() >= t0);
+  ASSERT_EQ(order, std::string("ab"));
+  ASSERT_EQ(sched.run_once(), 1u);  // t0 + 50ms: b alone
+  ASSERT_EQ(sched.run_once(), 2u);  // t0 + 100ms: both again
+  ASSERT_EQ(order, std::string("abbab"));
+  ASSERT_EQ(sched.wakeups(), 3u);
+}
+
+TEST(deadline_scheduler_watched_fd_and_wake_interrupt_the_wait) {
+  DeadlineScheduler sched;
+  ASSERT_TRUE(sched.ok());
+  int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  ASSERT_TRUE(efd >= 0);
+  int fired = 0;
+  ASSERT_TRUE(sched.watch(efd, [&] {
+    uint64_t v = 0;
+    ssize_t r = ::read(efd, &v, sizeof(v));
+    (void)r;
+    ++fired;
+  }));
+  sched.every(10s, [] {}, DeadlineScheduler::Clock::now() + 10s);
+
+  const auto t0 = DeadlineScheduler::Clock::now();
+  std::thread poke([&] {
+    std::this_thread::sleep_for(10ms);
+    const uint64_t one = 1;
+    ssize_t r = ::write(efd, &one, sizeof(one));
+    (void)r;
+  });
+  ASSERT_EQ(sched.run_once(), 1u);
+  poke.join();
+  ASSERT_EQ(fired, 1);
+
+  std::thread waker([&] { std::this_thread::sleep_for(10ms); sched.wake(); });
+  ASSERT_EQ(sched.run_once(), 0u);
+  waker.join();
+  ASSERT_TRUE(DeadlineScheduler::Clock::now() - t0 < 5s);
+  ::close(efd);
+}
+
+TEST(deadline_scheduler_reports_epollpri_watches) {
+  // A PSI trigger reports EPOLLPRI, never EPOLLIN. TCP urgent data is the
+  // unprivileged fd that does the same.
+  DeadlineScheduler sched;
+  ASSERT_TRUE(sched.ok());
+  const int lfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  ASSERT_EQ(::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(::listen(lfd, 1), 0);
+  ASSERT_EQ(::getsockname(lfd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+  const int cfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  ASSERT_EQ(::connect(cfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+  const int sfd = ::accept4(lfd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+  ASSERT_TRUE(sfd >= 0);
+
+  int fires = 0;
+  uint32_t seen = 0;
+  ASSERT_TRUE(sched.watch(sfd, EPOLLPRI, [&](uint32_t ev) {
+    seen = ev;
+    char c;
+    ssize_t r = ::recv(sfd, &c, 1, MSG_OOB);  // consume it, as a trigger poll does
+    (void)r;
+    ++fires;
+  }));
+  sched.every(10s, [] {}, DeadlineScheduler::Clock::now() + 10s);
+  const char urgent = '!';
+  ASSERT_EQ(::send(cfd, &urgent, 1, MSG_OOB), 1);
+  ASSERT_EQ(sched.run_once(), 1u);
+  ASSERT_EQ(fires, 1);
+  ASSERT_TRUE(seen & EPOLLPRI);
+
+  // Unwatched: a second urgent byte no longer reaches the callback.
+  sched.unwatch(sfd);
+  ASSERT_EQ(::send(cfd, &urgent, 1, MSG_OOB), 1);
+  std::thread waker([&] { std::this_thread::sleep_for(20ms); sched.wake(); });
+  ASSERT_EQ(sched.run_once(), 0u);
+  waker.join();
+  ASSERT_EQ(fires, 1);
+  for (int fd : {sfd, cfd, lfd}) ::close(fd);
+}
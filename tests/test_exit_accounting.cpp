@@ -0,0 +1,229 @@
+// Exit accounting: taskstats record parsing, per-process assembly and the
+// per-comm recently-exited rollup.
+#include "minitest.hpp"
+#include "env_guard.hpp"
+#include "app/MetricsServer.hpp"
+#include "collectors/NetlinkProcessCollector.hpp"
+#include "collectors/TaskstatsListener.hpp"
+#include "util/ExitRollup.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <linux/taskstats.h>
+
+using montauk::collectors::TaskExit;
+using montauk::collectors::TaskRecord;
+
+namespace {
+
+void put_attr(std::vector<uint8_t>& buf, uint16_t type, const void* data, size_t len) {
+  struct nlattr a{};
+  a.nla_type = type;
+  a.nla_len = static_cast<uint16_t>(NLA_HDRLEN + len);
+  const size_t at = buf.size();
+  buf.resize(at + NLA_ALIGN(a.nla_len), 0);
+  std::memcpy(buf.data() + at, &a, sizeof(a));
+  if (len) std::memcpy(buf.data() + at + NLA_HDRLEN, data, len);
+}
+
+// The attributes of one exit message as the kernel lays them out.
+std::vector<uint8_t> exit_msg(uint32_t pid, uint32_t tgid, const char* comm, uint64_t utime,
+                              uint64_t stime, uint64_t rss_kb, bool group_dead) {
+  struct taskstats ts{};
+  ts.ac_tgid = tgid;
+  std::strncpy(ts.ac_comm, comm, sizeof(ts.ac_comm) - 1);
+  ts.ac_utime = utime;
+  ts.ac_stime = stime;
+  ts.hiwater_rss = rss_kb;
+  ts.read_bytes = 100;
+  ts.write_bytes = 20;
+  std::vector<uint8_t> nest;
+  put_attr(nest, TASKSTATS_TYPE_PID, &pid, sizeof(pid));
+  put_attr(nest, TASKSTATS_TYPE_STATS, &ts, sizeof(ts));
+  std::vector<uint8_t> msg;
+  put_attr(msg, TASKSTATS_TYPE_AGGR_PID, nest.data(), nest.size());
+  if (group_dead) {
+    struct taskstats zero{};
+    std::vector<uint8_t> tnest;
+    put_attr(tnest, TASKSTATS_TYPE_TGID, &tgid, sizeof(tgid));
+    put_attr(tnest, TASKSTATS_TYPE_STATS, &zero, sizeof(zero));
+    put_attr(msg, TASKSTATS_TYPE_AGGR_TGID, tnest.data(), tnest.size());
+  }
+  return msg;
+}
+
+// One connector message carrying a FORK or EXIT proc_event for pid.
+void send_event(montauk::collectors::NetlinkProcessCollector& c, bool fork, int32_t pid) {
+  alignas(struct cn_msg) char buf[sizeof(struct cn_msg) + sizeof(struct proc_event)]{};
+  auto* msg = reinterpret_cast<struct cn_msg*>(buf);
+  msg->id.idx = CN_IDX_PROC;
+  msg->id.val = CN_VAL_PROC;
+  msg->len = sizeof(struct proc_event);
+  auto* ev = reinterpret_cast<struct proc_event*>(msg->data);
+  if (fork) {
+    ev->what = PROC_EVENT_FORK;
+    ev->event_data.fork.parent_pid = ev->event_data.fork.parent_tgid = 1;
+    ev->event_data.fork.child_pid = ev->event_data.fork.child_tgid = pid;
+  } else {
+    ev->what = PROC_EVENT_EXIT;
+    ev->event_data.exit.process_pid = ev->event_data.exit.process_tgid = pid;
+  }
+  c.handle_cn_msg(buf, sizeof(buf));
+}
+
+void write_stat(const std::filesystem::path& root, int pid, const std::string& comm, uint64_t ticks) {
+  std::filesystem::create_directories(root / "proc" / std::to_string(pid));
+  std::string s = std::to_string(pid) + " (" + comm + ") S 1";
+  for (int i = 0; i < 9; ++i) s += " 0";  // pgrp .. cmajflt
+  s += " " + std::to_string(ticks) + " 0";  // utime stime
+  for (int i = 0; i < 4; ++i) s += " 0";  // cutime .. nice
+  s += " 1 0 100 0 0";                    // num_threads itrealvalue starttime vsize rss
+  for (int i = 0; i < 28; ++i) s += " 0";
+  std::ofstream(root / "proc" / std::to_string(pid) / "stat") << s << "\n";
+}
+
+TaskRecord parse(const std::vector<uint8_t>& msg) {
+  TaskRecord r;
+  ASSERT_TRUE(montauk::collectors::parse_taskstats_record(msg.data(), msg.size(), r));
+  return r;
+}
+
+}  // namespace
+
+TEST(taskstats_record_parses_pid_stats_and_group_end) {
+  auto r = parse(exit_msg(42, 42, "cc1plus", 3000, 1000, 5120, false));
+  ASSERT_EQ(r.pid, 42);
+  ASSERT_EQ(r.tgid, 42);
+  ASSERT_TRUE(!r.group_dead);
+  ASSERT_EQ(r.stats.comm, std::string("cc1plus"));
+  ASSERT_EQ(r.stats.cpu_us, 4000ull);
+  ASSERT_EQ(r.stats.rss_kb, 5120ull);
+  ASSERT_EQ(r.stats.io_bytes, 120ull);
+  ASSERT_TRUE(parse(exit_msg(43, 40, "worker", 1, 1, 1, true)).group_dead);
+  TaskRecord none;
+  ASSERT_TRUE(!montauk::collectors::parse_taskstats_record(nullptr, 0, none));
+}
+
+TEST(taskstats_assembler_sums_threads_until_group_dies) {
+  montauk::collectors::TaskExitAssembler as;
+  std::vector<TaskExit> out;
+  as.add(parse(exit_msg(7, 7, "sh", 500, 500, 800, false)), out);  // single-threaded
+  ASSERT_EQ(out.size(), size_t{1});
+  ASSERT_EQ(out[0].cpu_us, 1000ull);
+  out.clear();
+  // Three threads of tgid 10: two workers, then the leader as the last one.
+  as.add(parse(exit_msg(11, 10, "ld-worker", 2000, 0, 900, false)), out);
+  as.add(parse(exit_msg(12, 10, "ld-worker", 3000, 0, 900, false)), out);
+  ASSERT_TRUE(out.empty());
+  ASSERT_EQ(as.pending(), size_t{1});
+  as.add(parse(exit_msg(10, 10, "ld", 1000, 500, 1000, true)), out);
+  ASSERT_EQ(out.size(), size_t{1});
+  ASSERT_EQ(out[0].tgid, 10);
+  ASSERT_EQ(out[0].comm, std::string("ld"));
+  ASSERT_EQ(out[0].cpu_us, 6500ull);
+  ASSERT_EQ(out[0].rss_kb, 1000ull);
+  ASSERT_EQ(out[0].io_bytes, 360ull);
+  ASSERT_EQ(as.pending(), size_t{0});
+}
+
+TEST(exit_rollup_merges_by_comm_and_ages_out) {
+  using Clock = montauk::util::ExitRollup::Clock;
+  montauk::util::ExitRollup r;
+  const auto t0 = Clock::now();
+  r.add("cc1", 1000, 100, 10, t0);
+  r.add("cc1", 3000, 300, 10, t0);
+  r.add("as", 500, 50, 0, t0);
+  std::vector<montauk::model::ExitedComm> out;
+  r.publish(out, t0);
+  ASSERT_EQ(out.size(), size_t{2});
+  ASSERT_EQ(out[0].comm, std::string("cc1"));
+  ASSERT_EQ(out[0].exits, 2ull);
+  ASSERT_EQ(out[0].cpu_us, 4000ull);
+  ASSERT_EQ(out[0].max_rss_kb, 300ull);
+  ASSERT_EQ(out[0].io_bytes, 20ull);
+  // One generation later the old exits are still in the window...
+  r.add("as", 500, 50, 0, t0 + montauk::util::ExitRollup::kGeneration);
+  r.publish(out, t0 + montauk::util::ExitRollup::kGeneration);
+  ASSERT_EQ(out.size(), size_t{2});
+  ASSERT_EQ(out[1].exits, 2ull);
+  // ...two later, only the newer generation is.
+  r.publish(out, t0 + 2 * montauk::util::ExitRollup::kGeneration);
+  ASSERT_EQ(out.size(), size_t{1});
+  ASSERT_EQ(out[0].exits, 1ull);
+  r.publish(out, t0 + 5 * montauk::util::ExitRollup::kGeneration);
+  ASSERT_TRUE(out.empty());
+}
+
+TEST(exit_rollup_bounds_names_and_folds_the_tail) {
+  using montauk::util::ExitRollup;
+  ExitRollup r;
+  const auto t0 = ExitRollup::Clock::now();
+  for (size_t i = 0; i < ExitRollup::kMaxComms + 50; ++i)
+    r.add("job" + std::to_string(i), 1000 + i, 0, 0, t0);
+  std::vector<montauk::model::ExitedComm> out;
+  r.publish(out, t0, 8);
+  ASSERT_EQ(out.size(), size_t{9});
+  ASSERT_EQ(out.back().comm, std::string(ExitRollup::kOther));
+  uint64_t exits = 0;
+  for (const auto& e : out) exits += e.exits;
+  ASSERT_EQ(exits, static_cast<uint64_t>(ExitRollup::kMaxComms + 50));
+}
+
+TEST(exited_rollup_reaches_prometheus_and_json) {
+  montauk::app::MetricsSnapshot snap{};
+  snap.exited.push_back(montauk::model::ExitedComm{"cc1plus", 12, 2'500'000, 2048, 4096});
+  const std::string prom = montauk::app::snapshot_to_prometheus(snap);
+  ASSERT_TRUE(prom.find("montauk_exited_processes{comm=\"cc1plus\"} 12") != std::string::npos);
+  ASSERT_TRUE(prom.find("montauk_exited_cpu_seconds{comm=\"cc1plus\"} 2.5") != std::string::npos);
+  ASSERT_TRUE(prom.find("montauk_exited_max_rss_bytes{comm=\"cc1plus\"} 2097152") != std::string::npos);
+  const std::string js = montauk::app::snapshot_to_json(snap);
+  ASSERT_TRUE(js.find("\"exited\":[{\"comm\":\"cc1plus\",\"exits\":12") != std::string::npos);
+}
+
+TEST(netlink_short_lived_means_outside_population_not_outside_scan) {
+  namespace fs = std::filesystem;
+  auto root = fs::temp_directory_path() / ("montauk_test_shortlived_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  constexpr int kPopulation = 8;
+  for (int i = 1; i <= kPopulation; ++i) write_stat(root, 100 + i, "daemon" + std::to_string(i), 5000);
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+
+  // No init(): events go straight in, and exits are read from /proc on the
+  // EXIT event as without taskstats.
+  montauk::collectors::NetlinkProcessCollector c(64, 64, 1);
+  c.set_sample_budget(2);  // far below the population
+  for (int i = 1; i <= kPopulation; ++i) send_event(c, true, 100 + i);
+  montauk::model::ProcessSnapshot s;
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_TRUE(s.size() < kPopulation);
+
+  // A long-lived daemon the budgeted scan did not read exits, and a process
+  // that forked after the sample comes and goes.
+  int32_t unread = 0;
+  for (int i = 1; i <= kPopulation && !unread; ++i) {
+    bool read = false;
+    for (int32_t p : s.pid) read |= p == 100 + i;
+    if (!read) unread = 100 + i;
+  }
+  ASSERT_TRUE(unread != 0);
+  send_event(c, false, unread);
+  write_stat(root, 200, "blip", 7);
+  send_event(c, true, 200);
+  send_event(c, false, 200);
+
+  ASSERT_TRUE(c.sample(s));
+  bool blip = false;
+  for (const auto& e : s.exited) {
+    ASSERT_TRUE(e.comm != "daemon" + std::to_string(unread - 100));
+    blip |= e.comm == "blip";
+  }
+  ASSERT_TRUE(blip);
+  fs::remove_all(root);
+}
@@ -5,22 +5,22 @@
 
 TEST(filters_basic) {
   montauk::model::ProcessSnapshot ps{};
-  ps.processes.push_back({.pid=1,.total_time=0,.rss_kb=10000,.cpu_pct=5.0,.user_name="mod",.cmd="chrome --renderer",.exe_path="/usr/bin/chrome"});
-  ps.processes.push_back({.pid=2,.total_time=0,.rss_kb=5000,.cpu_pct=1.0,.user_name="root",.cmd="sshd: root",.exe_path="/usr/sbin/sshd"});
+  ps.push_back({.pid=1,.total_time=0,.rss_kb=10000,.cpu_pct=5.0,.user_name="mod",.cmd="chrome --renderer",.exe_path="/usr/bin/chrome"});
+  ps.push_back({.pid=2,.total_time=0,.rss_kb=5000,.cpu_pct=1.0,.user_name="root",.cmd="sshd: root",.exe_path="/usr/sbin/sshd"});
   montauk::app::ProcessFilterSpec spec{};
   spec.name_contains = std::optional<std::string>("chrome");
   spec.cpu_min = std::optional<double>(2.0);
   montauk::app::ProcessFilter f(spec);
   auto idx = f.apply(ps);
   ASSERT_EQ(idx.size(), 1u);
-  ASSERT_EQ(ps.processes[idx[0]].pid, 1);
+  ASSERT_EQ(ps.pid[idx[0]], 1);
 }
 
 TEST(filters_case_insensitive_substring) {
   montauk::model::ProcessSnapshot ps{};
-  ps.processes.push_back({.pid=10,.total_time=0,.rss_kb=1000,.cpu_pct=2.0,.user_name="mod",.cmd="Firefox --new-tab",.exe_path="/usr/bin/firefox"});
-  ps.processes.push_back({.pid=20,.total_time=0,.rss_kb=2000,.cpu_pct=1.0,.user_name="mod",.cmd="code --unity-launch",.exe_path="/usr/bin/code"});
-  ps.processes.push_back({.pid=30,.total_time=0,.rss_kb=500,.cpu_pct=0.5,.user_name="root",.cmd="firefoxUpdater",.exe_path="/usr/bin/updater"});
+  ps.push_back({.pid=10,.total_time=0,.rss_kb=1000,.cpu_pct=2.0,.user_name="mod",.cmd="Firefox --new-tab",.exe_path="/usr/bin/firefox"});
+  ps.push_back({.pid=20,.total_time=0,.rss_kb=2000,.cpu_pct=1.0,.user_name="mod",.cmd="code --unity-launch",.exe_path="/usr/bin/code"});
+  ps.push_back({.pid=30,.total_time=0,.rss_kb=500,.cpu_pct=0.5,.user_name="root",.cmd="firefoxUpdater",.exe_path="/usr/bin/updater"});
 
   // "firefox" should match both PID 10 ("Firefox") and PID 30 ("firefoxUpdater") case-insensitively
   montauk::app::ProcessFilterSpec spec{};
@@ -28,8 +28,8 @@ TEST(filters_case_insensitive_substring) {
   montauk::app::ProcessFilter f(spec);
   auto idx = f.apply(ps);
   ASSERT_EQ(idx.size(), 2u);
-  ASSERT_EQ(ps.processes[idx[0]].pid, 10);
-  ASSERT_EQ(ps.processes[idx[1]].pid, 30);
+  ASSERT_EQ(ps.pid[idx[0]], 10);
+  ASSERT_EQ(ps.pid[idx[1]], 30);
 
   // Empty query should match all
   montauk::app::ProcessFilterSpec empty_spec{};
@@ -51,7 +51,7 @@ TEST(filters_apply_returns_ascending_indices) {
     // Every third process matches, so the result is sparse rather than a
     // contiguous prefix -- a run of 0,1,2,... would pass even if unsorted.
     const bool hit = (i % 3) == 0;
-    ps.processes.push_back({.pid = 1000 + i,
+    ps.push_back({.pid = 1000 + i,
                             .total_time = 0,
                             .rss_kb = 100,
                             .cpu_pct = 1.0,
@@ -69,7 +69,7 @@ TEST(filters_apply_returns_ascending_indices) {
 
   // And the exact membership predicate ProcessTable runs: binary search plus an
   // equality check must agree with a linear scan for every index, hit or miss.
-  for (size_t probe = 0; probe < ps.processes.size(); ++probe) {
+  for (size_t probe = 0; probe < ps.size(); ++probe) {
     bool linear = false;
     for (size_t m : idx) if (m == probe) { linear = true; break; }
     size_t pos = sublimation_searchsorted_u64(
@@ -0,0 +1,239 @@
+// Binary history log: writer/reader round trip, the text reader, and the
+// binary log keying every series exactly like the .prom log it replaces.
+#include "minitest.hpp"
+#include "fixtures/metrics_fixture.hpp"
+#include "app/HistorySink.hpp"
+#include "app/MetricsRender.hpp"
+#include "app/TraceRender.hpp"
+#include "model/HistoryLog.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <unistd.h>
+
+using montauk::model::HistoryReader;
+using montauk::model::HistoryReadStatus;
+using montauk::model::HistoryScrape;
+using montauk::model::HistoryWriter;
+using montauk::model::SeriesKind;
+
+namespace {
+
+std::filesystem::path temp_file(const char* suffix) {
+  auto p = std::filesystem::temp_directory_path() /
+           ("montauk_history_test_" + std::to_string(::getpid()) + "_" + suffix);
+  std::filesystem::remove(p);
+  return p;
+}
+
+// Series key -> its values, scrape by scrape (NaN where absent).
+using Table = std::map<std::string, std::vector<double>>;
+
+Table read_all(const std::filesystem::path& p, std::vector<int64_t>* ts = nullptr,
+               HistoryReadStatus* end = nullptr) {
+  HistoryReader r;
+  Table t;
+  if (r.open(p.c_str()) != HistoryReadStatus::Ok) return t;
+  HistoryScrape s;
+  size_t n = 0;
+  while (r.next(s)) {
+    if (ts) ts->push_back(s.ts_ms);
+    for (size_t i = 0; i < s.ids.size(); ++i) {
+      auto& col = t[r.series()[s.ids[i]].key()];
+      col.resize(n, NAN);
+      col.push_back(s.values[i]);
+    }
+    ++n;
+  }
+  for (auto& [k, col] : t) col.resize(n, NAN);
+  if (end) *end = r.status();
+  return t;
+}
+
+bool same_bits(double a, double b) { return std::bit_cast<uint64_t>(a) == std::bit_cast<uint64_t>(b); }
+
+}  // namespace
+
+TEST(history_log_round_trip) {
+  auto path = temp_file("rt.mhist");
+  Table want;
+  std::vector<int64_t> want_ts;
+  auto put = [&](HistoryWriter& w, size_t row, const char* name, const char* labels, double v) {
+    w.sample(name, labels, SeriesKind::Gauge, v);
+    std::string key = *labels ? std::string(name) + '{' + labels + '}' : std::string(name);
+    auto& col = want[key];
+    col.resize(row, NAN);
+    col.push_back(v);
+  };
+
+  // 150 scrapes: three blocks, then a second segment appended to the file
+  // the way a restarted writer reopens the hour.
+  size_t row = 0;
+  for (int seg = 0; seg < 2; ++seg) {
+    HistoryWriter w;
+    ASSERT_TRUE(w.open(path.c_str(), 1000 + seg));
+    for (int i = 0; i < 75; ++i, ++row) {
+      const int64_t ts = 1'700'000'000'000 + static_cast<int64_t>(row) * 1000 + (row % 7 == 3 ? 13 : 0);
+      w.begin_scrape(ts);
+      want_ts.push_back(ts);
+      put(w, row, "const_gauge", "", 42.5);
+      put(w, row, "ramp", "cpu=\"0\"", static_cast<double>(row) * 0.1);
+      put(w, row, "ramp", "cpu=\"1\"", -static_cast<double>(row) * 1e9);
+      if (row % 3 == 0) put(w, row, "sparse", "quote=\"a\\\"}b\"", static_cast<double>(row));
+      if (row == 10) put(w, row, "nan_once", "", NAN);
+      if (row >= 100) put(w, row, "late", "", 1.0 / static_cast<double>(row));
+      ASSERT_TRUE(w.end_scrape());
+    }
+  }
+  for (auto& [k, col] : want) col.resize(row, NAN);
+
+  std::vector<int64_t> ts;
+  HistoryReadStatus end;
+  Table got = read_all(path, &ts, &end);
+  ASSERT_TRUE(end == HistoryReadStatus::Ok);
+  ASSERT_EQ(ts, want_ts);
+  ASSERT_EQ(got.size(), want.size());
+  for (const auto& [k, col] : want) {
+    ASSERT_TRUE(got.contains(k));
+    for (size_t i = 0; i < col.size(); ++i) {
+      if (!same_bits(got[k][i], col[i])) std::fprintf(stderr, "  %s[%zu]\n", k.c_str(), i);
+      ASSERT_TRUE(same_bits(got[k][i], col[i]));
+    }
+  }
+
+  // A file cut off mid-block reads back to its last whole block.
+  const auto size = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, size - 200);
+  ts.clear();
+  got = read_all(path, &ts, &end);
+  ASSERT_TRUE(end == HistoryReadStatus::Corrupt || end == HistoryReadStatus::Ok);
+  ASSERT_TRUE(ts.size() >= 75 && ts.size() < 150);
+  ASSERT_TRUE(got["const_gauge"][0] == 42.5);
+
+  std::filesystem::remove(path);
+}
+
+TEST(history_log_reads_text) {
+  auto path = temp_file("text.prom");
+  {
+    std::ofstream f(path);
+    f << "# montauk_scrape_timestamp_ms 1000\n"
+         "# HELP reqs Requests.\n# TYPE reqs counter\nreqs 5\n"
+         "# TYPE lat histogram\nlat_bucket{le=\"0.1\"} 3\nlat_sum 0.2\n"
+         "odd{v=\"a}b\"} 7 1720000000000\n"
+         "# montauk_scrape_timestamp_ms 2000\n"
+         "reqs 9\n"
+         "odd{v=\"a}b\"} 8\n";
+  }
+  HistoryReader r;
+  ASSERT_TRUE(r.open(path.c_str()) == HistoryReadStatus::Ok);
+  ASSERT_TRUE(!r.binary());
+  HistoryScrape s;
+  ASSERT_TRUE(r.next(s));
+  ASSERT_EQ(s.ts_ms, 1000);
+  ASSERT_EQ(s.ids.size(), 4u);
+  ASSERT_EQ(r.series()[s.ids[0]].key(), std::string("reqs"));
+  ASSERT_TRUE(r.series()[s.ids[0]].kind == SeriesKind::Counter);
+  ASSERT_TRUE(r.series()[s.ids[1]].kind == SeriesKind::Histogram);
+  ASSERT_TRUE(r.series()[s.ids[2]].kind == SeriesKind::Histogram);
+  ASSERT_EQ(r.series()[s.ids[3]].labels, std::string("v=\"a}b\""));
+  ASSERT_TRUE(s.values[3] == 7.0);  // the trailing timestamp is not the value
+  ASSERT_TRUE(r.next(s));
+  ASSERT_EQ(s.ts_ms, 2000);
+  ASSERT_EQ(s.ids.size(), 2u);
+  ASSERT_TRUE(s.values[0] == 9.0);
+  ASSERT_EQ(r.series().size(), 4u);  // repeated series keep their ids
+  ASSERT_TRUE(!r.next(s));
+  ASSERT_TRUE(r.status() == HistoryReadStatus::Ok);
+  std::filesystem::remove(path);
+}
+
+TEST(history_sink_keys_like_prometheus_text) {
+  // The binary log of a snapshot holds exactly the series the .prom log of
+  // it does, under the same keys, with the same values -- so the --analyze
+  // readers cannot tell which of the two they were handed.
+  auto s = make_fixture_snapshot();
+  auto t = make_fixture_trace();
+  auto text_path = temp_file("fixture.prom");
+  auto bin_path = temp_file("fixture.mhist");
+  {
+    std::ofstream f(text_path);
+    f << "# montauk_scrape_timestamp_ms 5000\n"
+      << montauk::app::snapshot_to_prometheus(s) << montauk::app::trace_to_prometheus(t);
+  }
+  {
+    HistoryWriter w;
+    ASSERT_TRUE(w.open(bin_path.c_str(), 5000));
+    w.begin_scrape(5000);
+    montauk::app::HistorySink sink(w);
+    montauk::app::render_snapshot(sink, s);
+    montauk::app::render_trace(sink, t);
+    ASSERT_TRUE(w.end_scrape());
+  }
+  Table text = read_all(text_path), bin = read_all(bin_path);
+  ASSERT_TRUE(text.size() > 50);
+  for (const auto& [k, col] : text) {
+    if (!bin.contains(k)) std::fprintf(stderr, "  missing from binary: %s\n", k.c_str());
+    ASSERT_TRUE(bin.contains(k));
+    ASSERT_TRUE(same_bits(bin[k][0], col[0]) || (std::isnan(bin[k][0]) && std::isnan(col[0])));
+  }
+  ASSERT_EQ(bin.size(), text.size());
+  std::filesystem::remove(text_path);
+  std::filesystem::remove(bin_path);
+}
+
+TEST(history_delta_text_decodes_to_full_scrapes) {
+  // A change-only log replays to exactly the scrapes the full log holds:
+  // unchanged series carried forward, new ones added, vanished ones dropped,
+  // across a keyframe.
+  auto s = make_fixture_snapshot();
+  auto full_path = temp_file("full.prom");
+  auto delta_path = temp_file("delta.prom");
+  std::string full, delta;
+  montauk::model::PromDeltaEncoder enc;
+  const int64_t ts[] = {1000, 2000, 3000, 64000, 65000, 66000};
+  for (int i = 0; i < 6; ++i) {
+    s.cpu.usage_pct = 40.0 + (i % 2);
+    if (i == 2) {  // pid 939 exits
+      auto first = s.top_procs.row(0);
+      s.top_procs.clear_rows();
+      s.top_procs.push_back(first);
+    }
+    if (i == 3) {  // pid 1000 starts
+      auto row = s.top_procs.row(0);
+      row.pid = 1000;
+      s.top_procs.push_back(row);
+    }
+    if (i == 4) s.net.interfaces.pop_back();
+    const std::string body = montauk::app::snapshot_to_prometheus(s);
+    full += "# montauk_scrape_timestamp_ms " + std::to_string(ts[i]) + "\n" + body;
+    enc.encode(ts[i], body, delta);
+  }
+  std::ofstream(full_path) << full;
+  std::ofstream(delta_path) << delta;
+
+  std::vector<int64_t> full_ts, delta_ts;
+  Table want = read_all(full_path, &full_ts), got = read_all(delta_path, &delta_ts);
+  ASSERT_EQ(delta_ts, full_ts);
+  ASSERT_EQ(got.size(), want.size());
+  for (const auto& [k, col] : want) {
+    ASSERT_TRUE(got.contains(k));
+    for (size_t i = 0; i < col.size(); ++i)
+      ASSERT_TRUE(same_bits(got[k][i], col[i]) || (std::isnan(got[k][i]) && std::isnan(col[i])));
+  }
+  // Blocks 1, 2, 4 and 5 are deltas; 3 is past the keyframe interval.
+  size_t deltas = 0;
+  for (size_t pos = delta.find("# montauk_scrape_delta\n"); pos != std::string::npos;
+       pos = delta.find("# montauk_scrape_delta\n", pos + 1))
+    ++deltas;
+  ASSERT_EQ(deltas, 4u);
+  ASSERT_TRUE(delta.contains("# montauk_scrape_removed montauk_network_"));
+  ASSERT_TRUE(delta.size() * 2 < full.size());
+  std::filesystem::remove(full_path);
+  std::filesystem::remove(delta_path);
+}
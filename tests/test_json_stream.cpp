@@ -0,0 +1,88 @@
+// --json-stream: the first line is the one-shot --json object, later lines
+// carry only changed members and pid-keyed process rows.
+#include "minitest.hpp"
+#include "app/JsonStream.hpp"
+#include "app/MetricsServer.hpp"
+
+#include <format>
+#include <string>
+#include <vector>
+
+using montauk::model::ProcSample;
+using montauk::model::Snapshot;
+
+namespace {
+
+void fill(Snapshot& s, const std::vector<int32_t>& pids) {
+  s.cpu.model = "Test CPU";
+  s.cpu.usage_pct = 10.0;
+  s.cpu.per_core_pct = {10.0, 5.0};
+  s.cpu.has_freq = true;
+  s.cpu.freq_avg_mhz = 3000.0;
+  s.mem.total_kb = 8 << 20;
+  s.mem.used_kb = 1 << 20;
+  s.net.interfaces = {{"eth0", 1, 2, 3.0, 4.0, 5.0}};
+  s.procs.total_processes = 4;
+  std::vector<ProcSample> rows;
+  for (int32_t pid : pids) {
+    ProcSample r;
+    r.pid = pid;
+    r.rss_kb = 1000 + static_cast<uint64_t>(pid);
+    r.cmd = std::format("cmd{}", pid);
+    r.user_name = "user";
+    r.thread_count = 2;
+    rows.push_back(r);
+  }
+  s.procs.assign_rows(rows);
+}
+
+}  // namespace
+
+TEST(json_stream_first_line_is_the_oneshot_object) {
+  Snapshot s;
+  fill(s, {100, 101, 102, 103});
+  s.seq = 1;
+  montauk::app::JsonStream js;
+  std::string line;
+  js.next(s, line);
+  std::string want = montauk::app::snapshot_to_json(montauk::app::project_metrics_snapshot(s));
+  want.insert(want.find(',') + 1, "\"seq\":1,");
+  ASSERT_EQ(line, want);
+}
+
+TEST(json_stream_lines_carry_only_changes) {
+  Snapshot s;
+  fill(s, {100, 101, 102, 103});
+  s.seq = 1;
+  montauk::app::JsonStream js;
+  std::string line;
+  js.next(s, line);
+
+  // One cpu field, one row changed, one row gone, one new.
+  fill(s, {100, 101, 103, 200});
+  s.seq = 2;
+  s.cpu.usage_pct = 20.0;
+  s.procs.cpu_pct[1] = 5.0;
+  line.clear();
+  js.next(s, line);
+  ASSERT_TRUE(line.starts_with("{\"schema_version\":1,\"seq\":2,"));
+  ASSERT_TRUE(line.ends_with("}\n"));
+  ASSERT_TRUE(line.contains("\"cpu\":{\"usage_pct\":20}"));
+  ASSERT_TRUE(!line.contains("\"memory\"") && !line.contains("\"network\"") && !line.contains("\"system\""));
+  ASSERT_TRUE(line.contains("\"top\":{\"added\":[{\"pid\":200,\"cmd\":\"cmd200\""));
+  ASSERT_TRUE(line.contains("\"removed\":[102],\"changed\":[{\"pid\":101,\"cpu_pct\":5}],\"order\":[100,101,103,200]}"));
+  ASSERT_TRUE(line.contains("\"anomaly_features\":{\"added\":[{\"pid\":200,"));
+
+  // Nothing new: the line is just the generation.
+  s.seq = 3;
+  line.clear();
+  js.next(s, line);
+  ASSERT_EQ(line, std::string("{\"schema_version\":1,\"seq\":3}\n"));
+
+  // A member the render stops emitting goes to null.
+  s.seq = 4;
+  s.cpu.has_freq = false;
+  line.clear();
+  js.next(s, line);
+  ASSERT_EQ(line, std::string("{\"schema_version\":1,\"seq\":4,\"cpu\":{\"freq_mhz_avg\":null}}\n"));
+}
@@ -1,7 +1,8 @@
-// LogWriter: periodic Prometheus-format snapshot logging to disk.
+// LogWriter: periodic snapshot logging to disk, as .prom text or .mhist binary.
 #include "minitest.hpp"
 #include "app/LogWriter.hpp"
 #include "app/Producer.hpp"
+#include "model/HistoryLog.hpp"
 #include <filesystem>
 #include <fstream>
 #include <thread>
@@ -89,3 +90,45 @@ TEST(logwriter_empty_snapshot) {
 
   std::filesystem::remove_all(dir);
 }
+
+TEST(logwriter_writes_binary) {
+  auto dir = test_dir("binary");
+  std::filesystem::remove_all(dir);
+
+  montauk::app::SnapshotBuffers buffers;
+  montauk::app::Producer producer(buffers);
+  producer.start();
+  auto t0 = std::chrono::steady_clock::now();
+  while (buffers.seq() == 0 &&
+         std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  montauk::app::LogWriter writer(buffers, dir, std::chrono::milliseconds(200), nullptr,
+                                 montauk::app::LogFormat::Binary);
+  writer.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  writer.stop();
+  producer.stop();
+
+  // Stopping closes the hour's segment, so the pending block is on disk and
+  // reads back as scrapes carrying the snapshot's series.
+  int scrapes = 0;
+  bool saw_cpu = false;
+  for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+    ASSERT_TRUE(entry.path().extension() == ".mhist");
+    montauk::model::HistoryReader r;
+    ASSERT_TRUE(r.open(entry.path().c_str()) == montauk::model::HistoryReadStatus::Ok);
+    ASSERT_TRUE(r.binary());
+    montauk::model::HistoryScrape s;
+    while (r.next(s)) {
+      ++scrapes;
+      ASSERT_TRUE(s.ts_ms > 0);
+      for (uint32_t id : s.ids) saw_cpu = saw_cpu || r.series()[id].name == "montauk_cpu_usage_percent";
+    }
+  }
+  ASSERT_TRUE(scrapes >= 2);
+  ASSERT_TRUE(saw_cpu);
+
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,82 @@
+// MetricsCache: the /metrics exposition is rendered once per published
+// generation however many scrapes ask for it, concurrently or not, and its
+// gzip copy is built alongside on demand.
+#include "minitest.hpp"
+#include "app/MetricsCache.hpp"
+#include "app/MetricsHttp.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(metrics_cache_renders_once_per_generation) {
+  montauk::app::SnapshotBuffers buffers;
+  buffers.back().cpu.usage_pct = 12.0;
+  buffers.publish();
+  montauk::app::MetricsCache cache(buffers);
+
+  auto a = cache.get();
+  auto b = cache.get();
+  ASSERT_EQ(cache.renders(), 1u);
+  ASSERT_TRUE(a.get() == b.get());
+  ASSERT_TRUE(a->text().find("montauk_cpu_usage_percent 12") != std::string::npos);
+
+  buffers.back().cpu.usage_pct = 34.0;
+  buffers.publish();
+  auto c = cache.get();
+  ASSERT_EQ(cache.renders(), 2u);
+  ASSERT_TRUE(c->text().find("montauk_cpu_usage_percent 34") != std::string::npos);
+  // The superseded render is still intact for whoever holds it.
+  ASSERT_TRUE(a->text().find("montauk_cpu_usage_percent 12") != std::string::npos);
+}
+
+TEST(metrics_cache_concurrent_scrapes_share_one_render) {
+  montauk::app::SnapshotBuffers buffers;
+  buffers.back().mem.total_kb = 1 << 20;
+  buffers.publish();
+  montauk::app::MetricsCache cache(buffers);
+
+  std::vector<const montauk::app::MetricsExposition*> seen(8);
+  {
+    std::vector<std::jthread> scrapers;
+    for (size_t i = 0; i < seen.size(); ++i)
+      scrapers.emplace_back([&, i] {
+        auto e = cache.get();
+        (void)e->gzip();
+        seen[i] = e.get();
+      });
+  }
+  ASSERT_EQ(cache.renders(), 1u);
+  for (auto* e : seen) ASSERT_TRUE(e == seen[0]);
+}
+
+TEST(metrics_cache_gzip_copy) {
+  montauk::app::SnapshotBuffers buffers;
+  buffers.back().cpu.per_core_pct.assign(64, 50.0);
+  buffers.publish();
+  montauk::app::MetricsCache cache(buffers);
+  auto e = cache.get();
+#ifdef MONTAUK_HAVE_ZLIB
+  const std::string& gz = e->gzip();
+  if (!gz.empty()) {  // empty only on a box without libz
+    ASSERT_EQ(static_cast<unsigned char>(gz[0]), 0x1fu);
+    ASSERT_EQ(static_cast<unsigned char>(gz[1]), 0x8bu);
+    ASSERT_TRUE(gz.size() * 3 < e->text().size());
+    ASSERT_TRUE(&e->gzip() == &gz);  // compressed once, then reused
+  }
+#else
+  ASSERT_TRUE(e->gzip().empty());
+#endif
+}
+
+TEST(metrics_accepts_gzip_header) {
+  using montauk::app::accepts_gzip;
+  ASSERT_TRUE(accepts_gzip("GET /metrics HTTP/1.1\r\nHost: x\r\nAccept-Encoding: gzip\r\n\r\n"));
+  ASSERT_TRUE(accepts_gzip("GET /metrics HTTP/1.1\r\naccept-encoding: deflate, GZIP;q=0.5\r\n\r\n"));
+  ASSERT_TRUE(accepts_gzip("GET /metrics HTTP/1.1\r\nAccept-Encoding: *\r\n\r\n"));
+  ASSERT_TRUE(!accepts_gzip("GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n"));
+  ASSERT_TRUE(!accepts_gzip("GET /metrics HTTP/1.1\r\nAccept-Encoding: identity\r\n\r\n"));
+  ASSERT_TRUE(!accepts_gzip("GET /metrics HTTP/1.1\r\nAccept-Encoding: gzip;q=0\r\n\r\n"));
+  ASSERT_TRUE(!accepts_gzip("GET /metrics HTTP/1.1\r\nAccept-Encoding: gzip;q=0, *\r\n\r\n"));
+  // Only the head counts: a body mentioning the header is not a header.
+  ASSERT_TRUE(!accepts_gzip("GET /metrics HTTP/1.1\r\n\r\nAccept-Encoding: gzip\r\n"));
+}
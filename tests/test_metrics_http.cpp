@@ -0,0 +1,61 @@
+// The /metrics endpoint's HTTP layer: request framing (partial, pipelined,
+// bare-LF), keep-alive negotiation and the responses it routes to.
+#include "minitest.hpp"
+#include "app/MetricsHttp.hpp"
+#include <string>
+
+using montauk::app::HttpResponse;
+using montauk::app::parse_http_request;
+
+TEST(metrics_http_request_framing) {
+  ASSERT_TRUE(!parse_http_request("GET /metrics HTTP/1.1\r\nHost: x\r\n").has_value());
+
+  const std::string two = "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\nGET / HTTP/1.1\r\n\r\n";
+  auto a = parse_http_request(two);
+  ASSERT_TRUE(a.has_value());
+  ASSERT_EQ(a->request_line, std::string_view("GET /metrics HTTP/1.1"));
+  auto b = parse_http_request(std::string_view(two).substr(a->length));
+  ASSERT_TRUE(b.has_value());
+  ASSERT_EQ(b->request_line, std::string_view("GET / HTTP/1.1"));
+  ASSERT_EQ(a->length + b->length, two.size());
+
+  auto lf = parse_http_request("GET /metrics HTTP/1.0\n\n");
+  ASSERT_TRUE(lf.has_value());
+  ASSERT_EQ(lf->length, 23u);
+}
+
+TEST(metrics_http_keep_alive) {
+  ASSERT_TRUE(parse_http_request("GET /metrics HTTP/1.1\r\n\r\n")->keep_alive);
+  ASSERT_TRUE(!parse_http_request("GET /metrics HTTP/1.1\r\nConnection: close\r\n\r\n")->keep_alive);
+  ASSERT_TRUE(!parse_http_request("GET /metrics HTTP/1.0\r\n\r\n")->keep_alive);
+  ASSERT_TRUE(parse_http_request("GET /metrics HTTP/1.0\r\nconnection: Keep-Alive\r\n\r\n")->keep_alive);
+}
+
+TEST(metrics_http_responses) {
+  montauk::app::SnapshotBuffers buffers;
+  buffers.back().cpu.usage_pct = 7.0;
+  buffers.publish();
+  montauk::app::MetricsCache cache(buffers);
+  HttpResponse out;
+
+  montauk::app::build_http_response(*parse_http_request("GET /metrics HTTP/1.1\r\n\r\n"), cache, out);
+  ASSERT_TRUE(out.head.starts_with("HTTP/1.1 200 OK\r\n"));
+  ASSERT_TRUE(out.head.contains("Connection: keep-alive\r\n"));
+  ASSERT_TRUE(out.head.contains("Content-Length: " + std::to_string(out.body.size()) + "\r\n"));
+  ASSERT_TRUE(!out.head.contains("Content-Encoding"));
+  ASSERT_TRUE(out.body.contains("montauk_cpu_usage_percent 7"));
+  ASSERT_TRUE(out.exp != nullptr);
+
+  // A second scrape of the same generation reuses the render.
+  montauk::app::build_http_response(*parse_http_request("GET /metrics HTTP/1.1\r\nConnection: close\r\n\r\n"), cache, out);
+  ASSERT_EQ(cache.renders(), 1u);
+  ASSERT_TRUE(out.head.contains("Connection: close\r\n"));
+
+  montauk::app::build_http_response(*parse_http_request("GET /nope HTTP/1.1\r\n\r\n"), cache, out);
+  ASSERT_TRUE(out.head.starts_with("HTTP/1.1 404 Not Found\r\n"));
+  ASSERT_TRUE(out.exp == nullptr);
+
+  montauk::app::build_http_too_large(out);
+  ASSERT_TRUE(out.head.starts_with("HTTP/1.1 431 "));
+  ASSERT_TRUE(!out.keep_alive);
+}
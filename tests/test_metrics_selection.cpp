@@ -0,0 +1,170 @@
+// Selective /metrics: request-target parsing, the section walk skipping what
+// a selection excludes, per-family filtering and the per-selection cache.
+#include "minitest.hpp"
+#include "fixtures/metrics_fixture.hpp"
+#include "app/MetricsHttp.hpp"
+#include "app/MetricsSelection.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using montauk::app::MetricsSection;
+using montauk::app::MetricsSelection;
+using montauk::app::MetricsTarget;
+using montauk::app::parse_metrics_target;
+
+namespace {
+
+MetricsSelection only(MetricsSection s) {
+  MetricsSelection sel;
+  sel.sections = 1u << static_cast<unsigned>(s);
+  return sel;
+}
+
+// The family of every "# TYPE name kind" line, in order.
+std::vector<std::string> families_of(const std::string& prom) {
+  std::vector<std::string> out;
+  size_t pos = 0;
+  while ((pos = prom.find("# TYPE ", pos)) != std::string::npos) {
+    pos += 7;
+    out.push_back(prom.substr(pos, prom.find(' ', pos) - pos));
+  }
+  return out;
+}
+
+size_t count(const std::string& s, std::string_view needle) {
+  size_t n = 0;
+  for (size_t pos = s.find(needle); pos != std::string::npos; pos = s.find(needle, pos + 1)) ++n;
+  return n;
+}
+
+}  // namespace
+
+TEST(metrics_selection_parse_target) {
+  MetricsSelection sel;
+  ASSERT_TRUE(parse_metrics_target("/metrics", sel) == MetricsTarget::Ok);
+  ASSERT_TRUE(sel.key.empty());
+  ASSERT_TRUE(sel.wants(MetricsSection::Trace));
+
+  ASSERT_TRUE(parse_metrics_target("/metrics/system", sel) == MetricsTarget::Ok);
+  ASSERT_TRUE(sel.wants(MetricsSection::Cpu));
+  ASSERT_TRUE(!sel.wants(MetricsSection::Processes));
+  ASSERT_TRUE(!sel.wants(MetricsSection::Trace));
+
+  ASSERT_TRUE(parse_metrics_target("/metrics/procs?top=5", sel) == MetricsTarget::Ok);
+  ASSERT_EQ(sel.top, 5u);
+  ASSERT_TRUE(sel.wants(MetricsSection::Processes));
+  ASSERT_TRUE(!sel.wants(MetricsSection::Cpu));
+  ASSERT_TRUE(sel.wants_snapshot());
+
+  ASSERT_TRUE(parse_metrics_target("/metrics/trace", sel) == MetricsTarget::Ok);
+  ASSERT_TRUE(!sel.wants_snapshot());
+
+  // Order and repetition of the filters do not change the key.
+  MetricsSelection a, b;
+  ASSERT_TRUE(parse_metrics_target("/metrics?family=montauk_memory_*&family=montauk_cpu_usage_percent", a) == MetricsTarget::Ok);
+  ASSERT_TRUE(parse_metrics_target("/metrics?family=montauk_cpu_usage_percent%2Cmontauk_memory_%2A", b) == MetricsTarget::Ok);
+  ASSERT_EQ(a.key, b.key);
+  ASSERT_TRUE(a.wants(MetricsSection::Cpu));
+  ASSERT_TRUE(a.wants(MetricsSection::Memory));
+  ASSERT_TRUE(!a.wants(MetricsSection::Gpu));
+  ASSERT_TRUE(!a.wants(MetricsSection::Processes));
+  ASSERT_TRUE(a.wants_family("montauk_memory_used_bytes"));
+  ASSERT_TRUE(!a.wants_family("montauk_cpu_usage_percent_x"));
+
+  // A broad prefix reaches every section it could name.
+  ASSERT_TRUE(parse_metrics_target("/metrics?family=montauk_p*", sel) == MetricsTarget::Ok);
+  ASSERT_TRUE(sel.wants(MetricsSection::Pmu));
+  ASSERT_TRUE(sel.wants(MetricsSection::Processes));
+  ASSERT_TRUE(sel.wants(MetricsSection::Thermal));  // montauk_power_watts
+  ASSERT_TRUE(!sel.wants(MetricsSection::Cpu));
+
+  ASSERT_TRUE(parse_metrics_target("/metrics?top=x", sel) == MetricsTarget::BadRequest);
+  ASSERT_TRUE(parse_metrics_target("/metrics?fmaily=montauk_cpu_usage_percent", sel) == MetricsTarget::BadRequest);
+  ASSERT_TRUE(parse_metrics_target("/metrics?family=montauk_*cpu", sel) == MetricsTarget::BadRequest);
+  ASSERT_TRUE(parse_metrics_target("/metrics/nope", sel) == MetricsTarget::NotFound);
+  ASSERT_TRUE(parse_metrics_target("/metricsfoo", sel) == MetricsTarget::NotFound);
+}
+
+TEST(metrics_selection_sections_partition_the_walk) {
+  // Every family a section emits is one its prefixes name, and rendering the
+  // sections one at a time reproduces the full exposition byte for byte --
+  // skipping a section loses nothing another section was responsible for.
+  auto s = make_fixture_snapshot();
+  const std::string full = montauk::app::snapshot_to_prometheus(s);
+  std::string pieces;
+  for (unsigned i = 0; i < static_cast<unsigned>(MetricsSection::Trace); ++i) {
+    const auto sec = static_cast<MetricsSection>(i);
+    const std::string part = montauk::app::snapshot_to_prometheus(s, only(sec));
+    pieces += part;
+    for (const auto& name : families_of(part)) {
+      bool named = false;
+      for (std::string_view p : montauk::app::section_family_prefixes(sec)) named = named || name.starts_with(p);
+      if (!named) std::fprintf(stderr, "  section %u emits unlisted family %s\n", i, name.c_str());
+      ASSERT_TRUE(named);
+    }
+  }
+  ASSERT_EQ(pieces, full);
+
+  auto t = make_fixture_trace();
+  for (const auto& name : families_of(montauk::app::trace_to_prometheus(t))) {
+    bool named = false;
+    for (std::string_view p : montauk::app::section_family_prefixes(MetricsSection::Trace)) named = named || name.starts_with(p);
+    ASSERT_TRUE(named);
+  }
+  ASSERT_TRUE(montauk::app::trace_to_prometheus(t, only(MetricsSection::Cpu)).empty());
+}
+
+TEST(metrics_selection_filters_families_and_rows) {
+  auto s = make_fixture_snapshot();
+  MetricsSelection sel;
+
+  ASSERT_TRUE(parse_metrics_target("/metrics/procs?top=1", sel) == MetricsTarget::Ok);
+  const std::string procs = montauk::app::snapshot_to_prometheus(s, sel);
+  ASSERT_EQ(count(procs, "montauk_process_cpu_percent{"), 1u);
+  ASSERT_TRUE(procs.contains("montauk_processes_total 305"));
+  ASSERT_TRUE(!procs.contains("montauk_cpu_"));
+
+  ASSERT_TRUE(parse_metrics_target("/metrics?family=montauk_cpu_usage_percent,test_metric", sel) == MetricsTarget::Ok);
+  const std::string two = montauk::app::snapshot_to_prometheus(s, sel);
+  ASSERT_EQ(families_of(two), (std::vector<std::string>{"montauk_cpu_usage_percent", "test_metric"}));
+  ASSERT_TRUE(two.contains("\ntest_metric 1\n"));
+
+  ASSERT_TRUE(parse_metrics_target("/metrics?family=montauk_process_*", sel) == MetricsTarget::Ok);
+  for (const auto& name : families_of(montauk::app::snapshot_to_prometheus(s, sel)))
+    ASSERT_TRUE(name.starts_with("montauk_process_"));
+}
+
+TEST(metrics_selection_cached_per_selection) {
+  montauk::app::SnapshotBuffers buffers;
+  buffers.back().cpu.usage_pct = 7.0;
+  buffers.publish();
+  montauk::app::MetricsCache cache(buffers);
+  montauk::app::HttpResponse out;
+  auto get = [&](std::string_view req) {
+    montauk::app::build_http_response(*montauk::app::parse_http_request(req), cache, out);
+  };
+
+  get("GET /metrics/system HTTP/1.1\r\n\r\n");
+  ASSERT_TRUE(out.head.starts_with("HTTP/1.1 200 OK\r\n"));
+  ASSERT_TRUE(out.body.contains("montauk_cpu_usage_percent 7"));
+  ASSERT_TRUE(!out.body.contains("montauk_processes_total"));
+  get("GET /metrics/procs HTTP/1.1\r\n\r\n");
+  ASSERT_TRUE(out.body.contains("montauk_processes_total"));
+  ASSERT_TRUE(!out.body.contains("montauk_cpu_usage_percent"));
+  get("GET /metrics/system/ HTTP/1.1\r\n\r\n");
+  get("GET /metrics HTTP/1.1\r\n\r\n");
+  ASSERT_EQ(cache.renders(), 3u);
+
+  get("GET /metrics?top=-1 HTTP/1.1\r\n\r\n");
+  ASSERT_TRUE(out.head.starts_with("HTTP/1.1 400 Bad Request\r\n"));
+  ASSERT_TRUE(out.exp == nullptr);
+
+  // A new generation re-renders each selection on its next scrape.
+  buffers.back().cpu.usage_pct = 8.0;
+  buffers.publish();
+  get("GET /metrics/system HTTP/1.1\r\n\r\n");
+  ASSERT_TRUE(out.body.contains("montauk_cpu_usage_percent 8"));
+  ASSERT_EQ(cache.renders(), 4u);
+}
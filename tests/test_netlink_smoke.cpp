@@ -59,7 +59,7 @@ TEST(netlink_detect_child_and_shutdown) {
   montauk::model::ProcessSnapshot snap;
   c.sample(snap);
   bool found = false;
-  for (const auto& p : snap.processes) { if (p.pid == pid) { found = true; break; } }
+  for (int32_t p : snap.pid) { if (p == pid) { found = true; break; } }
   (void)found; // best-effort detection only; avoid flakiness by not asserting on it
   // It's reasonable to expect we see the child after EXEC; if not, allow pass to avoid flakiness
   ASSERT_TRUE(true);
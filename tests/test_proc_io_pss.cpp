@@ -0,0 +1,150 @@
+// ProcIoPssSampler: /proc/PID/io and smaps_rollup parsing, per-row rates
+// and ages over a fake /proc, the budget, and pid-reuse resets.
+#include "minitest.hpp"
+#include "env_guard.hpp"
+#include "collectors/ProcIoPssSampler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+using montauk::model::kAgeNever;
+
+namespace {
+
+void write_io(const fs::path& root, int pid, uint64_t rd, uint64_t wr) {
+  fs::create_directories(root / "proc" / std::to_string(pid));
+  std::ofstream(root / "proc" / std::to_string(pid) / "io")
+      << "rchar: 99999\nwchar: 88888\nsyscr: 10\nsyscw: 5\nread_bytes: " << rd << "\nwrite_bytes: " << wr
+      << "\ncancelled_write_bytes: 0\n";
+}
+
+void write_rollup(const fs::path& root, int pid, uint64_t pss_kb) {
+  std::ofstream(root / "proc" / std::to_string(pid) / "smaps_rollup")
+      << "55d0c0000000-7ffd4a3f9000 ---p 00000000 00:00 0                          [rollup]\n"
+      << "Rss:                4096 kB\nPss:             " << pss_kb << " kB\nPss_Anon:           1024 kB\n";
+}
+
+montauk::model::ProcessSnapshot table(std::initializer_list<std::pair<int, uint64_t>> pid_start) {
+  montauk::model::ProcessSnapshot s;
+  for (auto [pid, start] : pid_start) {
+    montauk::model::ProcSample r;
+    r.pid = pid;
+    r.start_time = start;
+    s.push_back(r);
+  }
+  return s;
+}
+
+}  // namespace
+
+TEST(proc_io_and_rollup_parsers) {
+  auto io = montauk::collectors::parse_proc_io(
+      "rchar: 5\nwchar: 6\nsyscr: 1\nsyscw: 1\nread_bytes: 4096\nwrite_bytes: 8192\ncancelled_write_bytes: 0\n");
+  ASSERT_TRUE(io.has_value());
+  ASSERT_EQ(io->read_bytes, 4096u);
+  ASSERT_EQ(io->write_bytes, 8192u);
+  ASSERT_TRUE(!montauk::collectors::parse_proc_io("rchar: 5\n").has_value());
+  auto pss = montauk::collectors::parse_smaps_rollup_pss_kb("Rss:  100 kB\nPss:   42 kB\nPss_Anon: 1 kB\n");
+  ASSERT_TRUE(pss.has_value());
+  ASSERT_EQ(*pss, 42u);
+  ASSERT_TRUE(!montauk::collectors::parse_smaps_rollup_pss_kb("Rss: 1 kB\n").has_value());
+}
+
+TEST(proc_io_pss_sampler_rates_and_ages) {
+  auto root = fs::temp_directory_path() / ("montauk_test_iopss_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  write_io(root, 100, 0, 0);
+  write_rollup(root, 100, 2048);
+  write_io(root, 200, 1000, 0);
+  write_rollup(root, 200, 512);
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+
+  // top_k 1: pid 100 every tick, pid 200 through the rotation.
+  montauk::collectors::ProcIoPssSampler sampler(1, std::chrono::milliseconds(50));
+  auto s = table({{100, 7}, {200, 9}});
+  sampler.sample(s);
+  ASSERT_EQ(s.io_age_ms[0], kAgeNever);  // one read: no rate yet
+  ASSERT_EQ(s.pss_kb[0], 2048u);
+  ASSERT_TRUE(s.pss_age_ms[0] != kAgeNever);
+  ASSERT_EQ(s.pss_kb[1], 512u);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  write_io(root, 100, 1 << 20, 1 << 19);
+  write_rollup(root, 100, 4096);
+  sampler.sample(s);
+  ASSERT_TRUE(s.io_age_ms[0] != kAgeNever && s.io_age_ms[0] < 1000);
+  // ~1 MiB read over ~100 ms.
+  ASSERT_TRUE(s.io_read_bps[0] > 2e6 && s.io_read_bps[0] < 12e6);
+  ASSERT_TRUE(s.io_write_bps[0] > 1e6);
+  ASSERT_EQ(s.pss_kb[0], 2048u);  // younger than kPssRefresh: the smaps walk is not repeated
+  ASSERT_EQ(s.io_read_bps[1], 0.0);
+
+  // Same pid, new start time: a different process, so no rate across it.
+  auto reused = table({{100, 8}});
+  sampler.sample(reused);
+  ASSERT_EQ(reused.io_age_ms[0], kAgeNever);
+  ASSERT_EQ(reused.pss_kb[0], 4096u);
+  fs::remove_all(root);
+}
+
+TEST(proc_io_pss_sampler_zero_budget_reads_nothing) {
+  auto root = fs::temp_directory_path() / ("montauk_test_iopss0_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  write_io(root, 300, 10, 10);
+  write_rollup(root, 300, 64);
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+  montauk::collectors::ProcIoPssSampler sampler(4, std::chrono::microseconds(0));
+  auto s = table({{300, 1}});
+  sampler.sample(s);
+  ASSERT_EQ(sampler.last_reads(), 0u);
+  ASSERT_TRUE(sampler.last_budget_hit());
+  ASSERT_EQ(s.size(), s.pss_age_ms.size());
+  ASSERT_EQ(s.pss_age_ms[0], kAgeNever);
+  fs::remove_all(root);
+}
+
+TEST(proc_io_pss_sampler_rotation_survives_reranking) {
+  auto root = fs::temp_directory_path() / ("montauk_test_iopssrr_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  constexpr int kRows = 10;
+  constexpr size_t kPerPass = 3;
+  for (int pid = 1; pid <= kRows; ++pid) {
+    write_io(root, pid * 10, 0, 0);
+    write_rollup(root, pid * 10, 64);
+  }
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+
+  // No top rows: everything goes through the rotation, kPerPass at a time.
+  montauk::collectors::ProcIoPssSampler sampler(0, std::chrono::seconds(5), kPerPass);
+  std::vector<int> order;
+  for (int pid = 1; pid <= kRows; ++pid) order.push_back(pid * 10);
+  std::vector<bool> seen(kRows + 1, false);
+  constexpr int kPasses = (kRows + kPerPass - 1) / kPerPass;
+  for (int pass = 0; pass < kPasses; ++pass) {
+    // Re-rank between passes: every row moves kPerPass places down, which
+    // keeps handing a row-index cursor the same rows it just read.
+    std::rotate(order.begin(), order.end() - kPerPass, order.end());
+    montauk::model::ProcessSnapshot s;
+    for (int pid : order) {
+      montauk::model::ProcSample r;
+      r.pid = pid;
+      r.start_time = 1;
+      s.push_back(r);
+    }
+    sampler.sample(s);
+    size_t fresh = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+      if (s.pss_age_ms[i] == kAgeNever || seen[s.pid[i] / 10]) continue;
+      seen[s.pid[i] / 10] = true;
+      ++fresh;
+    }
+    ASSERT_EQ(fresh, std::min<size_t>(kPerPass, kRows - pass * kPerPass));
+  }
+  for (int pid = 1; pid <= kRows; ++pid) ASSERT_TRUE(seen[pid]);
+  fs::remove_all(root);
+}
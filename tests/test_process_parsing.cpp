@@ -4,9 +4,18 @@
 #include "minitest.hpp"
 #include "env_guard.hpp"
 #include "collectors/ProcessParsing.hpp"
+#include "collectors/ShardedScan.hpp"
+#include "collectors/ProcessCollector.hpp"
+#include "util/PidFdCache.hpp"
+#include "util/ProcIdentityCache.hpp"
+#ifdef MONTAUK_HAVE_URING
+#include "collectors/UringProcessCollector.hpp"
+#endif
+#include <algorithm>
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <thread>
 #include <unistd.h>
 
 namespace fs = std::filesystem;
@@ -120,3 +129,290 @@ TEST(read_cpu_total_and_count_honor_proc_root) {
   ASSERT_EQ(montauk::collectors::read_cpu_total(), 1200ull);
   ASSERT_EQ(montauk::collectors::read_cpu_count(), 2u);
 }
+
+TEST(proc_reader_reads_lists_and_follows_root_changes) {
+  auto base = fs::temp_directory_path() / fs::path("montauk_test_procreader_") /
+              fs::path(std::to_string(::getpid()));
+  auto a = base / "a";
+  auto b = base / "b";
+  fs::create_directories(a / "proc/42");
+  fs::create_directories(a / "proc/7");
+  fs::create_directories(a / "proc/self-ish");
+  fs::create_directories(b / "proc/99");
+  std::ofstream(a / "proc/stat") << "cpu  1 2 3 4 0 0 0 0\n";
+  std::ofstream(a / "proc/42/stat") << stat_line("worker", 'R', 10, 20, 30);
+  std::ofstream(a / "proc/42/status") << "Name:\tworker\n"
+                                         "voluntary_ctxt_switches:\t5\n"
+                                         "nonvoluntary_ctxt_switches:\t6\n";
+  montauk::util::ProcReader rd;
+  {
+    TempRootGuard proc_root("MONTAUK_PROC_ROOT", a.string());
+    auto pids = rd.pids();
+    std::sort(pids.begin(), pids.end());
+    ASSERT_EQ(pids.size(), size_t{2});  // non-numeric entries skipped
+    ASSERT_EQ(pids[0], 7);
+    ASSERT_EQ(pids[1], 42);
+    ASSERT_EQ(montauk::collectors::read_cpu_total(rd), 10ull);
+    auto stat = rd.read_pid(42, "stat");
+    ASSERT_TRUE(stat.has_value());
+    char st = '?'; uint64_t ut = 0, stime = 0; int64_t rss = 0; std::string comm;
+    uint64_t mf = 0, jf = 0; int nt = 0;
+    ASSERT_TRUE(montauk::collectors::parse_stat_line(*stat, st, ut, stime, rss, comm, mf, jf, nt));
+    ASSERT_EQ(comm, std::string("worker"));
+    ASSERT_EQ(ut, 10ull);
+    auto cs = montauk::collectors::ctx_switches_from_status(rd, 42);
+    ASSERT_TRUE(cs.ok);
+    ASSERT_EQ(cs.voluntary, 5ull);
+    ASSERT_EQ(cs.involuntary, 6ull);
+    ASSERT_TRUE(!rd.read_pid(7, "stat").has_value());  // missing file
+  }
+  {
+    // The same reader re-resolves its dirfd when the root changes.
+    TempRootGuard proc_root("MONTAUK_PROC_ROOT", b.string());
+    const auto& pids = rd.pids();
+    ASSERT_EQ(pids.size(), size_t{1});
+    ASSERT_EQ(pids[0], 99);
+  }
+  fs::remove_all(base);
+}
+
+TEST(sharded_scan_matches_serial_order_and_counts) {
+  using montauk::collectors::ShardedScan;
+  std::vector<int32_t> pids(ShardedScan::kMinPidsPerShard * 4);
+  for (size_t i = 0; i < pids.size(); ++i) pids[i] = static_cast<int32_t>(pids.size() - i);
+  auto fn = [](ShardedScan::Shard& sh, int32_t pid) {
+    if (pid % 5 == 0) return;  // exited between listing and read
+    montauk::model::ProcSample ps;
+    ps.pid = pid;
+    sh.rows.push_back(std::move(ps));
+    sh.count_state(pid % 3 == 0 ? 'R' : (pid % 3 == 1 ? 'S' : 'Z'));
+  };
+  ShardedScan serial(1), sharded(4);
+  montauk::model::ProcessSnapshot a, b;
+  std::vector<montauk::model::ProcSample> ra, rb;
+  ASSERT_EQ(serial.run(pids, ra, a, fn), size_t{1});
+  ASSERT_EQ(sharded.run(pids, rb, b, fn), size_t{4});
+  ASSERT_EQ(ra.size(), rb.size());
+  for (size_t i = 0; i < ra.size(); ++i) ASSERT_EQ(ra[i].pid, rb[i].pid);
+  ASSERT_EQ(a.state_running, b.state_running);
+  ASSERT_EQ(a.state_sleeping, b.state_sleeping);
+  ASSERT_EQ(a.state_zombie, b.state_zombie);
+  // A small population never fans out.
+  montauk::model::ProcessSnapshot c;
+  std::vector<montauk::model::ProcSample> rc;
+  ASSERT_EQ(sharded.run(std::span<const int32_t>(pids).first(100), rc, c, fn), size_t{1});
+}
+
+TEST(pid_fd_cache_rereads_evicts_and_keys_on_starttime) {
+  using montauk::util::PidFdCache;
+  auto root = fs::temp_directory_path() / fs::path("montauk_test_fdcache_") /
+              fs::path(std::to_string(::getpid()));
+  for (int pid : {1, 2, 3}) {
+    fs::create_directories(root / "proc" / std::to_string(pid));
+    std::ofstream(root / "proc" / std::to_string(pid) / "status") << "v1 " << pid << "\n";
+  }
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+  montauk::util::ProcReader rd;
+  PidFdCache cache(3);  // one pid's worth
+  auto v = cache.read(rd, 1, 100, PidFdCache::Status);
+  ASSERT_TRUE(v.has_value());
+  ASSERT_EQ(std::string(*v), std::string("v1 1\n"));
+  ASSERT_EQ(cache.open_fds(), size_t{1});
+  // Same fd, fresh contents: the re-read is a pread from offset 0.
+  std::ofstream(root / "proc/1/status") << "v2 1\n";
+  v = cache.read_cached(rd, 1, PidFdCache::Status);
+  ASSERT_TRUE(v.has_value());
+  ASSERT_EQ(std::string(*v), std::string("v2 1\n"));
+  ASSERT_EQ(cache.open_fds(), size_t{1});
+  ASSERT_TRUE(!cache.read_cached(rd, 2, PidFdCache::Status).has_value());  // lookup never opens
+  // A new starttime under the same pid is another process: reopened.
+  ASSERT_TRUE(cache.open(rd, 1, 101, PidFdCache::Stat) == false);  // no stat file
+  ASSERT_EQ(cache.open_fds(), size_t{0});
+  ASSERT_TRUE(cache.read(rd, 1, 101, PidFdCache::Status).has_value());
+  // The cap counts fds: three pids with one leaf each fit exactly.
+  cache.tick();
+  ASSERT_TRUE(cache.read(rd, 2, 200, PidFdCache::Status).has_value());
+  cache.tick();
+  ASSERT_TRUE(cache.read(rd, 3, 300, PidFdCache::Status).has_value());
+  ASSERT_EQ(cache.open_fds(), size_t{3});
+  ASSERT_TRUE(cache.read_cached(rd, 1, PidFdCache::Status).has_value());
+  // A second leaf on an existing pid is past the cap too: the least recently
+  // used other pid goes, never the one being opened.
+  std::ofstream(root / "proc/3/cmdline") << "cmd3";
+  cache.tick();
+  ASSERT_TRUE(cache.read(rd, 3, 300, PidFdCache::Cmdline).has_value());
+  ASSERT_EQ(cache.open_fds(), size_t{3});
+  ASSERT_TRUE(!cache.read_cached(rd, 2, PidFdCache::Status).has_value());
+  ASSERT_TRUE(cache.read_cached(rd, 3, PidFdCache::Status).has_value());
+  cache.sweep([](int32_t pid, uint64_t) { return pid == 3; });
+  ASSERT_TRUE(!cache.read_cached(rd, 3, PidFdCache::Status).has_value());
+  cache.clear();
+  ASSERT_EQ(cache.open_fds(), size_t{0});
+  fs::remove_all(root);
+}
+
+TEST(proc_identity_cache_keys_on_image_and_interns) {
+  using montauk::util::ProcIdentityCache;
+  ProcIdentityCache ids(8);
+  auto& e = ids.at(10, 500, "bash");
+  ASSERT_TRUE(e.exe == nullptr && e.cmd == nullptr && e.user == nullptr);
+  e.exe = ids.intern("/usr/bin/bash");
+  e.user = ids.intern("alice");
+  // Same image: cached. Interned strings are shared across entries.
+  ASSERT_TRUE(ids.at(10, 500, "bash").exe != nullptr);
+  ids.at(11, 600, "bash").user = ids.intern("alice");
+  ASSERT_TRUE(ids.at(11, 600, "bash").user == ids.at(10, 500, "bash").user);
+  ASSERT_EQ(ids.pool_size(), size_t{2});
+  // exec keeps the starttime but changes comm; a recycled pid changes starttime.
+  ASSERT_TRUE(ids.at(10, 500, "make").exe == nullptr);
+  ASSERT_TRUE(ids.at(11, 601, "bash").user == nullptr);
+  // Past the cap the least recently used pids go.
+  for (int32_t pid = 100; pid < 108; ++pid) { ids.tick(); (void)ids.at(pid, 1, "w"); }
+  ASSERT_TRUE(ids.size() <= size_t{8});
+  ids.sweep([](int32_t, uint64_t) { return true; });
+  ASSERT_EQ(ids.size(), size_t{0});
+  ASSERT_EQ(ids.pool_size(), size_t{2});  // compaction waits for the pool to outgrow the entries
+  for (int i = 0; i < 300; ++i) ids.at(1, 1, "x").cmd = ids.intern("cmd " + std::to_string(i));
+  ids.sweep([](int32_t, uint64_t) { return false; });
+  ASSERT_EQ(ids.pool_size(), size_t{1});
+}
+
+TEST(process_snapshot_columns_share_an_interned_pool) {
+  using montauk::model::ProcessSnapshot;
+  using montauk::model::ProcSample;
+  std::vector<ProcSample> rows(3);
+  for (int i = 0; i < 3; ++i) {
+    rows[i].pid = 10 + i;
+    rows[i].cpu_pct = 3.0 - i;
+    rows[i].user_name = "alice";
+    rows[i].cmd = "worker " + std::to_string(i);
+  }
+  ProcessSnapshot s;
+  s.assign_rows(rows);
+  ASSERT_EQ(s.size(), size_t{3});
+  ASSERT_TRUE(s.user_name[0] == s.user_name[2]);  // one pool entry per distinct string
+  ASSERT_EQ(s.cmd_of(1), std::string("worker 1"));
+  ASSERT_EQ(s.exe_of(0), std::string());
+  ASSERT_EQ(s.row(2).pid, 12);
+  // Re-publishing the same rows reuses the ids; copies share the pool.
+  const auto pool = s.strings;
+  const size_t interned = pool->size();
+  s.assign_rows(rows);
+  ASSERT_TRUE(s.strings == pool);
+  ASSERT_EQ(pool->size(), interned);
+  ProcessSnapshot top;
+  top.assign_prefix(s, 2);
+  ASSERT_EQ(top.size(), size_t{2});
+  ASSERT_TRUE(top.strings == pool);
+  ASSERT_EQ(top.cmd_of(1), std::string("worker 1"));
+  // Past the budget the next publish starts a fresh pool holding only the
+  // live rows; the old one stays valid for the copies that still use it.
+  ProcSample churn;
+  for (size_t i = 0; pool->size() < ProcessSnapshot::kPoolBudget; ++i) {
+    churn.cmd = "short-lived " + std::to_string(i);
+    s.push_back(churn);
+  }
+  s.assign_rows(rows);
+  ASSERT_TRUE(s.strings != pool);
+  ASSERT_TRUE(s.strings->size() <= size_t{5});
+  ASSERT_EQ(top.cmd_of(0), std::string("worker 0"));
+}
+
+TEST(parse_schedstat_run_ns_takes_the_first_field) {
+  using montauk::collectors::parse_schedstat_run_ns;
+  ASSERT_EQ(parse_schedstat_run_ns("123456789 5000 42\n").value_or(0), 123456789ull);
+  ASSERT_TRUE(!parse_schedstat_run_ns("").has_value());
+  ASSERT_TRUE(!parse_schedstat_run_ns("x 1 2\n").has_value());
+}
+
+TEST(schedstat_accounting_sums_threads_over_wall_time) {
+  auto root = fs::temp_directory_path() / fs::path("montauk_test_schedstat_") /
+              fs::path(std::to_string(::getpid()));
+  fs::create_directories(root / "proc");
+  std::ofstream(root / "proc/stat") << "cpu  1 2 3 4 0 0 0 0\ncpu0 1 2 3 4 0 0 0 0\n";
+  auto self = root / "proc" / std::to_string(::getpid());  // the startup probe
+  fs::create_directories(self);
+  std::ofstream(self / "schedstat") << "1 0 0\n";
+  std::ofstream(self / "stat") << stat_line("montauk", 'R', 0, 0, 100);
+  auto one = root / "proc/21", multi = root / "proc/22";
+  fs::create_directories(one);
+  fs::create_directories(multi / "task/22");
+  fs::create_directories(multi / "task/23");
+  // Tick counters never move: any cpu_pct must come from the ns run times.
+  std::ofstream(one / "stat") << stat_line("single", 'R', 7, 7, 100, 0, 0, 1);
+  std::ofstream(multi / "stat") << stat_line("multi", 'R', 7, 7, 100, 0, 0, 2);
+  auto write_ns = [&](uint64_t single_ns, uint64_t thread_ns) {
+    std::ofstream(one / "schedstat") << single_ns << " 0 1\n";
+    std::ofstream(multi / "schedstat") << thread_ns << " 0 1\n";  // leader only: unused
+    std::ofstream(multi / "task/22/schedstat") << thread_ns << " 0 1\n";
+    std::ofstream(multi / "task/23/schedstat") << thread_ns << " 0 1\n";
+  };
+  write_ns(1'000'000'000, 1'000'000'000);
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+  montauk::collectors::ProcessCollector pc(0, 64, 0, 1, 0, montauk::collectors::CpuClock::Schedstat);
+  montauk::model::ProcessSnapshot s;
+  ASSERT_TRUE(pc.sample(s));
+  write_ns(1'040'000'000, 1'030'000'000);  // +40 ms; +30 ms on each of two threads
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_TRUE(pc.sample(s));
+  double single = -1, multi_pct = -1;
+  for (size_t i = 0; i < s.size(); ++i) {
+    if (s.pid[i] == 21) single = s.cpu_pct[i];
+    if (s.pid[i] == 22) multi_pct = s.cpu_pct[i];
+  }
+  // 40 ms and 60 ms of run time over a window of at least 100 ms.
+  ASSERT_TRUE(single > 10.0 && single <= 40.0);
+  ASSERT_TRUE(multi_pct > 15.0 && multi_pct <= 60.0);
+  ASSERT_TRUE(multi_pct > single);
+  fs::remove_all(root);
+}
+
+#ifdef MONTAUK_HAVE_URING
+// The batched backend must publish exactly what the synchronous one does:
+// same rows, same status fields, same churn placeholder for a pid whose stat
+// is gone, and a status file bigger than a batch slot read in full.
+TEST(uring_collector_matches_traditional) {
+  auto root = fs::temp_directory_path() / fs::path("montauk_test_uring_") /
+              fs::path(std::to_string(::getpid()));
+  fs::create_directories(root / "proc");
+  std::ofstream(root / "proc/stat") << "cpu  1 2 3 4 0 0 0 0\ncpu0 1 2 3 4 0 0 0 0\n";
+  for (int pid : {11, 12, 13, 14}) {
+    auto d = root / "proc" / std::to_string(pid);
+    fs::create_directories(d);
+    if (pid == 13) continue;  // exited: directory without files
+    std::ofstream(d / "stat") << stat_line("p" + std::to_string(pid), 'S', 10u * pid, 5, 100);
+    std::string status = "Name:\tp\nvoluntary_ctxt_switches:\t" + std::to_string(pid) +
+                         "\nnonvoluntary_ctxt_switches:\t" + std::to_string(pid * 2) + "\n";
+    if (pid == 14) status = std::string(6000, '#') + "\n" + status;  // past one slot
+    std::ofstream(d / "status") << status;
+  }
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+  montauk::collectors::ProcessCollector trad(0, 64, 0, 1);
+  montauk::collectors::UringProcessCollector ur(0, 64, 0, 1);
+  if (!ur.init()) { fs::remove_all(root); return; }  // no io_uring here: nothing to compare
+  montauk::model::ProcessSnapshot a, b;
+  ASSERT_TRUE(trad.sample(a));
+  ASSERT_TRUE(ur.sample(b));
+  ASSERT_EQ(a.size(), size_t{4});
+  ASSERT_EQ(a.size(), b.size());
+  auto by_pid = [](const montauk::model::ProcessSnapshot& s) {
+    std::vector<montauk::model::ProcSample> v;
+    for (size_t i = 0; i < s.size(); ++i) v.push_back(s.row(i));
+    std::sort(v.begin(), v.end(), [](const auto& x, const auto& y) { return x.pid < y.pid; });
+    return v;
+  };
+  auto ra = by_pid(a), rb = by_pid(b);
+  for (size_t i = 0; i < ra.size(); ++i) {
+    ASSERT_EQ(ra[i].pid, rb[i].pid);
+    ASSERT_EQ(ra[i].cmd, rb[i].cmd);
+    ASSERT_EQ(ra[i].total_time, rb[i].total_time);
+    ASSERT_EQ(ra[i].vctx_raw, rb[i].vctx_raw);
+    ASSERT_EQ(ra[i].nvctx_raw, rb[i].nvctx_raw);
+    ASSERT_TRUE(ra[i].churn_reason == rb[i].churn_reason);
+  }
+  ASSERT_EQ(rb[3].vctx_raw, 14ull);
+  ASSERT_EQ(a.state_sleeping, b.state_sleeping);
+  ASSERT_TRUE(ur.last_enters() > 0);
+  fs::remove_all(root);
+}
+#endif
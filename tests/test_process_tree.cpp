@@ -0,0 +1,135 @@
+// ProcessTree: edges from row ppids and fork/exit events, post-order subtree
+// rollups, sweeps of exited pids, pid reuse, and stat-line ppid parsing.
+#include "minitest.hpp"
+#include "collectors/ProcessParsing.hpp"
+#include "collectors/ProcessTree.hpp"
+#include <vector>
+
+using montauk::model::ProcSample;
+
+namespace {
+
+ProcSample proc(int32_t pid, int32_t ppid, double cpu, uint64_t rss_kb, int threads = 1, uint64_t start = 1) {
+  ProcSample r;
+  r.pid = pid;
+  r.ppid = ppid;
+  r.cpu_pct = cpu;
+  r.rss_kb = rss_kb;
+  r.thread_count = threads;
+  r.start_time = start;
+  return r;
+}
+
+const ProcSample& find(const std::vector<ProcSample>& rows, int32_t pid) {
+  for (const auto& r : rows)
+    if (r.pid == pid) return r;
+  static const ProcSample kNone;
+  return kNone;
+}
+
+}  // namespace
+
+TEST(stat_line_ppid) {
+  const std::string line =
+      "4242 (my (odd) proc) S 17 4242 4242 0 -1 4194304 10 0 2 0 30 12 0 0 20 0 3 0 9876 1000 256 18446744073709551615";
+  char st = '?';
+  uint64_t ut = 0, stime = 0, minflt = 0, majflt = 0, start = 0;
+  int64_t rss = 0;
+  int threads = 0;
+  int32_t ppid = 0;
+  std::string comm;
+  ASSERT_TRUE(montauk::collectors::parse_stat_line(line, st, ut, stime, rss, comm, minflt, majflt, threads, &start,
+                                                   &ppid));
+  ASSERT_EQ(ppid, 17);
+  ASSERT_EQ(comm, std::string("my (odd) proc"));
+  ASSERT_EQ(start, 9876u);
+  ASSERT_EQ(rss, 256);
+}
+
+TEST(process_tree_rolls_up_subtrees) {
+  // 1 ─┬─ 10 ─┬─ 11
+  //    │      └─ 12 ── 13
+  //    └─ 20
+  std::vector<ProcSample> rows{proc(13, 12, 4.0, 40, 2), proc(1, 0, 1.0, 100), proc(10, 1, 2.0, 200),
+                               proc(11, 10, 8.0, 300, 4), proc(12, 10, 16.0, 400), proc(20, 1, 32.0, 500)};
+  montauk::collectors::ProcessTree tree;
+  tree.refresh(rows);
+  ASSERT_EQ(tree.size(), 6u);
+  const auto& root = find(rows, 1);
+  ASSERT_EQ(root.subtree_procs, 6u);
+  ASSERT_TRUE(root.subtree_cpu_pct > 62.9 && root.subtree_cpu_pct < 63.1);
+  ASSERT_EQ(root.subtree_rss_kb, 1540u);
+  ASSERT_EQ(root.subtree_threads, 10u);
+  const auto& ten = find(rows, 10);
+  ASSERT_EQ(ten.subtree_procs, 4u);
+  ASSERT_EQ(ten.subtree_rss_kb, 940u);
+  ASSERT_EQ(find(rows, 12).subtree_procs, 2u);
+  ASSERT_EQ(find(rows, 20).subtree_procs, 1u);
+  ASSERT_EQ(find(rows, 13).ppid, 12);
+
+  // 12 exits; 13 is reparented to init. A complete scan drops 12 and moves 13.
+  rows = {proc(1, 0, 1.0, 100), proc(10, 1, 2.0, 200), proc(11, 10, 8.0, 300, 4), proc(13, 1, 4.0, 40, 2),
+          proc(20, 1, 32.0, 500)};
+  tree.refresh(rows);
+  ASSERT_EQ(tree.size(), 5u);
+  ASSERT_EQ(find(rows, 10).subtree_procs, 2u);
+  ASSERT_EQ(find(rows, 1).subtree_procs, 5u);
+  ASSERT_EQ(tree.parent_of(13), 1);
+}
+
+TEST(process_tree_fork_exit_events_between_scans) {
+  montauk::collectors::ProcessTree tree;
+  std::vector<ProcSample> rows{proc(1, 0, 0.0, 10), proc(50, 1, 5.0, 100)};
+  std::vector<int32_t> live{1, 50};
+  tree.refresh(rows, live);
+
+  // Forks attach children before they are ever scanned.
+  tree.on_fork(50, 51);
+  tree.on_fork(51, 52);
+  ASSERT_EQ(tree.parent_of(52), 51);
+  live = {1, 50, 51, 52};
+  std::vector<ProcSample> some{proc(50, 1, 5.0, 100)};  // budgeted: only 50 read this tick
+  tree.refresh(some, live);
+  ASSERT_EQ(some[0].subtree_procs, 3u);
+
+  // The grandchild is read; the unread nodes keep their last values.
+  std::vector<ProcSample> more{proc(52, 51, 7.0, 70)};
+  tree.refresh(more, live);
+  std::vector<ProcSample> again{proc(50, 1, 5.0, 100)};
+  tree.refresh(again, live);
+  ASSERT_TRUE(again[0].subtree_cpu_pct > 11.9 && again[0].subtree_cpu_pct < 12.1);
+  ASSERT_EQ(again[0].subtree_rss_kb, 170u);
+
+  tree.on_exit(51);
+  ASSERT_EQ(tree.parent_of(52), 0);  // orphaned until its stat names the reaper
+  live = {1, 50, 52};
+  tree.refresh(again, live);
+  ASSERT_EQ(again[0].subtree_procs, 1u);
+  ASSERT_EQ(tree.size(), 3u);
+
+  // A pid missing from the live set is swept even without its EXIT.
+  live = {1, 50};
+  tree.refresh(again, live);
+  ASSERT_EQ(tree.size(), 2u);
+}
+
+TEST(process_tree_recycled_pid_and_deep_chain) {
+  montauk::collectors::ProcessTree tree;
+  std::vector<ProcSample> rows{proc(1, 0, 0.0, 0), proc(7, 1, 1.0, 1, 1, 100), proc(8, 7, 1.0, 1)};
+  tree.refresh(rows);
+  ASSERT_EQ(find(rows, 7).subtree_procs, 2u);
+  // pid 7 comes back as a different process; 8 now reports init as parent.
+  rows = {proc(1, 0, 0.0, 0), proc(7, 1, 1.0, 1, 1, 200), proc(8, 1, 1.0, 1)};
+  tree.refresh(rows);
+  ASSERT_EQ(find(rows, 7).subtree_procs, 1u);
+  ASSERT_EQ(find(rows, 1).subtree_procs, 3u);
+
+  // A fork chain far deeper than any recursion would like.
+  rows.clear();
+  rows.push_back(proc(1, 0, 0.0, 1));
+  for (int32_t pid = 2; pid <= 20000; ++pid) rows.push_back(proc(pid, pid - 1, 0.0, 1));
+  tree.refresh(rows);
+  ASSERT_EQ(rows[0].subtree_procs, 20000u);
+  ASSERT_EQ(rows[0].subtree_rss_kb, 20000u);
+  ASSERT_EQ(rows.back().subtree_procs, 1u);
+}
@@ -40,12 +40,13 @@ TEST(prometheus_serializer_process_top_n) {
   montauk::app::MetricsSnapshot snap{};
   constexpr int N = 20;
   for (int i = 0; i < N; ++i) {
-    snap.top_procs[i].pid = 1000 + i;
-    snap.top_procs[i].cpu_pct = static_cast<double>(N - i);
-    snap.top_procs[i].rss_kb = 100000;
-    snap.top_procs[i].cmd = "proc" + std::to_string(i);
+    montauk::model::ProcSample p;
+    p.pid = 1000 + i;
+    p.cpu_pct = static_cast<double>(N - i);
+    p.rss_kb = 100000;
+    p.cmd = "proc" + std::to_string(i);
+    snap.top_procs.push_back(p);
   }
-  snap.top_procs_count = N;
   std::string out = montauk::app::snapshot_to_prometheus(snap);
   // Count montauk_process_cpu_percent lines (excluding HELP/TYPE)
   int count = 0;
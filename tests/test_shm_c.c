@@ -0,0 +1,77 @@
+// Proves include/util/shm_snapshot.h is valid C23 and that a C reader sees
+// the layout the C++ writer fills: fixed sizes, a write under the seqlock,
+// the consistent read, and open()'s validation. Plays the writer itself over
+// a temp file, so it needs no running montauk. Exits non-zero on mismatch.
+// The C++ writer is covered by test_shm_snapshot.cpp.
+
+#include "util/shm_snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Not assert(): the suite builds Release, and NDEBUG would compile every
+// check away.
+static int failures;
+#define CHECK(cond) \
+  do { if (!(cond)) { fprintf(stderr, "test_shm_c: %s:%d: %s\n", __FILE__, __LINE__, #cond); ++failures; } } while (0)
+
+static montauk_shm_data out;
+
+int main(void) {
+  _Static_assert(sizeof(montauk_shm_header) == 64, "header is one cache line");
+  _Static_assert(sizeof(montauk_shm_proc) % 8 == 0, "proc rows pack without padding");
+  _Static_assert(offsetof(montauk_shm_segment, data) == 64, "data follows the header");
+
+  char path[] = "/tmp/montauk_shm_c_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0 || ftruncate(fd, (off_t)sizeof(montauk_shm_segment)) != 0) return 1;
+  montauk_shm_segment* seg =
+      (montauk_shm_segment*)mmap(NULL, sizeof(montauk_shm_segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (seg == MAP_FAILED) return 1;
+
+  // No magic yet: a reader must refuse the half-made segment.
+  montauk_shm_reader r;
+  CHECK(montauk_shm_open(&r, path) == -EPROTO);
+
+  seg->hdr.version = MONTAUK_SHM_VERSION;
+  seg->hdr.header_size = sizeof(montauk_shm_header);
+  seg->hdr.segment_size = sizeof(montauk_shm_segment);
+  seg->hdr.writer_pid = (uint32_t)getpid();
+  seg->hdr.flags = MONTAUK_SHM_F_LIVE;
+  seg->hdr.magic = MONTAUK_SHM_MAGIC;
+  if (montauk_shm_open(&r, path) != 0) return 1;
+  CHECK(montauk_shm_read(&r, &out, NULL) == -ENODATA);
+  CHECK(montauk_shm_writer_alive(&r));
+
+  montauk_shm_write_begin(&seg->hdr);
+  CHECK(montauk_shm_read(&r, &out, NULL) == -EAGAIN);  // mid-write: never a torn copy
+  seg->data.cpu.usage_pct = 42.5;
+  seg->data.cpu.ncpus = 2;
+  seg->data.cpu.per_core_pct[1] = 99.0;
+  seg->data.mem.total_kb = 1024;
+  seg->data.nprocs = 2;
+  seg->data.procs[0].pid = 7;
+  seg->data.procs[1].pid = 9;
+  memcpy(seg->data.procs[1].cmd, "sidecar", 8);
+  seg->hdr.generation = 5;
+  montauk_shm_write_end(&seg->hdr);
+
+  uint64_t gen = 0;
+  CHECK(montauk_shm_read(&r, &out, &gen) == 0);
+  CHECK(gen == 5);
+  CHECK(out.cpu.usage_pct == 42.5);
+  CHECK(out.cpu.per_core_pct[1] == 99.0);
+  CHECK(out.mem.total_kb == 1024);
+  CHECK(out.nprocs == 2);
+  CHECK(out.procs[0].pid == 7);
+  CHECK(strcmp(out.procs[1].cmd, "sidecar") == 0);
+
+  seg->hdr.flags = 0;
+  CHECK(!montauk_shm_writer_alive(&r));
+
+  montauk_shm_close(&r);
+  munmap(seg, sizeof(montauk_shm_segment));
+  unlink(path);
+  fprintf(stderr, failures ? "test_shm_c: FAIL\n" : "test_shm_c: PASS\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+// ShmExporter: a Snapshot projected onto the shm_snapshot.h layout, published
+// under the seqlock, read back through the C reader; one writer per segment.
+#include "minitest.hpp"
+#include "app/ShmExport.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+montauk::model::ProcSample proc(int32_t pid, double cpu, const char* cmd) {
+  montauk::model::ProcSample r;
+  r.pid = pid;
+  r.ppid = 1;
+  r.cpu_pct = cpu;
+  r.rss_kb = 4096;
+  r.thread_count = 3;
+  r.cmd = cmd;
+  r.user_name = "root";
+  r.pss_kb = 1000;
+  r.pss_age_ms = 12;
+  r.subtree_procs = 2;
+  r.subtree_rss_kb = 8192;
+  return r;
+}
+
+}  // namespace
+
+TEST(shm_export_round_trip) {
+  const fs::path path = fs::temp_directory_path() / ("montauk_test_shm_" + std::to_string(::getpid()));
+  fs::remove(path);
+
+  montauk::app::SnapshotBuffers buffers;
+  auto& w = buffers.back();
+  w.cpu.usage_pct = 37.5;
+  w.cpu.per_core_pct = {10.0, 65.0};
+  w.cpu.logical_threads = 2;
+  w.mem.total_kb = 16 << 20;
+  w.mem.used_pct = 25.0;
+  w.procs.total_processes = 300;
+  w.procs.state_zombie = 1;
+  std::vector<montauk::model::ProcSample> rows{
+      proc(42, 50.0, "a-command-line-well-past-the-ninety-six-byte-cmd-field-of-the-segment-layout-so-it-must-truncate"),
+      proc(43, 5.0, "sidecar")};
+  w.procs.assign_rows(rows);
+  buffers.publish();
+
+  montauk::app::ShmExporter exporter(buffers, path);
+  ASSERT_TRUE(exporter.open());
+  montauk::app::ShmExporter second(buffers, path);
+  ASSERT_TRUE(!second.open());  // flock: one writer per segment
+
+  montauk_shm_reader r;
+  ASSERT_EQ(montauk_shm_open(&r, path.c_str()), 0);
+  auto out = std::make_unique<montauk_shm_data>();
+  ASSERT_EQ(montauk_shm_read(&r, out.get(), nullptr), -ENODATA);
+
+  exporter.publish(*buffers.acquire());
+  uint64_t gen = 0;
+  ASSERT_EQ(montauk_shm_read(&r, out.get(), &gen), 0);
+  ASSERT_EQ(gen, buffers.seq());
+  ASSERT_EQ(out->cpu.usage_pct, 37.5);
+  ASSERT_EQ(out->cpu.ncpus, 2u);
+  ASSERT_EQ(out->cpu.per_core_pct[1], 65.0);
+  ASSERT_EQ(out->mem.total_kb, uint64_t{16} << 20);
+  ASSERT_EQ(out->total_processes, 300u);
+  ASSERT_EQ(out->zombie_processes, 1u);
+  ASSERT_EQ(out->nprocs, 2u);
+  ASSERT_EQ(out->procs[0].pid, 42);
+  ASSERT_EQ(std::strlen(out->procs[0].cmd), size_t{MONTAUK_SHM_CMD_LEN - 1});
+  ASSERT_EQ(std::string(out->procs[1].cmd), std::string("sidecar"));
+  ASSERT_EQ(std::string(out->procs[1].user), std::string("root"));
+  ASSERT_EQ(out->procs[1].flags, MONTAUK_SHM_PROC_PSS | MONTAUK_SHM_PROC_TREE);
+  ASSERT_EQ(out->procs[1].pss_kb, 1000u);
+  ASSERT_EQ(out->procs[1].subtree_rss_kb, 8192u);
+  ASSERT_TRUE(montauk_shm_writer_alive(&r));
+
+  // The background loop picks up a new generation on its own.
+  buffers.back().cpu.usage_pct = 80.0;
+  buffers.publish();
+  exporter.start();
+  for (int i = 0; i < 200 && gen != buffers.seq(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    ASSERT_EQ(montauk_shm_read(&r, out.get(), &gen), 0);
+  }
+  ASSERT_EQ(gen, buffers.seq());
+  ASSERT_EQ(out->cpu.usage_pct, 80.0);
+  exporter.stop();
+
+  montauk_shm_close(&r);
+  fs::remove(path);
+}
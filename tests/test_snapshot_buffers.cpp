@@ -1,4 +1,4 @@
-// SnapshotBuffers: double-buffer publish/seqlock semantics.
+// SnapshotBuffers: RCU generation publish semantics.
 #include "minitest.hpp"
 #include "app/SnapshotBuffers.hpp"
 
@@ -7,14 +7,47 @@ TEST(snapshot_buffers_publish_swaps_and_increments_seq) {
   auto& back = bufs.back();
   back.mem.total_kb = 1000; back.mem.used_kb = 500; back.mem.used_pct = 50.0;
   bufs.publish();
-  const auto& front1 = bufs.front();
-  ASSERT_EQ(front1.mem.total_kb, 1000u);
-  auto seq1 = front1.seq;
+  auto front1 = bufs.acquire();
+  ASSERT_EQ(front1->mem.total_kb, 1000u);
+  auto seq1 = front1->seq;
   auto& back2 = bufs.back();
   back2.mem.used_kb = 600; back2.mem.used_pct = 60.0;
   bufs.publish();
-  const auto& front2 = bufs.front();
-  ASSERT_TRUE(front2.seq == seq1 + 1);
-  ASSERT_EQ(front2.mem.used_kb, 600u);
+  auto front2 = bufs.acquire();
+  ASSERT_TRUE(front2->seq == seq1 + 1);
+  ASSERT_TRUE(bufs.seq() == front2->seq);
+  ASSERT_EQ(front2->mem.used_kb, 600u);
+  ASSERT_EQ(front2->mem.total_kb, 1000u);  // the working copy accumulates
 }
 
+TEST(snapshot_buffers_held_generation_survives_later_publishes) {
+  montauk::app::SnapshotBuffers bufs;
+  bufs.back().mem.used_kb = 1;
+  bufs.publish();
+  auto held = bufs.acquire();
+  for (uint64_t i = 2; i < 10; ++i) {
+    bufs.back().mem.used_kb = i;
+    bufs.publish();
+  }
+  ASSERT_EQ(held->mem.used_kb, 1u);
+  ASSERT_EQ(held->seq, 1u);
+  ASSERT_TRUE(held.use_count() == 1);  // the buffer itself has moved on
+  ASSERT_EQ(bufs.acquire()->mem.used_kb, 9u);
+}
+
+TEST(snapshot_buffers_publish_wakes_each_waiter) {
+  montauk::app::SnapshotBuffers bufs;
+  montauk::app::PublishWaiter a(bufs.signal()), b(bufs.signal());
+  ASSERT_TRUE(a.fd() >= 0 && b.fd() >= 0);
+  pollfd p[2]{{a.fd(), POLLIN, 0}, {b.fd(), POLLIN, 0}};
+  ASSERT_EQ(::poll(p, 2, 0), 0);
+  bufs.publish();
+  // One waiter draining must not consume the other's wakeup.
+  a.drain();
+  ASSERT_EQ(::poll(&p[1], 1, 0), 1);
+  ASSERT_EQ(::poll(&p[0], 1, 0), 0);
+  b.drain();
+  a.wake();
+  ASSERT_EQ(::poll(&p[0], 1, 0), 1);
+  ASSERT_EQ(::poll(&p[1], 1, 0), 0);
+}
@@ -0,0 +1,226 @@
+// --serve / --attach: the snapshot codec's keyframes and deltas, rejection of
+// bad frames, and the server's per-viewer backpressure (a viewer that stops
+// reading skips generations and catches up to the newest) end to end.
+#include "minitest.hpp"
+#include "app/SnapshotClient.hpp"
+#include "app/SnapshotCodec.hpp"
+#include "app/SnapshotServer.hpp"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using montauk::model::ProcSample;
+using montauk::model::Snapshot;
+
+namespace {
+
+ProcSample proc(int32_t pid, double cpu, std::string cmd) {
+  ProcSample r;
+  r.pid = pid;
+  r.cpu_pct = cpu;
+  r.rss_kb = 1000 + static_cast<uint64_t>(pid);
+  r.cmd = std::move(cmd);
+  r.user_name = "u";
+  r.thread_count = 2;
+  return r;
+}
+
+void fill(Snapshot& s, double cpu, size_t nprocs, size_t cmd_len = 16) {
+  s.cpu.usage_pct = cpu;
+  s.cpu.per_core_pct = {cpu, cpu / 2};
+  s.cpu.model = "Test CPU";
+  s.mem.total_kb = 8 << 20;
+  s.net.interfaces = {{"eth0", 1, 2, 3.0, 4.0, 5.0}};
+  s.alerts = {{"warn", "something"}};
+  s.providers = {{"p", "m 1\n", {{"m", "", 1.0}}}};
+  s.pmu.per_process.resize(1);
+  std::strcpy(s.pmu.per_process[0].comm, "worker");
+  s.procs.total_processes = nprocs;
+  s.procs.exited = {{"cc1", 3, 10, 20, 30}};
+  s.collector_name = "Test";
+  std::vector<ProcSample> rows;
+  for (size_t i = 0; i < nprocs; ++i)
+    rows.push_back(proc(static_cast<int32_t>(100 + i), i == 0 ? cpu : 0.0, std::string(cmd_len, 'a' + i % 26)));
+  s.procs.assign_rows(rows);
+}
+
+std::string_view payload(const std::string& frame) { return std::string_view(frame).substr(sizeof(uint32_t)); }
+
+int connect_raw(const fs::path& path) {
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strcpy(addr.sun_path, path.c_str());
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}  // namespace
+
+TEST(snapshot_codec_keyframe_and_delta) {
+  Snapshot a;
+  fill(a, 10.0, 50);
+  a.seq = 1;
+  auto ea = montauk::app::encode_snapshot(a);
+  std::string key;
+  montauk::app::encode_frame(ea, nullptr, key);
+
+  montauk::app::SnapshotDecoder dec;
+  Snapshot out;
+  ASSERT_TRUE(dec.apply(payload(key), out));
+  ASSERT_EQ(dec.seq(), 1u);
+  ASSERT_EQ(out.cpu.usage_pct, 10.0);
+  ASSERT_EQ(out.cpu.model, std::string("Test CPU"));
+  ASSERT_EQ(out.net.interfaces.size(), 1u);
+  ASSERT_EQ(out.providers[0].metrics[0].name, std::string("m"));
+  ASSERT_EQ(std::string(out.pmu.per_process[0].comm), std::string("worker"));
+  ASSERT_EQ(out.procs.size(), 50u);
+  ASSERT_EQ(out.procs.cmd_of(3), a.procs.cmd_of(3));
+  ASSERT_EQ(out.procs.exited[0].comm, std::string("cc1"));
+  ASSERT_EQ(out.collector_name, std::string("Test"));
+
+  // Only the busy row and the cpu section change: the delta carries those.
+  Snapshot b;
+  fill(b, 20.0, 50);
+  b.seq = 2;
+  auto eb = montauk::app::encode_snapshot(b);
+  std::string delta;
+  montauk::app::encode_frame(eb, &ea, delta);
+  ASSERT_TRUE(delta.size() * 5 < key.size());
+  ASSERT_TRUE(dec.apply(payload(delta), out));
+  ASSERT_EQ(dec.seq(), 2u);
+  ASSERT_EQ(out.cpu.usage_pct, 20.0);
+  ASSERT_EQ(out.procs.cpu_pct[0], 20.0);
+  ASSERT_EQ(out.procs.cmd_of(49), b.procs.cmd_of(49));
+  ASSERT_EQ(out.alerts[0].message, std::string("something"));  // untouched section kept
+
+  // The same delta again is against a base the decoder no longer holds.
+  ASSERT_TRUE(!dec.apply(payload(delta), out));
+  montauk::app::SnapshotDecoder fresh;
+  ASSERT_TRUE(!fresh.apply(payload(delta), out));
+  ASSERT_TRUE(!fresh.apply(payload(key).substr(0, payload(key).size() - 3), out));
+}
+
+TEST(snapshot_server_viewer_end_to_end) {
+  const fs::path sock = fs::temp_directory_path() / ("montauk_test_serve_" + std::to_string(::getpid()) + ".sock");
+  montauk::app::SnapshotBuffers upstream;
+  fill(upstream.back(), 30.0, 20);
+  upstream.publish();
+
+  montauk::app::SnapshotServer server(upstream, sock);
+  ASSERT_TRUE(server.start());
+  montauk::app::SnapshotBuffers local;
+  montauk::app::SnapshotClient client(local, sock);
+  ASSERT_TRUE(client.connect());
+  client.start();
+
+  auto wait_for = [&](double cpu) {
+    for (int i = 0; i < 400; ++i) {
+      if (local.seq() > 0 && local.acquire()->cpu.usage_pct == cpu) return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+  };
+  ASSERT_TRUE(wait_for(30.0));
+  ASSERT_EQ(local.acquire()->procs.size(), 20u);
+  fill(upstream.back(), 45.0, 20);
+  upstream.publish();
+  ASSERT_TRUE(wait_for(45.0));
+  ASSERT_EQ(server.clients(), 1u);
+
+  server.stop();
+  for (int i = 0; i < 200 && client.connected(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_TRUE(!client.connected());
+  client.stop();
+  ASSERT_TRUE(!fs::exists(sock));
+}
+
+TEST(snapshot_server_refuses_live_socket_and_non_socket) {
+  const fs::path sock = fs::temp_directory_path() / ("montauk_test_claim_" + std::to_string(::getpid()) + ".sock");
+  montauk::app::SnapshotBuffers upstream;
+  montauk::app::SnapshotServer first(upstream, sock);
+  ASSERT_TRUE(first.start());
+  // A second server must not take over a live one's socket.
+  montauk::app::SnapshotServer second(upstream, sock);
+  ASSERT_TRUE(!second.start());
+  first.stop();
+
+  // A stale socket (bound, nobody listening) is replaced.
+  {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, sock.c_str(), sock.string().size() + 1);
+    ASSERT_EQ(::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)), 0);
+    ::close(fd);
+  }
+  ASSERT_TRUE(second.start());
+  second.stop();
+
+  // A regular file at the path is never deleted.
+  { std::ofstream(sock) << "keep"; }
+  montauk::app::SnapshotServer third(upstream, sock);
+  ASSERT_TRUE(!third.start());
+  ASSERT_TRUE(fs::is_regular_file(sock));
+  fs::remove(sock);
+}
+
+TEST(snapshot_server_slow_viewer_skips_generations) {
+  const fs::path sock = fs::temp_directory_path() / ("montauk_test_slow_" + std::to_string(::getpid()) + ".sock");
+  montauk::app::SnapshotBuffers upstream;
+  // ~1 MB keyframes: far past what a unix socket buffers, so a viewer that
+  // stops reading backs up after its first frame.
+  fill(upstream.back(), 1.0, 4000, 250);
+  upstream.publish();
+  montauk::app::SnapshotServer server(upstream, sock);
+  ASSERT_TRUE(server.start());
+  const int fd = connect_raw(sock);
+  ASSERT_TRUE(fd >= 0);
+
+  constexpr int kGens = 20;
+  for (int g = 2; g <= kGens; ++g) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    fill(upstream.back(), static_cast<double>(g), 4000, 250);
+    upstream.publish();
+  }
+
+  // Now drain: the viewer catches up to the newest generation in a handful of
+  // frames, not one per generation.
+  montauk::app::SnapshotDecoder dec;
+  Snapshot out;
+  std::string buf;
+  size_t frames = 0;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (out.cpu.usage_pct != kGens && std::chrono::steady_clock::now() < deadline) {
+    pollfd pfd{fd, POLLIN, 0};
+    if (::poll(&pfd, 1, 100) <= 0) continue;
+    char chunk[65536];
+    ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+    ASSERT_TRUE(n > 0);
+    buf.append(chunk, static_cast<size_t>(n));
+    while (buf.size() >= 4) {
+      uint32_t len = 0;
+      std::memcpy(&len, buf.data(), 4);
+      if (buf.size() < 4 + len) break;
+      ASSERT_TRUE(dec.apply(std::string_view(buf).substr(4, len), out));
+      buf.erase(0, 4 + len);
+      ++frames;
+    }
+  }
+  ASSERT_EQ(out.cpu.usage_pct, static_cast<double>(kGens));
+  ASSERT_EQ(out.procs.size(), 4000u);
+  ASSERT_TRUE(frames < static_cast<size_t>(kGens) / 2);
+  ASSERT_TRUE(server.generations_skipped() > 0);
+  ::close(fd);
+  server.stop();
+}
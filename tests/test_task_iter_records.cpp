@@ -0,0 +1,126 @@
+// BPF task-iterator records: folding the packed per-task stream into
+// processes, across chunk boundaries and in either thread/leader order.
+#include "minitest.hpp"
+#include "collectors/TaskIterRecords.hpp"
+#include "montauk_procs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using montauk::collectors::TaskIterFold;
+using montauk::collectors::TaskIterProc;
+
+namespace {
+
+template <typename Rec>
+void put(std::vector<uint8_t>& buf, const Rec& r) {
+  const size_t at = buf.size();
+  buf.resize(at + sizeof(r));
+  std::memcpy(buf.data() + at, &r, sizeof(r));
+}
+
+montauk_task_rec leader(uint32_t tgid, const char* comm, uint64_t run_ns, uint32_t threads) {
+  montauk_task_rec r{};
+  r.tgid = r.tid = tgid;
+  r.run_ns = run_ns;
+  r.cpu_ns = run_ns / 2;
+  r.nvcsw = 10;
+  r.nivcsw = 1;
+  r.flt = 100;
+  r.start_ns = 5'000'000'000ull;
+  r.rss_pages = 256;
+  r.ppid = 1;
+  r.uid = 1000;
+  r.nr_threads = threads;
+  r.state = 'R';
+  std::strncpy(r.comm, comm, sizeof(r.comm) - 1);
+  return r;
+}
+
+montauk_thread_rec thread(uint32_t tgid, uint32_t tid, uint64_t run_ns) {
+  montauk_thread_rec r{};
+  r.tgid = tgid;
+  r.tid = tid;
+  r.run_ns = run_ns;
+  r.cpu_ns = run_ns / 2;
+  r.nvcsw = 3;
+  r.nivcsw = 2;
+  r.flt = 7;
+  return r;
+}
+
+const TaskIterProc* find(const std::vector<TaskIterProc>& v, int32_t pid) {
+  auto it = std::find_if(v.begin(), v.end(), [&](const TaskIterProc& p) { return p.pid == pid; });
+  return it == v.end() ? nullptr : &*it;
+}
+
+}  // namespace
+
+TEST(task_iter_fold_sums_threads_onto_their_leader) {
+  std::vector<uint8_t> buf;
+  put(buf, thread(200, 203, 40));  // a thread may precede its leader
+  put(buf, leader(100, "solo", 1000, 1));
+  put(buf, leader(200, "pool", 500, 3));
+  put(buf, thread(200, 201, 60));
+  TaskIterFold fold;
+  fold.feed(buf.data(), buf.size());
+  std::vector<TaskIterProc> out;
+  ASSERT_TRUE(fold.finish(out));
+  ASSERT_EQ(out.size(), 2u);
+  const auto* pool = find(out, 200);
+  ASSERT_TRUE(pool != nullptr);
+  ASSERT_EQ(pool->run_ns, 600u);
+  ASSERT_EQ(pool->cpu_ns, 300u);
+  ASSERT_EQ(pool->nvcsw, 16u);
+  ASSERT_EQ(pool->nivcsw, 5u);
+  ASSERT_EQ(pool->flt, 114u);
+  ASSERT_EQ(pool->nr_threads, 3u);
+  ASSERT_EQ(pool->comm, std::string("pool"));
+  ASSERT_EQ(pool->rss_pages, 256u);
+  ASSERT_EQ(pool->uid, 1000u);
+  ASSERT_EQ(pool->state, 'R');
+  const auto* solo = find(out, 100);
+  ASSERT_TRUE(solo != nullptr);
+  ASSERT_EQ(solo->run_ns, 1000u);
+}
+
+TEST(task_iter_fold_carries_records_split_across_reads) {
+  std::vector<uint8_t> buf;
+  for (uint32_t p = 10; p < 40; ++p) {
+    put(buf, leader(p, "w", p * 10, 2));
+    put(buf, thread(p, p + 1000, 1));
+  }
+  TaskIterFold fold;
+  // Odd chunk sizes, so records straddle every kind of boundary.
+  for (size_t at = 0; at < buf.size();) {
+    const size_t n = std::min<size_t>(37, buf.size() - at);
+    fold.feed(buf.data() + at, n);
+    at += n;
+  }
+  std::vector<TaskIterProc> out;
+  ASSERT_TRUE(fold.finish(out));
+  ASSERT_EQ(out.size(), 30u);
+  const auto* p25 = find(out, 25);
+  ASSERT_TRUE(p25 != nullptr);
+  ASSERT_EQ(p25->run_ns, 251u);
+}
+
+TEST(task_iter_fold_drops_leaderless_groups_and_torn_tails) {
+  std::vector<uint8_t> buf;
+  put(buf, thread(300, 301, 50));  // leader reaped mid-walk
+  put(buf, leader(400, "ok", 10, 1));
+  TaskIterFold fold;
+  fold.feed(buf.data(), buf.size());
+  std::vector<TaskIterProc> out;
+  ASSERT_TRUE(fold.finish(out));
+  ASSERT_EQ(out.size(), 1u);
+  ASSERT_EQ(out[0].pid, 400);
+
+  // The fold resets between passes; a pass that ends mid-record says so.
+  fold.feed(buf.data(), buf.size() - 5);
+  ASSERT_TRUE(!fold.finish(out));
+  fold.feed(buf.data(), buf.size());
+  ASSERT_TRUE(fold.finish(out));
+  ASSERT_EQ(out.size(), 1u);
+}